@@ -0,0 +1,118 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the propagation of large linear sums.
+//
+// The model contains a few scalar products with random coefficients over the
+// same large array of variables, all equal to their value on a random hidden
+// assignment, and the plain sum of the variables. It is solved twice with the
+// same search and the same failure limit: once with the tree of partial sums
+// (batched_sum_threshold = 0), once with the batched propagator. Both runs
+// must explore the same search tree; the benchmark reports their times.
+//
+// Usage: run this with --helpshort for a short usage manual.
+
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/timer.h"
+#include "constraint_solver/constraint_solver.h"
+
+DEFINE_int32(num_vars, 10000, "Number of variables of the linear sums.");
+DEFINE_int32(num_scal_prods, 4, "Number of scalar products.");
+DEFINE_int32(domain_size, 10, "Size of the domains of the variables.");
+DEFINE_int32(max_coefficient, 100,
+             "Coefficients are drawn in [-max_coefficient, max_coefficient].");
+DEFINE_int32(fail_limit, 20000, "Failure limit of the search.");
+DEFINE_int32(batched_sum_threshold, 64,
+             "Threshold of the batched propagator for the second run.");
+DEFINE_int32(seed, 0, "Random seed.");
+
+namespace operations_research {
+struct LinearSumRun {
+  int64 branches;
+  int64 failures;
+  int64 time_in_ms;
+};
+
+LinearSumRun RunLinearSums(int batched_sum_threshold) {
+  ACMRandom random(FLAGS_seed);
+  std::vector<int64> hidden_solution(FLAGS_num_vars);
+  for (int i = 0; i < FLAGS_num_vars; ++i) {
+    hidden_solution[i] = random.Uniform(FLAGS_domain_size);
+  }
+
+  ConstraintSolverParameters parameters = Solver::DefaultSolverParameters();
+  parameters.set_batched_sum_threshold(batched_sum_threshold);
+  Solver solver("linear_sum_benchmark", parameters);
+  std::vector<IntVar*> vars;
+  solver.MakeIntVarArray(FLAGS_num_vars, 0, FLAGS_domain_size - 1, "x", &vars);
+  for (int c = 0; c < FLAGS_num_scal_prods; ++c) {
+    std::vector<int64> coefs(FLAGS_num_vars);
+    int64 rhs = 0;
+    for (int i = 0; i < FLAGS_num_vars; ++i) {
+      do {
+        coefs[i] = static_cast<int64>(random.Uniform(
+                       2 * FLAGS_max_coefficient + 1)) -
+                   FLAGS_max_coefficient;
+      } while (coefs[i] == 0);
+      rhs += coefs[i] * hidden_solution[i];
+    }
+    solver.AddConstraint(solver.MakeScalProdEquality(vars, coefs, rhs));
+  }
+  int64 sum = 0;
+  for (int i = 0; i < FLAGS_num_vars; ++i) {
+    sum += hidden_solution[i];
+  }
+  solver.AddConstraint(solver.MakeSumEquality(vars, sum));
+
+  DecisionBuilder* const db = solver.MakePhase(
+      vars, Solver::CHOOSE_FIRST_UNBOUND, Solver::ASSIGN_MIN_VALUE);
+  SearchLimit* const limit = solver.MakeFailuresLimit(FLAGS_fail_limit);
+  WallTimer timer;
+  timer.Start();
+  solver.Solve(db, limit);
+  timer.Stop();
+  LinearSumRun run;
+  run.branches = solver.branches();
+  run.failures = solver.failures();
+  run.time_in_ms = timer.GetInMs();
+  return run;
+}
+
+void LinearSumBenchmark() {
+  const LinearSumRun tree = RunLinearSums(0);
+  LOG(INFO) << "Tree of partial sums: " << tree.time_in_ms << " ms, "
+            << tree.branches << " branches, " << tree.failures << " failures";
+  const LinearSumRun batched = RunLinearSums(FLAGS_batched_sum_threshold);
+  LOG(INFO) << "Batched propagator: " << batched.time_in_ms << " ms, "
+            << batched.branches << " branches, " << batched.failures
+            << " failures";
+  CHECK_EQ(tree.branches, batched.branches);
+  CHECK_EQ(tree.failures, batched.failures);
+}
+}  // namespace operations_research
+
+static const char kUsage[] =
+    "Usage: see flags.\nThis program benchmarks the propagation of large "
+    "linear sums in the constraint solver.";
+
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage(kUsage);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::LinearSumBenchmark();
+  return 0;
+}
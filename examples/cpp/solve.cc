@@ -30,8 +30,8 @@
 
 DEFINE_string(input, "", "REQUIRED: Input file name.");
 DEFINE_string(solver, "glop",
-              "The solver to use: bop, cbc, clp, cplex, cplex_mip, glop, glpk_lp, "
-              "glpk_mip, gurobi_lp, gurobi_mip, scip, knapsack.");
+              "The solver to use: bop, cbc, clp, cplex, cplex_mip, glop, glop_mip, "
+              "glpk_lp, glpk_mip, gurobi_lp, gurobi_mip, scip, knapsack.");
 DEFINE_string(params_file, "",
               "Solver specific parameters file. "
               "If this flag is set, the --params flag is ignored.");DEFINE_string(params, "", "Solver specific parameters");
@@ -64,6 +64,8 @@ void Run() {
   MPSolver::OptimizationProblemType type;
   if (FLAGS_solver == "glop") {
     type = MPSolver::GLOP_LINEAR_PROGRAMMING;
+  } else if (FLAGS_solver == "glop_mip") {
+    type = MPSolver::GLOP_MIXED_INTEGER_PROGRAMMING;
 #if defined(USE_GLPK)
   } else if (FLAGS_solver == "glpk_lp") {
     type = MPSolver::GLPK_LINEAR_PROGRAMMING;
@@ -0,0 +1,126 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the compact table constraints.
+//
+// The model mimics a timetabling problem: a grid of variables (one row per
+// class, one column per time slot) on which many table constraints are
+// posted, all built on a small number of tuple sets (the allowed patterns of
+// consecutive slots). The benchmark reports the time and the memory used by
+// the initial propagation, where the masks of the tables are built, and the
+// number of masks shared through the cache of the solver. It then runs a
+// search with a time limit.
+//
+// Usage: run this with --helpshort for a short usage manual.
+
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/stringprintf.h"
+#include "base/timer.h"
+#include "constraint_solver/constraint_solver.h"
+#include "constraint_solver/constraint_solveri.h"
+#include "util/tuple_set.h"
+
+DEFINE_int32(num_classes, 200, "Number of rows of the grid of variables.");
+DEFINE_int32(num_slots, 40, "Number of columns of the grid of variables.");
+DEFINE_int32(domain_size, 8, "Size of the domains of the variables.");
+DEFINE_int32(arity, 4, "Arity of the table constraints.");
+DEFINE_int32(num_tuple_sets, 4, "Number of different tuple sets.");
+DEFINE_int32(num_tuples, 2000, "Number of tuples per tuple set.");
+DEFINE_int32(time_limit, 10000, "Time limit of the search in ms.");
+DEFINE_int32(seed, 0, "Random seed.");
+
+namespace operations_research {
+namespace {
+// Fails right after the initial propagation.
+class StopAtRootNode : public DecisionBuilder {
+ public:
+  StopAtRootNode() {}
+  ~StopAtRootNode() override {}
+  Decision* Next(Solver* const s) override { return s->MakeFailDecision(); }
+};
+}  // namespace
+
+void TableBenchmark() {
+  ACMRandom random(FLAGS_seed);
+  std::vector<IntTupleSet> tuple_sets;
+  for (int i = 0; i < FLAGS_num_tuple_sets; ++i) {
+    tuple_sets.push_back(IntTupleSet(FLAGS_arity));
+    std::vector<int64> tuple(FLAGS_arity);
+    for (int t = 0; t < FLAGS_num_tuples; ++t) {
+      for (int j = 0; j < FLAGS_arity; ++j) {
+        tuple[j] = random.Uniform(FLAGS_domain_size);
+      }
+      tuple_sets.back().Insert(tuple);
+    }
+  }
+
+  Solver solver("table_benchmark");
+  std::vector<std::vector<IntVar*>> grid(FLAGS_num_classes);
+  std::vector<IntVar*> all_vars;
+  for (int c = 0; c < FLAGS_num_classes; ++c) {
+    solver.MakeIntVarArray(FLAGS_num_slots, 0, FLAGS_domain_size - 1,
+                           StringPrintf("x%d_", c), &grid[c]);
+    all_vars.insert(all_vars.end(), grid[c].begin(), grid[c].end());
+  }
+  int num_tables = 0;
+  for (int c = 0; c < FLAGS_num_classes; ++c) {
+    for (int s = 0; s + FLAGS_arity <= FLAGS_num_slots; ++s) {
+      const std::vector<IntVar*> scope(grid[c].begin() + s,
+                                       grid[c].begin() + s + FLAGS_arity);
+      solver.AddConstraint(solver.MakeAllowedAssignments(
+          scope, tuple_sets[(c + s) % FLAGS_num_tuple_sets]));
+      ++num_tables;
+    }
+  }
+
+  const int64 memory_before = Solver::MemoryUsage();
+  WallTimer timer;
+  timer.Start();
+  StopAtRootNode stop_at_root_node;
+  solver.Solve(&stop_at_root_node);
+  timer.Stop();
+  const TableMasksCache* const cache = solver.TableMasks();
+  LOG(INFO) << num_tables << " tables, initial propagation in "
+            << timer.GetInMs() << " ms, "
+            << (Solver::MemoryUsage() - memory_before) / 1024 << " kB, "
+            << cache->num_inserted() << " masks built, " << cache->num_hits()
+            << " shared";
+
+  DecisionBuilder* const db = solver.MakePhase(
+      all_vars, Solver::CHOOSE_MIN_SIZE_LOWEST_MIN, Solver::ASSIGN_MIN_VALUE);
+  SearchLimit* const limit = solver.MakeTimeLimit(FLAGS_time_limit);
+  timer.Restart();
+  const bool found = solver.Solve(db, limit);
+  timer.Stop();
+  LOG(INFO) << (found ? "Solution found" : "No solution found") << " in "
+            << timer.GetInMs() << " ms, " << solver.branches() << " branches, "
+            << solver.failures() << " failures";
+}
+}  // namespace operations_research
+
+static const char kUsage[] =
+    "Usage: see flags.\nThis program benchmarks the table constraints of the "
+    "constraint solver.";
+
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage(kUsage);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  CHECK_GE(FLAGS_num_slots, FLAGS_arity);
+  operations_research::TableBenchmark();
+  return 0;
+}
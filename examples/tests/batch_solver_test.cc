@@ -0,0 +1,200 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks MPBatchSolver with requests submitted from several threads: each tag
+// must be returned exactly once by Next(), with the status and objective value
+// of MPSolver::SolveWithProto(), including for invalid requests. Destroying the
+// batch solver with pending requests must wait for them.
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/threadpool.h"
+#include "linear_solver/batch_solver.h"
+#include "linear_solver/linear_solver.h"
+#include "linear_solver/linear_solver.pb.h"
+
+namespace operations_research {
+
+// A random LP, maximizing a positive objective under packing constraints. One
+// request in five also requires a large sum of the variables, which makes some
+// of them infeasible, and one in ten refers to a variable that does not exist.
+MPModelRequest BuildRequest(int seed) {
+  const int kNumVars = 30;
+  const int kNumConstraints = 20;
+  ACMRandom random(seed);
+  MPModelRequest request;
+  request.set_solver_type(MPModelRequest::GLOP_LINEAR_PROGRAMMING);
+  MPModelProto* const model = request.mutable_model();
+  model->set_maximize(true);
+  for (int j = 0; j < kNumVars; ++j) {
+    MPVariableProto* const variable = model->add_variable();
+    variable->set_lower_bound(0.0);
+    variable->set_upper_bound(10.0);
+    variable->set_objective_coefficient(1 + random.Uniform(10));
+  }
+  for (int i = 0; i < kNumConstraints; ++i) {
+    MPConstraintProto* const constraint = model->add_constraint();
+    constraint->set_lower_bound(-MPSolver::infinity());
+    constraint->set_upper_bound(10 + random.Uniform(100));
+    for (int j = 0; j < kNumVars; ++j) {
+      if (random.OneIn(3)) {
+        constraint->add_var_index(j);
+        constraint->add_coefficient(1 + random.Uniform(5));
+      }
+    }
+  }
+  if (seed % 5 == 0) {
+    MPConstraintProto* const constraint = model->add_constraint();
+    constraint->set_lower_bound(random.Uniform(300));
+    constraint->set_upper_bound(MPSolver::infinity());
+    for (int j = 0; j < kNumVars; ++j) {
+      constraint->add_var_index(j);
+      constraint->add_coefficient(1.0);
+    }
+  }
+  if (seed % 10 == 3) {
+    model->mutable_constraint(0)->add_var_index(kNumVars);
+    model->mutable_constraint(0)->add_coefficient(1.0);
+  }
+  return request;
+}
+
+void CheckSameResponse(const MPSolutionResponse& expected,
+                       const MPSolutionResponse& actual) {
+  CHECK_EQ(expected.status(), actual.status());
+  if (expected.status() == MPSOLVER_OPTIMAL) {
+    CHECK_LE(std::abs(expected.objective_value() - actual.objective_value()),
+             1e-6 * (1.0 + std::abs(expected.objective_value())));
+  }
+}
+
+// Submits the requests of the given tags.
+void SubmitRequests(MPBatchSolver* batch_solver,
+                    const std::vector<MPModelRequest>* requests, int first_tag,
+                    int num_tags) {
+  for (int tag = first_tag; tag < first_tag + num_tags; ++tag) {
+    if (tag % 2 == 0) {
+      batch_solver->Submit(tag, (*requests)[tag]);
+    } else {
+      batch_solver->Submit(
+          tag, std::unique_ptr<MPModelRequest>(
+                   new MPModelRequest((*requests)[tag])));
+    }
+  }
+}
+
+void TestConcurrentSubmissions() {
+  const int kNumSubmitters = 4;
+  const int kNumRequestsPerSubmitter = 50;
+  const int kNumRequests = kNumSubmitters * kNumRequestsPerSubmitter;
+  std::vector<MPModelRequest> requests;
+  std::vector<MPSolutionResponse> expected(kNumRequests);
+  int num_invalid = 0;
+  int num_infeasible = 0;
+  for (int tag = 0; tag < kNumRequests; ++tag) {
+    requests.push_back(BuildRequest(tag));
+    MPSolver::SolveWithProto(requests.back(), &expected[tag]);
+    if (expected[tag].status() == MPSOLVER_MODEL_INVALID) ++num_invalid;
+    if (expected[tag].status() == MPSOLVER_INFEASIBLE) ++num_infeasible;
+  }
+  CHECK_GT(num_invalid, 0);
+  CHECK_GT(num_infeasible, 0);
+
+  MPBatchSolver batch_solver(3);
+  int64 tag = -1;
+  MPSolutionResponse response;
+  CHECK(!batch_solver.Next(&tag, &response));
+  CHECK(!batch_solver.TryNext(&tag, &response));
+  std::vector<int> num_received(kNumRequests, 0);
+  {
+    ThreadPool submitters("Submitters", kNumSubmitters);
+    submitters.StartWorkers();
+    for (int i = 0; i < kNumSubmitters; ++i) {
+      submitters.Add(::NewCallback(&SubmitRequests, &batch_solver,
+                                   static_cast<const std::vector<
+                                       MPModelRequest>*>(&requests),
+                                   i * kNumRequestsPerSubmitter,
+                                   kNumRequestsPerSubmitter));
+    }
+    // The responses are received while the requests are submitted. Next()
+    // returns false when all the requests submitted so far were returned.
+    int num_responses = 0;
+    while (num_responses < kNumRequests) {
+      if (!batch_solver.Next(&tag, &response)) continue;
+      CHECK_GE(tag, 0);
+      CHECK_LT(tag, kNumRequests);
+      ++num_received[tag];
+      CheckSameResponse(expected[tag], response);
+      ++num_responses;
+    }
+  }
+  for (int i = 0; i < kNumRequests; ++i) CHECK_EQ(1, num_received[i]) << i;
+  CHECK_EQ(0, batch_solver.NumPending());
+  CHECK(!batch_solver.Next(&tag, &response));
+}
+
+// A request for a solver that is not available is answered without solving.
+void TestUnavailableSolver() {
+  const MPModelRequest::SolverType kSolverType =
+      MPModelRequest::GUROBI_LINEAR_PROGRAMMING;
+  if (MPSolver::SupportsProblemType(
+          static_cast<MPSolver::OptimizationProblemType>(kSolverType))) {
+    return;
+  }
+  MPBatchSolver batch_solver(2);
+  MPModelRequest request = BuildRequest(1);
+  request.set_solver_type(kSolverType);
+  batch_solver.Submit(7, request);
+  int64 tag = -1;
+  MPSolutionResponse response;
+  CHECK(batch_solver.Next(&tag, &response));
+  CHECK_EQ(7, tag);
+  CHECK_EQ(MPSOLVER_SOLVER_TYPE_UNAVAILABLE, response.status());
+}
+
+// Only some of the responses are retrieved before the destruction of the batch
+// solver, which must wait for the requests still being solved.
+void TestShutdownWithPendingRequests() {
+  const int kNumRequests = 40;
+  std::unique_ptr<MPBatchSolver> batch_solver(new MPBatchSolver(2));
+  for (int tag = 0; tag < kNumRequests; ++tag) {
+    batch_solver->Submit(tag, BuildRequest(1000 + tag));
+  }
+  CHECK_EQ(kNumRequests, batch_solver->NumPending());
+  int64 tag = -1;
+  MPSolutionResponse response;
+  for (int i = 0; i < 3; ++i) CHECK(batch_solver->Next(&tag, &response));
+  CHECK_EQ(kNumRequests - 3, batch_solver->NumPending());
+  batch_solver.reset();
+}
+
+void RunAllTests() {
+  TestConcurrentSubmissions();
+  TestUnavailableSolver();
+  TestShutdownWithPendingRequests();
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
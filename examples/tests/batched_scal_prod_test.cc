@@ -0,0 +1,361 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests of the batched propagator of the large scalar products: its solutions
+// are compared with the ones of the default propagators on random scalar
+// products with negative coefficients, with a fixed or a variable target, and
+// the default propagators are checked to be used when the sums of the bounds
+// could overflow. Models with such products are also exported and loaded
+// back.
+
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/stringprintf.h"
+#include "constraint_solver/constraint_solver.h"
+#include "constraint_solver/model.pb.h"
+
+namespace operations_research {
+
+// The parameters of a solver that uses the batched propagator from
+// 'threshold' terms on, or never if it is 0.
+ConstraintSolverParameters Parameters(int threshold) {
+  ConstraintSolverParameters parameters = Solver::DefaultSolverParameters();
+  parameters.set_batched_sum_threshold(threshold);
+  return parameters;
+}
+
+bool IsBatched(const Constraint* const ct) {
+  return ct->DebugString().find("BatchedScalProd(") == 0;
+}
+
+// A random scalar product with non-zero coefficients of both signs, over
+// domains that contain 0 and are not reduced to it.
+struct ScalProd {
+  ScalProd(int size, int64 domain, ACMRandom* const random) {
+    for (int i = 0; i < size; ++i) {
+      int64 coef = 0;
+      while (coef == 0) coef = random->Uniform(11) - 5;
+      coefs.push_back(coef);
+      mins.push_back(-random->Uniform(domain + 1));
+      maxs.push_back(1 + random->Uniform(domain));
+    }
+  }
+
+  std::vector<int64> coefs;
+  std::vector<int64> mins;
+  std::vector<int64> maxs;
+};
+
+// Counts the solutions of sum(coefs[i] * vars[i]) == target, with a fixed
+// target if target_min == target_max.
+int CountSolutions(const ScalProd& scal_prod, int64 target_min,
+                   int64 target_max, int threshold) {
+  Solver solver("batched_scal_prod", Parameters(threshold));
+  std::vector<IntVar*> vars;
+  for (int i = 0; i < scal_prod.coefs.size(); ++i) {
+    vars.push_back(solver.MakeIntVar(scal_prod.mins[i], scal_prod.maxs[i]));
+  }
+  std::vector<IntVar*> decision_vars = vars;
+  Constraint* ct = nullptr;
+  if (target_min == target_max) {
+    ct = solver.MakeScalProdEquality(vars, scal_prod.coefs, target_min);
+  } else {
+    IntVar* const target = solver.MakeIntVar(target_min, target_max);
+    ct = solver.MakeScalProdEquality(vars, scal_prod.coefs, target);
+    decision_vars.push_back(target);
+  }
+  CHECK_EQ(threshold > 0, IsBatched(ct)) << ct->DebugString();
+  solver.AddConstraint(ct);
+  solver.NewSearch(solver.MakePhase(decision_vars, Solver::CHOOSE_RANDOM,
+                                    Solver::ASSIGN_RANDOM_VALUE));
+  int count = 0;
+  while (solver.NextSolution()) {
+    int64 sum = 0;
+    for (int i = 0; i < vars.size(); ++i) {
+      sum += scal_prod.coefs[i] * vars[i]->Value();
+    }
+    CHECK_LE(target_min, sum);
+    CHECK_GE(target_max, sum);
+    ++count;
+  }
+  solver.EndSearch();
+  return count;
+}
+
+void TestSameSolutionsAsDefaultPropagators(int seed) {
+  ACMRandom random(seed);
+  const ScalProd scal_prod(6, 2, &random);
+  const int64 target = random.Uniform(9) - 4;
+  CHECK_EQ(CountSolutions(scal_prod, target, target, 0),
+           CountSolutions(scal_prod, target, target, 4));
+  CHECK_EQ(CountSolutions(scal_prod, target - 3, target + 3, 0),
+           CountSolutions(scal_prod, target - 3, target + 3, 4));
+}
+
+// A product with more terms than a block of the propagator, whose fixed
+// target is the value of a random assignment.
+void TestLargeScalProdWithFixedTarget(int seed) {
+  ACMRandom random(seed);
+  const ScalProd scal_prod(150, 3, &random);
+  int64 target = 0;
+  for (int i = 0; i < scal_prod.coefs.size(); ++i) {
+    target += scal_prod.coefs[i] *
+              (scal_prod.mins[i] +
+               random.Uniform(scal_prod.maxs[i] - scal_prod.mins[i] + 1));
+  }
+  Solver solver("large_scal_prod", Parameters(100));
+  std::vector<IntVar*> vars;
+  for (int i = 0; i < scal_prod.coefs.size(); ++i) {
+    vars.push_back(solver.MakeIntVar(scal_prod.mins[i], scal_prod.maxs[i]));
+  }
+  Constraint* const ct =
+      solver.MakeScalProdEquality(vars, scal_prod.coefs, target);
+  CHECK(IsBatched(ct));
+  solver.AddConstraint(ct);
+  solver.NewSearch(solver.MakePhase(vars, Solver::CHOOSE_RANDOM,
+                                    Solver::ASSIGN_RANDOM_VALUE));
+  CHECK(solver.NextSolution());
+  int64 sum = 0;
+  for (int i = 0; i < vars.size(); ++i) {
+    sum += scal_prod.coefs[i] * vars[i]->Value();
+  }
+  CHECK_EQ(target, sum);
+  solver.EndSearch();
+}
+
+// The result of a search over a model with several large scalar products.
+struct LargeModelSearch {
+  std::vector<std::vector<int64>> solutions;
+  int64 branches;
+  int64 failures;
+};
+
+// Searches for the first 200 solutions of a model made of two scalar products
+// and two sums of 80 terms over 100 variables, sharing most of them, with the
+// given threshold. The targets are computed from a random assignment, so the
+// model is feasible. The search also stops after 5000 failures.
+LargeModelSearch SearchLargeModel(int seed, int threshold) {
+  ACMRandom random(seed);
+  const int kNumVars = 100;
+  const int kNumTerms = 80;
+  const ScalProd domains(kNumVars, 2, &random);
+  std::vector<int64> assignment;
+  for (int i = 0; i < kNumVars; ++i) {
+    assignment.push_back(domains.mins[i] +
+                         random.Uniform(domains.maxs[i] - domains.mins[i] + 1));
+  }
+  Solver solver("large_model", Parameters(threshold));
+  std::vector<IntVar*> vars;
+  for (int i = 0; i < kNumVars; ++i) {
+    vars.push_back(solver.MakeIntVar(domains.mins[i], domains.maxs[i],
+                                     StringPrintf("x%d", i)));
+  }
+  std::vector<IntVar*> decision_vars = vars;
+  std::vector<Constraint*> cts;
+  for (int p = 0; p < 4; ++p) {
+    const int first = p * (kNumVars - kNumTerms) / 3;
+    const std::vector<IntVar*> terms(vars.begin() + first,
+                                     vars.begin() + first + kNumTerms);
+    const ScalProd scal_prod(kNumTerms, 0, &random);
+    int64 value = 0;
+    for (int i = 0; i < kNumTerms; ++i) {
+      value += (p < 2 ? scal_prod.coefs[i] : 1) * assignment[first + i];
+    }
+    if (p == 0) {
+      cts.push_back(
+          solver.MakeScalProdEquality(terms, scal_prod.coefs, value));
+    } else if (p == 3) {
+      cts.push_back(solver.MakeSumLessOrEqual(terms, value));
+    } else {
+      IntVar* const target = solver.MakeIntVar(value - 3, value + 3);
+      cts.push_back(p == 1 ? solver.MakeScalProdEquality(
+                                 terms, scal_prod.coefs, target)
+                           : solver.MakeSumEquality(terms, target));
+      decision_vars.push_back(target);
+    }
+  }
+  // The last constraint bounds the variable of a sum expression, which is
+  // defined by another constraint, batched or not.
+  for (int p = 0; p < cts.size(); ++p) {
+    CHECK(p == 3 || (threshold > 0) == IsBatched(cts[p]))
+        << cts[p]->DebugString();
+    solver.AddConstraint(cts[p]);
+  }
+
+  LargeModelSearch result;
+  solver.NewSearch(solver.MakePhase(decision_vars, Solver::CHOOSE_FIRST_UNBOUND,
+                                    Solver::ASSIGN_CENTER_VALUE),
+                   solver.MakeLimit(kint64max, kint64max, 5000, 200));
+  while (solver.NextSolution()) {
+    result.solutions.push_back(std::vector<int64>());
+    for (IntVar* const var : decision_vars) {
+      result.solutions.back().push_back(var->Value());
+    }
+  }
+  solver.EndSearch();
+  result.branches = solver.branches();
+  result.failures = solver.failures();
+  return result;
+}
+
+// Both propagators compute the bounds consistency of the scalar products, so
+// a depth-first search with a static order visits the same tree with both of
+// them, whatever their order of propagation.
+void TestLargeModelSameSearchAsDefaultPropagators(int seed) {
+  const LargeModelSearch batched =
+      SearchLargeModel(seed, Solver::DefaultSolverParameters()
+                                 .batched_sum_threshold());
+  const LargeModelSearch unbatched = SearchLargeModel(seed, 0);
+  CHECK_EQ(200, unbatched.solutions.size());
+  CHECK(unbatched.solutions == batched.solutions);
+  CHECK_EQ(unbatched.branches, batched.branches);
+  CHECK_EQ(unbatched.failures, batched.failures);
+}
+
+// The sums of the bounds of these terms would overflow: the default
+// propagators are used, and still find the value of the last variable.
+void TestOverflowFallsBackToDefaultPropagators() {
+  Solver solver("overflow", Parameters(4));
+  const int64 bound = kint64max / 8;
+  std::vector<IntVar*> vars;
+  solver.MakeIntVarArray(5, 0, bound, "x", &vars);
+  const std::vector<int64> coefs = {1, 2, -3, 4, -5};
+  Constraint* const ct = solver.MakeScalProdEquality(vars, coefs, int64{0});
+  CHECK(!IsBatched(ct));
+  solver.AddConstraint(ct);
+  solver.AddConstraint(solver.MakeEquality(vars[0], 13));
+  solver.AddConstraint(solver.MakeEquality(vars[1], 20));
+  solver.AddConstraint(solver.MakeEquality(vars[2], 5));
+  solver.AddConstraint(solver.MakeEquality(vars[3], 3));
+  solver.NewSearch(solver.MakePhase(vars, Solver::CHOOSE_FIRST_UNBOUND,
+                                    Solver::ASSIGN_MIN_VALUE));
+  CHECK(solver.NextSolution());
+  CHECK_EQ(10, vars[4]->Value());
+  solver.EndSearch();
+
+  // With small enough bounds, the same product is batched.
+  Solver small_solver("no_overflow", Parameters(4));
+  std::vector<IntVar*> small_vars;
+  small_solver.MakeIntVarArray(5, 0, 1000, "x", &small_vars);
+  CHECK(IsBatched(
+      small_solver.MakeScalProdEquality(small_vars, coefs, int64{0})));
+}
+
+// The kinds of target of the exported scalar products.
+enum TargetKind { FIXED_TARGET, VARIABLE_TARGET, SCAL_PROD_EXPRESSION };
+
+// Returns the values of the first solution of the search over 'vars'.
+std::vector<int64> FirstSolution(Solver* const solver,
+                                 const std::vector<IntVar*>& vars) {
+  std::vector<int64> values;
+  solver->NewSearch(solver->MakePhase(vars, Solver::CHOOSE_FIRST_UNBOUND,
+                                      Solver::ASSIGN_MIN_VALUE));
+  CHECK(solver->NextSolution());
+  for (IntVar* const var : vars) {
+    values.push_back(var->Value());
+  }
+  solver->EndSearch();
+  return values;
+}
+
+// Exports a model made of a scalar product over more terms than the default
+// batched_sum_threshold, loads it back into another solver, and checks that
+// both find the same first solution, which satisfies the scalar product.
+void TestExportAndLoad(int seed, TargetKind kind) {
+  ACMRandom random(seed);
+  const ScalProd scal_prod(70, 3, &random);
+  const int size = scal_prod.coefs.size();
+  int64 target = 0;
+  for (int i = 0; i < size; ++i) {
+    target += scal_prod.coefs[i] *
+              (scal_prod.mins[i] +
+               random.Uniform(scal_prod.maxs[i] - scal_prod.mins[i] + 1));
+  }
+  Solver solver("export", Solver::DefaultSolverParameters());
+  CHECK_LE(solver.parameters().batched_sum_threshold(), size);
+  std::vector<IntVar*> vars;
+  for (int i = 0; i < size; ++i) {
+    vars.push_back(solver.MakeIntVar(scal_prod.mins[i], scal_prod.maxs[i],
+                                     StringPrintf("x%d", i)));
+  }
+  std::vector<IntVar*> decision_vars = vars;
+  if (kind == FIXED_TARGET) {
+    Constraint* const ct =
+        solver.MakeScalProdEquality(vars, scal_prod.coefs, target);
+    CHECK(IsBatched(ct));
+    solver.AddConstraint(ct);
+  } else {
+    IntVar* const target_var =
+        solver.MakeIntVar(target - 5, target + 5, "target");
+    if (kind == VARIABLE_TARGET) {
+      Constraint* const ct =
+          solver.MakeScalProdEquality(vars, scal_prod.coefs, target_var);
+      CHECK(IsBatched(ct));
+      solver.AddConstraint(ct);
+    } else {
+      solver.AddConstraint(solver.MakeEquality(
+          solver.MakeScalProd(vars, scal_prod.coefs), target_var));
+    }
+    decision_vars.push_back(target_var);
+  }
+  CpModel model;
+  solver.ExportModel(std::vector<SearchMonitor*>(), &model,
+                     solver.MakePhase(decision_vars,
+                                      Solver::CHOOSE_FIRST_UNBOUND,
+                                      Solver::ASSIGN_MIN_VALUE));
+
+  Solver loaded_solver("load", Solver::DefaultSolverParameters());
+  std::vector<std::vector<IntVar*>> variable_groups;
+  CHECK(loaded_solver.LoadModel(model, nullptr, &variable_groups));
+  CHECK_EQ(1, variable_groups.size());
+  CHECK_EQ(decision_vars.size(), variable_groups[0].size());
+
+  const std::vector<int64> values = FirstSolution(&solver, decision_vars);
+  CHECK(values == FirstSolution(&loaded_solver, variable_groups[0]));
+  int64 sum = 0;
+  for (int i = 0; i < size; ++i) {
+    sum += scal_prod.coefs[i] * values[i];
+  }
+  CHECK_EQ(kind == FIXED_TARGET ? target : values.back(), sum);
+}
+
+void RunAllTests() {
+  for (int seed = 0; seed < 30; ++seed) {
+    TestSameSolutionsAsDefaultPropagators(seed);
+  }
+  for (int seed = 0; seed < 10; ++seed) {
+    TestLargeScalProdWithFixedTarget(seed);
+  }
+  for (int seed = 0; seed < 10; ++seed) {
+    TestLargeModelSameSearchAsDefaultPropagators(seed);
+  }
+  TestOverflowFallsBackToDefaultPropagators();
+  for (int seed = 0; seed < 5; ++seed) {
+    TestExportAndLoad(seed, FIXED_TARGET);
+    TestExportAndLoad(seed, VARIABLE_TARGET);
+    TestExportAndLoad(seed, SCAL_PROD_EXPRESSION);
+  }
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
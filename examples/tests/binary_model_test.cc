@@ -0,0 +1,230 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Round trip of a model through the binary format of binary_model.h: the model
+// is written, mapped and solved by GLOP directly from the mapping, and the
+// result must match the solve of the original proto. Truncated, misaligned and
+// corrupted files must be rejected by MPBinaryModel::Open().
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/file.h"
+#include "base/join.h"
+#include "base/logging.h"
+#include "linear_solver/binary_model.h"
+#include "linear_solver/linear_solver.h"
+#include "linear_solver/linear_solver.pb.h"
+
+DEFINE_string(binary_model_test_dir, "/tmp",
+              "Directory where the test writes its binary model files.");
+
+namespace operations_research {
+
+std::string TestFile(const std::string& name) {
+  return StrCat(FLAGS_binary_model_test_dir, "/binary_model_test_", name,
+                ".mpb");
+}
+
+void CheckNear(double expected, double actual) {
+  CHECK_LE(std::abs(expected - actual), 1e-6 * (1.0 + std::abs(expected)))
+      << "expected " << expected << ", got " << actual;
+}
+
+// A small LP with names, infinite bounds on variables and constraints, and an
+// empty row. Its optimum is finite.
+MPModelProto BuildModel() {
+  const double kInfinity = MPSolver::infinity();
+  MPModelProto model;
+  model.set_name("binary_model_test");
+  model.set_maximize(true);
+  model.set_objective_offset(2.5);
+  struct {
+    const char* name;
+    double lb;
+    double ub;
+    double objective;
+  } const kVariables[] = {{"x", 0.0, kInfinity, 3.0},
+                          {"y", -kInfinity, 4.0, 2.0},
+                          {"free", -kInfinity, kInfinity, -1.0},
+                          {"", 1.0, 1.0, 0.5}};
+  for (const auto& v : kVariables) {
+    MPVariableProto* const variable = model.add_variable();
+    variable->set_name(v.name);
+    variable->set_lower_bound(v.lb);
+    variable->set_upper_bound(v.ub);
+    variable->set_objective_coefficient(v.objective);
+  }
+  struct {
+    const char* name;
+    double lb;
+    double ub;
+    std::vector<int> var_indices;
+    std::vector<double> coefficients;
+  } const kConstraints[] = {
+      {"capacity", -kInfinity, 10.0, {0, 1}, {1.0, 1.0}},
+      {"empty", -kInfinity, kInfinity, {}, {}},
+      {"link", -3.0, kInfinity, {1, 2}, {1.0, -1.0}},
+      {"", 0.0, 0.0, {2, 3, 0}, {1.0, 2.0, -0.5}}};
+  for (const auto& c : kConstraints) {
+    MPConstraintProto* const constraint = model.add_constraint();
+    constraint->set_name(c.name);
+    constraint->set_lower_bound(c.lb);
+    constraint->set_upper_bound(c.ub);
+    for (int k = 0; k < c.var_indices.size(); ++k) {
+      constraint->add_var_index(c.var_indices[k]);
+      constraint->add_coefficient(c.coefficients[k]);
+    }
+  }
+  return model;
+}
+
+// The binary model must hold the same model as the proto, names included.
+void CheckSameModel(const MPModelProto& expected, const MPBinaryModel& model) {
+  CHECK_EQ(expected.name(), model.name().ToString());
+  CHECK_EQ(expected.maximize(), model.maximize());
+  CHECK_EQ(expected.objective_offset(), model.objective_offset());
+  CHECK_EQ(expected.variable_size(), model.num_variables());
+  for (int j = 0; j < expected.variable_size(); ++j) {
+    const MPVariableProto& variable = expected.variable(j);
+    CHECK_EQ(variable.name(), model.variable_name(j).ToString());
+    CHECK_EQ(variable.lower_bound(), model.variable_lower_bounds()[j]);
+    CHECK_EQ(variable.upper_bound(), model.variable_upper_bounds()[j]);
+    CHECK_EQ(variable.objective_coefficient(),
+             model.objective_coefficients()[j]);
+    CHECK_EQ(variable.is_integer(), model.variable_is_integer()[j] != 0);
+  }
+  CHECK_EQ(expected.constraint_size(), model.num_constraints());
+  for (int i = 0; i < expected.constraint_size(); ++i) {
+    const MPConstraintProto& constraint = expected.constraint(i);
+    CHECK_EQ(constraint.name(), model.constraint_name(i).ToString());
+    CHECK_EQ(constraint.lower_bound(), model.constraint_lower_bounds()[i]);
+    CHECK_EQ(constraint.upper_bound(), model.constraint_upper_bounds()[i]);
+    const int64 begin = model.row_starts()[i];
+    CHECK_EQ(constraint.var_index_size(), model.row_starts()[i + 1] - begin);
+    for (int k = 0; k < constraint.var_index_size(); ++k) {
+      CHECK_EQ(constraint.var_index(k), model.column_indices()[begin + k]);
+      CHECK_EQ(constraint.coefficient(k), model.coefficients()[begin + k]);
+    }
+  }
+  CHECK_EQ("", model.FindError());
+
+  // ExportToProto() sets all the fields, even to their default values.
+  MPModelProto expected_with_defaults = expected;
+  for (MPVariableProto& variable :
+       *expected_with_defaults.mutable_variable()) {
+    variable.set_is_integer(variable.is_integer());
+  }
+  for (MPConstraintProto& constraint :
+       *expected_with_defaults.mutable_constraint()) {
+    constraint.set_is_lazy(constraint.is_lazy());
+  }
+  MPModelProto exported;
+  model.ExportToProto(false, &exported);
+  CHECK_EQ(expected_with_defaults.SerializeAsString(),
+           exported.SerializeAsString());
+}
+
+void TestRoundTrip() {
+  const MPModelProto proto = BuildModel();
+  const std::string filename = TestFile("round_trip");
+  std::string error;
+  CHECK(WriteModelAsBinaryFile(proto, filename, &error)) << error;
+  MPBinaryModel model;
+  CHECK(model.Open(filename, &error)) << error;
+  CheckSameModel(proto, model);
+
+  MPModelRequest request;
+  *request.mutable_model() = proto;
+  request.set_solver_type(MPModelRequest::GLOP_LINEAR_PROGRAMMING);
+  MPSolutionResponse expected;
+  MPSolver::SolveWithProto(request, &expected);
+  CHECK_EQ(MPSOLVER_OPTIMAL, expected.status());
+
+  MPSolver solver("binary_model_test", MPSolver::GLOP_LINEAR_PROGRAMMING);
+  MPSolutionResponse response;
+  solver.ClearAndSolveBinaryModel(model, &response);
+  CHECK_EQ(expected.status(), response.status());
+  CheckNear(expected.objective_value(), response.objective_value());
+  CHECK_EQ(expected.variable_value_size(), response.variable_value_size());
+  for (int j = 0; j < expected.variable_value_size(); ++j) {
+    CheckNear(expected.variable_value(j), response.variable_value(j));
+  }
+  model.Close();
+  CHECK_EQ(0, model.num_variables());
+  File::Delete(filename);
+}
+
+// Writes the given contents to a file, and checks that Open() rejects it with
+// an error message containing the expected one.
+void CheckRejected(const std::string& name, const std::string& contents,
+                   const std::string& expected_error) {
+  const std::string filename = TestFile(name);
+  CHECK(file::SetContents(filename, contents, file::Defaults()).ok());
+  MPBinaryModel model;
+  std::string error;
+  CHECK(!model.Open(filename, &error)) << name;
+  CHECK_NE(std::string::npos, error.find(expected_error))
+      << name << ": " << error;
+  CHECK_EQ(0, model.num_variables());
+  CHECK_EQ(0, model.num_constraints());
+  File::Delete(filename);
+}
+
+void TestInvalidFiles() {
+  const std::string filename = TestFile("valid");
+  std::string error;
+  CHECK(WriteModelAsBinaryFile(BuildModel(), filename, &error)) << error;
+  std::string contents;
+  CHECK(file::GetContents(filename, &contents, file::Defaults()).ok());
+  File::Delete(filename);
+  CHECK_EQ(0, contents.size() % kMPBinaryModelAlignment);
+
+  CheckRejected("empty", "", "File too small");
+  CheckRejected("header_only", contents.substr(0, 16), "File too small");
+  // Truncated in the middle of the sections, and in the padding of the last
+  // one.
+  CheckRejected("truncated", contents.substr(0, contents.size() / 2),
+                "Truncated file");
+  CheckRejected("truncated_padding", contents.substr(0, contents.size() - 1),
+                "Truncated file");
+
+  // Sections shifted from their aligned positions, as if the header had been
+  // written without its padding or with extra bytes.
+  std::string shifted = contents;
+  shifted.insert(kMPBinaryModelAlignment, 8, '\0');
+  CheckRejected("shifted", shifted, "Misaligned file");
+  CheckRejected("extra_bytes", contents + std::string(3, '\0'),
+                "Misaligned file");
+
+  std::string bad_magic = contents;
+  bad_magic[0] = 'X';
+  CheckRejected("bad_magic", bad_magic, "Not a binary model file");
+  CheckRejected("text", std::string(contents.size(), 'a'),
+                "Not a binary model file");
+}
+
+void RunAllTests() {
+  TestRoundTrip();
+  TestInvalidFiles();
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
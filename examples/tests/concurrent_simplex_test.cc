@@ -0,0 +1,180 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the race of the primal and the dual simplex enabled by
+// use_concurrent_simplex: the solution must be the one computed by the
+// sequential solve with the algorithm reported by LastSolveUsedDualSimplex(),
+// and the external Boolean of the caller must stop both algorithms.
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#include "base/callback.h"
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/threadpool.h"
+#include "base/timer.h"
+#include "glop/lp_solver.h"
+#include "glop/parameters.pb.h"
+#include "lp_data/lp_data.h"
+#include "lp_data/lp_types.h"
+#include "util/time_limit.h"
+
+namespace operations_research {
+namespace glop {
+
+// A random LP with non-negative variables and positive costs. When
+// covering is true, it minimizes the costs under covering constraints
+// (A.x >= b): the slack basis is then dual feasible, which favors the dual
+// simplex. Otherwise it maximizes them under packing constraints (A.x <= b),
+// for which the slack basis is primal feasible, which favors the primal
+// simplex.
+void BuildLp(int num_rows, int num_cols, bool covering, int seed,
+             LinearProgram* lp) {
+  const Fractional kInfinity = std::numeric_limits<Fractional>::infinity();
+  ACMRandom random(seed);
+  lp->Clear();
+  lp->SetMaximizationProblem(!covering);
+  for (int col = 0; col < num_cols; ++col) {
+    const ColIndex new_col = lp->CreateNewVariable();
+    lp->SetVariableBounds(new_col, 0.0, 100.0);
+    lp->SetObjectiveCoefficient(new_col, 1 + random.Uniform(20));
+  }
+  for (int row = 0; row < num_rows; ++row) {
+    const RowIndex new_row = lp->CreateNewConstraint();
+    const Fractional bound = 10 + random.Uniform(100);
+    if (covering) {
+      lp->SetConstraintBounds(new_row, bound, kInfinity);
+    } else {
+      lp->SetConstraintBounds(new_row, -kInfinity, bound);
+    }
+    for (int i = 0; i < 5; ++i) {
+      lp->SetCoefficient(new_row, ColIndex(random.Uniform(num_cols)),
+                         1 + random.Uniform(9));
+    }
+  }
+  lp->CleanUp();
+}
+
+GlopParameters Parameters(bool concurrent, bool use_dual_simplex) {
+  GlopParameters parameters;
+  parameters.set_use_concurrent_simplex(concurrent);
+  parameters.set_use_dual_simplex(use_dual_simplex);
+  return parameters;
+}
+
+// Solves the lp with the race, then sequentially with the algorithm that won
+// it and with the default algorithm: the race must give exactly the result of
+// the winner, and the objective value of the default algorithm. Returns true
+// if the dual simplex won.
+bool CheckConcurrentSolve(const LinearProgram& lp) {
+  LPSolver concurrent;
+  concurrent.SetParameters(Parameters(true, false));
+  const ProblemStatus status = concurrent.Solve(lp);
+  CHECK_EQ(ProblemStatus::OPTIMAL, status);
+  const bool dual_won = concurrent.LastSolveUsedDualSimplex();
+
+  LPSolver winner;
+  winner.SetParameters(Parameters(false, dual_won));
+  CHECK_EQ(ProblemStatus::OPTIMAL, winner.Solve(lp));
+  CHECK_EQ(dual_won, winner.LastSolveUsedDualSimplex());
+  CHECK_EQ(winner.GetNumberOfSimplexIterations(),
+           concurrent.GetNumberOfSimplexIterations());
+  CHECK_EQ(winner.GetObjectiveValue(), concurrent.GetObjectiveValue());
+  for (ColIndex col(0); col < lp.num_variables(); ++col) {
+    CHECK_EQ(winner.variable_values()[col], concurrent.variable_values()[col])
+        << col;
+  }
+
+  LPSolver sequential;
+  sequential.SetParameters(Parameters(false, false));
+  CHECK_EQ(ProblemStatus::OPTIMAL, sequential.Solve(lp));
+  CHECK_LE(std::abs(sequential.GetObjectiveValue() -
+                    concurrent.GetObjectiveValue()),
+           1e-6 * (1.0 + std::abs(sequential.GetObjectiveValue())));
+  return dual_won;
+}
+
+void TestConcurrentSolves() {
+  LinearProgram lp;
+  int num_dual_wins = 0;
+  for (int seed = 0; seed < 10; ++seed) {
+    for (const bool covering : {false, true}) {
+      BuildLp(200, 300, covering, seed, &lp);
+      if (CheckConcurrentSolve(lp)) ++num_dual_wins;
+    }
+  }
+  LOG(INFO) << "The dual simplex won " << num_dual_wins << " races out of 20.";
+}
+
+// Sets the flag after the given delay. There is no portable sleep in base/.
+void SetAfterDelay(std::atomic<bool>* flag, int64 delay_ms) {
+  WallTimer timer;
+  timer.Start();
+  while (timer.GetInMs() < delay_ms) {
+  }
+  *flag = true;
+}
+
+// The external Boolean of the time limit of the caller, as set by
+// MPSolver::InterruptSolve(), is set while both algorithms run: the solve must
+// stop much sooner than without interruption.
+void TestInterruption() {
+  LinearProgram lp;
+  BuildLp(4000, 6000, true, 1, &lp);
+  LPSolver solver;
+  solver.SetParameters(Parameters(true, false));
+
+  WallTimer timer;
+  timer.Start();
+  std::unique_ptr<TimeLimit> unlimited = TimeLimit::Infinite();
+  CHECK_EQ(ProblemStatus::OPTIMAL,
+           solver.SolveWithTimeLimit(lp, unlimited.get()));
+  const int64 full_solve_ms = timer.GetInMs();
+
+  const int64 kDelayMs = 20;
+  CHECK_GT(full_solve_ms, 10 * kDelayMs) << "The lp is too easy.";
+  solver.Clear();
+  std::atomic<bool> interrupt(false);
+  std::unique_ptr<TimeLimit> time_limit = TimeLimit::Infinite();
+  time_limit->RegisterExternalBooleanAsLimit(&interrupt);
+  timer.Restart();
+  {
+    ThreadPool pool("Interrupter", 1);
+    pool.StartWorkers();
+    pool.Add(NewCallback(&SetAfterDelay, &interrupt, kDelayMs));
+    CHECK_NE(ProblemStatus::OPTIMAL,
+             solver.SolveWithTimeLimit(lp, time_limit.get()));
+  }
+  const int64 interrupted_solve_ms = timer.GetInMs();
+  LOG(INFO) << "Full solve: " << full_solve_ms
+            << " ms, interrupted solve: " << interrupted_solve_ms << " ms.";
+  CHECK_LT(interrupted_solve_ms, full_solve_ms / 2);
+}
+
+void RunAllTests() {
+  TestConcurrentSolves();
+  TestInterruption();
+}
+
+}  // namespace glop
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::glop::RunAllTests();
+  return 0;
+}
@@ -0,0 +1,195 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the order of the delayed demons set by Demon::set_cost(): the
+// cheapest ones run first, and the events they raise on variables are
+// propagated before the next delayed demon runs. Events enqueuing a demon
+// already in the queue must be counted by Solver::merged_demon_events().
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "constraint_solver/constraint_solver.h"
+
+namespace operations_research {
+
+// A demon logging its runs. It decreases the maximum of the given variable,
+// if any.
+class LoggingDemon : public Demon {
+ public:
+  LoggingDemon(const std::string& name, Solver::DemonPriority priority,
+               std::vector<std::string>* const log, IntVar* const var)
+      : name_(name), priority_(priority), log_(log), var_(var) {}
+
+  void Run(Solver* const solver) override {
+    log_->push_back(name_);
+    if (var_ != nullptr) var_->SetMax(var_->Max() - 1);
+  }
+
+  Solver::DemonPriority priority() const override { return priority_; }
+
+  std::string DebugString() const override { return name_; }
+
+ private:
+  const std::string name_;
+  const Solver::DemonPriority priority_;
+  std::vector<std::string>* const log_;
+  IntVar* const var_;
+};
+
+// Delayed demons of all costs on the variables x and y, some of them on both.
+// The cheap demon of x changes z, whose demon of normal priority must run
+// right after it.
+class DemonCostConstraint : public Constraint {
+ public:
+  DemonCostConstraint(Solver* const solver, IntVar* const x, IntVar* const y,
+                      IntVar* const z, std::vector<std::string>* const log)
+      : Constraint(solver), x_(x), y_(y), z_(z), log_(log) {}
+
+  void Post() override {
+    Demon* const expensive_x =
+        MakeDelayedDemon("expensive_x", Solver::EXPENSIVE_DEMON, nullptr);
+    Demon* const linear_xy =
+        MakeDelayedDemon("linear_xy", Solver::LINEAR_DEMON, nullptr);
+    Demon* const cheap_x =
+        MakeDelayedDemon("cheap_x", Solver::CHEAP_DEMON, z_);
+    Demon* const expensive_y =
+        MakeDelayedDemon("expensive_y", Solver::EXPENSIVE_DEMON, nullptr);
+    Demon* const cheap_xy =
+        MakeDelayedDemon("cheap_xy", Solver::CHEAP_DEMON, nullptr);
+    // The demons are attached in an order unrelated to their costs, whatever
+    // the order in which they are enqueued by the variable.
+    x_->WhenRange(cheap_x);
+    x_->WhenRange(expensive_x);
+    x_->WhenRange(linear_xy);
+    x_->WhenRange(cheap_xy);
+    y_->WhenRange(expensive_y);
+    y_->WhenRange(linear_xy);
+    y_->WhenRange(cheap_xy);
+    z_->WhenRange(solver()->RevAlloc(
+        new LoggingDemon("normal_z", Solver::NORMAL_PRIORITY, log_, nullptr)));
+  }
+
+  void InitialPropagate() override {}
+
+  // Changes the bounds of x twice and those of y once, as a single event for
+  // the demons.
+  void ChangeBounds() {
+    FreezeQueue();
+    x_->SetMin(x_->Min() + 1);
+    x_->SetMax(x_->Max() - 1);
+    y_->SetMax(y_->Max() - 1);
+    UnfreezeQueue();
+  }
+
+  std::string DebugString() const override { return "DemonCostConstraint"; }
+
+ private:
+  Demon* MakeDelayedDemon(const std::string& name, Solver::DemonCost cost,
+                          IntVar* const var) {
+    Demon* const demon = solver()->RevAlloc(
+        new LoggingDemon(name, Solver::DELAYED_PRIORITY, log_, var));
+    demon->set_cost(cost);
+    CHECK_EQ(cost, demon->cost());
+    return demon;
+  }
+
+  IntVar* const x_;
+  IntVar* const y_;
+  IntVar* const z_;
+  std::vector<std::string>* const log_;
+};
+
+// Changes the bounds during the search, and checks the runs of the demons and
+// the merged events.
+class ChangeBounds : public DecisionBuilder {
+ public:
+  ChangeBounds(DemonCostConstraint* const constraint,
+               std::vector<std::string>* const log)
+      : constraint_(constraint), log_(log) {}
+
+  Decision* Next(Solver* const solver) override {
+    CHECK(log_->empty());
+    const int64 merged_var_events =
+        solver->merged_demon_events(Solver::VAR_PRIORITY);
+    const int64 merged_delayed_events =
+        solver->merged_demon_events(Solver::DELAYED_PRIORITY);
+    constraint_->ChangeBounds();
+
+    // The cheap demons run first, in any order between them. The demons of
+    // the other costs only run once.
+    CHECK_EQ(6, log_->size());
+    const std::vector<std::string> cheap_demons = {(*log_)[0], (*log_)[1],
+                                                   (*log_)[2]};
+    const auto cheap_x =
+        std::find(cheap_demons.begin(), cheap_demons.end(), "cheap_x");
+    CHECK(cheap_x != cheap_demons.end());
+    CHECK(cheap_x + 1 != cheap_demons.end());
+    CHECK_EQ("normal_z", *(cheap_x + 1));
+    CHECK(std::find(cheap_demons.begin(), cheap_demons.end(), "cheap_xy") !=
+          cheap_demons.end());
+    CHECK_EQ("linear_xy", (*log_)[3]);
+    CHECK(((*log_)[4] == "expensive_x" && (*log_)[5] == "expensive_y") ||
+          ((*log_)[4] == "expensive_y" && (*log_)[5] == "expensive_x"));
+
+    // The second change of x is merged with the first one, and the change of
+    // y finds linear_xy and cheap_xy already enqueued by x.
+    CHECK_EQ(merged_var_events + 1,
+             solver->merged_demon_events(Solver::VAR_PRIORITY));
+    CHECK_EQ(merged_delayed_events + 2,
+             solver->merged_demon_events(Solver::DELAYED_PRIORITY));
+    log_->clear();
+    return nullptr;
+  }
+
+ private:
+  DemonCostConstraint* const constraint_;
+  std::vector<std::string>* const log_;
+};
+
+void TestDelayedDemonOrder() {
+  Solver solver("demon_cost_test");
+  std::vector<std::string> log;
+  IntVar* const x = solver.MakeIntVar(0, 10, "x");
+  IntVar* const y = solver.MakeIntVar(0, 10, "y");
+  IntVar* const z = solver.MakeIntVar(0, 10, "z");
+  DemonCostConstraint* const constraint =
+      solver.RevAlloc(new DemonCostConstraint(&solver, x, y, z, &log));
+  solver.AddConstraint(constraint);
+  CHECK(solver.Solve(solver.RevAlloc(new ChangeBounds(constraint, &log))));
+  CHECK(log.empty());
+}
+
+// The default cost of a demon is LINEAR_DEMON.
+void TestDefaultCost() {
+  std::vector<std::string> log;
+  LoggingDemon demon("demon", Solver::DELAYED_PRIORITY, &log, nullptr);
+  CHECK_EQ(Solver::LINEAR_DEMON, demon.cost());
+}
+
+void RunAllTests() {
+  TestDelayedDemonOrder();
+  TestDefaultCost();
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
@@ -0,0 +1,255 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the dense LU used for the end of the Markowitz factorization, forced
+// on random and ill-conditioned matrices, with one or several threads: its
+// solves are compared with the ones of the sparse factorization, and a
+// singular residual matrix must be reported as such.
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "glop/lu_factorization.h"
+#include "glop/parameters.pb.h"
+#include "lp_data/lp_types.h"
+#include "lp_data/sparse.h"
+
+namespace operations_research {
+namespace glop {
+
+// Parameters of a factorization that switches to the dense LU as soon as the
+// residual matrix has min_size rows, or never.
+GlopParameters Parameters(bool dense, int num_threads) {
+  GlopParameters parameters;
+  if (dense) {
+    parameters.set_use_dense_lu_tail(true);
+    parameters.set_markowitz_dense_switch_density(0.0);
+    parameters.set_markowitz_dense_switch_min_size(8);
+    parameters.set_markowitz_dense_num_threads(num_threads);
+  }
+  return parameters;
+}
+
+bool UsedDenseLu(const LuFactorization& lu) {
+  return lu.StatString().find("dense_residual_size") != std::string::npos;
+}
+
+class DenseLuTest {
+ public:
+  DenseLuTest(int size, int seed) : size_(size), random_(seed) {}
+
+  // A random matrix with a few entries per column, plus a diagonal so that it
+  // is very likely non-singular. Its residual matrix after the singleton
+  // columns is large and fills in quickly.
+  void BuildRandomMatrix(int num_entries_per_column) {
+    matrix_.Clear();
+    matrix_.SetNumRows(RowIndex(size_));
+    for (int col = 0; col < size_; ++col) {
+      const ColIndex new_col = matrix_.AppendEmptyColumn();
+      SparseColumn* const column = matrix_.mutable_column(new_col);
+      column->SetCoefficient(RowIndex(col), random_.UniformDouble(1.0, 2.0));
+      for (int i = 0; i < num_entries_per_column; ++i) {
+        column->SetCoefficient(RowIndex(random_.Uniform(size_)),
+                               random_.UniformDouble(-1.0, 1.0));
+      }
+    }
+    matrix_.CleanUp();
+  }
+
+  // A random matrix whose rows and columns are scaled by factors spanning
+  // several orders of magnitude, and with pairs of almost equal columns.
+  void BuildIllConditionedMatrix() {
+    BuildRandomMatrix(6);
+    std::vector<Fractional> row_scales(size_);
+    for (int row = 0; row < size_; ++row) {
+      row_scales[row] = std::pow(10.0, random_.UniformDouble(-2.0, 2.0));
+    }
+    SparseMatrix scaled;
+    scaled.SetNumRows(RowIndex(size_));
+    for (ColIndex col(0); col < size_; ++col) {
+      const ColIndex new_col = scaled.AppendEmptyColumn();
+      SparseColumn* const column = scaled.mutable_column(new_col);
+      // Every fourth column is almost equal to the previous one.
+      const ColIndex source =
+          col.value() % 4 == 3 ? col - ColIndex(1) : col;
+      const Fractional col_scale =
+          std::pow(10.0, random_.UniformDouble(-2.0, 2.0));
+      for (const SparseColumn::Entry e : matrix_.column(source)) {
+        column->SetCoefficient(e.row(), e.coefficient() * col_scale *
+                                            row_scales[e.row().value()]);
+      }
+      if (source != col) {
+        column->SetCoefficient(
+            RowIndex(col.value()),
+            column->LookUpCoefficient(RowIndex(col.value())) + 1e-3);
+      }
+    }
+    matrix_.PopulateFromSparseMatrix(scaled);
+    matrix_.CleanUp();
+  }
+
+  // A random matrix with a column equal to the sum of two other ones, all of
+  // them in the dense part of the factorization.
+  void BuildSingularMatrix() {
+    BuildRandomMatrix(10);
+    SparseMatrix singular;
+    singular.SetNumRows(RowIndex(size_));
+    for (ColIndex col(0); col < size_; ++col) {
+      const ColIndex new_col = singular.AppendEmptyColumn();
+      SparseColumn* const column = singular.mutable_column(new_col);
+      if (col == size_ / 2) {
+        DenseColumn sum(RowIndex(size_), 0.0);
+        for (const ColIndex source : {ColIndex(1), ColIndex(size_ - 2)}) {
+          for (const SparseColumn::Entry e : matrix_.column(source)) {
+            sum[e.row()] += e.coefficient();
+          }
+        }
+        for (RowIndex row(0); row < size_; ++row) {
+          if (sum[row] != 0.0) column->SetCoefficient(row, sum[row]);
+        }
+      } else {
+        column->PopulateFromSparseVector(matrix_.column(col));
+      }
+    }
+    matrix_.PopulateFromSparseMatrix(singular);
+    matrix_.CleanUp();
+  }
+
+  // Factorizes the matrix with the sparse and the dense paths, and compares
+  // their right and left solves on random inputs. Their residuals are checked
+  // relatively to the magnitude of the solutions.
+  void CheckDenseSolvesMatchSparseSolves(int num_threads, double tolerance) {
+    MatrixView view;
+    view.PopulateFromMatrix(matrix_);
+    LuFactorization sparse;
+    sparse.SetParameters(Parameters(false, 1));
+    CHECK(sparse.ComputeFactorization(view).ok());
+    CHECK(!UsedDenseLu(sparse));
+    LuFactorization dense;
+    dense.SetParameters(Parameters(true, num_threads));
+    CHECK(dense.ComputeFactorization(view).ok());
+    CHECK(UsedDenseLu(dense));
+
+    for (int trial = 0; trial < 5; ++trial) {
+      DenseColumn rhs(RowIndex(size_), 0.0);
+      DenseRow row_rhs(ColIndex(size_), 0.0);
+      for (int i = 0; i < size_; ++i) {
+        rhs[RowIndex(i)] = random_.UniformDouble(-1.0, 1.0);
+        row_rhs[ColIndex(i)] = random_.UniformDouble(-1.0, 1.0);
+      }
+
+      DenseColumn x = rhs;
+      DenseColumn expected_x = rhs;
+      dense.RightSolve(&x);
+      sparse.RightSolve(&expected_x);
+      CheckClose(expected_x, x, tolerance);
+      CHECK_LE(RightResidual(x, rhs), tolerance * (1.0 + MaxMagnitude(x)));
+
+      DenseRow y = row_rhs;
+      DenseRow expected_y = row_rhs;
+      dense.LeftSolve(&y);
+      sparse.LeftSolve(&expected_y);
+      CheckClose(expected_y, y, tolerance);
+    }
+  }
+
+  // Both paths must report the singularity. The rounding errors leave pivots
+  // of the order of the machine precision instead of zeros, hence the larger
+  // singularity threshold.
+  void CheckSingularityIsReported(int num_threads) {
+    MatrixView view;
+    view.PopulateFromMatrix(matrix_);
+    GlopParameters sparse_parameters = Parameters(false, 1);
+    sparse_parameters.set_markowitz_singularity_threshold(1e-9);
+    LuFactorization sparse;
+    sparse.SetParameters(sparse_parameters);
+    CHECK(!sparse.ComputeFactorization(view).ok());
+    GlopParameters dense_parameters = Parameters(true, num_threads);
+    dense_parameters.set_markowitz_singularity_threshold(1e-9);
+    LuFactorization dense;
+    dense.SetParameters(dense_parameters);
+    CHECK(!dense.ComputeFactorization(view).ok());
+    CHECK(UsedDenseLu(dense));
+  }
+
+ private:
+  template <typename Vector>
+  static Fractional MaxMagnitude(const Vector& v) {
+    Fractional result = 0.0;
+    for (const Fractional value : v) result = std::max(result, std::abs(value));
+    return result;
+  }
+
+  template <typename Vector>
+  static void CheckClose(const Vector& expected, const Vector& actual,
+                         double tolerance) {
+    const Fractional scale = 1.0 + MaxMagnitude(expected);
+    for (int i = 0; i < expected.size(); ++i) {
+      CHECK_LE(std::abs(expected.data()[i] - actual.data()[i]),
+               tolerance * scale)
+          << "at " << i << ": " << expected.data()[i] << " vs "
+          << actual.data()[i];
+    }
+  }
+
+  // Returns the max norm of matrix_ * x - rhs.
+  Fractional RightResidual(const DenseColumn& x, const DenseColumn& rhs) {
+    DenseColumn product(RowIndex(size_), 0.0);
+    for (ColIndex col(0); col < size_; ++col) {
+      for (const SparseColumn::Entry e : matrix_.column(col)) {
+        product[e.row()] += e.coefficient() * x[ColToRowIndex(col)];
+      }
+    }
+    Fractional residual = 0.0;
+    for (RowIndex row(0); row < size_; ++row) {
+      residual = std::max(residual, std::abs(product[row] - rhs[row]));
+    }
+    return residual;
+  }
+
+  const int size_;
+  ACMRandom random_;
+  SparseMatrix matrix_;
+};
+
+void RunAllTests() {
+  for (int seed = 0; seed < 5; ++seed) {
+    for (const int num_threads : {1, 4}) {
+      // Large enough for several panels and several threads.
+      DenseLuTest test(300, seed);
+      test.BuildRandomMatrix(4);
+      test.CheckDenseSolvesMatchSparseSolves(num_threads, 1e-8);
+      test.BuildIllConditionedMatrix();
+      test.CheckDenseSolvesMatchSparseSolves(num_threads, 1e-4);
+      test.BuildSingularMatrix();
+      test.CheckSingularityIsReported(num_threads);
+    }
+  }
+  // A residual matrix smaller than one panel.
+  DenseLuTest small_test(40, 12345);
+  small_test.BuildRandomMatrix(3);
+  small_test.CheckDenseSolvesMatchSparseSolves(1, 1e-8);
+}
+
+}  // namespace glop
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::glop::RunAllTests();
+  return 0;
+}
@@ -0,0 +1,160 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the solves of a BasisFactorization updated with the Forrest-Tomlin
+// update against the solves of a freshly refactorized basis.
+
+#include <cmath>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "glop/basis_representation.h"
+#include "glop/parameters.pb.h"
+#include "lp_data/lp_types.h"
+#include "lp_data/sparse.h"
+
+namespace operations_research {
+namespace glop {
+
+class ForrestTomlinTest {
+ public:
+  explicit ForrestTomlinTest(int num_rows)
+      : num_rows_(num_rows), random_(12345) {}
+
+  // Builds a random sparse matrix [A | I] where the slack columns I form the
+  // initial basis.
+  void SetUp() {
+    matrix_.SetNumRows(RowIndex(num_rows_));
+    for (int col = 0; col < num_rows_; ++col) {
+      const ColIndex new_col = matrix_.AppendEmptyColumn();
+      SparseColumn* const column = matrix_.mutable_column(new_col);
+      for (int i = 0; i < 4; ++i) {
+        column->SetCoefficient(RowIndex(random_.Uniform(num_rows_)),
+                               random_.UniformDouble(-10.0, 10.0));
+      }
+    }
+    for (RowIndex row(0); row < num_rows_; ++row) {
+      matrix_.AppendUnitVector(row, 1.0);
+    }
+    matrix_.CleanUp();
+    matrix_view_.PopulateFromMatrix(matrix_);
+    basis_.clear();
+    is_basic_.assign(matrix_.num_cols().value(), false);
+    for (RowIndex row(0); row < num_rows_; ++row) {
+      basis_.push_back(ColIndex(num_rows_) + RowToColIndex(row));
+      is_basic_[num_rows_ + row.value()] = true;
+    }
+  }
+
+  // Performs 'num_updates' random basis changes on a factorization using the
+  // Forrest-Tomlin update, and regularly compares its solves with the ones of
+  // a factorization computed from scratch.
+  void TestUpdatesMatchRefactorization(int num_updates) {
+    SetUp();
+    GlopParameters parameters;
+    parameters.set_use_forrest_tomlin_update(true);
+    parameters.set_basis_refactorization_period(num_updates + 1);
+    BasisFactorization factorization(matrix_view_, basis_);
+    factorization.SetParameters(parameters);
+    CHECK(factorization.Initialize().ok());
+    CHECK(factorization.ForceRefactorization().ok());
+
+    int num_forrest_tomlin_updates = 0;
+    for (int update = 0; update < num_updates; ++update) {
+      // Picks a non-basic entering column and the leaving row with the largest
+      // pivot, as a simplex iteration with a stable ratio test would.
+      ColIndex entering_col;
+      do {
+        entering_col = ColIndex(random_.Uniform(matrix_.num_cols().value()));
+      } while (is_basic_[entering_col.value()]);
+      DenseColumn direction;
+      std::vector<RowIndex> non_zeros;
+      factorization.RightSolveForProblemColumn(entering_col, &direction,
+                                               &non_zeros);
+      RowIndex leaving_row(0);
+      for (RowIndex row(0); row < num_rows_; ++row) {
+        if (std::abs(direction[row]) > std::abs(direction[leaving_row])) {
+          leaving_row = row;
+        }
+      }
+      if (std::abs(direction[leaving_row]) < 1e-3) continue;
+
+      is_basic_[basis_[leaving_row].value()] = false;
+      is_basic_[entering_col.value()] = true;
+      basis_[leaving_row] = entering_col;
+      CHECK(factorization.Update(entering_col, leaving_row, non_zeros,
+                                 &direction).ok());
+      if (!factorization.IsRefactorized()) ++num_forrest_tomlin_updates;
+      if (update % 10 == 9) CheckSolves(factorization);
+    }
+    CheckSolves(factorization);
+    CHECK_GT(num_forrest_tomlin_updates, num_updates / 2);
+  }
+
+ private:
+  // Compares the right and left solves of 'factorization' on random inputs with
+  // the ones of a factorization of the same basis computed from scratch.
+  void CheckSolves(const BasisFactorization& factorization) {
+    BasisFactorization reference(matrix_view_, basis_);
+    reference.SetParameters(GlopParameters());
+    CHECK(reference.ForceRefactorization().ok());
+
+    DenseColumn rhs(RowIndex(num_rows_), 0.0);
+    DenseRow row_rhs(ColIndex(num_rows_), 0.0);
+    for (RowIndex row(0); row < num_rows_; ++row) {
+      if (random_.OneIn(3)) rhs[row] = random_.UniformDouble(-1.0, 1.0);
+      if (random_.OneIn(3)) {
+        row_rhs[RowToColIndex(row)] = random_.UniformDouble(-1.0, 1.0);
+      }
+    }
+
+    DenseColumn d = rhs;
+    DenseColumn expected_d = rhs;
+    factorization.RightSolve(&d);
+    reference.RightSolve(&expected_d);
+    for (RowIndex row(0); row < num_rows_; ++row) {
+      CHECK_LE(std::abs(expected_d[row] - d[row]),
+               1e-6 * (1.0 + std::abs(expected_d[row])));
+    }
+
+    DenseRow y = row_rhs;
+    DenseRow expected_y = row_rhs;
+    factorization.LeftSolve(&y);
+    reference.LeftSolve(&expected_y);
+    for (ColIndex col(0); col < num_rows_; ++col) {
+      CHECK_LE(std::abs(expected_y[col] - y[col]),
+               1e-6 * (1.0 + std::abs(expected_y[col])));
+    }
+  }
+
+  const int num_rows_;
+  ACMRandom random_;
+  SparseMatrix matrix_;
+  MatrixView matrix_view_;
+  RowToColMapping basis_;
+  std::vector<bool> is_basic_;
+};
+
+}  // namespace glop
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::glop::ForrestTomlinTest small_test(20);
+  small_test.TestUpdatesMatchRefactorization(15);
+  operations_research::glop::ForrestTomlinTest large_test(300);
+  large_test.TestUpdatesMatchRefactorization(150);
+  return 0;
+}
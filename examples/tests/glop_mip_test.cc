@@ -0,0 +1,149 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Solves small mixed integer programs with the Glop branch and bound, with and
+// without presolve, and checks the statuses and the optimal objective values.
+
+#include <cmath>
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "linear_solver/linear_solver.h"
+
+namespace operations_research {
+
+void CheckNear(double expected, double actual) {
+  CHECK_LE(std::abs(expected - actual), 1e-6 * (1.0 + std::abs(expected)))
+      << "expected " << expected << ", got " << actual;
+}
+
+MPSolver::ResultStatus Solve(bool presolve, MPSolver* solver) {
+  MPSolverParameters parameters;
+  parameters.SetIntegerParam(MPSolverParameters::PRESOLVE,
+                             presolve ? MPSolverParameters::PRESOLVE_ON
+                                      : MPSolverParameters::PRESOLVE_OFF);
+  return solver->Solve(parameters);
+}
+
+// A knapsack with general integer variables, whose linear relaxation is
+// fractional.
+void TestKnapsack(bool presolve) {
+  MPSolver solver("knapsack", MPSolver::GLOP_MIXED_INTEGER_PROGRAMMING);
+  MPVariable* const x = solver.MakeIntVar(0, 3, "x");
+  MPVariable* const y = solver.MakeIntVar(0, 3, "y");
+  MPVariable* const z = solver.MakeIntVar(0, 3, "z");
+  MPVariable* const w = solver.MakeIntVar(0, 3, "w");
+  MPConstraint* const capacity =
+      solver.MakeRowConstraint(-MPSolver::infinity(), 14.0);
+  capacity->SetCoefficient(x, 5);
+  capacity->SetCoefficient(y, 7);
+  capacity->SetCoefficient(z, 4);
+  capacity->SetCoefficient(w, 3);
+  MPObjective* const objective = solver.MutableObjective();
+  objective->SetCoefficient(x, 8);
+  objective->SetCoefficient(y, 11);
+  objective->SetCoefficient(z, 6);
+  objective->SetCoefficient(w, 4);
+  objective->SetMaximization();
+  CHECK_EQ(MPSolver::OPTIMAL, Solve(presolve, &solver));
+  CheckNear(22.0, objective->Value());
+  CHECK_LE(5 * x->solution_value() + 7 * y->solution_value() +
+               4 * z->solution_value() + 3 * w->solution_value(),
+           14.0 + 1e-6);
+}
+
+// A minimization with negative bounds, an equality constraint and a
+// continuous variable. The optimum is x = -3, y = 4, z = 5, u = 2.5.
+void TestMixedModel(bool presolve) {
+  MPSolver solver("mixed", MPSolver::GLOP_MIXED_INTEGER_PROGRAMMING);
+  MPVariable* const x = solver.MakeIntVar(-5, 5, "x");
+  MPVariable* const y = solver.MakeIntVar(-5, 5, "y");
+  MPVariable* const z = solver.MakeIntVar(-5, 5, "z");
+  MPVariable* const u = solver.MakeNumVar(0, 10, "u");
+  MPConstraint* const equality = solver.MakeRowConstraint(4.0, 4.0);
+  equality->SetCoefficient(x, 1);
+  equality->SetCoefficient(y, -2);
+  equality->SetCoefficient(z, 3);
+  MPConstraint* const covering =
+      solver.MakeRowConstraint(3.5, MPSolver::infinity());
+  covering->SetCoefficient(x, 2);
+  covering->SetCoefficient(y, 3);
+  covering->SetCoefficient(z, -1);
+  covering->SetCoefficient(u, 1);
+  MPConstraint* const sum = solver.MakeRowConstraint(-MPSolver::infinity(), 6);
+  sum->SetCoefficient(x, 1);
+  sum->SetCoefficient(y, 1);
+  sum->SetCoefficient(z, 1);
+  MPObjective* const objective = solver.MutableObjective();
+  objective->SetCoefficient(x, 3);
+  objective->SetCoefficient(y, -2);
+  objective->SetCoefficient(z, 4);
+  objective->SetCoefficient(u, 1);
+  objective->SetMinimization();
+  CHECK_EQ(MPSolver::OPTIMAL, Solve(presolve, &solver));
+  CheckNear(5.5, objective->Value());
+  CheckNear(4.0, x->solution_value() - 2 * y->solution_value() +
+                     3 * z->solution_value());
+  CheckNear(2.5, u->solution_value());
+}
+
+// 2x + 2y = 3 has real solutions but no integer one.
+void TestInfeasible(bool presolve) {
+  MPSolver solver("infeasible", MPSolver::GLOP_MIXED_INTEGER_PROGRAMMING);
+  MPVariable* const x = solver.MakeIntVar(0, 5, "x");
+  MPVariable* const y = solver.MakeIntVar(0, 5, "y");
+  MPConstraint* const ct = solver.MakeRowConstraint(3.0, 3.0);
+  ct->SetCoefficient(x, 2);
+  ct->SetCoefficient(y, 2);
+  solver.MutableObjective()->SetCoefficient(x, 1);
+  CHECK_EQ(MPSolver::INFEASIBLE, Solve(presolve, &solver));
+}
+
+// An integer variable whose bounds do not contain any integer.
+void TestEmptyIntegerDomain(bool presolve) {
+  MPSolver solver("empty", MPSolver::GLOP_MIXED_INTEGER_PROGRAMMING);
+  MPVariable* const x = solver.MakeIntVar(0.3, 0.7, "x");
+  solver.MutableObjective()->SetCoefficient(x, 1);
+  CHECK_EQ(MPSolver::INFEASIBLE, Solve(presolve, &solver));
+}
+
+// The linear relaxation of max x s.t. x - y <= 0.5 is unbounded.
+void TestUnboundedRelaxation(bool presolve) {
+  MPSolver solver("unbounded", MPSolver::GLOP_MIXED_INTEGER_PROGRAMMING);
+  MPVariable* const x = solver.MakeIntVar(0, MPSolver::infinity(), "x");
+  MPVariable* const y = solver.MakeNumVar(0, MPSolver::infinity(), "y");
+  MPConstraint* const ct = solver.MakeRowConstraint(-MPSolver::infinity(), 0.5);
+  ct->SetCoefficient(x, 1);
+  ct->SetCoefficient(y, -1);
+  solver.MutableObjective()->SetCoefficient(x, 1);
+  solver.MutableObjective()->SetMaximization();
+  CHECK_EQ(MPSolver::UNBOUNDED, Solve(presolve, &solver));
+}
+
+void RunAllTests() {
+  for (const bool presolve : {false, true}) {
+    TestKnapsack(presolve);
+    TestMixedModel(presolve);
+    TestInfeasible(presolve);
+    TestEmptyIntegerDomain(presolve);
+    TestUnboundedRelaxation(presolve);
+  }
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
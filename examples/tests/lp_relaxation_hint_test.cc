@@ -0,0 +1,242 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the solution hints: FindSolutionHintFromLpRelaxation() must return a
+// feasible hint found by rounding or by its fix-and-propagate dive, and no hint
+// when an integer variable has no integer value in its bounds. The hints given
+// to BranchAndBound::SetSolutionHint() must only be used if they are feasible.
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "glop/branch_and_bound.h"
+#include "glop/parameters.pb.h"
+#include "linear_solver/linear_solver.h"
+#include "linear_solver/linear_solver.pb.h"
+#include "linear_solver/lp_relaxation_hint.h"
+#include "linear_solver/model_validator.h"
+#include "lp_data/lp_data.h"
+#include "lp_data/lp_types.h"
+
+DECLARE_bool(mpsolver_lp_relaxation_hint);
+
+namespace operations_research {
+
+void AddVariable(double lb, double ub, double objective, bool is_integer,
+                 MPModelProto* model) {
+  MPVariableProto* const variable = model->add_variable();
+  variable->set_lower_bound(lb);
+  variable->set_upper_bound(ub);
+  variable->set_objective_coefficient(objective);
+  variable->set_is_integer(is_integer);
+}
+
+void AddConstraint(double lb, double ub, const std::vector<int>& var_indices,
+                   const std::vector<double>& coefficients,
+                   MPModelProto* model) {
+  MPConstraintProto* const constraint = model->add_constraint();
+  constraint->set_lower_bound(lb);
+  constraint->set_upper_bound(ub);
+  for (int k = 0; k < var_indices.size(); ++k) {
+    constraint->add_var_index(var_indices[k]);
+    constraint->add_coefficient(coefficients[k]);
+  }
+}
+
+// Returns the hint found for the model, after checking that it has one value
+// per variable, in order.
+std::vector<double> FindHint(const MPModelProto& model) {
+  CHECK_EQ("", FindErrorInMPModelProto(model));
+  PartialVariableAssignment hint;
+  CHECK(FindSolutionHintFromLpRelaxation(model, 10.0, &hint));
+  CHECK_EQ(model.variable_size(), hint.var_index_size());
+  CHECK_EQ(model.variable_size(), hint.var_value_size());
+  std::vector<double> values;
+  for (int i = 0; i < hint.var_index_size(); ++i) {
+    CHECK_EQ(i, hint.var_index(i));
+    values.push_back(hint.var_value(i));
+  }
+  return values;
+}
+
+// The relaxation of max 2 x + y, x + y <= 3.2 with x <= 2 has the unique
+// optimum (2, 1.2), which rounds to a feasible solution.
+void TestHintFoundByRounding() {
+  MPModelProto model;
+  model.set_maximize(true);
+  AddVariable(0.0, 2.0, 2.0, true, &model);
+  AddVariable(0.0, 10.0, 1.0, true, &model);
+  AddConstraint(-MPSolver::infinity(), 3.2, {0, 1}, {1.0, 1.0}, &model);
+  const std::vector<double> hint = FindHint(model);
+  CHECK_EQ(2.0, hint[0]);
+  CHECK_EQ(1.0, hint[1]);
+}
+
+// The relaxation of max 1.2 x + y + 0.1 z, x + y <= 1.5, x + z <= 2 with x, y
+// binary and z continuous in [0, 10] has the unique optimum (1, 0.5, 1),
+// whose rounding (1, 1, 1) violates the first constraint. The dive fixes x to
+// 1 first, which propagates y to 0, and z is then set by the linear program.
+void TestHintFoundByDive() {
+  MPModelProto model;
+  model.set_maximize(true);
+  AddVariable(0.0, 1.0, 1.2, true, &model);
+  AddVariable(0.0, 1.0, 1.0, true, &model);
+  AddVariable(0.0, 10.0, 0.1, false, &model);
+  AddConstraint(-MPSolver::infinity(), 1.5, {0, 1}, {1.0, 1.0}, &model);
+  AddConstraint(-MPSolver::infinity(), 2.0, {0, 2}, {1.0, 1.0}, &model);
+  const std::vector<double> hint = FindHint(model);
+  CHECK_EQ(1.0, hint[0]);
+  CHECK_EQ(0.0, hint[1]);
+  CHECK_LE(std::abs(hint[2] - 1.0), 1e-9);
+}
+
+// The integer variable x in [0, 5] must satisfy 0.6 <= 2 x - y <= 1.4 with y
+// fixed to 0 by its bounds: the relaxation is feasible, but the propagation of
+// the constraint empties the domain of x, and no hint must be returned. Solving
+// the model with the generated hints enabled must prove it infeasible.
+void TestEmptyIntegerDomain() {
+  MPModelProto model;
+  model.set_maximize(true);
+  AddVariable(0.0, 5.0, 1.0, true, &model);
+  AddVariable(0.0, 0.0, 1.0, true, &model);
+  AddVariable(0.0, 5.0, 1.0, true, &model);
+  AddConstraint(0.6, 1.4, {0, 1}, {2.0, -1.0}, &model);
+  AddConstraint(-MPSolver::infinity(), 3.5, {0, 2}, {1.0, 1.0}, &model);
+  CHECK_EQ("", FindErrorInMPModelProto(model));
+  PartialVariableAssignment hint;
+  CHECK(!FindSolutionHintFromLpRelaxation(model, 10.0, &hint));
+  CHECK_EQ(0, hint.var_index_size());
+
+  FLAGS_mpsolver_lp_relaxation_hint = true;
+  MPModelRequest request;
+  *request.mutable_model() = model;
+  request.set_solver_type(MPModelRequest::GLOP_MIXED_INTEGER_PROGRAMMING);
+  MPSolutionResponse response;
+  MPSolver::SolveWithProto(request, &response);
+  CHECK_EQ(MPSOLVER_INFEASIBLE, response.status());
+  FLAGS_mpsolver_lp_relaxation_hint = false;
+
+  // Bounds without any integer, like [0.3, 0.7], are reported by
+  // FindErrorInMPModelProto(), but the heuristic must not rely on it: the
+  // domain of x is emptied by the rounding of its bounds, and x must not be
+  // fixed outside of it, even if no constraint propagates it.
+  MPModelProto empty_bounds_model;
+  empty_bounds_model.set_maximize(true);
+  AddVariable(0.3, 0.7, 1.0, true, &empty_bounds_model);
+  AddVariable(0.0, 5.0, 1.0, true, &empty_bounds_model);
+  AddConstraint(-MPSolver::infinity(), 3.5, {1}, {1.0}, &empty_bounds_model);
+  CHECK(!FindSolutionHintFromLpRelaxation(empty_bounds_model, 10.0, &hint));
+  CHECK_EQ(0, hint.var_index_size());
+}
+
+namespace glop {
+
+// max 5 x0 + 4 x1 + 3 x2, 2 x0 + 3 x1 + x2 <= 5, 4 x0 + x1 + 2 x2 <= 11,
+// 3 x0 + 4 x1 + 2 x2 <= 8, with integer variables in [0, 10]. Its optimum is
+// (2, 0, 1), of value 13.
+void BuildMip(LinearProgram* lp) {
+  const Fractional kInfinity = std::numeric_limits<Fractional>::infinity();
+  lp->Clear();
+  lp->SetMaximizationProblem(true);
+  const Fractional kObjective[] = {5.0, 4.0, 3.0};
+  const Fractional kCoefficients[3][3] = {
+      {2.0, 3.0, 1.0}, {4.0, 1.0, 2.0}, {3.0, 4.0, 2.0}};
+  const Fractional kUpperBounds[] = {5.0, 11.0, 8.0};
+  for (int j = 0; j < 3; ++j) {
+    const ColIndex col = lp->CreateNewVariable();
+    lp->SetVariableBounds(col, 0.0, 10.0);
+    lp->SetVariableIntegrality(col, true);
+    lp->SetObjectiveCoefficient(col, kObjective[j]);
+  }
+  for (int i = 0; i < 3; ++i) {
+    const RowIndex row = lp->CreateNewConstraint();
+    lp->SetConstraintBounds(row, -kInfinity, kUpperBounds[i]);
+    for (int j = 0; j < 3; ++j) {
+      lp->SetCoefficient(row, ColIndex(j), kCoefficients[i][j]);
+    }
+  }
+}
+
+DenseRow MakeRow(const std::vector<Fractional>& values) {
+  DenseRow row(ColIndex(values.size()), 0.0);
+  for (int j = 0; j < values.size(); ++j) row[ColIndex(j)] = values[j];
+  return row;
+}
+
+// Solves the lp with the given hint and node limit, and returns the status.
+ProblemStatus SolveWithHint(const LinearProgram& lp, const DenseRow& hint,
+                            int64 max_num_nodes, BranchAndBound* solver) {
+  GlopParameters parameters;
+  parameters.set_mip_max_number_of_nodes(max_num_nodes);
+  solver->SetParameters(parameters);
+  solver->SetSolutionHint(hint);
+  return solver->Solve(lp);
+}
+
+void TestBranchAndBoundHint() {
+  LinearProgram lp;
+  BuildMip(&lp);
+
+  // Without any node, the feasible hint is the solution.
+  const DenseRow feasible_hint = MakeRow({1.0, 1.0, 0.0});
+  BranchAndBound solver;
+  CHECK_EQ(ProblemStatus::PRIMAL_FEASIBLE,
+           SolveWithHint(lp, feasible_hint, 0, &solver));
+  CHECK_EQ(9.0, solver.objective_value());
+  for (ColIndex col(0); col < 3; ++col) {
+    CHECK_EQ(feasible_hint[col], solver.variable_values()[col]);
+  }
+
+  // Hints violating a constraint, a bound or the integrality, or of the wrong
+  // size, are ignored, even the first one whose objective is better than the
+  // optimum.
+  const std::vector<DenseRow> ignored_hints = {
+      MakeRow({3.0, 0.0, 0.0}), MakeRow({-1.0, 0.0, 5.0}),
+      MakeRow({2.5, 0.0, 0.0}), MakeRow({2.0, 0.0, 1.0, 0.0}),
+      MakeRow({2.0, 0.0})};
+  for (const DenseRow& hint : ignored_hints) {
+    BranchAndBound solver;
+    CHECK_EQ(ProblemStatus::INIT, SolveWithHint(lp, hint, 0, &solver));
+    CHECK_EQ(ProblemStatus::OPTIMAL, SolveWithHint(lp, hint, -1, &solver));
+    CHECK_EQ(13.0, solver.objective_value());
+    CHECK_EQ(2.0, solver.variable_values()[ColIndex(0)]);
+    CHECK_EQ(0.0, solver.variable_values()[ColIndex(1)]);
+    CHECK_EQ(1.0, solver.variable_values()[ColIndex(2)]);
+  }
+
+  // An empty hint clears the previous one.
+  CHECK_EQ(ProblemStatus::PRIMAL_FEASIBLE,
+           SolveWithHint(lp, feasible_hint, 0, &solver));
+  CHECK_EQ(ProblemStatus::INIT, SolveWithHint(lp, DenseRow(), 0, &solver));
+}
+
+}  // namespace glop
+
+void RunAllTests() {
+  TestHintFoundByRounding();
+  TestHintFoundByDive();
+  TestEmptyIntegerDomain();
+  glop::TestBranchAndBoundHint();
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
@@ -0,0 +1,231 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the validation of large models with several threads, which must
+// report the same first error as the serial validation, and the exports of
+// models to a MPModelExportSink, which must output the same bytes as the
+// exports to a string.
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/join.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "linear_solver/linear_solver.h"
+#include "linear_solver/linear_solver.pb.h"
+#include "linear_solver/model_exporter.h"
+#include "linear_solver/model_validator.h"
+
+namespace operations_research {
+
+// A random model with the given number of constraints of 'num_terms_per_row'
+// terms each, large enough to be validated in several chunks.
+MPModelProto BuildModel(int num_vars, int num_constraints,
+                        int num_terms_per_row, int seed) {
+  ACMRandom random(seed);
+  MPModelProto model;
+  model.set_name("model_validator_test");
+  for (int j = 0; j < num_vars; ++j) {
+    MPVariableProto* const variable = model.add_variable();
+    variable->set_name(StrCat("x", j));
+    variable->set_lower_bound(0.0);
+    variable->set_upper_bound(1 + random.Uniform(10));
+    variable->set_objective_coefficient(random.Uniform(20));
+    variable->set_is_integer(random.OneIn(3));
+  }
+  for (int i = 0; i < num_constraints; ++i) {
+    MPConstraintProto* const constraint = model.add_constraint();
+    constraint->set_name(StrCat("c", i));
+    constraint->set_lower_bound(-MPSolver::infinity());
+    constraint->set_upper_bound(10 + random.Uniform(100));
+    // Consecutive variables, so that none appears twice in a row.
+    const int first_var = random.Uniform(num_vars - num_terms_per_row);
+    for (int k = 0; k < num_terms_per_row; ++k) {
+      constraint->add_var_index(first_var + k);
+      constraint->add_coefficient(1 + random.Uniform(9));
+    }
+  }
+  return model;
+}
+
+// Checks that the validation with several threads returns the error of the
+// serial one, which must contain the expected error.
+void CheckSameError(const MPModelProto& model, const std::string& expected) {
+  const std::string serial_error = FindErrorInMPModelProto(model);
+  CHECK_EQ(serial_error, FindErrorInMPModelProto(model, 1));
+  CHECK_NE(std::string::npos, serial_error.find(expected)) << serial_error;
+  for (const int num_threads : {2, 4, 8}) {
+    CHECK_EQ(serial_error, FindErrorInMPModelProto(model, num_threads))
+        << num_threads << " threads";
+  }
+}
+
+void TestParallelValidation() {
+  // 4000 constraints of 50 terms: about 200000 terms, i.e. several chunks.
+  const int kNumConstraints = 4000;
+  const MPModelProto valid_model = BuildModel(200, kNumConstraints, 50, 1);
+  CheckSameError(valid_model, "");
+  CHECK(FindErrorInMPModelProto(valid_model).empty());
+
+  // Invalid constraints at various positions: the first one must be reported,
+  // even when a later chunk is found invalid first.
+  const std::vector<std::vector<int>> kInvalidConstraints = {
+      {0}, {kNumConstraints - 1}, {10, 2000, 3999}, {3999, 1500, 1400},
+      {1300, 1301}};
+  for (const std::vector<int>& invalid_constraints : kInvalidConstraints) {
+    MPModelProto model = valid_model;
+    int first_invalid = kNumConstraints;
+    for (const int i : invalid_constraints) {
+      model.mutable_constraint(i)->set_coefficient(
+          3, std::numeric_limits<double>::quiet_NaN());
+      first_invalid = std::min(first_invalid, i);
+    }
+    CheckSameError(model, StrCat("In constraint #", first_invalid, ": "));
+  }
+
+  // The first constraint is invalid, and so is a constraint in the middle of
+  // each of the other chunks, which are validated while the first chunk is
+  // found invalid: their errors must not replace the first one.
+  const MPModelProto large_model = BuildModel(200, 20000, 50, 2);
+  for (int repeat = 0; repeat < 10; ++repeat) {
+    MPModelProto model = large_model;
+    for (int i = 0; i < model.constraint_size(); i += 997) {
+      model.mutable_constraint(i)->set_coefficient(
+          3, std::numeric_limits<double>::quiet_NaN());
+    }
+    CheckSameError(model, "In constraint #0: ");
+  }
+
+  // Other kinds of errors in the constraints, and errors found before or after
+  // the validation of the constraints.
+  MPModelProto model = valid_model;
+  model.mutable_constraint(2500)->set_var_index(7, 200);
+  model.mutable_constraint(3000)->set_var_index(
+      8, model.constraint(3000).var_index(9));
+  CheckSameError(model, "In constraint #2500: ");
+  model.mutable_constraint(1000)->set_lower_bound(MPSolver::infinity());
+  CheckSameError(model, "In constraint #1000: ");
+  model.mutable_variable(5)->set_lower_bound(
+      std::numeric_limits<double>::quiet_NaN());
+  CheckSameError(model, "In variable #5: ");
+
+  model = valid_model;
+  model.mutable_solution_hint()->add_var_index(200);
+  model.mutable_solution_hint()->add_var_value(1.0);
+  CheckSameError(model, "In solution_hint(): ");
+}
+
+// A sink appending the output to a string, which can be made to fail after a
+// given number of calls.
+class StringSink : public MPModelExportSink {
+ public:
+  explicit StringSink(int max_num_appends)
+      : max_num_appends_(max_num_appends), num_appends_(0) {}
+
+  bool Append(const char* data, size_t size) override {
+    if (num_appends_ == max_num_appends_) return false;
+    ++num_appends_;
+    output_.append(data, size);
+    return true;
+  }
+
+  const std::string& output() const { return output_; }
+  int num_appends() const { return num_appends_; }
+
+ private:
+  const int max_num_appends_;
+  int num_appends_;
+  std::string output_;
+};
+
+// Checks that the exports of the model to a sink output the same bytes as the
+// exports to a string, in all the formats. Returns the minimum number of calls
+// to Append() of the exports.
+int CheckSameExports(const MPModelProto& model) {
+  MPModelProtoExporter exporter(model);
+  int min_num_appends = std::numeric_limits<int>::max();
+  for (const bool obfuscated : {false, true}) {
+    std::string expected;
+    CHECK(exporter.ExportModelAsLpFormat(obfuscated, &expected));
+    StringSink sink(std::numeric_limits<int>::max());
+    CHECK(exporter.ExportModelAsLpFormat(obfuscated, &sink));
+    CHECK(expected == sink.output()) << "LP, obfuscated: " << obfuscated;
+    min_num_appends = std::min(min_num_appends, sink.num_appends());
+
+    for (const bool fixed_format : {false, true}) {
+      std::string expected;
+      CHECK(exporter.ExportModelAsMpsFormat(fixed_format, obfuscated,
+                                            &expected));
+      StringSink sink(std::numeric_limits<int>::max());
+      CHECK(exporter.ExportModelAsMpsFormat(fixed_format, obfuscated, &sink));
+      CHECK(expected == sink.output())
+          << "MPS, fixed format: " << fixed_format
+          << ", obfuscated: " << obfuscated;
+      min_num_appends = std::min(min_num_appends, sink.num_appends());
+    }
+  }
+  return min_num_appends;
+}
+
+void TestExportSinks() {
+  // A small model, output in a single call to Append().
+  const MPModelProto small_model = BuildModel(20, 10, 5, 2);
+  CHECK_EQ(1, CheckSameExports(small_model));
+
+  // A model whose exports are larger than the buffer of the exporter, output
+  // in several calls to Append().
+  const MPModelProto large_model = BuildModel(1000, 4000, 50, 3);
+  CHECK_GT(CheckSameExports(large_model), 1);
+
+  // The exports through MPSolver.
+  MPSolver solver("model_validator_test", MPSolver::GLOP_LINEAR_PROGRAMMING);
+  std::string error;
+  CHECK_EQ(MPSOLVER_MODEL_IS_VALID,
+           solver.LoadModelFromProto(large_model, &error))
+      << error;
+  std::string expected;
+  CHECK(solver.ExportModelAsLpFormat(false, &expected));
+  StringSink lp_sink(std::numeric_limits<int>::max());
+  CHECK(solver.ExportModelAsLpFormat(false, &lp_sink));
+  CHECK(expected == lp_sink.output());
+  CHECK(solver.ExportModelAsMpsFormat(false, false, &expected));
+  StringSink mps_sink(std::numeric_limits<int>::max());
+  CHECK(solver.ExportModelAsMpsFormat(false, false, &mps_sink));
+  CHECK(expected == mps_sink.output());
+
+  // A failure of the sink, on the first or on a later call, fails the export.
+  MPModelProtoExporter exporter(large_model);
+  for (const int max_num_appends : {0, 1}) {
+    StringSink failing_lp_sink(max_num_appends);
+    CHECK(!exporter.ExportModelAsLpFormat(false, &failing_lp_sink));
+    StringSink failing_mps_sink(max_num_appends);
+    CHECK(!exporter.ExportModelAsMpsFormat(false, false, &failing_mps_sink));
+  }
+}
+
+void RunAllTests() {
+  TestParallelValidation();
+  TestExportSinks();
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
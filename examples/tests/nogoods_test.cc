@@ -0,0 +1,206 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests of the nogood managers: the propagation of the watched nogoods, the
+// deletion of the least active ones, and the solutions of random problems
+// compared with the naive manager and with a brute force enumeration.
+
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "constraint_solver/constraint_solver.h"
+
+namespace operations_research {
+
+// A nogood x == a && y == b && z == c.
+NoGood* MakeEqualNoGood(NoGoodManager* const manager, IntVar* const x,
+                        int64 a, IntVar* const y, int64 b, IntVar* const z,
+                        int64 c) {
+  NoGood* const nogood = manager->MakeNoGood();
+  nogood->AddIntegerVariableEqualValueTerm(x, a);
+  nogood->AddIntegerVariableEqualValueTerm(y, b);
+  nogood->AddIntegerVariableEqualValueTerm(z, c);
+  return nogood;
+}
+
+// Binds x and y and checks whether z can still take the given value.
+class BindAndCheck : public DecisionBuilder {
+ public:
+  BindAndCheck(IntVar* const x, int64 a, IntVar* const y, int64 b,
+               IntVar* const z, int64 c, bool expected_in_domain)
+      : x_(x),
+        a_(a),
+        y_(y),
+        b_(b),
+        z_(z),
+        c_(c),
+        expected_in_domain_(expected_in_domain) {}
+  ~BindAndCheck() override {}
+
+  Decision* Next(Solver* const s) override {
+    x_->SetValue(a_);
+    y_->SetValue(b_);
+    CHECK_EQ(expected_in_domain_, z_->Contains(c_));
+    return nullptr;
+  }
+
+ private:
+  IntVar* const x_;
+  const int64 a_;
+  IntVar* const y_;
+  const int64 b_;
+  IntVar* const z_;
+  const int64 c_;
+  const bool expected_in_domain_;
+};
+
+// Binding x moves its watch to the z term, binding y then refutes z == c.
+void TestWatchedNoGoodPropagates() {
+  Solver solver("watch");
+  IntVar* const x = solver.MakeIntVar(0, 3, "x");
+  IntVar* const y = solver.MakeIntVar(0, 3, "y");
+  IntVar* const z = solver.MakeIntVar(0, 3, "z");
+  NoGoodManager* const manager = solver.MakeWatchedNoGoodManager(10);
+  manager->AddNoGood(MakeEqualNoGood(manager, x, 1, y, 2, z, 3));
+  CHECK(solver.Solve(
+      solver.RevAlloc(new BindAndCheck(x, 1, y, 2, z, 3, false)), manager));
+  CHECK(solver.Solve(
+      solver.RevAlloc(new BindAndCheck(x, 1, y, 1, z, 3, true)), manager));
+}
+
+// With at most 4 nogoods, adding a fifth one deletes the 3 least active ones
+// at the next root node. The nogood that propagated in the first search, and
+// the most recent one, have the highest activities and are kept.
+void TestInactiveNoGoodsAreDeleted() {
+  Solver solver("deletion");
+  IntVar* const x = solver.MakeIntVar(0, 3, "x");
+  IntVar* const y = solver.MakeIntVar(0, 3, "y");
+  IntVar* const z = solver.MakeIntVar(0, 3, "z");
+  NoGoodManager* const manager = solver.MakeWatchedNoGoodManager(4);
+  manager->AddNoGood(MakeEqualNoGood(manager, x, 1, y, 2, z, 3));
+  for (int value = 0; value < 3; ++value) {
+    manager->AddNoGood(MakeEqualNoGood(manager, x, value, y, value, z, value));
+  }
+  CHECK(solver.Solve(
+      solver.RevAlloc(new BindAndCheck(x, 1, y, 2, z, 3, false)), manager));
+  CHECK_EQ(4, manager->NoGoodCount());
+
+  manager->AddNoGood(MakeEqualNoGood(manager, x, 3, y, 3, z, 0));
+  CHECK(solver.Solve(
+      solver.RevAlloc(new BindAndCheck(x, 1, y, 2, z, 3, false)), manager));
+  CHECK_EQ(2, manager->NoGoodCount());
+  CHECK(solver.Solve(
+      solver.RevAlloc(new BindAndCheck(x, 3, y, 3, z, 0, false)), manager));
+  for (int value = 0; value < 3; ++value) {
+    CHECK(solver.Solve(
+        solver.RevAlloc(new BindAndCheck(x, value, y, value, z, value, true)),
+        manager));
+  }
+}
+
+// One term of a random nogood.
+struct Term {
+  int var;
+  int64 value;
+  bool equal;
+};
+
+bool IsForbidden(const std::vector<Term>& nogood,
+                 const std::vector<int64>& values) {
+  for (const Term& term : nogood) {
+    if ((values[term.var] == term.value) != term.equal) return false;
+  }
+  return true;
+}
+
+// Counts the solutions of random nogoods over a few variables with the given
+// manager, which must agree with the brute force count.
+void TestRandomNoGoods(bool watched, int seed) {
+  const int kNumVars = 5;
+  const int kDomainSize = 3;
+  ACMRandom random(seed);
+  std::vector<std::vector<Term>> nogoods(20);
+  for (std::vector<Term>& nogood : nogoods) {
+    const int size = 1 + random.Uniform(4);
+    for (int i = 0; i < size; ++i) {
+      nogood.push_back({random.Uniform(kNumVars), random.Uniform(kDomainSize),
+                        !random.OneIn(4)});
+    }
+  }
+
+  int expected_count = 0;
+  std::vector<int64> values(kNumVars, 0);
+  while (true) {
+    bool forbidden = false;
+    for (const std::vector<Term>& nogood : nogoods) {
+      forbidden |= IsForbidden(nogood, values);
+    }
+    if (!forbidden) ++expected_count;
+    int var = 0;
+    while (var < kNumVars && values[var] == kDomainSize - 1) values[var++] = 0;
+    if (var == kNumVars) break;
+    ++values[var];
+  }
+
+  Solver solver("random_nogoods");
+  std::vector<IntVar*> vars;
+  solver.MakeIntVarArray(kNumVars, 0, kDomainSize - 1, "x", &vars);
+  NoGoodManager* const manager = watched
+                                     ? solver.MakeWatchedNoGoodManager(100)
+                                     : solver.MakeNoGoodManager();
+  for (const std::vector<Term>& terms : nogoods) {
+    NoGood* const nogood = manager->MakeNoGood();
+    for (const Term& term : terms) {
+      if (term.equal) {
+        nogood->AddIntegerVariableEqualValueTerm(vars[term.var], term.value);
+      } else {
+        nogood->AddIntegerVariableNotEqualValueTerm(vars[term.var],
+                                                    term.value);
+      }
+    }
+    manager->AddNoGood(nogood);
+  }
+  solver.NewSearch(solver.MakePhase(vars, Solver::CHOOSE_FIRST_UNBOUND,
+                                    Solver::ASSIGN_MIN_VALUE),
+                   manager);
+  int count = 0;
+  while (solver.NextSolution()) {
+    for (int var = 0; var < kNumVars; ++var) values[var] = vars[var]->Value();
+    for (const std::vector<Term>& nogood : nogoods) {
+      CHECK(!IsForbidden(nogood, values));
+    }
+    ++count;
+  }
+  solver.EndSearch();
+  CHECK_EQ(expected_count, count);
+}
+
+void RunAllTests() {
+  TestWatchedNoGoodPropagates();
+  TestInactiveNoGoodsAreDeleted();
+  for (int seed = 0; seed < 20; ++seed) {
+    TestRandomNoGoods(false, seed);
+    TestRandomNoGoods(true, seed);
+  }
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
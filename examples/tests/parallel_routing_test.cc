@@ -0,0 +1,217 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks RoutingModel::SolveInParallelWithParameters() on a small random
+// capacitated vehicle routing problem solved by three workers: the returned
+// assignment must be feasible and as good as the best solution found by the
+// workers, also when this solution was found by a worker other than the
+// calling model and must be replayed in it. Closed models must be rejected.
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "constraint_solver/routing.h"
+
+namespace operations_research {
+
+// Random customers in a square with random demands, served from node 0.
+class CvrpData {
+ public:
+  CvrpData(int num_nodes, int seed)
+      : x_(num_nodes), y_(num_nodes), demand_(num_nodes, 0) {
+    ACMRandom random(seed);
+    for (int node = 0; node < num_nodes; ++node) {
+      x_[node] = random.Uniform(100);
+      y_[node] = random.Uniform(100);
+      if (node > 0) demand_[node] = 1 + random.Uniform(9);
+    }
+  }
+
+  int64 Distance(RoutingModel::NodeIndex from, RoutingModel::NodeIndex to) {
+    return std::abs(x_[from.value()] - x_[to.value()]) +
+           std::abs(y_[from.value()] - y_[to.value()]);
+  }
+  int64 Demand(RoutingModel::NodeIndex from, RoutingModel::NodeIndex to) {
+    return demand_[from.value()];
+  }
+
+ private:
+  std::vector<int64> x_;
+  std::vector<int64> y_;
+  std::vector<int64> demand_;
+};
+
+const int kNumNodes = 30;
+const int kNumVehicles = 6;
+const int64 kCapacity = 40;
+
+// Records the cost of the best solution found by the search of a model.
+class BestCostRecorder : public SearchMonitor {
+ public:
+  BestCostRecorder(RoutingModel* const model, int64* const best_cost)
+      : SearchMonitor(model->solver()), model_(model), best_cost_(best_cost) {}
+  bool AtSolution() override {
+    *best_cost_ = std::min(*best_cost_, model_->CostVar()->Min());
+    return false;
+  }
+  std::string DebugString() const override { return "BestCostRecorder"; }
+
+ private:
+  RoutingModel* const model_;
+  int64* const best_cost_;
+};
+
+// Fails at the root of the first search of a model, which thus finds no
+// solution; the following searches, such as the replay of a solution, are
+// left unchanged.
+class FirstSearchFailer : public SearchMonitor {
+ public:
+  explicit FirstSearchFailer(Solver* const solver)
+      : SearchMonitor(solver), num_searches_(0) {}
+  void EnterSearch() override { ++num_searches_; }
+  void BeginNextDecision(DecisionBuilder* const b) override {
+    if (num_searches_ == 1) solver()->Fail();
+  }
+  std::string DebugString() const override { return "FirstSearchFailer"; }
+
+ private:
+  int num_searches_;
+};
+
+// A model of the problem, with its own callbacks, the best cost found by its
+// search being recorded in best_cost.
+std::unique_ptr<RoutingModel> BuildModel(CvrpData* const data,
+                                         int64* const best_cost) {
+  std::unique_ptr<RoutingModel> model(
+      new RoutingModel(kNumNodes, kNumVehicles));
+  model->SetDepot(RoutingModel::NodeIndex(0));
+  model->SetArcCostEvaluatorOfAllVehicles(
+      NewPermanentCallback(data, &CvrpData::Distance));
+  model->AddDimension(NewPermanentCallback(data, &CvrpData::Demand), 0,
+                      kCapacity, true, "capacity");
+  model->AddSearchMonitor(
+      model->solver()->RevAlloc(new BestCostRecorder(model.get(), best_cost)));
+  return model;
+}
+
+RoutingSearchParameters SearchParameters() {
+  RoutingSearchParameters parameters = RoutingModel::DefaultSearchParameters();
+  parameters.set_first_solution_strategy(
+      FirstSolutionStrategy::PATH_CHEAPEST_ARC);
+  parameters.set_time_limit_ms(1000);
+  return parameters;
+}
+
+// Checks that each customer is visited once, that the capacity of the vehicles
+// is respected and that the cost of the assignment is the one of its routes.
+void CheckFeasible(const RoutingModel& model, const Assignment& assignment,
+                   CvrpData* const data) {
+  std::vector<int> num_visits(kNumNodes, 0);
+  int64 cost = 0;
+  for (int vehicle = 0; vehicle < kNumVehicles; ++vehicle) {
+    int64 load = 0;
+    int64 index = model.Start(vehicle);
+    while (!model.IsEnd(index)) {
+      const int64 next = assignment.Value(model.NextVar(index));
+      const RoutingModel::NodeIndex node = model.IndexToNode(index);
+      ++num_visits[node.value()];
+      load += data->Demand(node, model.IndexToNode(next));
+      cost += data->Distance(node, model.IndexToNode(next));
+      index = next;
+    }
+    CHECK_LE(load, kCapacity);
+  }
+  for (int node = 1; node < kNumNodes; ++node) {
+    CHECK_EQ(1, num_visits[node]) << "node " << node;
+  }
+  CHECK_EQ(cost, assignment.ObjectiveValue());
+}
+
+// Solves the problem with three workers. If worker 0, the calling model, finds
+// no solution, the best solution comes from another worker.
+void TestParallelSolve(int seed, bool worker_zero_fails) {
+  const int kNumWorkers = 3;
+  CvrpData data(kNumNodes, seed);
+  std::vector<int64> best_costs(kNumWorkers, kint64max);
+  std::unique_ptr<RoutingModel> model = BuildModel(&data, &best_costs[0]);
+  if (worker_zero_fails) {
+    model->AddSearchMonitor(
+        model->solver()->RevAlloc(new FirstSearchFailer(model->solver())));
+  }
+  const Assignment* const solution = model->SolveInParallelWithParameters(
+      kNumWorkers,
+      [&data, &best_costs](int worker) {
+        return BuildModel(&data, &best_costs[worker]);
+      },
+      SearchParameters());
+  CHECK(solution != nullptr);
+  CheckFeasible(*model, *solution, &data);
+  const int64 best_cost =
+      *std::min_element(best_costs.begin(), best_costs.end());
+  if (worker_zero_fails) {
+    // The cost recorded in worker 0 is the one of the replayed solution.
+    CHECK_EQ(best_cost, best_costs[0]);
+    CHECK_LT(*std::min_element(best_costs.begin() + 1, best_costs.end()),
+             kint64max);
+  }
+  CHECK_EQ(best_cost, solution->ObjectiveValue());
+  CHECK_EQ(RoutingModel::ROUTING_SUCCESS, model->status());
+}
+
+// Neither the calling model nor the models of the workers may be closed.
+void TestClosedModelsAreRejected() {
+  CvrpData data(kNumNodes, 0);
+  int64 best_cost = kint64max;
+  std::unique_ptr<RoutingModel> closed_model = BuildModel(&data, &best_cost);
+  closed_model->CloseModel();
+  CHECK(closed_model->SolveInParallelWithParameters(
+            2, [&data, &best_cost](int worker) {
+              return BuildModel(&data, &best_cost);
+            },
+            SearchParameters()) == nullptr);
+
+  std::unique_ptr<RoutingModel> model = BuildModel(&data, &best_cost);
+  CHECK(model->SolveInParallelWithParameters(
+            3, [&data, &best_cost](int worker) {
+              std::unique_ptr<RoutingModel> worker_model =
+                  BuildModel(&data, &best_cost);
+              if (worker == 2) worker_model->CloseModel();
+              return worker_model;
+            },
+            SearchParameters()) == nullptr);
+  CHECK_EQ(kint64max, best_cost);
+}
+
+void RunAllTests() {
+  for (int seed = 0; seed < 3; ++seed) {
+    TestParallelSolve(seed, false);
+    TestParallelSolve(seed, true);
+  }
+  TestClosedModelsAreRejected();
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
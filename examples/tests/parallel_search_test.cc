@@ -0,0 +1,185 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks ParallelSearch::Solve() with one and several workers against the
+// sequential search of the same model: the optimum of a small assignment
+// problem, and the number of solutions of the n-queens problem, enumerated
+// without solution limit, must be the same.
+
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "constraint_solver/constraint_solver.h"
+#include "constraint_solver/parallel_search.h"
+
+namespace operations_research {
+
+DecisionBuilder* MakeSearch(Solver* const solver,
+                            const std::vector<IntVar*>& vars) {
+  return solver->MakePhase(vars, Solver::CHOOSE_MIN_SIZE_LOWEST_MIN,
+                           Solver::ASSIGN_MIN_VALUE);
+}
+
+// An assignment of n tasks to n machines, all different, minimizing the sum
+// of random costs. A few pairs of tasks must be on ordered machines.
+class AssignmentModel {
+ public:
+  AssignmentModel(int size, int seed) : size_(size), costs_(size * size) {
+    ACMRandom random(seed);
+    for (int64& cost : costs_) cost = random.Uniform(100);
+  }
+
+  // Builds the model in the given solver, and returns its cost variable.
+  IntVar* Build(Solver* const solver, std::vector<IntVar*>* const vars) {
+    solver->MakeIntVarArray(size_, 0, size_ - 1, "x", vars);
+    solver->AddConstraint(solver->MakeAllDifferent(*vars));
+    for (int task = 0; task + 1 < size_; task += 3) {
+      solver->AddConstraint(
+          solver->MakeLess((*vars)[task], (*vars)[task + 1]));
+    }
+    std::vector<IntVar*> task_costs;
+    for (int task = 0; task < size_; ++task) {
+      task_costs.push_back(
+          solver
+              ->MakeElement(std::vector<int64>(costs_.begin() + task * size_,
+                                               costs_.begin() +
+                                                   (task + 1) * size_),
+                            (*vars)[task])
+              ->Var());
+    }
+    return solver->MakeSum(task_costs)->Var();
+  }
+
+  // Returns the optimal cost found by the sequential search.
+  int64 SolveSequentially() {
+    Solver solver("assignment");
+    std::vector<IntVar*> vars;
+    IntVar* const cost = Build(&solver, &vars);
+    SolutionCollector* const collector = solver.MakeLastSolutionCollector();
+    collector->AddObjective(cost);
+    CHECK(solver.Solve(MakeSearch(&solver, vars), collector,
+                       solver.MakeMinimize(cost, 1)));
+    return collector->objective_value(0);
+  }
+
+  // Returns the optimal cost found by the parallel search, after checking the
+  // reported solution.
+  int64 SolveInParallel(int num_workers) {
+    Solver solver("assignment");
+    std::vector<IntVar*> vars;
+    IntVar* const cost = Build(&solver, &vars);
+    ParallelSearch search(&solver, vars, solver.MakeMinimize(cost, 1),
+                          num_workers);
+    CHECK(search.Solve(MakeSearch, kint64max));
+    CHECK(search.search_completed());
+    CHECK_GT(search.num_solutions(), 0);
+    const std::vector<int64>& solution = search.solution();
+    CHECK_EQ(size_, solution.size());
+    std::vector<bool> used(size_, false);
+    int64 solution_cost = 0;
+    for (int task = 0; task < size_; ++task) {
+      CHECK(!used[solution[task]]);
+      used[solution[task]] = true;
+      solution_cost += costs_[task * size_ + solution[task]];
+      if (task % 3 == 0 && task + 1 < size_) {
+        CHECK_LT(solution[task], solution[task + 1]);
+      }
+    }
+    CHECK_EQ(solution_cost, search.objective_value());
+    return search.objective_value();
+  }
+
+ private:
+  const int size_;
+  std::vector<int64> costs_;
+};
+
+// The n-queens problem, one queen per column.
+void BuildQueens(Solver* const solver, int size,
+                 std::vector<IntVar*>* const queens) {
+  solver->MakeIntVarArray(size, 0, size - 1, "queen", queens);
+  std::vector<IntVar*> up;
+  std::vector<IntVar*> down;
+  for (int i = 0; i < size; ++i) {
+    up.push_back(solver->MakeSum((*queens)[i], i)->Var());
+    down.push_back(solver->MakeSum((*queens)[i], -i)->Var());
+  }
+  solver->AddConstraint(solver->MakeAllDifferent(*queens));
+  solver->AddConstraint(solver->MakeAllDifferent(up));
+  solver->AddConstraint(solver->MakeAllDifferent(down));
+}
+
+void CheckQueens(const std::vector<int64>& queens) {
+  for (int i = 0; i < queens.size(); ++i) {
+    for (int j = i + 1; j < queens.size(); ++j) {
+      CHECK_NE(queens[i], queens[j]);
+      CHECK_NE(queens[i] + i, queens[j] + j);
+      CHECK_NE(queens[i] - i, queens[j] - j);
+    }
+  }
+}
+
+int64 CountQueensSequentially(int size) {
+  Solver solver("queens");
+  std::vector<IntVar*> queens;
+  BuildQueens(&solver, size, &queens);
+  SolutionCollector* const collector = solver.MakeAllSolutionCollector();
+  solver.Solve(MakeSearch(&solver, queens), collector);
+  return collector->solution_count();
+}
+
+// Returns the number of solutions found by the parallel search with the given
+// solution limit.
+int64 CountQueensInParallel(int size, int num_workers, int64 solution_limit) {
+  Solver solver("queens");
+  std::vector<IntVar*> queens;
+  BuildQueens(&solver, size, &queens);
+  ParallelSearch search(&solver, queens, nullptr, num_workers);
+  search.set_solution_limit(solution_limit);
+  CHECK(search.Solve(MakeSearch, kint64max));
+  CHECK_EQ(solution_limit == kint64max, search.search_completed());
+  CHECK_EQ(size, search.solution().size());
+  CheckQueens(search.solution());
+  return search.num_solutions();
+}
+
+void RunAllTests() {
+  for (int seed = 0; seed < 3; ++seed) {
+    AssignmentModel model(9, seed);
+    const int64 optimum = model.SolveSequentially();
+    CHECK_EQ(optimum, model.SolveInParallel(1));
+    CHECK_EQ(optimum, model.SolveInParallel(4));
+  }
+
+  for (const int size : {6, 8, 10}) {
+    const int64 num_solutions = CountQueensSequentially(size);
+    CHECK_EQ(num_solutions, CountQueensInParallel(size, 1, kint64max));
+    CHECK_EQ(num_solutions, CountQueensInParallel(size, 4, kint64max));
+  }
+  // A limit, such as the default one, stops the search when it is reached,
+  // whatever the number of workers.
+  CHECK_EQ(1, CountQueensInParallel(8, 4, 1));
+  CHECK_EQ(10, CountQueensInParallel(8, 4, 10));
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
@@ -0,0 +1,285 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the time windows of random moves with the path cumul filter of a
+// dimension without costs, which accepts the changed chains from summaries
+// of the synchronized paths. Its decisions are compared with the ones of the
+// same filter scanning the whole paths, forced by a soft bound with a zero
+// coefficient, and with a direct evaluation of the time windows.
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "constraint_solver/routing.h"
+
+namespace operations_research {
+
+// Random nodes in a square, with a service time and a time window.
+class TimeWindowData {
+ public:
+  TimeWindowData(int num_nodes, int64 horizon, ACMRandom* const random)
+      : x_(num_nodes), y_(num_nodes), service_(num_nodes, 0),
+        window_min_(num_nodes, 0), window_max_(num_nodes, horizon) {
+    for (int node = 0; node < num_nodes; ++node) {
+      x_[node] = random->Uniform(100);
+      y_[node] = random->Uniform(100);
+      if (node == 0) continue;
+      service_[node] = random->Uniform(20);
+      window_min_[node] = 1 + random->Uniform(horizon / 2);
+      window_max_[node] = std::min(
+          horizon, window_min_[node] + horizon / 10 +
+                       random->Uniform(horizon / 2));
+    }
+  }
+
+  int64 Time(RoutingModel::NodeIndex from, RoutingModel::NodeIndex to) {
+    const int64 distance = static_cast<int64>(
+        std::hypot(x_[from.value()] - x_[to.value()],
+                   y_[from.value()] - y_[to.value()]));
+    return service_[from.value()] + distance;
+  }
+  int64 window_min(RoutingModel::NodeIndex node) const {
+    return window_min_[node.value()];
+  }
+  int64 window_max(RoutingModel::NodeIndex node) const {
+    return window_max_[node.value()];
+  }
+
+ private:
+  std::vector<int64> x_;
+  std::vector<int64> y_;
+  std::vector<int64> service_;
+  std::vector<int64> window_min_;
+  std::vector<int64> window_max_;
+};
+
+// A routing model with a time dimension and its closed path cumul filter.
+class TimeWindowModel {
+ public:
+  TimeWindowModel(int num_nodes, int num_vehicles, int64 horizon,
+                  bool full_scan, TimeWindowData* const data)
+      : model_(num_nodes, num_vehicles) {
+    model_.SetArcCostEvaluatorOfAllVehicles(
+        NewPermanentCallback(data, &TimeWindowData::Time));
+    model_.AddDimension(NewPermanentCallback(data, &TimeWindowData::Time),
+                        horizon, horizon, false, "time");
+    RoutingDimension* const time = model_.GetMutableDimension("time");
+    for (int node = 1; node < num_nodes; ++node) {
+      const RoutingModel::NodeIndex node_index(node);
+      time->CumulVar(model_.NodeToIndex(node_index))
+          ->SetRange(data->window_min(node_index),
+                     data->window_max(node_index));
+    }
+    if (full_scan) {
+      // Any soft bound disables the path summaries.
+      time->SetCumulVarSoftUpperBound(RoutingModel::NodeIndex(1), horizon, 0);
+    }
+    model_.CloseModel();
+    filter_ = MakePathCumulFilter(model_, *time, nullptr);
+    empty_ = model_.solver()->MakeAssignment();
+  }
+
+  RoutingModel* model() { return &model_; }
+
+  // Returns the assignment of the next variables to the given values.
+  Assignment* MakeAssignment(const std::vector<int64>& nexts,
+                             const std::vector<int64>* const old_nexts) {
+    Assignment* const assignment = model_.solver()->MakeAssignment();
+    for (int index = 0; index < nexts.size(); ++index) {
+      if (old_nexts == nullptr || (*old_nexts)[index] != nexts[index]) {
+        assignment->Add(model_.NextVar(index));
+        assignment->SetValue(model_.NextVar(index), nexts[index]);
+      }
+    }
+    return assignment;
+  }
+
+  void Synchronize(const std::vector<int64>& nexts,
+                   const std::vector<int64>* const old_nexts) {
+    filter_->Synchronize(MakeAssignment(nexts, nullptr),
+                         old_nexts == nullptr
+                             ? nullptr
+                             : MakeAssignment(nexts, old_nexts));
+  }
+
+  bool Accept(const std::vector<int64>& nexts,
+              const std::vector<int64>& old_nexts) {
+    return filter_->Accept(MakeAssignment(nexts, &old_nexts), empty_);
+  }
+
+ private:
+  RoutingModel model_;
+  RoutingLocalSearchFilter* filter_;
+  Assignment* empty_;
+};
+
+class PathCumulFilterTest {
+ public:
+  PathCumulFilterTest(int num_nodes, int num_vehicles, int seed)
+      : num_vehicles_(num_vehicles),
+        horizon_(20 * num_nodes),
+        random_(seed),
+        data_(num_nodes, horizon_, &random_),
+        summaries_(num_nodes, num_vehicles, horizon_, false, &data_),
+        full_scan_(num_nodes, num_vehicles, horizon_, true, &data_),
+        routes_(num_vehicles) {
+    RoutingModel* const model = summaries_.model();
+    for (int index = 0; index < model->Size(); ++index) {
+      if (!model->IsStart(index)) {
+        routes_[random_.Uniform(num_vehicles_)].push_back(index);
+      }
+    }
+  }
+
+  // Applies random moves, checks that both filters agree with the time
+  // windows, and synchronizes them with about half of the moves, feasible or
+  // not.
+  void TestRandomMoves(int num_moves) {
+    std::vector<int64> nexts = Nexts(routes_);
+    summaries_.Synchronize(nexts, nullptr);
+    full_scan_.Synchronize(nexts, nullptr);
+    int num_accepted = 0;
+    for (int move = 0; move < num_moves; ++move) {
+      std::vector<std::vector<int64>> new_routes = routes_;
+      MakeRandomMove(&new_routes);
+      const std::vector<int64> new_nexts = Nexts(new_routes);
+      if (new_nexts == nexts) continue;
+      const bool feasible = ChangedRoutesAreFeasible(new_routes);
+      CHECK_EQ(feasible, full_scan_.Accept(new_nexts, nexts));
+      CHECK_EQ(feasible, summaries_.Accept(new_nexts, nexts));
+      num_accepted += feasible;
+      if (random_.OneIn(2)) {
+        // Synchronizes incrementally, as the local search does, or sometimes
+        // with the whole solution.
+        const bool full = random_.OneIn(10);
+        summaries_.Synchronize(new_nexts, full ? nullptr : &nexts);
+        full_scan_.Synchronize(new_nexts, full ? nullptr : &nexts);
+        routes_ = new_routes;
+        nexts = new_nexts;
+      }
+    }
+    // The instance is neither too tight nor too loose for the test to be
+    // meaningful.
+    CHECK_GT(num_accepted, 0);
+    CHECK_LT(num_accepted, num_moves);
+  }
+
+ private:
+  std::vector<int64> Nexts(const std::vector<std::vector<int64>>& routes) {
+    RoutingModel* const model = summaries_.model();
+    std::vector<int64> nexts(model->Size(), -1);
+    for (int vehicle = 0; vehicle < num_vehicles_; ++vehicle) {
+      int64 previous = model->Start(vehicle);
+      for (const int64 index : routes[vehicle]) {
+        nexts[previous] = index;
+        previous = index;
+      }
+      nexts[previous] = model->End(vehicle);
+    }
+    return nexts;
+  }
+
+  // Relocates a node, exchanges two nodes, reverses a chain (whose changed
+  // chain can be long for a few changed arcs) or exchanges route ends.
+  void MakeRandomMove(std::vector<std::vector<int64>>* const routes) {
+    std::vector<int64>& route1 = (*routes)[random_.Uniform(num_vehicles_)];
+    std::vector<int64>& route2 = (*routes)[random_.Uniform(num_vehicles_)];
+    if (route1.empty()) return;
+    const int position1 = random_.Uniform(route1.size());
+    switch (random_.Uniform(4)) {
+      case 0: {
+        const int64 node = route1[position1];
+        route1.erase(route1.begin() + position1);
+        route2.insert(route2.begin() + random_.Uniform(route2.size() + 1),
+                      node);
+        break;
+      }
+      case 1:
+        if (!route2.empty()) {
+          std::swap(route1[position1],
+                    route2[random_.Uniform(route2.size())]);
+        }
+        break;
+      case 2: {
+        const int position2 = random_.Uniform(route1.size());
+        std::reverse(route1.begin() + std::min(position1, position2),
+                     route1.begin() + std::max(position1, position2) + 1);
+        break;
+      }
+      default:
+        if (&route1 != &route2) {
+          const int position2 = random_.Uniform(route2.size() + 1);
+          std::vector<int64> end1(route1.begin() + position1, route1.end());
+          route1.resize(position1);
+          route1.insert(route1.end(), route2.begin() + position2,
+                        route2.end());
+          route2.resize(position2);
+          route2.insert(route2.end(), end1.begin(), end1.end());
+        }
+    }
+  }
+
+  // Checks the time windows of the routes which differ from the synchronized
+  // ones, waiting when arriving early. Like the filters, assumes the other
+  // routes are feasible.
+  bool ChangedRoutesAreFeasible(
+      const std::vector<std::vector<int64>>& routes) {
+    RoutingModel* const model = summaries_.model();
+    for (int vehicle = 0; vehicle < num_vehicles_; ++vehicle) {
+      if (routes[vehicle] == routes_[vehicle]) continue;
+      int64 previous = model->Start(vehicle);
+      int64 time = 0;
+      std::vector<int64> route = routes[vehicle];
+      route.push_back(model->End(vehicle));
+      for (const int64 index : route) {
+        const RoutingModel::NodeIndex node = model->IndexToNode(index);
+        time = std::max(data_.window_min(node),
+                        time + data_.Time(model->IndexToNode(previous), node));
+        if (time > data_.window_max(node)) return false;
+        previous = index;
+      }
+    }
+    return true;
+  }
+
+  const int num_vehicles_;
+  const int64 horizon_;
+  ACMRandom random_;
+  TimeWindowData data_;
+  TimeWindowModel summaries_;
+  TimeWindowModel full_scan_;
+  std::vector<std::vector<int64>> routes_;
+};
+
+void RunAllTests() {
+  for (int seed = 0; seed < 5; ++seed) {
+    PathCumulFilterTest test(40, 4, seed);
+    test.TestRandomMoves(2000);
+  }
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
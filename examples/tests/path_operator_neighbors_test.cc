@@ -0,0 +1,368 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the path operators restricted to the neighbors of a node by
+// PathOperator::SetNeighbors() on small random solutions. With neighbor lists
+// containing all the other nodes, the restricted operators must build the same
+// neighbors as the unrestricted ones. With short neighbor lists, each neighbor
+// must be one of the unrestricted neighbors which satisfies the neighbor
+// relation of the operator, also after a restart on another solution; the
+// 2-opt neighbors, which extend the reversed chain over the skipped positions,
+// must be exactly those.
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "constraint_solver/constraint_solver.h"
+#include "constraint_solver/constraint_solveri.h"
+#include "constraint_solver/routing.h"
+
+namespace operations_research {
+
+typedef std::vector<int64> Solution;
+
+enum OperatorType {
+  RELOCATE,
+  EXCHANGE,
+  CROSS,
+  TWO_OPT,
+  MAKE_ACTIVE,
+  PAIR_RELOCATE
+};
+const OperatorType kOperatorTypes[] = {RELOCATE, EXCHANGE,    CROSS,
+                                       TWO_OPT,  MAKE_ACTIVE, PAIR_RELOCATE};
+const int kNumOperatorTypes = PAIR_RELOCATE + 1;
+
+// A random solution of num_paths paths over num_nodes next variables, the
+// first num_paths nodes being the path starts; some nodes are inactive. The
+// first and last nodes of each path with at least two nodes form a pair.
+class NeighborsTest {
+ public:
+  NeighborsTest(int num_nodes, int num_paths, int seed)
+      : num_nodes_(num_nodes), num_paths_(num_paths), random_(seed) {
+    std::vector<int> nodes;
+    for (int node = num_paths_; node < num_nodes_; ++node) {
+      nodes.push_back(node);
+    }
+    std::random_shuffle(nodes.begin(), nodes.end(), random_);
+    solution_.resize(num_nodes_);
+    std::vector<std::vector<int>> paths(num_paths_);
+    for (const int node : nodes) {
+      if (random_.OneIn(5)) {
+        solution_[node] = node;
+      } else {
+        // The last path is more often empty.
+        paths[random_.Uniform(num_paths_ * 2 - 1) / 2].push_back(node);
+      }
+    }
+    for (int path = 0; path < num_paths_; ++path) {
+      int64 previous = path;
+      for (const int node : paths[path]) {
+        solution_[previous] = node;
+        previous = node;
+      }
+      solution_[previous] = num_nodes_ + path;
+      if (paths[path].size() >= 2) {
+        pairs_.push_back({paths[path].front(), paths[path].back()});
+      }
+    }
+    for (int node = 0; node < num_nodes_; ++node) {
+      x_.push_back(random_.Uniform(100));
+      y_.push_back(random_.Uniform(100));
+    }
+  }
+
+  // Sets the neighbors of each node to its num_neighbors nearest other nodes.
+  void SetNumNeighbors(int num_neighbors) {
+    neighbors_.assign(num_nodes_, std::vector<int>());
+    for (int node = 0; node < num_nodes_; ++node) {
+      std::vector<std::pair<double, int>> distances;
+      for (int other = 0; other < num_nodes_; ++other) {
+        if (other == node) continue;
+        distances.push_back(
+            {std::hypot(x_[node] - x_[other], y_[node] - y_[other]), other});
+      }
+      std::sort(distances.begin(), distances.end());
+      for (int i = 0; i < num_neighbors && i < distances.size(); ++i) {
+        neighbors_[node].push_back(distances[i].second);
+      }
+    }
+  }
+
+  bool IsNeighbor(int64 node, int64 neighbor) const {
+    const std::vector<int>& neighbors = neighbors_[node];
+    return std::find(neighbors.begin(), neighbors.end(), neighbor) !=
+           neighbors.end();
+  }
+  const Solution& solution() const { return solution_; }
+  void set_solution(const Solution& solution) { solution_ = solution; }
+  int64 BaseNext(int64 node) const { return solution_[node]; }
+  bool IsStart(int64 node) const { return node < num_paths_; }
+  bool IsEnd(int64 node) const { return node >= num_nodes_; }
+
+  // Returns the neighbors of the operator of the given type, in the order in
+  // which they are enumerated, restricted or not to the current neighbors.
+  // If restart_after is positive, the operator is restarted on its
+  // restart_after-th neighbor, which becomes the current solution, as after a
+  // move of the local search; only the neighbors of this solution are then
+  // returned.
+  std::vector<Solution> Enumerate(OperatorType type, bool restricted,
+                                  int restart_after = 0) {
+    Solver solver("neighbors");
+    std::vector<IntVar*> nexts;
+    solver.MakeIntVarArray(num_nodes_, 0, num_nodes_ + num_paths_ - 1,
+                           "next", &nexts);
+    LocalSearchOperator* const op = MakeOperator(&solver, nexts, type);
+    if (restricted) {
+      static_cast<PathOperator*>(op)->SetNeighbors(
+          [this](int64 node) -> const std::vector<int>& {
+            return neighbors_[node];
+          });
+    }
+    Assignment* const assignment = solver.MakeAssignment();
+    assignment->Add(nexts);
+    for (int node = 0; node < num_nodes_; ++node) {
+      assignment->SetValue(nexts[node], solution_[node]);
+    }
+    op->Start(assignment);
+    std::vector<Solution> neighbors;
+    Assignment* const delta = solver.MakeAssignment();
+    Assignment* const deltadelta = solver.MakeAssignment();
+    while (true) {
+      delta->Clear();
+      deltadelta->Clear();
+      if (!op->MakeNextNeighbor(delta, deltadelta)) break;
+      Solution neighbor = solution_;
+      for (const IntVarElement& element :
+           delta->IntVarContainer().elements()) {
+        neighbor[std::find(nexts.begin(), nexts.end(), element.Var()) -
+                 nexts.begin()] = element.Value();
+      }
+      neighbors.push_back(neighbor);
+      if (neighbors.size() == restart_after) {
+        solution_ = neighbor;
+        for (int node = 0; node < num_nodes_; ++node) {
+          assignment->SetValue(nexts[node], solution_[node]);
+        }
+        op->Start(assignment);
+        neighbors.clear();
+        restart_after = 0;
+      }
+    }
+    return neighbors;
+  }
+
+  // Returns true if the neighbor has a new arc from a path start, or from a
+  // node to one of the nodes the neighbors of which it belongs to. The
+  // restricted base node of Relocate, Exchange, Cross, MakeActive and
+  // PairRelocate becomes the new predecessor of the reference node.
+  bool HasNeighborArc(const Solution& neighbor) const {
+    for (int node = 0; node < num_nodes_; ++node) {
+      const int64 next = neighbor[node];
+      if (next == solution_[node] || next == node || IsEnd(next)) continue;
+      if (IsStart(node) || IsNeighbor(next, node)) return true;
+    }
+    return false;
+  }
+
+  // Returns the base nodes (b0, b1) of a 2-opt neighbor, which reverses the
+  // chain strictly between b0 and b1.
+  std::pair<int64, int64> TwoOptBaseNodes(const Solution& neighbor) const {
+    for (int path = 0; path < num_paths_; ++path) {
+      const std::vector<int64> before = PathNodes(solution_, path);
+      const std::vector<int64> after = PathNodes(neighbor, path);
+      CHECK_EQ(before.size(), after.size());
+      int first = 0;
+      while (first < before.size() && before[first] == after[first]) ++first;
+      if (first == before.size()) continue;
+      int last = before.size() - 1;
+      while (before[last] == after[last]) --last;
+      CHECK_GE(last - first, 1);
+      for (int i = first; i <= last; ++i) {
+        CHECK_EQ(before[i], after[first + last - i]);
+      }
+      return {before[first - 1], before[last + 1]};
+    }
+    LOG(FATAL) << "Unchanged neighbor";
+    return {-1, -1};
+  }
+
+  // 2-opt reverses the chain after b0 up to b1 if b1 is a neighbor of b0.
+  bool IsRestrictedTwoOptNeighbor(const Solution& neighbor) const {
+    const std::pair<int64, int64> base_nodes = TwoOptBaseNodes(neighbor);
+    return IsStart(base_nodes.first) || IsEnd(base_nodes.second) ||
+           IsNeighbor(base_nodes.first, base_nodes.second);
+  }
+
+ private:
+  LocalSearchOperator* MakeOperator(Solver* const solver,
+                                    const std::vector<IntVar*>& nexts,
+                                    OperatorType type) const {
+    switch (type) {
+      case RELOCATE:
+        return solver->MakeOperator(nexts, Solver::RELOCATE);
+      case EXCHANGE:
+        return solver->MakeOperator(nexts, Solver::EXCHANGE);
+      case CROSS:
+        return solver->MakeOperator(nexts, Solver::CROSS);
+      case TWO_OPT:
+        return solver->MakeOperator(nexts, Solver::TWOOPT);
+      case MAKE_ACTIVE:
+        return solver->MakeOperator(nexts, Solver::MAKEACTIVE);
+      case PAIR_RELOCATE:
+        return MakePairRelocate(solver, nexts, {}, nullptr, pairs_);
+    }
+    return nullptr;
+  }
+
+  std::vector<int64> PathNodes(const Solution& solution, int path) const {
+    std::vector<int64> nodes = {path};
+    while (!IsEnd(nodes.back())) nodes.push_back(solution[nodes.back()]);
+    return nodes;
+  }
+
+  const int num_nodes_;
+  const int num_paths_;
+  ACMRandom random_;
+  Solution solution_;
+  RoutingModel::NodePairs pairs_;
+  std::vector<int64> x_;
+  std::vector<int64> y_;
+  std::vector<std::vector<int>> neighbors_;
+};
+
+void TestAllNeighbors(int seed) {
+  const int kNumNodes = 12;
+  NeighborsTest test(kNumNodes, 3, seed);
+  test.SetNumNeighbors(kNumNodes - 1);
+  for (const OperatorType type : kOperatorTypes) {
+    // The sets of neighbors are compared: the swap of two adjacent nodes is
+    // built twice by Exchange, and only once when restricted, from the base
+    // node after which the second node is moved.
+    const std::vector<Solution> all = test.Enumerate(type, false);
+    const std::vector<Solution> restricted = test.Enumerate(type, true);
+    CHECK(std::set<Solution>(all.begin(), all.end()) ==
+          std::set<Solution>(restricted.begin(), restricted.end()))
+        << "operator " << type;
+  }
+}
+
+// Returns the number of 2-opt neighbors which directly follow a neighbor with
+// the same first base node and skip positions of the second base node: their
+// chain is extended by several nodes.
+int NumTwoOptChainExtensions(const NeighborsTest& test,
+                             const std::vector<Solution>& neighbors) {
+  int num_extensions = 0;
+  for (int i = 1; i < neighbors.size(); ++i) {
+    const std::pair<int64, int64> previous =
+        test.TwoOptBaseNodes(neighbors[i - 1]);
+    const std::pair<int64, int64> current = test.TwoOptBaseNodes(neighbors[i]);
+    if (previous.first == current.first &&
+        test.BaseNext(previous.second) != current.second) {
+      ++num_extensions;
+    }
+  }
+  return num_extensions;
+}
+
+// Each restricted neighbor must be an unrestricted neighbor of the current
+// solution which satisfies the neighbor relation of the operator.
+void CheckRestrictedNeighbors(const NeighborsTest& test, OperatorType type,
+                              const std::vector<Solution>& all,
+                              const std::vector<Solution>& restricted) {
+  const std::set<Solution> all_set(all.begin(), all.end());
+  for (const Solution& neighbor : restricted) {
+    CHECK(all_set.count(neighbor)) << "operator " << type;
+    if (type == TWO_OPT) {
+      CHECK(test.IsRestrictedTwoOptNeighbor(neighbor));
+    } else {
+      CHECK(test.HasNeighborArc(neighbor)) << "operator " << type;
+    }
+  }
+}
+
+// Counts the neighbors of each operator type, and the 2-opt chain extensions.
+struct NeighborCounts {
+  NeighborCounts()
+      : all(kNumOperatorTypes, 0),
+        restricted(kNumOperatorTypes, 0),
+        two_opt_extensions(0) {}
+  std::vector<int> all;
+  std::vector<int> restricted;
+  int two_opt_extensions;
+};
+
+void TestRestrictedNeighbors(int seed, NeighborCounts* counts) {
+  NeighborsTest test(16, 3, seed);
+  test.SetNumNeighbors(2);
+  for (const OperatorType type : kOperatorTypes) {
+    const std::vector<Solution> all = test.Enumerate(type, false);
+    const std::vector<Solution> restricted = test.Enumerate(type, true);
+    CheckRestrictedNeighbors(test, type, all, restricted);
+    counts->all[type] += all.size();
+    counts->restricted[type] += restricted.size();
+
+    // After a move, the restricted base node kept by the restarted operator
+    // is not necessarily a neighbor of the new reference node.
+    const Solution initial_solution = test.solution();
+    const std::vector<Solution> restarted =
+        test.Enumerate(type, true, (restricted.size() + 1) / 2);
+    if (test.solution() != initial_solution) {
+      CheckRestrictedNeighbors(test, type, test.Enumerate(type, false),
+                               restarted);
+      test.set_solution(initial_solution);
+    }
+    if (type == TWO_OPT) {
+      std::vector<Solution> expected;
+      for (const Solution& neighbor : all) {
+        if (test.IsRestrictedTwoOptNeighbor(neighbor)) {
+          expected.push_back(neighbor);
+        }
+      }
+      CHECK(expected == restricted);
+      counts->two_opt_extensions += NumTwoOptChainExtensions(test, restricted);
+    }
+  }
+}
+
+void RunAllTests() {
+  NeighborCounts counts;
+  for (int seed = 0; seed < 20; ++seed) {
+    TestAllNeighbors(seed);
+    TestRestrictedNeighbors(seed, &counts);
+  }
+  // Each restriction must have removed neighbors, but not all of them.
+  for (const OperatorType type : kOperatorTypes) {
+    CHECK_GT(counts.restricted[type], 0) << "operator " << type;
+    CHECK_LT(counts.restricted[type], counts.all[type]) << "operator " << type;
+  }
+  // The chain of 2-opt must have been extended by several nodes at once.
+  CHECK_GT(counts.two_opt_extensions, 0);
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
@@ -0,0 +1,338 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the worklist of the presolve loop of MainLpPreprocessor: on random
+// LPs with fixed variables, singleton and doubleton rows, and proportional rows
+// and columns, it must give the same presolved LP and the same postsolved
+// solution as a presolve that runs every preprocessor at every pass. Also
+// checks that FindProportionalColumns() gives the same mapping for any number
+// of threads.
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "glop/parameters.pb.h"
+#include "glop/preprocessor.h"
+#include "glop/revised_simplex.h"
+#include "lp_data/lp_data.h"
+#include "lp_data/lp_types.h"
+#include "lp_data/matrix_utils.h"
+#include "lp_data/sparse.h"
+#include "util/time_limit.h"
+
+namespace operations_research {
+namespace glop {
+
+// MainLpPreprocessor::Run() without its worklist: every preprocessor of the
+// presolve loop is run at every pass.
+class EveryPassPreprocessor : public Preprocessor {
+ public:
+  EveryPassPreprocessor() {}
+
+  bool Run(LinearProgram* lp, TimeLimit* time_limit) override {
+    RunAndPush<ShiftVariableBoundsPreprocessor>(time_limit, lp);
+    const int kMaxNumPasses = 20;
+    for (int i = 0; i < kMaxNumPasses; ++i) {
+      const int old_stack_size = preprocessors_.size();
+      RunAndPush<FixedVariablePreprocessor>(time_limit, lp);
+      RunAndPush<SingletonPreprocessor>(time_limit, lp);
+      RunAndPush<ForcingAndImpliedFreeConstraintPreprocessor>(time_limit, lp);
+      RunAndPush<FreeConstraintPreprocessor>(time_limit, lp);
+      RunAndPush<UnconstrainedVariablePreprocessor>(time_limit, lp);
+      RunAndPush<DoubletonEqualityRowPreprocessor>(time_limit, lp);
+      RunAndPush<ImpliedFreePreprocessor>(time_limit, lp);
+      RunAndPush<DoubletonFreeColumnPreprocessor>(time_limit, lp);
+      if (preprocessors_.size() == old_stack_size) break;
+    }
+    RunAndPush<EmptyColumnPreprocessor>(time_limit, lp);
+    RunAndPush<EmptyConstraintPreprocessor>(time_limit, lp);
+    RunAndPush<ProportionalColumnPreprocessor>(time_limit, lp);
+    RunAndPush<ProportionalRowPreprocessor>(time_limit, lp);
+    const int old_stack_size = preprocessors_.size();
+    RunAndPush<DualizerPreprocessor>(time_limit, lp);
+    RunAndPush<SolowHalimPreprocessor>(time_limit, lp);
+    if (old_stack_size != preprocessors_.size()) {
+      RunAndPush<SingletonPreprocessor>(time_limit, lp);
+      RunAndPush<FreeConstraintPreprocessor>(time_limit, lp);
+      RunAndPush<UnconstrainedVariablePreprocessor>(time_limit, lp);
+      RunAndPush<EmptyColumnPreprocessor>(time_limit, lp);
+      RunAndPush<EmptyConstraintPreprocessor>(time_limit, lp);
+    }
+    RunAndPush<SingletonColumnSignPreprocessor>(time_limit, lp);
+    RunAndPush<ScalingPreprocessor>(time_limit, lp);
+    RunAndPush<AddSlackVariablesPreprocessor>(time_limit, lp);
+    return !preprocessors_.empty();
+  }
+
+  void RecoverSolution(ProblemSolution* solution) const override {
+    for (int i = preprocessors_.size() - 1; i >= 0; --i) {
+      preprocessors_[i]->RecoverSolution(solution);
+    }
+  }
+
+ private:
+  // Same as MainLpPreprocessor::RunAndPushIfRelevant().
+  template <class P>
+  void RunAndPush(TimeLimit* time_limit, LinearProgram* lp) {
+    if (status_ != ProblemStatus::INIT) return;
+    if (lp->num_variables() == 0 && lp->num_constraints() == 0) {
+      status_ = ProblemStatus::OPTIMAL;
+      return;
+    }
+    std::unique_ptr<Preprocessor> preprocessor(new P());
+    preprocessor->SetParameters(parameters_);
+    const bool needs_postsolve = preprocessor->Run(lp, time_limit);
+    status_ = preprocessor->status();
+    if (needs_postsolve) preprocessors_.push_back(std::move(preprocessor));
+  }
+
+  std::vector<std::unique_ptr<Preprocessor>> preprocessors_;
+};
+
+// A random feasible and bounded LP with a few entries per row, whose variables are fixed,
+// boxed, bounded on one side or free, and whose constraints are equalities,
+// ranges or one-sided around the activity of a random point. Some rows and
+// columns are copies of other ones scaled by a random factor, some rows are
+// singletons or doubleton equalities.
+void BuildLp(int num_rows, int num_cols, int seed, LinearProgram* lp) {
+  const Fractional kInfinity = std::numeric_limits<Fractional>::infinity();
+  ACMRandom random(seed);
+  lp->Clear();
+  std::vector<Fractional> point(num_cols);
+  for (int col = 0; col < num_cols; ++col) {
+    const ColIndex new_col = lp->CreateNewVariable();
+    point[col] = random.Uniform(10);
+    // The costs are such that the objective is bounded.
+    const Fractional cost = random.Uniform(6);
+    switch (random.Uniform(5)) {
+      case 0:
+        lp->SetVariableBounds(new_col, point[col], point[col]);
+        lp->SetObjectiveCoefficient(new_col, cost - 3.0);
+        break;
+      case 1:
+        lp->SetVariableBounds(new_col, 0.0, kInfinity);
+        lp->SetObjectiveCoefficient(new_col, cost);
+        break;
+      case 2:
+        lp->SetVariableBounds(new_col, -kInfinity, 10.0);
+        lp->SetObjectiveCoefficient(new_col, -cost);
+        break;
+      case 3:
+        lp->SetVariableBounds(new_col, -kInfinity, kInfinity);
+        break;
+      default:
+        lp->SetVariableBounds(new_col, 0.0, 10.0);
+        lp->SetObjectiveCoefficient(new_col, cost - 3.0);
+    }
+  }
+  // Rows of coefficients, some of them proportional to a previous one.
+  std::vector<std::vector<Fractional>> rows(num_rows,
+                                            std::vector<Fractional>(num_cols));
+  for (int row = 0; row < num_rows; ++row) {
+    if (row > 0 && random.Uniform(5) == 0) {
+      const int model = random.Uniform(row);
+      const Fractional factor = random.Uniform(2) == 0 ? -2.0 : 3.0;
+      for (int col = 0; col < num_cols; ++col) {
+        rows[row][col] = factor * rows[model][col];
+      }
+      continue;
+    }
+    const int num_entries = 1 + random.Uniform(4);
+    for (int i = 0; i < num_entries; ++i) {
+      rows[row][random.Uniform(num_cols)] = random.Uniform(9) - 4.0;
+    }
+  }
+  // Columns proportional to a previous one.
+  for (int col = 1; col < num_cols; ++col) {
+    if (random.Uniform(6) != 0) continue;
+    const int model = random.Uniform(col);
+    for (int row = 0; row < num_rows; ++row) {
+      rows[row][col] = -2.0 * rows[row][model];
+    }
+  }
+  for (int row = 0; row < num_rows; ++row) {
+    const RowIndex new_row = lp->CreateNewConstraint();
+    Fractional activity = 0.0;
+    for (int col = 0; col < num_cols; ++col) {
+      if (rows[row][col] == 0.0) continue;
+      lp->SetCoefficient(new_row, ColIndex(col), rows[row][col]);
+      activity += rows[row][col] * point[col];
+    }
+    switch (random.Uniform(3)) {
+      case 0:
+        lp->SetConstraintBounds(new_row, activity, activity);
+        break;
+      case 1:
+        lp->SetConstraintBounds(new_row, activity - random.Uniform(5),
+                                activity + random.Uniform(5));
+        break;
+      default:
+        lp->SetConstraintBounds(new_row, -kInfinity,
+                                activity + random.Uniform(5));
+    }
+  }
+}
+
+// Solves the presolved lp with the simplex, and returns the postsolved
+// solution.
+ProblemSolution SolveAndPostsolve(const GlopParameters& parameters,
+                                  const LinearProgram& lp,
+                                  const Preprocessor& preprocessor) {
+  ProblemSolution solution(lp.num_constraints(), lp.num_variables());
+  solution.status = preprocessor.status();
+  if (solution.status == ProblemStatus::INIT) {
+    std::unique_ptr<TimeLimit> time_limit = TimeLimit::Infinite();
+    RevisedSimplex simplex;
+    simplex.SetParameters(parameters);
+    CHECK(simplex.Solve(lp, time_limit.get()).ok());
+    solution.status = simplex.GetProblemStatus();
+    for (ColIndex col(0); col < lp.num_variables(); ++col) {
+      solution.primal_values[col] = simplex.GetVariableValue(col);
+      solution.variable_statuses[col] = simplex.GetVariableStatus(col);
+    }
+    for (RowIndex row(0); row < lp.num_constraints(); ++row) {
+      solution.dual_values[row] = simplex.GetDualValue(row);
+      solution.constraint_statuses[row] = simplex.GetConstraintStatus(row);
+    }
+  }
+  preprocessor.RecoverSolution(&solution);
+  return solution;
+}
+
+// Presolves the same lp with and without the worklist, and returns true if
+// the presolve removed some rows or columns.
+bool TestSameAsEveryPass(int seed) {
+  LinearProgram lp;
+  BuildLp(30, 40, seed, &lp);
+  GlopParameters parameters;
+  std::unique_ptr<TimeLimit> time_limit = TimeLimit::Infinite();
+
+  LinearProgram worklist_lp;
+  worklist_lp.PopulateFromLinearProgram(lp);
+  MainLpPreprocessor worklist;
+  worklist.SetParameters(parameters);
+  const bool worklist_postsolve = worklist.Run(&worklist_lp, time_limit.get());
+
+  LinearProgram every_pass_lp;
+  every_pass_lp.PopulateFromLinearProgram(lp);
+  EveryPassPreprocessor every_pass;
+  every_pass.SetParameters(parameters);
+  CHECK_EQ(every_pass.Run(&every_pass_lp, time_limit.get()),
+           worklist_postsolve);
+
+  CHECK(worklist.status() == every_pass.status());
+  CHECK_EQ(every_pass_lp.Dump(), worklist_lp.Dump());
+
+  const ProblemSolution worklist_solution =
+      SolveAndPostsolve(parameters, worklist_lp, worklist);
+  const ProblemSolution every_pass_solution =
+      SolveAndPostsolve(parameters, every_pass_lp, every_pass);
+  CHECK(worklist_solution.status == every_pass_solution.status);
+  CHECK(worklist_solution.status == ProblemStatus::OPTIMAL);
+  CHECK_EQ(lp.num_variables(), worklist_solution.primal_values.size());
+  CHECK(worklist_solution.primal_values == every_pass_solution.primal_values);
+  CHECK(worklist_solution.dual_values == every_pass_solution.dual_values);
+  CHECK(worklist_solution.variable_statuses ==
+        every_pass_solution.variable_statuses);
+  CHECK(worklist_solution.constraint_statuses ==
+        every_pass_solution.constraint_statuses);
+  return worklist_lp.num_variables() < lp.num_variables() ||
+         worklist_lp.num_constraints() < lp.num_constraints();
+}
+
+// A matrix whose columns have few distinct non-zero patterns, and classes of
+// columns proportional up to a scaling factor, with their members spread over
+// the whole matrix.
+void BuildMatrixWithProportionalColumns(int num_rows, int num_cols, int seed,
+                                        SparseMatrix* matrix) {
+  ACMRandom random(seed);
+  matrix->Clear();
+  matrix->SetNumRows(RowIndex(num_rows));
+  const int kNumModels = 50;
+  std::vector<std::vector<int>> model_rows(kNumModels);
+  std::vector<std::vector<Fractional>> model_coefficients(kNumModels);
+  for (int model = 0; model < kNumModels; ++model) {
+    // Two models out of three share their non-zero pattern with the previous
+    // one, so that the fingerprint groups hold several classes.
+    if (model > 0 && random.Uniform(3) != 0) {
+      model_rows[model] = model_rows[model - 1];
+    } else {
+      const int num_entries = 1 + random.Uniform(5);
+      for (int i = 0; i < num_entries; ++i) {
+        model_rows[model].push_back(random.Uniform(num_rows));
+      }
+    }
+    for (int i = 0; i < model_rows[model].size(); ++i) {
+      model_coefficients[model].push_back(random.UniformDouble(-1.0, 1.0));
+    }
+  }
+  for (int col = 0; col < num_cols; ++col) {
+    const ColIndex new_col = matrix->AppendEmptyColumn();
+    if (random.Uniform(10) == 0) continue;
+    SparseColumn* const column = matrix->mutable_column(new_col);
+    if (random.Uniform(4) == 0) {
+      column->SetCoefficient(RowIndex(random.Uniform(num_rows)),
+                             random.UniformDouble(1.0, 2.0));
+      continue;
+    }
+    const int model = random.Uniform(kNumModels);
+    const Fractional factor = random.UniformDouble(0.5, 4.0);
+    for (int i = 0; i < model_rows[model].size(); ++i) {
+      column->SetCoefficient(RowIndex(model_rows[model][i]),
+                             factor * model_coefficients[model][i]);
+    }
+  }
+  matrix->CleanUp();
+}
+
+// Most columns are proportional to another one, and their mapping must not
+// depend on the number of threads.
+void TestSameMappingForAnyNumberOfThreads(int seed) {
+  SparseMatrix matrix;
+  BuildMatrixWithProportionalColumns(200, 5000, seed, &matrix);
+  const Fractional kTolerance = 1e-9;
+  const ColMapping mapping = FindProportionalColumns(matrix, kTolerance, 1);
+  int num_proportional_cols = 0;
+  for (ColIndex col(0); col < matrix.num_cols(); ++col) {
+    if (mapping[col] != kInvalidCol) ++num_proportional_cols;
+  }
+  CHECK_GT(num_proportional_cols, matrix.num_cols().value() / 2);
+  for (const int num_threads : {2, 3, 8}) {
+    CHECK(mapping == FindProportionalColumns(matrix, kTolerance, num_threads));
+  }
+}
+
+void RunAllTests() {
+  int num_presolved_lps = 0;
+  for (int seed = 0; seed < 100; ++seed) {
+    if (TestSameAsEveryPass(seed)) ++num_presolved_lps;
+  }
+  CHECK_GT(num_presolved_lps, 50);
+  for (int seed = 0; seed < 5; ++seed) {
+    TestSameMappingForAnyNumberOfThreads(seed);
+  }
+}
+
+}  // namespace glop
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::glop::RunAllTests();
+  return 0;
+}
@@ -0,0 +1,210 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the objects built by Solver::RevAllocInArena() across pushed and
+// popped states, outside of search and during search, including objects
+// larger than the blocks of the arenas: the objects must not overlap, their
+// destructors must run on backtrack, in the reverse order of their creation,
+// and their memory must be reused by the objects built after the backtrack.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "constraint_solver/constraint_solver.h"
+
+namespace operations_research {
+
+// An object built in an arena, which logs its destruction. Its payload is
+// filled with its id, and checked on destruction to detect overlaps.
+template <int kPayloadSize>
+class ArenaObject : public BaseObject {
+ public:
+  ArenaObject(int id, std::vector<int>* const destroyed)
+      : id_(id), destroyed_(destroyed) {
+    memset(payload_, id_ & 0xff, kPayloadSize);
+  }
+  ~ArenaObject() override {
+    for (int i = 0; i < kPayloadSize; ++i) {
+      CHECK_EQ(static_cast<char>(id_ & 0xff), payload_[i]) << id_;
+    }
+    destroyed_->push_back(id_);
+  }
+
+  std::string DebugString() const override { return "ArenaObject"; }
+
+ private:
+  const int id_;
+  std::vector<int>* const destroyed_;
+  char payload_[kPayloadSize];
+};
+
+// Its size is not a multiple of the alignment of the arenas.
+typedef ArenaObject<28> SmallObject;
+// Larger than the blocks of the search arena (64 KB), and of the arena of the
+// objects built outside of search (1 MB).
+typedef ArenaObject<100000> LargeSearchObject;
+typedef ArenaObject<(3 << 20) / 2> LargeModelObject;
+
+void CheckAligned(const void* const object) {
+  CHECK_EQ(0, reinterpret_cast<uintptr_t>(object) % Solver::kArenaAlignment);
+}
+
+// Builds the given number of small objects, with consecutive ids from
+// *next_id, and returns the first one.
+SmallObject* BuildSmallObjects(Solver* const solver, int num_objects,
+                               int* const next_id,
+                               std::vector<int>* const destroyed) {
+  SmallObject* first = nullptr;
+  for (int i = 0; i < num_objects; ++i) {
+    SmallObject* const object =
+        solver->RevAllocInArena<SmallObject>((*next_id)++, destroyed);
+    CheckAligned(object);
+    if (first == nullptr) first = object;
+  }
+  return first;
+}
+
+// Checks that the objects with the ids in [begin, end) were destroyed, in the
+// reverse order of their creation, and nothing else.
+void CheckDestroyed(int begin, int end, std::vector<int>* const destroyed) {
+  CHECK_EQ(end - begin, destroyed->size());
+  for (int i = 0; i < destroyed->size(); ++i) {
+    CHECK_EQ(end - 1 - i, (*destroyed)[i]);
+  }
+  destroyed->clear();
+}
+
+// Builds objects at three levels of states, and pops the two last ones. Each
+// state builds enough small objects to fill several blocks, and a large
+// object. Returns the number of objects left at the first level.
+template <class LargeObject>
+int TestStates(Solver* const solver, std::vector<int>* const destroyed) {
+  int next_id = 0;
+  BuildSmallObjects(solver, 10, &next_id, destroyed);
+  const int first_level_end = next_id;
+
+  solver->PushState();
+  const int second_level_begin = next_id;
+  SmallObject* const second_level_first =
+      BuildSmallObjects(solver, 50000, &next_id, destroyed);
+  LargeObject* const second_level_large =
+      solver->RevAllocInArena<LargeObject>(next_id++, destroyed);
+  CheckAligned(second_level_large);
+  BuildSmallObjects(solver, 100, &next_id, destroyed);
+  const int second_level_end = next_id;
+
+  solver->PushState();
+  const int third_level_begin = next_id;
+  SmallObject* const third_level_first =
+      BuildSmallObjects(solver, 1000, &next_id, destroyed);
+  LargeObject* const third_level_large =
+      solver->RevAllocInArena<LargeObject>(next_id++, destroyed);
+  CheckAligned(third_level_large);
+  BuildSmallObjects(solver, 50000, &next_id, destroyed);
+  CHECK(destroyed->empty());
+
+  // Only the objects of the third level are destroyed, and their memory is
+  // reused by the next objects, including the large one.
+  solver->PopState();
+  CheckDestroyed(third_level_begin, next_id, destroyed);
+  next_id = third_level_begin;
+  CHECK(BuildSmallObjects(solver, 1000, &next_id, destroyed) ==
+        third_level_first);
+  CHECK(solver->RevAllocInArena<LargeObject>(next_id++, destroyed) ==
+        third_level_large);
+
+  // The objects rebuilt on the second level are destroyed with it.
+  solver->PopState();
+  CheckDestroyed(second_level_begin, next_id, destroyed);
+  next_id = second_level_begin;
+  solver->PushState();
+  CHECK(BuildSmallObjects(solver, 50000, &next_id, destroyed) ==
+        second_level_first);
+  CHECK(solver->RevAllocInArena<LargeObject>(next_id++, destroyed) ==
+        second_level_large);
+  solver->PopState();
+  CheckDestroyed(second_level_begin, next_id, destroyed);
+
+  // The large object built first must not be given one of the blocks of the
+  // small objects built before.
+  next_id = second_level_begin;
+  solver->PushState();
+  CheckAligned(solver->RevAllocInArena<LargeObject>(next_id++, destroyed));
+  BuildSmallObjects(solver, 50000, &next_id, destroyed);
+  CheckAligned(solver->RevAllocInArena<LargeObject>(next_id++, destroyed));
+  solver->PopState();
+  CheckDestroyed(second_level_begin, next_id, destroyed);
+  return first_level_end;
+}
+
+// Runs TestStates() during the search, and checks that the objects of the
+// first level are destroyed when the search backtracks.
+class TestStatesInSearch : public DecisionBuilder {
+ public:
+  explicit TestStatesInSearch(std::vector<int>* const destroyed)
+      : destroyed_(destroyed), num_objects_left_(0) {}
+
+  Decision* Next(Solver* const solver) override {
+    num_objects_left_ = TestStates<LargeSearchObject>(solver, destroyed_);
+    CHECK(destroyed_->empty());
+    return nullptr;
+  }
+
+  int num_objects_left() const { return num_objects_left_; }
+
+ private:
+  std::vector<int>* const destroyed_;
+  int num_objects_left_;
+};
+
+void TestOutsideOfSearch() {
+  std::vector<int> destroyed;
+  int num_objects_left = 0;
+  {
+    Solver solver("reversible_arena_test");
+    num_objects_left = TestStates<LargeModelObject>(&solver, &destroyed);
+    CHECK(destroyed.empty());
+  }
+  CheckDestroyed(0, num_objects_left, &destroyed);
+}
+
+void TestInSearch() {
+  std::vector<int> destroyed;
+  Solver solver("reversible_arena_test");
+  TestStatesInSearch* const db =
+      solver.RevAlloc(new TestStatesInSearch(&destroyed));
+  CHECK(solver.Solve(db));
+  CHECK_GT(db->num_objects_left(), 0);
+  CheckDestroyed(0, db->num_objects_left(), &destroyed);
+
+  // A second search reuses the memory of the first one.
+  CHECK(solver.Solve(db));
+  CheckDestroyed(0, db->num_objects_left(), &destroyed);
+}
+
+void RunAllTests() {
+  TestOutsideOfSearch();
+  TestInSearch();
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
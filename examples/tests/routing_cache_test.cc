@@ -0,0 +1,250 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the caches of the node callbacks of the routing model: the cached
+// values must be the ones of the callback whatever the type used to store
+// them, including when values overflowing 32 bits force the cache to be
+// refilled, and whatever the number of threads filling it. Caches of callbacks
+// with equal values must be shared, but not caches whose fingerprints collide.
+// Large caches are only kept when their values are compressed.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/commandlineflags.h"
+#include "base/hash.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "constraint_solver/routing.h"
+
+DECLARE_bool(routing_cache_callbacks);
+DECLARE_int64(routing_max_cache_size);
+DECLARE_int64(routing_max_compressed_cache_size);
+DECLARE_bool(routing_compress_cache);
+
+namespace operations_research {
+
+// A matrix of random values in [min_value, max_value], with both bounds
+// reached.
+class RandomMatrix {
+ public:
+  RandomMatrix(int size, int64 min_value, int64 max_value, int seed)
+      : size_(size), values_(size * size) {
+    ACMRandom random(seed);
+    for (int64& value : values_) {
+      value = min_value +
+              static_cast<int64>(random.UniformDouble(
+                  0.0, static_cast<double>(max_value - min_value)));
+      value = std::max(min_value, std::min(max_value, value));
+    }
+    values_[1] = min_value;
+    values_[values_.size() - 2] = max_value;
+  }
+
+  int64 Value(RoutingModel::NodeIndex from, RoutingModel::NodeIndex to) {
+    ++num_calls_;
+    return values_[from.value() * size_ + to.value()];
+  }
+  int64 num_calls() const { return num_calls_; }
+  void Set(int from, int to, int64 value) {
+    values_[from * size_ + to] = value;
+  }
+  RoutingModel::NodeEvaluator2* NewCallback() {
+    return NewPermanentCallback(this, &RandomMatrix::Value);
+  }
+
+ private:
+  const int size_;
+  std::vector<int64> values_;
+  int64 num_calls_ = 0;
+};
+
+void CheckSameValues(int size, RoutingModel::NodeEvaluator2* expected,
+                     RoutingModel::NodeEvaluator2* actual) {
+  for (RoutingModel::NodeIndex from(0); from < size; ++from) {
+    for (RoutingModel::NodeIndex to(0); to < size; ++to) {
+      CHECK_EQ(expected->Run(from, to), actual->Run(from, to))
+          << "from " << from << " to " << to;
+    }
+  }
+}
+
+// Caches the values of a matrix with or without compression, and with one or
+// several threads. Values only fit in 64 bits when 'wide' is true: the
+// compressed cache, first filled on 32 bits, must then be refilled and hold
+// the same values as the uncompressed one. Otherwise the compressed cache uses
+// a smaller type, and thus does not have the same values as the uncompressed
+// one.
+void TestBuild(int size, int64 min_value, int64 max_value, bool wide) {
+  RandomMatrix matrix(size, min_value, max_value, size);
+  std::unique_ptr<RoutingModel::NodeEvaluator2> callback(matrix.NewCallback());
+  std::unique_ptr<RoutingCache> uncompressed(
+      RoutingCache::Build(callback.get(), size, 1, false));
+  CheckSameValues(size, callback.get(), uncompressed.get());
+  std::unique_ptr<RoutingCache> compressed(
+      RoutingCache::Build(callback.get(), size, 1, true));
+  CheckSameValues(size, callback.get(), compressed.get());
+  CHECK_EQ(uncompressed->fingerprint(), compressed->fingerprint());
+  CHECK_EQ(wide, compressed->HasSameValues(*uncompressed));
+  CHECK_EQ(wide, uncompressed->HasSameValues(*compressed));
+
+  std::unique_ptr<RoutingCache> compressed_only(
+      RoutingCache::BuildCompressed(callback.get(), size, 1));
+  if (wide) {
+    CHECK(compressed_only == nullptr);
+  } else {
+    CHECK(compressed_only->HasSameValues(*compressed));
+  }
+
+  for (const bool compress : {false, true}) {
+    const RoutingCache& single_thread = compress ? *compressed : *uncompressed;
+    std::unique_ptr<RoutingCache> multi_thread(
+        RoutingCache::Build(callback.get(), size, 4, compress));
+    CheckSameValues(size, callback.get(), multi_thread.get());
+    CHECK_EQ(single_thread.fingerprint(), multi_thread->fingerprint());
+    CHECK(multi_thread->HasSameValues(single_thread));
+  }
+}
+
+// Two distinct callbacks with the same values share the cache of the first
+// one; callbacks with other values, even if only the last one differs, get
+// their own cache.
+void TestSharing() {
+  const int kSize = 20;
+  hash_map<uint64, RoutingModel::NodeEvaluator2*> caches;
+  RandomMatrix matrix(kSize, 0, 1000, 1);
+  RandomMatrix same_matrix(kSize, 0, 1000, 1);
+  RandomMatrix other_matrix(kSize, 0, 1000, 2);
+  std::unique_ptr<RoutingModel::NodeEvaluator2> callback(matrix.NewCallback());
+  std::unique_ptr<RoutingModel::NodeEvaluator2> same_callback(
+      same_matrix.NewCallback());
+  std::unique_ptr<RoutingModel::NodeEvaluator2> other_callback(
+      other_matrix.NewCallback());
+
+  std::unique_ptr<RoutingCache> cache(RoutingCache::FindOrAddSharedCache(
+      RoutingCache::Build(callback.get(), kSize, 1, true), &caches));
+  CHECK_EQ(1, caches.size());
+  CHECK(RoutingCache::FindOrAddSharedCache(
+            RoutingCache::Build(same_callback.get(), kSize, 1, true),
+            &caches) == cache.get());
+  CHECK_EQ(1, caches.size());
+  std::unique_ptr<RoutingCache> other_cache(RoutingCache::FindOrAddSharedCache(
+      RoutingCache::Build(other_callback.get(), kSize, 1, true), &caches));
+  CHECK(other_cache.get() != cache.get());
+  CHECK_EQ(2, caches.size());
+  CheckSameValues(kSize, same_callback.get(), cache.get());
+  CheckSameValues(kSize, other_callback.get(), other_cache.get());
+
+  same_matrix.Set(kSize - 1, kSize - 1, 1001);
+  std::unique_ptr<RoutingCache> last_value_cache(
+      RoutingCache::FindOrAddSharedCache(
+          RoutingCache::Build(same_callback.get(), kSize, 1, true), &caches));
+  CHECK(last_value_cache.get() != cache.get());
+  CHECK_NE(cache->fingerprint(), last_value_cache->fingerprint());
+  CHECK_EQ(3, caches.size());
+  CheckSameValues(kSize, same_callback.get(), last_value_cache.get());
+}
+
+// A cache whose fingerprint is already used by a cache with other values is
+// neither shared nor added; the cache already there is kept.
+void TestFingerprintCollision() {
+  const int kSize = 20;
+  RandomMatrix matrix(kSize, 0, 1000, 1);
+  RandomMatrix other_matrix(kSize, 0, 1000, 2);
+  std::unique_ptr<RoutingModel::NodeEvaluator2> callback(matrix.NewCallback());
+  std::unique_ptr<RoutingModel::NodeEvaluator2> other_callback(
+      other_matrix.NewCallback());
+  std::unique_ptr<RoutingCache> cache(
+      RoutingCache::Build(callback.get(), kSize, 1, true));
+  std::unique_ptr<RoutingCache> other_cache(
+      RoutingCache::Build(other_callback.get(), kSize, 1, true));
+  CHECK_NE(cache->fingerprint(), other_cache->fingerprint());
+
+  // Simulates a collision by registering 'cache' under the fingerprint of
+  // 'other_cache'.
+  hash_map<uint64, RoutingModel::NodeEvaluator2*> caches;
+  caches[other_cache->fingerprint()] = cache.get();
+  CHECK(RoutingCache::FindOrAddSharedCache(other_cache.get(), &caches) ==
+        other_cache.get());
+  CHECK_EQ(1, caches.size());
+  CHECK(caches[other_cache->fingerprint()] == cache.get());
+  CheckSameValues(kSize, other_callback.get(), other_cache.get());
+}
+
+// Adds a dimension on a matrix to a model of 'size' nodes, and returns true
+// if its callback was cached: a cached callback is evaluated on all pairs of
+// nodes when it is added, and not when the dimension evaluates a transit.
+bool IsDimensionCallbackCached(int size, int64 max_value) {
+  RandomMatrix matrix(size, 0, max_value, size);
+  RoutingModel model(size, 1);
+  CHECK(model.AddDimension(matrix.NewCallback(), 0, kint64max, true, "dim"));
+  const int64 num_calls_when_added = matrix.num_calls();
+  model.GetDimensionOrDie("dim").transit_evaluator(0)(0, 1);
+  const bool cached = matrix.num_calls() == num_calls_when_added;
+  CHECK_EQ(cached, num_calls_when_added >= size * size);
+  return cached;
+}
+
+// Above routing_max_cache_size, caches are only kept up to
+// routing_max_compressed_cache_size, if compression is on and the values fit
+// on 32 bits.
+void TestCacheSizeLimits() {
+  FLAGS_routing_cache_callbacks = true;
+  FLAGS_routing_max_cache_size = 10;
+  FLAGS_routing_max_compressed_cache_size = 30;
+  const int64 kWide = static_cast<int64>(kint32max) + 1;
+  for (const bool compress : {false, true}) {
+    FLAGS_routing_compress_cache = compress;
+    CHECK(IsDimensionCallbackCached(10, 1000));
+    CHECK(IsDimensionCallbackCached(10, kWide));
+    CHECK_EQ(compress, IsDimensionCallbackCached(30, 1000));
+    CHECK(!IsDimensionCallbackCached(31, 1000));
+  }
+  // The compressed cache is built, then dropped since the values need 64 bits.
+  RandomMatrix matrix(30, 0, kWide, 30);
+  RoutingModel model(30, 1);
+  CHECK(model.AddDimension(matrix.NewCallback(), 0, kint64max, true, "dim"));
+  CHECK_EQ(30 * 30, matrix.num_calls());
+  model.GetDimensionOrDie("dim").transit_evaluator(0)(0, 1);
+  CHECK_EQ(30 * 30 + 1, matrix.num_calls());
+  FLAGS_routing_cache_callbacks = false;
+}
+
+void RunAllTests() {
+  for (const int size : {2, 7, 50}) {
+    // Values stored on 16 bits, up to the largest one.
+    TestBuild(size, 0, kuint16max, false);
+    TestBuild(size, 0, kuint16max + 1, false);
+    // Values stored on 32 bits: negative values, values above the 16-bit range
+    // and the bounds of the 32-bit range.
+    TestBuild(size, -5, 70000, false);
+    TestBuild(size, kint32min, kint32max, false);
+    // Values overflowing 32 bits.
+    TestBuild(size, 0, static_cast<int64>(kint32max) + 1, true);
+    TestBuild(size, kint64min / 4, kint64max / 4, true);
+  }
+  TestSharing();
+  TestFingerprintCollision();
+  TestCacheSizeLimits();
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
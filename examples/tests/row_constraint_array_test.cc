@@ -0,0 +1,178 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests of the constraints created in bulk by MPSolver::MakeRowConstraintArray:
+// duplicated variables and zeros in a row, lookups in a long row, changes
+// after the bulk creation, and the solve of a model built in bulk compared
+// with the same model built term by term.
+
+#include <cmath>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "linear_solver/linear_solver.h"
+#include "linear_solver/linear_solver.pb.h"
+
+namespace operations_research {
+
+void CheckNear(double expected, double actual) {
+  CHECK_LE(std::abs(expected - actual), 1e-6 * (1.0 + std::abs(expected)))
+      << "expected " << expected << ", got " << actual;
+}
+
+// Returns the number of terms stored in the constraint of the given index,
+// zeros included.
+int NumTerms(const MPSolver& solver, int index) {
+  MPModelProto model;
+  solver.ExportModelToProto(&model);
+  return model.constraint(index).var_index_size();
+}
+
+// The last coefficient of a variable that appears twice is kept, even if it
+// is zero, and the zeros of the other variables are skipped.
+void TestDuplicatesAndZeros() {
+  MPSolver solver("duplicates", MPSolver::GLOP_LINEAR_PROGRAMMING);
+  std::vector<MPVariable*> vars;
+  solver.MakeNumVarArray(4, 0.0, 10.0, "x", &vars);
+  std::vector<MPConstraint*> constraints;
+  solver.MakeRowConstraintArray({0.0, -1.0}, {5.0, 1.0}, {0, 5, 8},
+                                {0, 1, 0, 2, 3, 1, 1, 2},
+                                {1.0, 2.0, 3.0, 0.0, 4.0, 5.0, 0.0, 6.0}, "c",
+                                &constraints);
+  CHECK_EQ(2, constraints.size());
+  CHECK_EQ(2, solver.NumConstraints());
+  CHECK_EQ("c0", constraints[0]->name());
+  CHECK_EQ("c1", constraints[1]->name());
+
+  MPConstraint* const first = constraints[0];
+  CHECK_EQ(0.0, first->lb());
+  CHECK_EQ(5.0, first->ub());
+  CHECK_EQ(3.0, first->GetCoefficient(vars[0]));
+  CHECK_EQ(2.0, first->GetCoefficient(vars[1]));
+  CHECK_EQ(0.0, first->GetCoefficient(vars[2]));
+  CHECK_EQ(4.0, first->GetCoefficient(vars[3]));
+  // The zero of x2 was skipped.
+  CHECK_EQ(3, NumTerms(solver, 0));
+
+  MPConstraint* const second = constraints[1];
+  // x1 was set to 5 and then to 0: the zero is kept, as with SetCoefficient.
+  CHECK_EQ(2, NumTerms(solver, 1));
+  CHECK_EQ(0.0, second->GetCoefficient(vars[1]));
+  CHECK_EQ(6.0, second->GetCoefficient(vars[2]));
+  CHECK_EQ(0.0, second->GetCoefficient(vars[0]));
+}
+
+// A row much longer than the rows looked up by a linear scan, followed by
+// changes of existing and new coefficients.
+void TestLongRow() {
+  const int kNumVars = 1000;
+  MPSolver solver("long_row", MPSolver::GLOP_LINEAR_PROGRAMMING);
+  std::vector<MPVariable*> vars;
+  solver.MakeNumVarArray(kNumVars + 1, 0.0, 1.0, "x", &vars);
+  std::vector<int> var_indices;
+  std::vector<double> coefficients;
+  for (int i = kNumVars - 1; i >= 0; --i) {
+    var_indices.push_back(i);
+    coefficients.push_back(i + 1);
+  }
+  std::vector<MPConstraint*> constraints;
+  solver.MakeRowConstraintArray({0.0}, {1.0}, {0, kNumVars}, var_indices,
+                                coefficients, "", &constraints);
+  MPConstraint* const ct = constraints[0];
+  CHECK_EQ(kNumVars, NumTerms(solver, 0));
+  const MPConstraint& const_ct = *ct;
+  for (int i = 0; i < kNumVars; ++i) {
+    CHECK_EQ(i + 1, const_ct.GetCoefficient(vars[i]));
+  }
+  CHECK_EQ(0.0, const_ct.GetCoefficient(vars[kNumVars]));
+
+  ct->SetCoefficient(vars[10], -2.0);
+  ct->SetCoefficient(vars[kNumVars], 7.0);
+  ct->SetCoefficient(vars[20], 0.0);
+  CHECK_EQ(kNumVars + 1, NumTerms(solver, 0));
+  for (int i = 0; i < kNumVars; ++i) {
+    const double expected = i == 10 ? -2.0 : i == 20 ? 0.0 : i + 1;
+    CHECK_EQ(expected, const_ct.GetCoefficient(vars[i]));
+  }
+  CHECK_EQ(7.0, const_ct.GetCoefficient(vars[kNumVars]));
+}
+
+// Builds a random LP, either with MakeRowConstraintArray or with one
+// SetCoefficient per term, changes a few coefficients after its creation,
+// and returns its optimal objective value.
+double SolveRandomLp(bool bulk, int seed) {
+  const int kNumVars = 40;
+  const int kNumRows = 30;
+  ACMRandom random(seed);
+  MPSolver solver("random_lp", MPSolver::GLOP_LINEAR_PROGRAMMING);
+  std::vector<MPVariable*> vars;
+  solver.MakeNumVarArray(kNumVars, 0.0, 10.0, "x", &vars);
+  std::vector<double> lb;
+  std::vector<double> ub;
+  std::vector<int> row_starts = {0};
+  std::vector<int> var_indices;
+  std::vector<double> coefficients;
+  for (int row = 0; row < kNumRows; ++row) {
+    lb.push_back(-MPSolver::infinity());
+    ub.push_back(random.Uniform(100));
+    // Some rows are long enough to be indexed.
+    const int size = random.OneIn(3) ? 30 : 1 + random.Uniform(8);
+    for (int i = 0; i < size; ++i) {
+      var_indices.push_back(random.Uniform(kNumVars));
+      coefficients.push_back(random.Uniform(10));
+    }
+    row_starts.push_back(var_indices.size());
+  }
+  std::vector<MPConstraint*> constraints;
+  if (bulk) {
+    solver.MakeRowConstraintArray(lb, ub, row_starts, var_indices,
+                                  coefficients, "", &constraints);
+  } else {
+    for (int row = 0; row < kNumRows; ++row) {
+      MPConstraint* const ct = solver.MakeRowConstraint(lb[row], ub[row]);
+      for (int k = row_starts[row]; k < row_starts[row + 1]; ++k) {
+        ct->SetCoefficient(vars[var_indices[k]], coefficients[k]);
+      }
+      constraints.push_back(ct);
+    }
+  }
+  for (int change = 0; change < 20; ++change) {
+    constraints[random.Uniform(kNumRows)]->SetCoefficient(
+        vars[random.Uniform(kNumVars)], random.Uniform(10));
+  }
+  MPObjective* const objective = solver.MutableObjective();
+  for (int var = 0; var < kNumVars; ++var) {
+    objective->SetCoefficient(vars[var], 1 + random.Uniform(5));
+  }
+  objective->SetMaximization();
+  CHECK_EQ(MPSolver::OPTIMAL, solver.Solve());
+  return objective->Value();
+}
+
+void RunAllTests() {
+  TestDuplicatesAndZeros();
+  TestLongRow();
+  for (int seed = 0; seed < 10; ++seed) {
+    CheckNear(SolveRandomLp(false, seed), SolveRandomLp(true, seed));
+  }
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
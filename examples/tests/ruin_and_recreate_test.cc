@@ -0,0 +1,326 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the ruin-and-recreate operator of the routing library on random
+// capacitated problems with optional nodes and pickup and delivery pairs:
+// its neighbors must be complete solutions accepted by the feasibility
+// filters, pairs must be removed together, the nodes which are not removed
+// must keep their order or stay unperformed, and building a solution from
+// partial routes must not modify the solver.
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "constraint_solver/constraint_solver.h"
+#include "constraint_solver/constraint_solveri.h"
+#include "constraint_solver/routing.h"
+
+namespace operations_research {
+
+const int kNumNodes = 25;
+const int kNumVehicles = 4;
+const int64 kCapacity = 25;
+
+// Random customers in a square with random demands, served from node 0.
+class RuinData {
+ public:
+  explicit RuinData(int seed)
+      : x_(kNumNodes), y_(kNumNodes), demand_(kNumNodes, 0) {
+    ACMRandom random(seed);
+    for (int node = 0; node < kNumNodes; ++node) {
+      x_[node] = random.Uniform(100);
+      y_[node] = random.Uniform(100);
+      if (node > 0) demand_[node] = 1 + random.Uniform(9);
+    }
+  }
+
+  int64 Distance(RoutingModel::NodeIndex from, RoutingModel::NodeIndex to) {
+    return std::abs(x_[from.value()] - x_[to.value()]) +
+           std::abs(y_[from.value()] - y_[to.value()]);
+  }
+  int64 Demand(RoutingModel::NodeIndex from, RoutingModel::NodeIndex to) {
+    return demand_[from.value()];
+  }
+
+ private:
+  std::vector<int64> x_;
+  std::vector<int64> y_;
+  std::vector<int64> demand_;
+};
+
+// Insertion heuristic which records the partial routes it starts from.
+class RecordingInsertion
+    : public GlobalCheapestInsertionFilteredDecisionBuilder {
+ public:
+  RecordingInsertion(RoutingModel* model,
+                     const std::vector<LocalSearchFilter*>& filters)
+      : GlobalCheapestInsertionFilteredDecisionBuilder(
+            model,
+            NewPermanentCallback(model, &RoutingModel::GetArcCostForVehicle),
+            NewPermanentCallback(model,
+                                 &RoutingModel::UnperformedPenaltyOrValue, 0),
+            filters) {}
+  bool BuildSolution() override {
+    known_nexts_.resize(Size());
+    for (int node = 0; node < Size(); ++node) {
+      known_nexts_[node] = GetKnownNext(node);
+    }
+    return GlobalCheapestInsertionFilteredDecisionBuilder::BuildSolution();
+  }
+  // Next of each node in the partial routes of the last built solution, -1 if
+  // the node was removed.
+  const std::vector<int64>& known_nexts() const { return known_nexts_; }
+
+ private:
+  std::vector<int64> known_nexts_;
+};
+
+// The feasibility filters of the model, as built by the routing library.
+std::vector<LocalSearchFilter*> MakeFeasibilityFilters(
+    const RoutingModel& model) {
+  return {MakePathCumulFilter(model, model.GetDimensionOrDie("capacity"),
+                              nullptr),
+          MakeNodeDisjunctionFilter(model, nullptr),
+          model.solver()->MakeVariableDomainFilter(),
+          MakeNodePrecedenceFilter(model, model.GetPickupAndDeliveryPairs()),
+          MakeVehicleVarFilter(model)};
+}
+
+// A problem with optional customers, the first num_pairs pairs of customers
+// (1, 2), (3, 4)... being pickup and delivery pairs, and its first solution.
+class RuinAndRecreateTest {
+ public:
+  RuinAndRecreateTest(int num_pairs, int seed)
+      : data_(seed), model_(kNumNodes, kNumVehicles) {
+    model_.SetDepot(RoutingModel::NodeIndex(0));
+    model_.SetArcCostEvaluatorOfAllVehicles(
+        NewPermanentCallback(&data_, &RuinData::Distance));
+    model_.AddDimension(NewPermanentCallback(&data_, &RuinData::Demand), 0,
+                        kCapacity, true, "capacity");
+    for (int node = 1; node < kNumNodes; ++node) {
+      model_.AddDisjunction({RoutingModel::NodeIndex(node)}, 1000);
+    }
+    for (int pair = 0; pair < num_pairs; ++pair) {
+      model_.AddPickupAndDelivery(RoutingModel::NodeIndex(2 * pair + 1),
+                                  RoutingModel::NodeIndex(2 * pair + 2));
+    }
+    RoutingSearchParameters parameters =
+        RoutingModel::DefaultSearchParameters();
+    parameters.set_first_solution_strategy(
+        FirstSolutionStrategy::PARALLEL_CHEAPEST_INSERTION);
+    parameters.set_solution_limit(1);
+    const Assignment* const solution = model_.SolveWithParameters(parameters);
+    CHECK(solution != nullptr);
+    solution_ = model_.solver()->MakeAssignment(solution);
+    for (int node = 0; node < model_.Size(); ++node) {
+      nexts_.push_back(solution_->Value(model_.NextVar(node)));
+    }
+    recreate_ = model_.solver()->RevAlloc(
+        new RecordingInsertion(&model_, MakeFeasibilityFilters(model_)));
+    filters_ = MakeFeasibilityFilters(model_);
+  }
+
+  int NumInactiveNodes() const {
+    int num_inactive_nodes = 0;
+    for (int node = 0; node < model_.Size(); ++node) {
+      if (nexts_[node] == node) ++num_inactive_nodes;
+    }
+    return num_inactive_nodes;
+  }
+
+  // Builds and checks all the neighbors of the current solution; returns
+  // their number.
+  int CheckNeighbors() {
+    LocalSearchOperator* const ruin_and_recreate =
+        MakeRuinAndRecreate(&model_, {}, recreate_, 5, 4);
+    ruin_and_recreate->Start(solution_);
+    Assignment* const empty = model_.solver()->MakeAssignment();
+    for (LocalSearchFilter* const filter : filters_) {
+      filter->Synchronize(solution_, nullptr);
+    }
+    int num_neighbors = 0;
+    Assignment* const delta = model_.solver()->MakeAssignment();
+    Assignment* const deltadelta = model_.solver()->MakeAssignment();
+    while (true) {
+      delta->Clear();
+      deltadelta->Clear();
+      if (!ruin_and_recreate->MakeNextNeighbor(delta, deltadelta)) break;
+      ++num_neighbors;
+      for (LocalSearchFilter* const filter : filters_) {
+        CHECK(filter->Accept(delta, empty)) << filter->DebugString();
+      }
+      std::vector<int64> neighbor = nexts_;
+      for (const IntVarElement& element :
+           delta->IntVarContainer().elements()) {
+        const std::vector<IntVar*>& nexts = model_.Nexts();
+        neighbor[std::find(nexts.begin(), nexts.end(), element.Var()) -
+                 nexts.begin()] = element.Value();
+      }
+      CHECK(neighbor != nexts_);
+      CheckComplete(neighbor);
+      CheckRuinedRoutes(recreate_->known_nexts(), neighbor);
+    }
+    return num_neighbors;
+  }
+
+  // Builds solutions from the routes of the current solution without some of
+  // their nodes, outside of a search: the domains of the variables and the
+  // search statistics of the solver must not change.
+  void CheckBuildSolutionFromRoutes(int seed) {
+    Solver* const solver = model_.solver();
+    std::vector<IntVar*> vars = model_.Nexts();
+    vars.insert(vars.end(), model_.VehicleVars().begin(),
+                model_.VehicleVars().end());
+    const std::vector<IntVar*>& cumuls =
+        model_.GetDimensionOrDie("capacity").cumuls();
+    vars.insert(vars.end(), cumuls.begin(), cumuls.end());
+    std::vector<std::pair<int64, int64>> domains;
+    for (const IntVar* const var : vars) {
+      domains.push_back({var->Min(), var->Max()});
+    }
+    const int64 failures = solver->failures();
+    const int64 branches = solver->branches();
+
+    ACMRandom random(seed);
+    std::vector<bool> removed(model_.Size(), false);
+    for (int node = 0; node < model_.Size(); ++node) {
+      removed[node] = !model_.IsStart(node) && random.OneIn(3);
+    }
+    for (const RoutingModel::NodePair& pair :
+         model_.GetPickupAndDeliveryPairs()) {
+      removed[pair.second] = removed[pair.first];
+    }
+    std::vector<int64> known_nexts(model_.Size());
+    for (int node = 0; node < model_.Size(); ++node) {
+      if (removed[node]) {
+        known_nexts[node] = -1;
+      } else if (nexts_[node] == node) {
+        known_nexts[node] = node;
+      } else {
+        int64 next = nexts_[node];
+        while (!model_.IsEnd(next) && removed[next]) next = nexts_[next];
+        known_nexts[node] = next;
+      }
+    }
+    const Assignment* const solution = recreate_->BuildSolutionFromRoutes(
+        [&known_nexts](int64 node) { return known_nexts[node]; });
+    CHECK(solution != nullptr);
+    std::vector<int64> nexts(model_.Size());
+    for (int node = 0; node < model_.Size(); ++node) {
+      nexts[node] = solution->IntVarContainer().Element(node).Value();
+    }
+    CheckComplete(nexts);
+    CheckRuinedRoutes(known_nexts, nexts);
+
+    CHECK_EQ(Solver::OUTSIDE_SEARCH, solver->state());
+    CHECK_EQ(failures, solver->failures());
+    CHECK_EQ(branches, solver->branches());
+    for (int i = 0; i < vars.size(); ++i) {
+      CHECK_EQ(domains[i].first, vars[i]->Min());
+      CHECK_EQ(domains[i].second, vars[i]->Max());
+    }
+  }
+
+ private:
+  // Each node is either unperformed or on exactly one route, the capacity of
+  // each route is respected and pickups are performed before their deliveries
+  // on the same route, or both are unperformed.
+  void CheckComplete(const std::vector<int64>& nexts) {
+    std::vector<int> vehicles(model_.Size(), -1);
+    std::vector<int> positions(model_.Size(), -1);
+    for (int vehicle = 0; vehicle < kNumVehicles; ++vehicle) {
+      int64 load = 0;
+      int position = 0;
+      for (int64 node = model_.Start(vehicle); !model_.IsEnd(node);
+           node = nexts[node]) {
+        CHECK_EQ(-1, vehicles[node]) << "node " << node;
+        vehicles[node] = vehicle;
+        positions[node] = position++;
+        load += data_.Demand(model_.IndexToNode(node),
+                             model_.IndexToNode(nexts[node]));
+      }
+      CHECK_LE(load, kCapacity);
+    }
+    for (int node = 0; node < model_.Size(); ++node) {
+      CHECK_EQ(vehicles[node] == -1, nexts[node] == node) << "node " << node;
+    }
+    for (const RoutingModel::NodePair& pair :
+         model_.GetPickupAndDeliveryPairs()) {
+      CHECK_EQ(vehicles[pair.first], vehicles[pair.second]);
+      CHECK_LE(positions[pair.first], positions[pair.second]);
+    }
+  }
+
+  // known_nexts are the partial routes from which the nodes with a -1 next
+  // were reinserted into nexts: the pairs must have been removed together,
+  // the other nodes must be in the same order on the same routes, and the
+  // unperformed nodes which were not removed must still be unperformed.
+  void CheckRuinedRoutes(const std::vector<int64>& known_nexts,
+                         const std::vector<int64>& nexts) {
+    for (const RoutingModel::NodePair& pair :
+         model_.GetPickupAndDeliveryPairs()) {
+      CHECK_EQ(known_nexts[pair.first] == -1, known_nexts[pair.second] == -1);
+    }
+    for (int node = 0; node < model_.Size(); ++node) {
+      if (known_nexts[node] == -1) continue;
+      if (known_nexts[node] == node) {
+        CHECK_EQ(node, nexts[node]);
+        continue;
+      }
+      int64 next = nexts[node];
+      while (!model_.IsEnd(next) && known_nexts[next] == -1) {
+        next = nexts[next];
+      }
+      CHECK_EQ(known_nexts[node], next) << "node " << node;
+    }
+  }
+
+  RuinData data_;
+  RoutingModel model_;
+  Assignment* solution_;
+  std::vector<int64> nexts_;
+  RecordingInsertion* recreate_;
+  std::vector<LocalSearchFilter*> filters_;
+};
+
+void RunAllTests() {
+  int num_neighbors = 0;
+  int num_inactive_nodes = 0;
+  for (int seed = 0; seed < 5; ++seed) {
+    for (const int num_pairs : {0, 4}) {
+      RuinAndRecreateTest test(num_pairs, seed);
+      num_inactive_nodes += test.NumInactiveNodes();
+      num_neighbors += test.CheckNeighbors();
+      test.CheckBuildSolutionFromRoutes(seed);
+    }
+  }
+  CHECK_GT(num_neighbors, 0);
+  // The capacity of the vehicles leaves some nodes unperformed.
+  CHECK_GT(num_inactive_nodes, 0);
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
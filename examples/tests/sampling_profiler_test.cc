@@ -0,0 +1,177 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the sampling propagation profiler: the profile of a propagation-heavy
+// search must be made of "frame;frame;frame count" lines naming the model and
+// the sampled constraints. Deleting a solver on another thread than the one
+// that searched must not stop the sampling of the solver searching there.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/commandlineflags.h"
+#include "base/file.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/split.h"
+#include "base/threadpool.h"
+#include "constraint_solver/constraint_solver.h"
+
+DEFINE_string(sampling_profiler_test_file, "/tmp/sampling_profiler_test.txt",
+              "File where the solvers export their sampled profiles.");
+
+namespace operations_research {
+
+ConstraintSolverParameters SamplingParameters() {
+  ConstraintSolverParameters parameters = Solver::DefaultSolverParameters();
+  parameters.set_sampling_profile_file(FLAGS_sampling_profiler_test_file);
+  parameters.set_sampling_profile_period_us(100);
+  return parameters;
+}
+
+// The n-queens problem, one queen per column, whose search enumerates all the
+// solutions: most of the time is spent propagating the AllDifferent
+// constraints.
+DecisionBuilder* BuildQueens(Solver* const solver, int size) {
+  std::vector<IntVar*> queens;
+  solver->MakeIntVarArray(size, 0, size - 1, "queen", &queens);
+  std::vector<IntVar*> up;
+  std::vector<IntVar*> down;
+  for (int i = 0; i < size; ++i) {
+    up.push_back(solver->MakeSum(queens[i], i)->Var());
+    down.push_back(solver->MakeSum(queens[i], -i)->Var());
+  }
+  solver->AddConstraint(solver->MakeAllDifferent(queens));
+  solver->AddConstraint(solver->MakeAllDifferent(up));
+  solver->AddConstraint(solver->MakeAllDifferent(down));
+  return solver->MakePhase(queens, Solver::CHOOSE_FIRST_UNBOUND,
+                           Solver::ASSIGN_MIN_VALUE);
+}
+
+// Runs the current search until its end, or until the given number of
+// solutions.
+void Search(Solver* const solver, int64 max_num_solutions) {
+  int64 num_solutions = 0;
+  while (num_solutions < max_num_solutions && solver->NextSolution()) {
+    ++num_solutions;
+  }
+}
+
+// Checks that the profile only has well-formed lines, and returns the total
+// number of samples. The names of the types of the second frames are added to
+// 'types'.
+int64 CheckProfile(const std::string& profile, const std::string& model_name,
+                   std::vector<std::string>* const types) {
+  int64 num_samples = 0;
+  for (const std::string& line :
+       strings::Split(profile, "\n", strings::SkipEmpty())) {
+    const size_t space = line.rfind(' ');
+    CHECK_NE(std::string::npos, space) << line;
+    const std::string count = line.substr(space + 1);
+    CHECK(!count.empty()) << line;
+    CHECK_EQ(std::string::npos, count.find_first_not_of("0123456789"))
+        << line;
+    const int64 line_count = std::stoll(count);
+    CHECK_GT(line_count, 0) << line;
+    num_samples += line_count;
+
+    const std::vector<std::string> frames =
+        strings::Split(line.substr(0, space), ";", strings::SkipEmpty());
+    CHECK_EQ(model_name, frames[0]) << line;
+    if (frames.size() == 2) {
+      // Samples taken outside of any demon or constraint, or dropped ones.
+      CHECK(frames[1] == "search" || frames[1] == "dropped") << line;
+    } else {
+      CHECK_EQ(3, frames.size()) << line;
+      CHECK(!frames[1].empty()) << line;
+      CHECK(!frames[2].empty()) << line;
+      types->push_back(frames[1]);
+    }
+  }
+  return num_samples;
+}
+
+void TestProfile() {
+  Solver solver("queens", SamplingParameters());
+  DecisionBuilder* const db = BuildQueens(&solver, 11);
+  solver.NewSearch(db);
+  Search(&solver, kint64max);
+  solver.EndSearch();
+
+  const std::string profile = solver.SampledPropagationProfile();
+  std::vector<std::string> types;
+  const int64 num_samples = CheckProfile(profile, "queens", &types);
+  LOG(INFO) << num_samples << " samples:\n" << profile;
+  CHECK_GT(num_samples, 0);
+  // The AllDifferent constraints and their demons must be sampled.
+  bool all_different_found = false;
+  for (const std::string& type : types) {
+    if (type.find("AllDifferent") != std::string::npos) {
+      all_different_found = true;
+    }
+  }
+  CHECK(all_different_found) << profile;
+
+  // The profile is also exported at the end of the search.
+  std::string exported;
+  CHECK(file::GetContents(FLAGS_sampling_profiler_test_file, &exported,
+                          file::Defaults())
+            .ok());
+  CHECK_EQ(profile, exported);
+  File::Delete(FLAGS_sampling_profiler_test_file);
+}
+
+void StartSearch(Solver* solver, DecisionBuilder* db) {
+  solver->NewSearch(db);
+  Search(solver, 1);
+}
+
+// A solver whose search is started on another thread is deleted on this one,
+// while a search of another solver is running here: the sampling of the
+// latter must go on.
+void TestDeleteOnAnotherThread() {
+  Solver solver("local", SamplingParameters());
+  DecisionBuilder* const db = BuildQueens(&solver, 11);
+  solver.NewSearch(db);
+
+  std::unique_ptr<Solver> remote(new Solver("remote", SamplingParameters()));
+  DecisionBuilder* const remote_db = BuildQueens(remote.get(), 8);
+  {
+    ThreadPool pool("RemoteSearch", 1);
+    pool.StartWorkers();
+    pool.Add(NewCallback(&StartSearch, remote.get(), remote_db));
+  }
+  remote.reset();
+
+  Search(&solver, kint64max);
+  std::vector<std::string> types;
+  CHECK_GT(CheckProfile(solver.SampledPropagationProfile(), "local", &types),
+           0);
+  solver.EndSearch();
+  File::Delete(FLAGS_sampling_profiler_test_file);
+}
+
+void RunAllTests() {
+  TestProfile();
+  TestDeleteOnAnotherThread();
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
@@ -0,0 +1,117 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Solves a snapshot of a model several times with different data, and checks
+// the solutions, including when constraints are added after the snapshot.
+
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "constraint_solver/constraint_solver.h"
+
+namespace operations_research {
+
+// The model x + y == sum, y >= min_y, whose data sum and min_y are held by
+// variables.
+class SnapshotTest {
+ public:
+  SnapshotTest()
+      : solver_("snapshot_test"),
+        x_(solver_.MakeIntVar(0, 10, "x")),
+        y_(solver_.MakeIntVar(0, 10, "y")),
+        sum_(solver_.MakeIntVar(0, 10, "sum")),
+        min_y_(solver_.MakeIntVar(0, 10, "min_y")),
+        data_(solver_.MakeAssignment()) {
+    solver_.AddConstraint(
+        solver_.MakeEquality(solver_.MakeSum(x_, y_), sum_));
+    solver_.AddConstraint(solver_.MakeGreaterOrEqual(y_, min_y_));
+    data_->Add(sum_);
+    data_->Add(min_y_);
+  }
+
+  void TestSolveWithDifferentData() {
+    CHECK(solver_.SnapshotModel());
+    CHECK_EQ(2, solver_.model_snapshot_size());
+    // x is maximized, hence y == min_y.
+    CheckSolution(5, 3, true, 2, 3);
+    CheckSolution(8, 1, true, 7, 1);
+    CheckSolution(2, 3, false, 0, 0);
+    CheckSolution(10, 0, true, 10, 0);
+    // The domains reduced by the searches are restored.
+    CHECK_EQ(0, x_->Min());
+    CHECK_EQ(10, x_->Max());
+  }
+
+  // Each search posts the constraints added after the snapshot.
+  void TestConstraintsAddedAfterSnapshot() {
+    CHECK(solver_.SnapshotModel());
+    solver_.AddConstraint(solver_.MakeLessOrEqual(x_, 4));
+    CheckSolution(8, 1, true, 4, 4);
+    CheckSolution(5, 3, true, 2, 3);
+    CheckSolution(10, 0, true, 4, 6);
+    solver_.AddConstraint(solver_.MakeNonEquality(y_, 6));
+    CheckSolution(10, 0, true, 3, 7);
+    CheckSolution(8, 1, true, 4, 4);
+    CHECK_EQ(2, solver_.model_snapshot_size());
+  }
+
+ private:
+  // Solves with the given data, maximizing x, and checks the solution.
+  void CheckSolution(int64 sum, int64 min_y, bool expected_feasible,
+                     int64 expected_x, int64 expected_y) {
+    data_->SetValue(sum_, sum);
+    data_->SetValue(min_y_, min_y);
+    const std::vector<IntVar*> vars = {x_, y_};
+    DecisionBuilder* const db = solver_.Compose(
+        solver_.MakeRestoreAssignment(data_),
+        solver_.MakePhase(vars, Solver::CHOOSE_FIRST_UNBOUND,
+                          Solver::ASSIGN_MAX_VALUE));
+    Assignment* const solution = solver_.MakeAssignment();
+    solution->Add(vars);
+    SolutionCollector* const collector =
+        solver_.MakeFirstSolutionCollector(solution);
+    CHECK_EQ(expected_feasible, solver_.Solve(db, collector));
+    if (expected_feasible) {
+      CHECK_EQ(expected_x, collector->Value(0, x_));
+      CHECK_EQ(expected_y, collector->Value(0, y_));
+    }
+  }
+
+  Solver solver_;
+  IntVar* const x_;
+  IntVar* const y_;
+  IntVar* const sum_;
+  IntVar* const min_y_;
+  Assignment* const data_;
+};
+
+void RunAllTests() {
+  {
+    SnapshotTest test;
+    test.TestSolveWithDifferentData();
+  }
+  {
+    SnapshotTest test;
+    test.TestConstraintsAddedAfterSnapshot();
+  }
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
@@ -0,0 +1,243 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the cache of the masks of the compact table constraints. Tables
+// posted on one tuple set, over variables of different ranges and through
+// different affine transformations, must propagate and find the same solutions
+// as the same tables posted on private copies of the tuple set, which share no
+// masks. The cache must also keep the data of a tuple set alive once all the
+// constraints and tuple sets that used it are destroyed, so that its address
+// cannot be reused by another tuple set.
+
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/stringprintf.h"
+#include "constraint_solver/constraint_solver.h"
+#include "constraint_solver/constraint_solveri.h"
+#include "util/tuple_set.h"
+
+namespace operations_research {
+
+// A random set of num_tuples tuples of the given arity with values in
+// [0, max_value].
+IntTupleSet RandomTuples(int arity, int num_tuples, int max_value,
+                         ACMRandom* const random) {
+  IntTupleSet tuples(arity);
+  std::vector<int64> tuple(arity);
+  while (tuples.NumTuples() < num_tuples) {
+    for (int i = 0; i < arity; ++i) {
+      tuple[i] = random->Uniform(max_value + 1);
+    }
+    tuples.Insert(tuple);
+  }
+  return tuples;
+}
+
+// A copy of the given tuple set that does not share its data.
+IntTupleSet PrivateCopy(const IntTupleSet& tuples) {
+  IntTupleSet copy(tuples.Arity());
+  std::vector<int64> tuple(tuples.Arity());
+  for (int t = 0; t < tuples.NumTuples(); ++t) {
+    for (int i = 0; i < tuples.Arity(); ++i) {
+      tuple[i] = tuples.Value(t, i);
+    }
+    copy.Insert(tuple);
+  }
+  return copy;
+}
+
+// Records the domains of the variables after the initial propagation.
+class RecordDomains : public DecisionBuilder {
+ public:
+  RecordDomains(const std::vector<IntVar*>& vars, std::string* const domains)
+      : vars_(vars), domains_(domains) {}
+  ~RecordDomains() override {}
+
+  Decision* Next(Solver* const s) override {
+    domains_->clear();
+    for (IntVar* const var : vars_) {
+      *domains_ += var->DebugString() + "\n";
+    }
+    return nullptr;
+  }
+
+ private:
+  const std::vector<IntVar*> vars_;
+  std::string* const domains_;
+};
+
+struct TableModelResult {
+  std::string root_domains;
+  std::vector<std::vector<int64>> solutions;
+  int64 branches;
+  int64 failures;
+  int64 cache_hits;
+};
+
+// Posts tables of arity 3 on a sliding window over variables with ranges in
+// [0, 4], seen through the transformations x, x + 2, 2 * x and 9 - x. All the
+// transformed values are in [0, 9], the range of the values of the tuples:
+// the initial propagation does not reduce the ranges before the masks are
+// built. The tables thus request masks with the same key, and with keys that
+// only differ by the factor or the offset of the transformation, by the minimum
+// of the range, or by the size of the range. With 'shared', all the tables use the
+// same tuple set, otherwise each of them uses a private copy.
+TableModelResult SolveTableModel(const IntTupleSet& tuples, bool shared) {
+  Solver solver("table_masks_cache");
+  const int kNumVars = 12;
+  const int64 kMins[] = {0, 1, 0, 0};
+  const int64 kMaxs[] = {4, 4, 3, 4};
+  std::vector<IntVar*> vars;
+  for (int i = 0; i < kNumVars; ++i) {
+    vars.push_back(
+        solver.MakeIntVar(kMins[i % 4], kMaxs[i % 4], StringPrintf("x%d", i)));
+  }
+  // The transformation of a column changes every four windows.
+  const int kShifts[] = {0, 2, 1};
+  for (int start = 0; start + 3 <= kNumVars; ++start) {
+    std::vector<IntVar*> scope;
+    for (int column = 0; column < 3; ++column) {
+      IntVar* const var = vars[start + column];
+      switch ((column + kShifts[start / 4 % 3]) % 4) {
+        case 0:
+          scope.push_back(var);
+          break;
+        case 1:
+          scope.push_back(solver.MakeSum(var, 2)->Var());
+          break;
+        case 2:
+          scope.push_back(solver.MakeProd(var, 2)->Var());
+          break;
+        default:
+          scope.push_back(solver.MakeDifference(9, var)->Var());
+      }
+    }
+    Constraint* const ct = solver.MakeAllowedAssignments(
+        scope, shared ? tuples : PrivateCopy(tuples));
+    CHECK_EQ(0, ct->DebugString().find("CompactPositiveTableConstraint"));
+    solver.AddConstraint(ct);
+  }
+
+  TableModelResult result;
+  RecordDomains record_domains(vars, &result.root_domains);
+  CHECK(solver.Solve(&record_domains));
+  // The next searches propagate the same constraints again, and find all
+  // their masks in the cache.
+  result.cache_hits = solver.TableMasks()->num_hits();
+  solver.NewSearch(solver.MakePhase(vars, Solver::CHOOSE_FIRST_UNBOUND,
+                                    Solver::ASSIGN_MIN_VALUE));
+  while (solver.NextSolution()) {
+    result.solutions.push_back(std::vector<int64>());
+    for (IntVar* const var : vars) {
+      result.solutions.back().push_back(var->Value());
+    }
+  }
+  solver.EndSearch();
+  result.branches = solver.branches();
+  result.failures = solver.failures();
+  return result;
+}
+
+void TestSharedTuplesSetsPropagateAsPrivateCopies(int seed) {
+  ACMRandom random(seed);
+  const IntTupleSet tuples = RandomTuples(3, 250, 9, &random);
+  const TableModelResult shared = SolveTableModel(tuples, true);
+  const TableModelResult private_copies = SolveTableModel(tuples, false);
+  CHECK_GT(shared.cache_hits, 0);
+  CHECK_EQ(0, private_copies.cache_hits);
+  CHECK_EQ(private_copies.root_domains, shared.root_domains);
+  CHECK(private_copies.solutions == shared.solutions);
+  CHECK_EQ(private_copies.branches, shared.branches);
+  CHECK_EQ(private_copies.failures, shared.failures);
+}
+
+// Posts a table on a tuple set owned by the decision builder, during the
+// search. The constraint is destroyed when the search backtracks, and the
+// tuple set when the decision builder returns.
+class PostTemporaryTable : public DecisionBuilder {
+ public:
+  PostTemporaryTable(const std::vector<IntVar*>& vars, int seed,
+                     const int64** const raw_data)
+      : vars_(vars), seed_(seed), raw_data_(raw_data) {}
+  ~PostTemporaryTable() override {}
+
+  Decision* Next(Solver* const s) override {
+    ACMRandom random(seed_);
+    const IntTupleSet tuples = RandomTuples(vars_.size(), 100, 5, &random);
+    *raw_data_ = tuples.RawData();
+    s->AddConstraint(s->MakeAllowedAssignments(vars_, tuples));
+    return nullptr;
+  }
+
+ private:
+  const std::vector<IntVar*> vars_;
+  const int seed_;
+  const int64** const raw_data_;
+};
+
+void TestCacheKeepsTupleSetsAlive() {
+  Solver solver("keep_alive");
+  std::vector<IntVar*> vars;
+  solver.MakeIntVarArray(3, 0, 5, "x", &vars);
+  const int64* raw_data = nullptr;
+  PostTemporaryTable post_table(vars, 0, &raw_data);
+  CHECK(solver.Solve(&post_table));
+  CHECK_EQ(1, solver.TableMasks()->num_inserted() / vars.size());
+
+  // Only the cache holds the data of the tuple set now: the new tuple sets,
+  // of the same size, cannot be allocated at its address.
+  ACMRandom random(1);
+  for (int i = 0; i < 100; ++i) {
+    const IntTupleSet tuples = RandomTuples(vars.size(), 100, 5, &random);
+    CHECK(tuples.RawData() != raw_data);
+  }
+
+  // A table posted on other tuples does not find the masks of the first one.
+  ACMRandom other_random(2);
+  const IntTupleSet other_tuples =
+      RandomTuples(vars.size(), 100, 5, &other_random);
+  solver.AddConstraint(solver.MakeAllowedAssignments(vars, other_tuples));
+  solver.NewSearch(solver.MakePhase(vars, Solver::CHOOSE_FIRST_UNBOUND,
+                                    Solver::ASSIGN_MIN_VALUE));
+  int num_solutions = 0;
+  while (solver.NextSolution()) {
+    std::vector<int64> tuple;
+    for (IntVar* const var : vars) {
+      tuple.push_back(var->Value());
+    }
+    CHECK(other_tuples.Contains(tuple));
+    ++num_solutions;
+  }
+  solver.EndSearch();
+  CHECK_EQ(other_tuples.NumTuples(), num_solutions);
+}
+
+void RunAllTests() {
+  for (int seed = 0; seed < 10; ++seed) {
+    TestSharedTuplesSetsPropagateAsPrivateCopies(seed);
+  }
+  TestCacheKeepsTupleSetsAlive();
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
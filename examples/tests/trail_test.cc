@@ -0,0 +1,229 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that the values saved on the trail of the solver are restored on
+// backtrack, with all the trail compressions. The trail blocks are small, so
+// most of the trail goes through a pack and unpack round trip. Also checks that
+// a reversible value changed in several propagation waves of the same node,
+// and thus saved only once, is restored.
+
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "constraint_solver/constraint_solver.h"
+#include "constraint_solver/constraint_solveri.h"
+
+namespace operations_research {
+
+// One value of each type stored on the trail.
+struct TrailedValues {
+  int int_value = 0;
+  int64 int64_value = 0;
+  uint64 uint64_value = 0;
+  double double_value = 0.0;
+  bool bool_value = false;
+  void* ptr_value = nullptr;
+};
+
+class TrailTest {
+ public:
+  TrailTest(ConstraintSolverParameters::TrailCompression compression,
+            bool pack_in_background)
+      : solver_("trail_test",
+                Parameters(compression, pack_in_background)),
+        random_(12345),
+        values_(kNumValues) {}
+
+  // Goes down kNumLevels levels, back up half of them, down again, and then
+  // back to the root, checking the values restored at each level.
+  void TestBacktrackRestoresValues() {
+    for (int level = 0; level < kNumLevels; ++level) PushLevel();
+    for (int level = 0; level < kNumLevels / 2; ++level) PopLevel();
+    for (int level = 0; level < kNumLevels; ++level) PushLevel();
+    while (!snapshots_.empty()) PopLevel();
+  }
+
+ private:
+  static const int kNumValues = 300;
+  static const int kNumLevels = 20;
+
+  static ConstraintSolverParameters Parameters(
+      ConstraintSolverParameters::TrailCompression compression,
+      bool pack_in_background) {
+    ConstraintSolverParameters parameters = Solver::DefaultSolverParameters();
+    parameters.set_compress_trail(compression);
+    parameters.set_pack_trail_in_background(pack_in_background);
+    parameters.set_trail_block_size(16);
+    return parameters;
+  }
+
+  // Changes random values, in a random order so that the addresses on the
+  // trail go in both directions, with values of all magnitudes.
+  void PushLevel() {
+    snapshots_.push_back(values_);
+    solver_.PushState();
+    for (int change = 0; change < kNumValues; ++change) {
+      TrailedValues* const values = &values_[random_.Uniform(kNumValues)];
+      const int64 value = random_.Next64() >> random_.Uniform(64);
+      switch (random_.Uniform(6)) {
+        case 0:
+          solver_.SaveAndSetValue(&values->int_value, static_cast<int>(value));
+          break;
+        case 1:
+          solver_.SaveAndSetValue(&values->int64_value, -value);
+          break;
+        case 2:
+          solver_.SaveAndSetValue(&values->uint64_value,
+                                  static_cast<uint64>(value));
+          break;
+        case 3:
+          solver_.SaveAndSetValue(&values->double_value,
+                                  random_.UniformDouble(-1e6, 1e6));
+          break;
+        case 4:
+          solver_.SaveAndSetValue(&values->bool_value, !values->bool_value);
+          break;
+        default:
+          solver_.SaveAndSetValue(
+              &values->ptr_value,
+              static_cast<void*>(&values_[random_.Uniform(kNumValues)]));
+      }
+    }
+  }
+
+  void PopLevel() {
+    solver_.PopState();
+    const std::vector<TrailedValues>& expected = snapshots_.back();
+    for (int i = 0; i < kNumValues; ++i) {
+      CHECK_EQ(expected[i].int_value, values_[i].int_value);
+      CHECK_EQ(expected[i].int64_value, values_[i].int64_value);
+      CHECK_EQ(expected[i].uint64_value, values_[i].uint64_value);
+      CHECK_EQ(expected[i].double_value, values_[i].double_value);
+      CHECK_EQ(expected[i].bool_value, values_[i].bool_value);
+      CHECK_EQ(expected[i].ptr_value, values_[i].ptr_value);
+    }
+    snapshots_.pop_back();
+  }
+
+  Solver solver_;
+  ACMRandom random_;
+  std::vector<TrailedValues> values_;
+  std::vector<std::vector<TrailedValues>> snapshots_;
+};
+
+// Increments a reversible counter each time the range of a variable changes.
+// Its demon runs at most once per propagation wave.
+class RangeChangeCounter : public Constraint {
+ public:
+  RangeChangeCounter(Solver* const s, IntVar* const var)
+      : Constraint(s), var_(var), count_(0) {}
+  ~RangeChangeCounter() override {}
+
+  void Post() override {
+    var_->WhenRange(MakeConstraintDemon0(
+        solver(), this, &RangeChangeCounter::Increment, "Increment"));
+  }
+  void InitialPropagate() override {}
+
+  void Increment() {
+    count_.SetValue(solver(), count_.Value() + 1);
+  }
+
+  int count() const { return count_.Value(); }
+
+ private:
+  IntVar* const var_;
+  Rev<int> count_;
+};
+
+// Raises the minimum of the variable twice, in two propagation waves.
+class TwoWaveDecision : public Decision {
+ public:
+  explicit TwoWaveDecision(IntVar* const var) : var_(var) {}
+  ~TwoWaveDecision() override {}
+
+  void Apply(Solver* const s) override {
+    var_->SetMin(1);
+    var_->SetMin(2);
+  }
+  void Refute(Solver* const s) override { var_->SetMax(0); }
+
+ private:
+  IntVar* const var_;
+};
+
+// Applies a TwoWaveDecision, checks the counter in its left branch and fails,
+// and then checks the counter in its right branch.
+class TwoWaveBuilder : public DecisionBuilder {
+ public:
+  TwoWaveBuilder(IntVar* const var, RangeChangeCounter* const counter)
+      : var_(var), counter_(counter), step_(0) {}
+  ~TwoWaveBuilder() override {}
+
+  Decision* Next(Solver* const s) override {
+    switch (step_++) {
+      case 0:
+        CHECK_EQ(0, counter_->count());
+        return s->RevAlloc(new TwoWaveDecision(var_));
+      case 1:
+        // The counter was changed by two waves of the same node, and only
+        // saved on the trail by the first one.
+        CHECK_EQ(2, counter_->count());
+        s->Fail();
+        return nullptr;
+      default:
+        // Both changes were undone before the refutation incremented it.
+        CHECK_EQ(1, counter_->count());
+        return nullptr;
+    }
+  }
+
+ private:
+  IntVar* const var_;
+  RangeChangeCounter* const counter_;
+  int step_;
+};
+
+void TestValueChangedInTwoWavesIsRestored() {
+  Solver solver("two_waves");
+  IntVar* const var = solver.MakeIntVar(0, 10, "var");
+  RangeChangeCounter* const counter =
+      solver.RevAlloc(new RangeChangeCounter(&solver, var));
+  solver.AddConstraint(counter);
+  CHECK(solver.Solve(solver.RevAlloc(new TwoWaveBuilder(var, counter))));
+  CHECK_EQ(0, counter->count());
+}
+
+void RunAllTests() {
+  TestValueChangedInTwoWavesIsRestored();
+  for (const ConstraintSolverParameters::TrailCompression compression :
+       {ConstraintSolverParameters::NO_COMPRESSION,
+        ConstraintSolverParameters::COMPRESS_WITH_ZLIB,
+        ConstraintSolverParameters::COMPRESS_WITH_DELTA_ENCODING}) {
+    for (const bool pack_in_background : {false, true}) {
+      TrailTest test(compression, pack_in_background);
+      test.TestBacktrackRestoresValues();
+    }
+  }
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::RunAllTests();
+  return 0;
+}
@@ -117,6 +117,7 @@ CC_BINARIES = \
 	$(BIN_DIR)/jobshop_sat$E \
 	$(BIN_DIR)/jobshop_earlytardy$E \
 	$(BIN_DIR)/linear_assignment_api$E \
+	$(BIN_DIR)/linear_sum_benchmark$E \
 	$(BIN_DIR)/ls_api$E \
 	$(BIN_DIR)/magic_square$E \
 	$(BIN_DIR)/model_util$E \
@@ -126,6 +127,7 @@ CC_BINARIES = \
 	$(BIN_DIR)/pdptw$E \
 	$(BIN_DIR)/dimacs_assignment$E \
 	$(BIN_DIR)/sports_scheduling$E \
+	$(BIN_DIR)/table_benchmark$E \
 	$(BIN_DIR)/tsp$E \
 	$(BIN_DIR)/weighted_tardiness_sat$E \
 	$(BIN_DIR)/integer_programming$E \
@@ -369,6 +371,12 @@ $(OBJ_DIR)/jobshop_sat.$O: $(EX_DIR)/cpp/jobshop_sat.cc $(CP_DEPS)
 $(BIN_DIR)/jobshop_sat$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/jobshop_sat.$O
 	$(CCC) $(CFLAGS) $(OBJ_DIR)/jobshop_sat.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sjobshop_sat$E
 
+$(OBJ_DIR)/linear_sum_benchmark.$O: $(EX_DIR)/cpp/linear_sum_benchmark.cc $(CP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/linear_sum_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Slinear_sum_benchmark.$O
+
+$(BIN_DIR)/linear_sum_benchmark$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/linear_sum_benchmark.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/linear_sum_benchmark.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Slinear_sum_benchmark$E
+
 $(OBJ_DIR)/magic_square.$O: $(EX_DIR)/cpp/magic_square.cc $(CP_DEPS)
 	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/magic_square.cc $(OBJ_OUT)$(OBJ_DIR)$Smagic_square.$O
 
@@ -423,6 +431,12 @@ $(OBJ_DIR)/sports_scheduling.$O: $(EX_DIR)/cpp/sports_scheduling.cc $(CP_DEPS)
 $(BIN_DIR)/sports_scheduling$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/sports_scheduling.$O
 	$(CCC) $(CFLAGS) $(OBJ_DIR)/sports_scheduling.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Ssports_scheduling$E
 
+$(OBJ_DIR)/table_benchmark.$O: $(EX_DIR)/cpp/table_benchmark.cc $(CP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/table_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Stable_benchmark.$O
+
+$(BIN_DIR)/table_benchmark$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/table_benchmark.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/table_benchmark.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Stable_benchmark$E
+
 $(OBJ_DIR)/tsp.$O: $(EX_DIR)/cpp/tsp.cc $(ROUTING_DEPS)
 	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/tsp.cc $(OBJ_OUT)$(OBJ_DIR)$Stsp.$O
 
@@ -497,6 +511,90 @@ $(OBJ_DIR)/boolean_test.$O: $(EX_DIR)/tests/boolean_test.cc $(SRC_DIR)/constrain
 $(BIN_DIR)/boolean_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/boolean_test.$O
 	$(CCC) $(CFLAGS) $(OBJ_DIR)/boolean_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sboolean_test$E
 
+$(OBJ_DIR)/trail_test.$O: $(EX_DIR)/tests/trail_test.cc $(CP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/trail_test.cc $(OBJ_OUT)$(OBJ_DIR)$Strail_test.$O
+
+$(BIN_DIR)/trail_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/trail_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/trail_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Strail_test$E
+
+$(OBJ_DIR)/nogoods_test.$O: $(EX_DIR)/tests/nogoods_test.cc $(CP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/nogoods_test.cc $(OBJ_OUT)$(OBJ_DIR)$Snogoods_test.$O
+
+$(BIN_DIR)/nogoods_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/nogoods_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/nogoods_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Snogoods_test$E
+
+$(OBJ_DIR)/snapshot_test.$O: $(EX_DIR)/tests/snapshot_test.cc $(CP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/snapshot_test.cc $(OBJ_OUT)$(OBJ_DIR)$Ssnapshot_test.$O
+
+$(BIN_DIR)/snapshot_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/snapshot_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/snapshot_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Ssnapshot_test$E
+
+$(OBJ_DIR)/batched_scal_prod_test.$O: $(EX_DIR)/tests/batched_scal_prod_test.cc $(CP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/batched_scal_prod_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sbatched_scal_prod_test.$O
+
+$(BIN_DIR)/batched_scal_prod_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/batched_scal_prod_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/batched_scal_prod_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sbatched_scal_prod_test$E
+
+$(OBJ_DIR)/parallel_search_test.$O: $(EX_DIR)/tests/parallel_search_test.cc $(CP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/parallel_search_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sparallel_search_test.$O
+
+$(BIN_DIR)/parallel_search_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/parallel_search_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/parallel_search_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sparallel_search_test$E
+
+$(OBJ_DIR)/sampling_profiler_test.$O: $(EX_DIR)/tests/sampling_profiler_test.cc $(CP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/sampling_profiler_test.cc $(OBJ_OUT)$(OBJ_DIR)$Ssampling_profiler_test.$O
+
+$(BIN_DIR)/sampling_profiler_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/sampling_profiler_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/sampling_profiler_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Ssampling_profiler_test$E
+
+$(OBJ_DIR)/reversible_arena_test.$O: $(EX_DIR)/tests/reversible_arena_test.cc $(CP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/reversible_arena_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sreversible_arena_test.$O
+
+$(BIN_DIR)/reversible_arena_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/reversible_arena_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/reversible_arena_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sreversible_arena_test$E
+
+$(OBJ_DIR)/demon_cost_test.$O: $(EX_DIR)/tests/demon_cost_test.cc $(CP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/demon_cost_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sdemon_cost_test.$O
+
+$(BIN_DIR)/demon_cost_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/demon_cost_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/demon_cost_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sdemon_cost_test$E
+
+$(OBJ_DIR)/table_masks_cache_test.$O: $(EX_DIR)/tests/table_masks_cache_test.cc $(CP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/table_masks_cache_test.cc $(OBJ_OUT)$(OBJ_DIR)$Stable_masks_cache_test.$O
+
+$(BIN_DIR)/table_masks_cache_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/table_masks_cache_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/table_masks_cache_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Stable_masks_cache_test$E
+
+$(OBJ_DIR)/path_cumul_filter_test.$O: $(EX_DIR)/tests/path_cumul_filter_test.cc $(ROUTING_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/path_cumul_filter_test.cc $(OBJ_OUT)$(OBJ_DIR)$Spath_cumul_filter_test.$O
+
+$(BIN_DIR)/path_cumul_filter_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/path_cumul_filter_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/path_cumul_filter_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Spath_cumul_filter_test$E
+
+$(OBJ_DIR)/path_operator_neighbors_test.$O: $(EX_DIR)/tests/path_operator_neighbors_test.cc $(ROUTING_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/path_operator_neighbors_test.cc $(OBJ_OUT)$(OBJ_DIR)$Spath_operator_neighbors_test.$O
+
+$(BIN_DIR)/path_operator_neighbors_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/path_operator_neighbors_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/path_operator_neighbors_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Spath_operator_neighbors_test$E
+
+$(OBJ_DIR)/parallel_routing_test.$O: $(EX_DIR)/tests/parallel_routing_test.cc $(ROUTING_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/parallel_routing_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sparallel_routing_test.$O
+
+$(BIN_DIR)/parallel_routing_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/parallel_routing_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/parallel_routing_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sparallel_routing_test$E
+
+$(OBJ_DIR)/ruin_and_recreate_test.$O: $(EX_DIR)/tests/ruin_and_recreate_test.cc $(ROUTING_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/ruin_and_recreate_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sruin_and_recreate_test.$O
+
+$(BIN_DIR)/ruin_and_recreate_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/ruin_and_recreate_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/ruin_and_recreate_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sruin_and_recreate_test$E
+
+$(OBJ_DIR)/routing_cache_test.$O: $(EX_DIR)/tests/routing_cache_test.cc $(ROUTING_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/routing_cache_test.cc $(OBJ_OUT)$(OBJ_DIR)$Srouting_cache_test.$O
+
+$(BIN_DIR)/routing_cache_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/routing_cache_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/routing_cache_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Srouting_cache_test$E
+
 $(OBJ_DIR)/ls_api.$O: $(EX_DIR)/cpp/ls_api.cc $(SRC_DIR)/constraint_solver/constraint_solver.h
 	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/ls_api.cc $(OBJ_OUT)$(OBJ_DIR)$Sls_api.$O
 
@@ -555,6 +653,68 @@ $(OBJ_DIR)/glop/solve.$O: $(EX_DIR)/cpp/solve.cc $(GEN_DIR)/glop/parameters.pb.h
 $(BIN_DIR)/solve$E: $(OBJ_DIR)/glop/solve.$O $(OR_TOOLS_LIBS)
 	$(CCC) $(CFLAGS) $(OBJ_DIR)$Sglop$Ssolve.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Ssolve$E
 
+# LP tests.
+
+$(OBJ_DIR)/forrest_tomlin_test.$O: $(EX_DIR)/tests/forrest_tomlin_test.cc $(GLOP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/forrest_tomlin_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sforrest_tomlin_test.$O
+
+$(BIN_DIR)/forrest_tomlin_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/forrest_tomlin_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/forrest_tomlin_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sforrest_tomlin_test$E
+
+$(OBJ_DIR)/dense_lu_test.$O: $(EX_DIR)/tests/dense_lu_test.cc $(GLOP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/dense_lu_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sdense_lu_test.$O
+
+$(BIN_DIR)/dense_lu_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/dense_lu_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/dense_lu_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sdense_lu_test$E
+
+$(OBJ_DIR)/preprocessor_worklist_test.$O: $(EX_DIR)/tests/preprocessor_worklist_test.cc $(GLOP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/preprocessor_worklist_test.cc $(OBJ_OUT)$(OBJ_DIR)$Spreprocessor_worklist_test.$O
+
+$(BIN_DIR)/preprocessor_worklist_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/preprocessor_worklist_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/preprocessor_worklist_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Spreprocessor_worklist_test$E
+
+$(OBJ_DIR)/concurrent_simplex_test.$O: $(EX_DIR)/tests/concurrent_simplex_test.cc $(GLOP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/concurrent_simplex_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sconcurrent_simplex_test.$O
+
+$(BIN_DIR)/concurrent_simplex_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/concurrent_simplex_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/concurrent_simplex_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sconcurrent_simplex_test$E
+
+$(OBJ_DIR)/glop_mip_test.$O: $(EX_DIR)/tests/glop_mip_test.cc $(LP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/glop_mip_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop_mip_test.$O
+
+$(BIN_DIR)/glop_mip_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/glop_mip_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/glop_mip_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sglop_mip_test$E
+
+$(OBJ_DIR)/row_constraint_array_test.$O: $(EX_DIR)/tests/row_constraint_array_test.cc $(LP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/row_constraint_array_test.cc $(OBJ_OUT)$(OBJ_DIR)$Srow_constraint_array_test.$O
+
+$(BIN_DIR)/row_constraint_array_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/row_constraint_array_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/row_constraint_array_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Srow_constraint_array_test$E
+
+$(OBJ_DIR)/binary_model_test.$O: $(EX_DIR)/tests/binary_model_test.cc $(LP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/binary_model_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sbinary_model_test.$O
+
+$(BIN_DIR)/binary_model_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/binary_model_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/binary_model_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sbinary_model_test$E
+
+$(OBJ_DIR)/batch_solver_test.$O: $(EX_DIR)/tests/batch_solver_test.cc $(LP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/batch_solver_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sbatch_solver_test.$O
+
+$(BIN_DIR)/batch_solver_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/batch_solver_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/batch_solver_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sbatch_solver_test$E
+
+$(OBJ_DIR)/model_validator_test.$O: $(EX_DIR)/tests/model_validator_test.cc $(LP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/model_validator_test.cc $(OBJ_OUT)$(OBJ_DIR)$Smodel_validator_test.$O
+
+$(BIN_DIR)/model_validator_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/model_validator_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/model_validator_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Smodel_validator_test$E
+
+$(OBJ_DIR)/lp_relaxation_hint_test.$O: $(EX_DIR)/tests/lp_relaxation_hint_test.cc $(LP_DEPS)
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/lp_relaxation_hint_test.cc $(OBJ_OUT)$(OBJ_DIR)$Slp_relaxation_hint_test.$O
+
+$(BIN_DIR)/lp_relaxation_hint_test$E: $(OR_TOOLS_LIBS) $(OBJ_DIR)/lp_relaxation_hint_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/lp_relaxation_hint_test.$O $(OR_TOOLS_LNK) $(OR_TOOLS_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Slp_relaxation_hint_test$E
+
 # Sat solver
 
 sat: bin/sat_runner$E
@@ -692,6 +692,7 @@ $(OBJ_DIR)/lp_data/sparse_column.$O: \
 
 GLOP_DEPS = \
     $(SRC_DIR)/glop/basis_representation.h \
+    $(SRC_DIR)/glop/branch_and_bound.h \
     $(SRC_DIR)/glop/dual_edge_norms.h \
     $(SRC_DIR)/glop/entering_variable.h \
     $(SRC_DIR)/glop/lu_factorization.h \
@@ -737,6 +738,7 @@ GLOP_DEPS = \
 
 GLOP_LIB_OBJS = \
     $(OBJ_DIR)/glop/basis_representation.$O \
+    $(OBJ_DIR)/glop/branch_and_bound.$O \
     $(OBJ_DIR)/glop/dual_edge_norms.$O \
     $(OBJ_DIR)/glop/entering_variable.$O \
     $(OBJ_DIR)/glop/initial_basis.$O \
@@ -764,6 +766,15 @@ $(SRC_DIR)/glop/basis_representation.h: \
     $(SRC_DIR)/lp_data/lp_types.h \
     $(SRC_DIR)/lp_data/sparse.h
 
+$(SRC_DIR)/glop/branch_and_bound.h: \
+    $(GEN_DIR)/glop/parameters.pb.h \
+    $(SRC_DIR)/glop/revised_simplex.h \
+    $(SRC_DIR)/util/time_limit.h \
+    $(SRC_DIR)/base/integral_types.h \
+    $(SRC_DIR)/base/macros.h \
+    $(SRC_DIR)/lp_data/lp_data.h \
+    $(SRC_DIR)/lp_data/lp_types.h
+
 $(SRC_DIR)/glop/dual_edge_norms.h: \
     $(SRC_DIR)/glop/basis_representation.h \
     $(GEN_DIR)/glop/parameters.pb.h \
@@ -899,6 +910,13 @@ $(OBJ_DIR)/glop/basis_representation.$O: \
     $(SRC_DIR)/lp_data/lp_utils.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/glop/basis_representation.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Sbasis_representation.$O
 
+$(OBJ_DIR)/glop/branch_and_bound.$O: \
+    $(SRC_DIR)/glop/branch_and_bound.cc \
+    $(SRC_DIR)/glop/branch_and_bound.h \
+    $(SRC_DIR)/glop/status.h \
+    $(SRC_DIR)/base/logging.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/glop/branch_and_bound.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Sbranch_and_bound.$O
+
 $(OBJ_DIR)/glop/dual_edge_norms.$O: \
     $(SRC_DIR)/glop/dual_edge_norms.cc \
     $(SRC_DIR)/glop/dual_edge_norms.h \
@@ -931,7 +949,9 @@ $(OBJ_DIR)/glop/lp_solver.$O: \
     $(SRC_DIR)/base/commandlineflags.h \
     $(SRC_DIR)/base/integral_types.h \
     $(SRC_DIR)/base/join.h \
+    $(SRC_DIR)/base/mutex.h \
     $(SRC_DIR)/base/strutil.h \
+    $(SRC_DIR)/base/threadpool.h \
     $(SRC_DIR)/base/timer.h \
     $(SRC_DIR)/lp_data/lp_types.h \
     $(SRC_DIR)/lp_data/lp_utils.h
@@ -946,7 +966,9 @@ $(OBJ_DIR)/glop/lu_factorization.$O: \
 $(OBJ_DIR)/glop/markowitz.$O: \
     $(SRC_DIR)/glop/markowitz.cc \
     $(SRC_DIR)/glop/markowitz.h \
+    $(SRC_DIR)/base/callback.h \
     $(SRC_DIR)/base/stringprintf.h \
+    $(SRC_DIR)/base/threadpool.h \
     $(SRC_DIR)/lp_data/lp_utils.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/glop/markowitz.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Smarkowitz.$O
 
@@ -2079,20 +2101,43 @@ LP_DEPS = \
     $(SRC_DIR)/bop/bop_util.h
 
 LP_LIB_OBJS = \
+    $(OBJ_DIR)/linear_solver/batch_solver.$O \
+    $(OBJ_DIR)/linear_solver/binary_model.$O \
     $(OBJ_DIR)/linear_solver/bop_interface.$O \
     $(OBJ_DIR)/linear_solver/cbc_interface.$O \
     $(OBJ_DIR)/linear_solver/clp_interface.$O \
     $(OBJ_DIR)/linear_solver/cplex_interface.$O \
     $(OBJ_DIR)/linear_solver/glop_interface.$O \
+    $(OBJ_DIR)/linear_solver/glop_mip_interface.$O \
+    $(OBJ_DIR)/linear_solver/glop_utils.$O \
     $(OBJ_DIR)/linear_solver/glpk_interface.$O \
     $(OBJ_DIR)/linear_solver/gurobi_interface.$O \
     $(OBJ_DIR)/linear_solver/linear_solver.$O \
+    $(OBJ_DIR)/linear_solver/lp_relaxation_hint.$O \
     $(OBJ_DIR)/linear_solver/model_exporter.$O \
     $(OBJ_DIR)/linear_solver/model_validator.$O \
     $(OBJ_DIR)/linear_solver/scip_interface.$O \
     $(OBJ_DIR)/linear_solver/sulum_interface.$O \
     $(OBJ_DIR)/linear_solver/linear_solver.pb.$O
 
+$(SRC_DIR)/linear_solver/batch_solver.h: \
+    $(SRC_DIR)/linear_solver/linear_solver.h \
+    $(GEN_DIR)/linear_solver/linear_solver.pb.h \
+    $(SRC_DIR)/base/integral_types.h \
+    $(SRC_DIR)/base/macros.h \
+    $(SRC_DIR)/base/mutex.h \
+    $(SRC_DIR)/base/threadpool.h
+
+$(SRC_DIR)/linear_solver/binary_model.h: \
+    $(SRC_DIR)/base/integral_types.h \
+    $(SRC_DIR)/base/macros.h \
+    $(SRC_DIR)/base/stringpiece.h
+
+$(SRC_DIR)/linear_solver/glop_utils.h: \
+    $(SRC_DIR)/linear_solver/linear_solver.h \
+    $(SRC_DIR)/lp_data/lp_data.h \
+    $(SRC_DIR)/lp_data/lp_types.h
+
 $(SRC_DIR)/linear_solver/linear_solver.h: \
     $(GEN_DIR)/linear_solver/linear_solver.pb.h \
     $(SRC_DIR)/base/hash.h \
@@ -2112,6 +2157,9 @@ $(SRC_DIR)/linear_solver/linear_solver_ext.h: \
     $(SRC_DIR)/base/strutil.h \
     $(SRC_DIR)/base/timer.h
 
+$(SRC_DIR)/linear_solver/lp_relaxation_hint.h: \
+    $(GEN_DIR)/linear_solver/linear_solver.pb.h
+
 $(SRC_DIR)/linear_solver/model_exporter.h: \
     $(SRC_DIR)/base/hash.h \
     $(SRC_DIR)/base/macros.h
@@ -2119,6 +2167,22 @@ $(SRC_DIR)/linear_solver/model_exporter.h: \
 $(SRC_DIR)/linear_solver/model_validator.h: \
     $(GEN_DIR)/linear_solver/linear_solver.pb.h
 
+$(OBJ_DIR)/linear_solver/batch_solver.$O: \
+    $(SRC_DIR)/linear_solver/batch_solver.cc \
+    $(SRC_DIR)/linear_solver/batch_solver.h \
+    $(SRC_DIR)/base/callback.h \
+    $(SRC_DIR)/base/logging.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/linear_solver/batch_solver.cc $(OBJ_OUT)$(OBJ_DIR)$Slinear_solver$Sbatch_solver.$O
+
+$(OBJ_DIR)/linear_solver/binary_model.$O: \
+    $(SRC_DIR)/linear_solver/binary_model.cc \
+    $(SRC_DIR)/linear_solver/binary_model.h \
+    $(GEN_DIR)/linear_solver/linear_solver.pb.h \
+    $(SRC_DIR)/base/file.h \
+    $(SRC_DIR)/base/join.h \
+    $(SRC_DIR)/base/logging.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/linear_solver/binary_model.cc $(OBJ_OUT)$(OBJ_DIR)$Slinear_solver$Sbinary_model.$O
+
 $(OBJ_DIR)/linear_solver/bop_interface.$O: \
     $(SRC_DIR)/linear_solver/bop_interface.cc \
     $(SRC_DIR)/linear_solver/linear_solver.h \
@@ -2166,6 +2230,8 @@ $(OBJ_DIR)/linear_solver/cplex_interface.$O: \
 
 $(OBJ_DIR)/linear_solver/glop_interface.$O: \
     $(SRC_DIR)/linear_solver/glop_interface.cc \
+    $(SRC_DIR)/linear_solver/binary_model.h \
+    $(SRC_DIR)/linear_solver/glop_utils.h \
     $(SRC_DIR)/linear_solver/linear_solver.h \
     $(SRC_DIR)/base/commandlineflags.h \
     $(SRC_DIR)/base/file.h \
@@ -2180,6 +2246,26 @@ $(OBJ_DIR)/linear_solver/glop_interface.$O: \
     $(GEN_DIR)/glop/parameters.pb.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/linear_solver/glop_interface.cc $(OBJ_OUT)$(OBJ_DIR)$Slinear_solver$Sglop_interface.$O
 
+$(OBJ_DIR)/linear_solver/glop_mip_interface.$O: \
+    $(SRC_DIR)/linear_solver/glop_mip_interface.cc \
+    $(SRC_DIR)/linear_solver/glop_utils.h \
+    $(SRC_DIR)/linear_solver/linear_solver.h \
+    $(SRC_DIR)/base/hash.h \
+    $(SRC_DIR)/base/integral_types.h \
+    $(SRC_DIR)/base/logging.h \
+    $(SRC_DIR)/util/time_limit.h \
+    $(SRC_DIR)/lp_data/lp_data.h \
+    $(SRC_DIR)/lp_data/lp_types.h \
+    $(SRC_DIR)/glop/branch_and_bound.h \
+    $(GEN_DIR)/glop/parameters.pb.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/linear_solver/glop_mip_interface.cc $(OBJ_OUT)$(OBJ_DIR)$Slinear_solver$Sglop_mip_interface.$O
+
+$(OBJ_DIR)/linear_solver/glop_utils.$O: \
+    $(SRC_DIR)/linear_solver/glop_utils.cc \
+    $(SRC_DIR)/linear_solver/glop_utils.h \
+    $(SRC_DIR)/base/logging.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/linear_solver/glop_utils.cc $(OBJ_OUT)$(OBJ_DIR)$Slinear_solver$Sglop_utils.$O
+
 $(OBJ_DIR)/linear_solver/glpk_interface.$O: \
     $(SRC_DIR)/linear_solver/glpk_interface.cc \
     $(SRC_DIR)/linear_solver/linear_solver.h \
@@ -2205,8 +2291,10 @@ $(OBJ_DIR)/linear_solver/gurobi_interface.$O: \
 
 $(OBJ_DIR)/linear_solver/linear_solver.$O: \
     $(SRC_DIR)/linear_solver/linear_solver.cc \
+    $(SRC_DIR)/linear_solver/binary_model.h \
     $(SRC_DIR)/linear_solver/linear_solver.h \
     $(GEN_DIR)/linear_solver/linear_solver.pb.h \
+    $(SRC_DIR)/linear_solver/lp_relaxation_hint.h \
     $(SRC_DIR)/linear_solver/model_exporter.h \
     $(SRC_DIR)/linear_solver/model_validator.h \
     $(SRC_DIR)/base/accurate_sum.h \
@@ -2224,6 +2312,19 @@ $(OBJ_DIR)/linear_solver/linear_solver.$O: \
     $(SRC_DIR)/util/proto_tools.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/linear_solver/linear_solver.cc $(OBJ_OUT)$(OBJ_DIR)$Slinear_solver$Slinear_solver.$O
 
+$(OBJ_DIR)/linear_solver/lp_relaxation_hint.$O: \
+    $(SRC_DIR)/linear_solver/lp_relaxation_hint.cc \
+    $(SRC_DIR)/linear_solver/lp_relaxation_hint.h \
+    $(SRC_DIR)/base/integral_types.h \
+    $(SRC_DIR)/base/logging.h \
+    $(SRC_DIR)/base/macros.h \
+    $(SRC_DIR)/glop/lp_solver.h \
+    $(SRC_DIR)/glop/proto_utils.h \
+    $(SRC_DIR)/lp_data/lp_data.h \
+    $(SRC_DIR)/lp_data/lp_types.h \
+    $(SRC_DIR)/util/time_limit.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/linear_solver/lp_relaxation_hint.cc $(OBJ_OUT)$(OBJ_DIR)$Slinear_solver$Slp_relaxation_hint.$O
+
 $(OBJ_DIR)/linear_solver/model_exporter.$O: \
     $(SRC_DIR)/linear_solver/model_exporter.cc \
     $(GEN_DIR)/linear_solver/linear_solver.pb.h \
@@ -2242,7 +2343,10 @@ $(OBJ_DIR)/linear_solver/model_validator.$O: \
     $(SRC_DIR)/linear_solver/model_validator.cc \
     $(SRC_DIR)/linear_solver/model_validator.h \
     $(SRC_DIR)/base/accurate_sum.h \
+    $(SRC_DIR)/base/callback.h \
     $(SRC_DIR)/base/join.h \
+    $(SRC_DIR)/base/macros.h \
+    $(SRC_DIR)/base/threadpool.h \
     $(SRC_DIR)/util/fp_utils.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/linear_solver/model_validator.cc $(OBJ_OUT)$(OBJ_DIR)$Slinear_solver$Smodel_validator.$O
 
@@ -2349,6 +2453,7 @@ CP_LIB_OBJS = \
     $(OBJ_DIR)/constraint_solver/model_cache.$O \
     $(OBJ_DIR)/constraint_solver/nogoods.$O \
     $(OBJ_DIR)/constraint_solver/pack.$O \
+    $(OBJ_DIR)/constraint_solver/parallel_search.$O \
     $(OBJ_DIR)/constraint_solver/range_cst.$O \
     $(OBJ_DIR)/constraint_solver/resource.$O \
     $(OBJ_DIR)/constraint_solver/routing.$O \
@@ -2408,6 +2513,13 @@ $(SRC_DIR)/constraint_solver/constraint_solveri.h: \
 $(SRC_DIR)/constraint_solver/hybrid.h: \
     $(SRC_DIR)/constraint_solver/constraint_solver.h
 
+$(SRC_DIR)/constraint_solver/parallel_search.h: \
+    $(SRC_DIR)/constraint_solver/constraint_solver.h \
+    $(SRC_DIR)/base/integral_types.h \
+    $(SRC_DIR)/base/macros.h \
+    $(SRC_DIR)/base/mutex.h \
+    $(SRC_DIR)/base/timer.h
+
 $(SRC_DIR)/constraint_solver/routing.h: \
     $(SRC_DIR)/constraint_solver/constraint_solver.h \
     $(SRC_DIR)/constraint_solver/constraint_solveri.h \
@@ -2504,17 +2616,21 @@ $(OBJ_DIR)/constraint_solver/constraint_solver.$O: \
     $(SRC_DIR)/constraint_solver/constraint_solver.h \
     $(SRC_DIR)/constraint_solver/constraint_solveri.h \
     $(GEN_DIR)/constraint_solver/model.pb.h \
+    $(SRC_DIR)/base/callback.h \
     $(SRC_DIR)/base/commandlineflags.h \
     $(SRC_DIR)/base/file.h \
     $(SRC_DIR)/base/integral_types.h \
     $(SRC_DIR)/base/logging.h \
     $(SRC_DIR)/base/macros.h \
     $(SRC_DIR)/base/map_util.h \
+    $(SRC_DIR)/base/mutex.h \
     $(SRC_DIR)/base/random.h \
     $(SRC_DIR)/base/recordio.h \
     $(SRC_DIR)/base/stl_util.h \
     $(SRC_DIR)/base/stringpiece.h \
     $(SRC_DIR)/base/stringprintf.h \
+    $(SRC_DIR)/base/threadpool.h \
+    $(SRC_DIR)/base/time_support.h \
     $(SRC_DIR)/util/tuple_set.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/constraint_solver/constraint_solver.cc $(OBJ_OUT)$(OBJ_DIR)$Sconstraint_solver$Sconstraint_solver.$O
 
@@ -2562,7 +2678,9 @@ $(OBJ_DIR)/constraint_solver/demon_profiler.$O: \
     $(SRC_DIR)/base/file.h \
     $(SRC_DIR)/base/hash.h \
     $(SRC_DIR)/base/integral_types.h \
+    $(SRC_DIR)/base/join.h \
     $(SRC_DIR)/base/logging.h \
+    $(SRC_DIR)/base/mutex.h \
     $(SRC_DIR)/base/status.h \
     $(SRC_DIR)/base/stl_util.h \
     $(SRC_DIR)/base/stringprintf.h
@@ -2763,6 +2881,20 @@ $(OBJ_DIR)/constraint_solver/pack.$O: \
     $(SRC_DIR)/base/stringprintf.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/constraint_solver/pack.cc $(OBJ_OUT)$(OBJ_DIR)$Sconstraint_solver$Spack.$O
 
+$(OBJ_DIR)/constraint_solver/parallel_search.$O: \
+    $(SRC_DIR)/constraint_solver/parallel_search.cc \
+    $(SRC_DIR)/constraint_solver/constraint_solver.h \
+    $(SRC_DIR)/constraint_solver/constraint_solveri.h \
+    $(SRC_DIR)/constraint_solver/parallel_search.h \
+    $(GEN_DIR)/constraint_solver/model.pb.h \
+    $(SRC_DIR)/base/callback.h \
+    $(SRC_DIR)/base/hash.h \
+    $(SRC_DIR)/base/logging.h \
+    $(SRC_DIR)/base/map_util.h \
+    $(SRC_DIR)/base/stringprintf.h \
+    $(SRC_DIR)/base/threadpool.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/constraint_solver/parallel_search.cc $(OBJ_OUT)$(OBJ_DIR)$Sconstraint_solver$Sparallel_search.$O
+
 $(OBJ_DIR)/constraint_solver/range_cst.$O: \
     $(SRC_DIR)/constraint_solver/range_cst.cc \
     $(SRC_DIR)/constraint_solver/constraint_solver.h \
@@ -2800,8 +2932,11 @@ $(OBJ_DIR)/constraint_solver/routing.$O: \
     $(SRC_DIR)/base/integral_types.h \
     $(SRC_DIR)/base/logging.h \
     $(SRC_DIR)/base/map_util.h \
+    $(SRC_DIR)/base/mutex.h \
+    $(SRC_DIR)/base/random.h \
     $(SRC_DIR)/base/stl_util.h \
     $(SRC_DIR)/base/thorough_hash.h \
+    $(SRC_DIR)/base/threadpool.h \
     $(SRC_DIR)/util/saturated_arithmetic.h \
     $(SRC_DIR)/graph/linear_assignment.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/constraint_solver/routing.cc $(OBJ_OUT)$(OBJ_DIR)$Sconstraint_solver$Srouting.$O
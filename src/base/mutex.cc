@@ -24,9 +24,12 @@ bool Mutex::TryLock() { return real_mutex_.try_lock(); }
 
 CondVar::CondVar() {}
 CondVar::~CondVar() {}
+// The mutex must be held by the caller, it is released while waiting and held
+// again on return.
 void CondVar::Wait(Mutex* const mu) {
-  std::unique_lock<std::mutex> mutex_lock(mu->real_mutex_);
+  std::unique_lock<std::mutex> mutex_lock(mu->real_mutex_, std::adopt_lock);
   real_condition_.wait(mutex_lock);
+  mutex_lock.release();
 }
 void CondVar::Signal() { real_condition_.notify_one(); }
 void CondVar::SignalAll() { real_condition_.notify_all(); }
@@ -360,6 +360,7 @@ class BoundsAllDifferent : public BaseAllDifferent {
     Demon* range = MakeDelayedConstraintDemon0(
         solver(), this, &BoundsAllDifferent::IncrementalPropagate,
         "IncrementalPropagate");
+    range->set_cost(Solver::EXPENSIVE_DEMON);
 
     for (int i = 0; i < size(); ++i) {
       vars_[i]->WhenRange(range);
@@ -17,6 +17,7 @@
 
 #include "constraint_solver/constraint_solver.h"
 
+#include <algorithm>
 #include <csetjmp>
 #include <deque>
 #include <iosfwd>
@@ -24,6 +25,7 @@
 #include <string>
 #include "base/random.h"
 
+#include "base/callback.h"
 #include "base/commandlineflags.h"
 #include "base/integral_types.h"
 #include "base/logging.h"
@@ -34,7 +36,10 @@
 #include "base/stringpiece.h"
 #include "zlib.h"
 #include "base/map_util.h"
+#include "base/mutex.h"
 #include "base/stl_util.h"
+#include "base/threadpool.h"
+#include "base/time_support.h"
 #include "constraint_solver/constraint_solveri.h"
 #include "constraint_solver/model.pb.h"
 #include "util/tuple_set.h"
@@ -56,6 +61,12 @@ DEFINE_bool(cp_disable_solve, false,
 DEFINE_string(cp_profile_file, "", "Export profiling overview to file.");
 DEFINE_bool(cp_print_local_search_profile, false,
             "Print local search profiling data after solving.");
+DEFINE_string(cp_sampling_profile_file, "",
+              "Export the samples of the propagation, in the collapsed-stack "
+              "format of flame graphs, to file.");
+DEFINE_int32(cp_sampling_profile_period_us, 1000,
+             "Period of the sampling propagation profiler, in microseconds "
+             "of CPU time.");
 DEFINE_bool(cp_name_variables, false, "Force all variables to have names.");
 DEFINE_bool(cp_name_cast_variables, false,
             "Name variables casted from expressions");
@@ -89,6 +100,9 @@ DEFINE_bool(cp_diffn_use_cumulative, true,
             "Diffn constraint adds redundant cumulative constraint");
 DEFINE_bool(cp_use_element_rmq, true,
             "If true, rmq's will be used in element expressions.");
+DEFINE_int32(cp_batched_sum_threshold, 64,
+             "Sums and scalar products with at least this number of terms "
+             "use the batched linear propagator. 0 disables it.");
 
 void ConstraintSolverFailsHere() { VLOG(3) << "Fail"; }
 
@@ -126,6 +140,8 @@ ConstraintSolverParameters Solver::DefaultSolverParameters() {
   params.set_profile_file(FLAGS_cp_profile_file);
   params.set_profile_local_search(FLAGS_cp_print_local_search_profile);
   params.set_print_local_search_profile(FLAGS_cp_print_local_search_profile);
+  params.set_sampling_profile_file(FLAGS_cp_sampling_profile_file);
+  params.set_sampling_profile_period_us(FLAGS_cp_sampling_profile_period_us);
   params.set_print_model(FLAGS_cp_print_model);
   params.set_print_model_stats(FLAGS_cp_model_stats);
   params.set_export_file(FLAGS_cp_export_file);
@@ -146,6 +162,7 @@ ConstraintSolverParameters Solver::DefaultSolverParameters() {
   params.set_max_edge_finder_size(FLAGS_cp_max_edge_finder_size);
   params.set_diffn_use_cumulative(FLAGS_cp_diffn_use_cumulative);
   params.set_use_element_rmq(FLAGS_cp_use_element_rmq);
+  params.set_batched_sum_threshold(FLAGS_cp_batched_sum_threshold);
   return params;
 }
 
@@ -156,6 +173,11 @@ extern void InstallDemonProfiler(DemonProfiler* const monitor);
 extern LocalSearchProfiler* BuildLocalSearchProfiler(Solver* solver);
 extern void DeleteLocalSearchProfiler(LocalSearchProfiler* monitor);
 extern void InstallLocalSearchProfiler(LocalSearchProfiler* monitor);
+extern PropagationSampler* BuildPropagationSampler(Solver* const solver);
+extern void DeletePropagationSampler(PropagationSampler* const sampler);
+extern void StartPropagationSampler(PropagationSampler* const sampler);
+extern void StopPropagationSampler(PropagationSampler* const sampler);
+extern void DrainPropagationSampler(PropagationSampler* const sampler);
 
 // TODO(user): remove this complex logic.
 // We need the double test because parameters are set too late when using
@@ -174,6 +196,10 @@ bool Solver::IsLocalSearchProfilingEnabled() const {
          parameters_.print_local_search_profile();
 }
 
+bool Solver::IsSamplingProfilingEnabled() const {
+  return !parameters_.sampling_profile_file().empty();
+}
+
 bool Solver::InstrumentsVariables() const {
   return parameters_.trace_propagation();
 }
@@ -212,6 +238,7 @@ class Queue {
 
   explicit Queue(Solver* const s)
       : solver_(s),
+        num_delayed_demons_(0),
         stamp_(1),
         freeze_level_(0),
         in_process_(false),
@@ -239,39 +266,48 @@ class Queue {
       if (++solver_->demon_runs_[demon->priority()] % kTestPeriod == 0) {
         solver_->TopPeriodicCheck();
       }
+      solver_->running_demon_ = demon;
       demon->Run(solver_);
       solver_->CheckFail();
+      solver_->running_demon_ = nullptr;
     } else {
       solver_->GetPropagationMonitor()->BeginDemonRun(demon);
       if (++solver_->demon_runs_[demon->priority()] % kTestPeriod == 0) {
         solver_->TopPeriodicCheck();
       }
+      solver_->running_demon_ = demon;
       demon->Run(solver_);
       solver_->CheckFail();
+      solver_->running_demon_ = nullptr;
       solver_->GetPropagationMonitor()->EndDemonRun(demon);
     }
   }
 
+  // Runs the pending demons until the fixpoint: the variable demons first,
+  // then the delayed demons by increasing cost.
   void Process() {
     if (!in_process_) {
       in_process_ = true;
-      while (!var_queue_.empty() || !delayed_queue_.empty()) {
+      for (;;) {
         if (!var_queue_.empty()) {
           Demon* const demon = var_queue_.front();
           var_queue_.pop_front();
           ProcessOneDemon(demon);
-        } else {
-          DCHECK(!delayed_queue_.empty());
-          Demon* const demon = delayed_queue_.front();
-          delayed_queue_.pop_front();
+        } else if (num_delayed_demons_ > 0) {
+          Demon* const demon = PopCheapestDelayedDemon();
           ProcessOneDemon(demon);
+        } else {
+          break;
         }
       }
       in_process_ = false;
     }
   }
 
+  // The demons are run from the demon of a variable, which is restored as
+  // the running demon afterwards.
   void ExecuteAll(const SimpleRevFIFO<Demon*>& demons) {
+    Demon* const variable_demon = solver_->running_demon_;
     if (!instruments_demons_) {
       for (SimpleRevFIFO<Demon*>::Iterator it(&demons); it.ok(); ++it) {
         Demon* const demon = *it;
@@ -281,6 +317,7 @@ class Queue {
               0) {
             solver_->TopPeriodicCheck();
           }
+          solver_->running_demon_ = demon;
           demon->Run(solver_);
           solver_->CheckFail();
         }
@@ -295,12 +332,14 @@ class Queue {
               0) {
             solver_->TopPeriodicCheck();
           }
+          solver_->running_demon_ = demon;
           demon->Run(solver_);
           solver_->CheckFail();
           solver_->GetPropagationMonitor()->EndDemonRun(demon);
         }
       }
     }
+    solver_->running_demon_ = variable_demon;
   }
 
   void EnqueueAll(const SimpleRevFIFO<Demon*>& demons) {
@@ -309,6 +348,8 @@ class Queue {
     }
   }
 
+  // A demon is in the queue if and only if its stamp is the one of the
+  // queue. Then the new event is merged with the pending one.
   void EnqueueVar(Demon* const demon) {
     DCHECK(demon->priority() == Solver::VAR_PRIORITY);
     if (demon->stamp() < stamp_) {
@@ -317,6 +358,8 @@ class Queue {
       if (freeze_level_ == 0) {
         Process();
       }
+    } else if (demon->stamp() == stamp_) {
+      ++solver_->merged_demon_events_[Solver::VAR_PRIORITY];
     }
   }
 
@@ -324,14 +367,20 @@ class Queue {
     DCHECK(demon->priority() == Solver::DELAYED_PRIORITY);
     if (demon->stamp() < stamp_) {
       demon->set_stamp(stamp_);
-      delayed_queue_.push_back(demon);
+      delayed_queues_[demon->cost()].push_back(demon);
+      ++num_delayed_demons_;
+    } else if (demon->stamp() == stamp_) {
+      ++solver_->merged_demon_events_[Solver::DELAYED_PRIORITY];
     }
   }
 
   void AfterFailure() {
     // Clean queue.
     var_queue_.clear();
-    delayed_queue_.clear();
+    for (std::deque<Demon*>& delayed_queue : delayed_queues_) {
+      delayed_queue.clear();
+    }
+    num_delayed_demons_ = 0;
 
     // Call cleaning actions on variables.
     if (clean_action_ != nullptr) {
@@ -381,7 +430,13 @@ class Queue {
       for (int counter = 0; counter < to_add_.size(); ++counter) {
         Constraint* const constraint = to_add_[counter];
         // TODO(user): Add profiling to initial propagation
+        // A constraint can be added while another one is posted, for instance
+        // by a demon it runs, so the posted constraint is restored afterwards.
+        Constraint* const previous_posted_constraint =
+            solver_->posted_constraint_;
+        solver_->posted_constraint_ = constraint;
         constraint->PostAndPropagate();
+        solver_->posted_constraint_ = previous_posted_constraint;
       }
       in_add_ = false;
       to_add_.clear();
@@ -389,9 +444,25 @@ class Queue {
   }
 
  private:
+  Demon* PopCheapestDelayedDemon() {
+    DCHECK_GT(num_delayed_demons_, 0);
+    --num_delayed_demons_;
+    for (std::deque<Demon*>& delayed_queue : delayed_queues_) {
+      if (!delayed_queue.empty()) {
+        Demon* const demon = delayed_queue.front();
+        delayed_queue.pop_front();
+        return demon;
+      }
+    }
+    LOG(FATAL) << "No delayed demon to pop.";
+    return nullptr;
+  }
+
   Solver* const solver_;
   std::deque<Demon*> var_queue_;
-  std::deque<Demon*> delayed_queue_;
+  // One queue per demon cost.
+  std::deque<Demon*> delayed_queues_[Solver::kNumDemonCosts];
+  int num_delayed_demons_;
   uint64 stamp_;
   // The number of nested freeze levels. The queue is frozen if and only if
   // freeze_level_ > 0.
@@ -404,6 +475,88 @@ class Queue {
   const bool instruments_demons_;
 };
 
+// ------------------ Reversible arena -----------
+
+namespace {
+// A bump-pointer allocator for the reversible memory of the solver. Memory is
+// carved out of large blocks, and released in O(1) by moving the allocation
+// point back to a mark taken earlier, which is valid because the reversible
+// memory is released in the reverse order of its allocation. Blocks are only
+// freed with the arena, so they are reused by the allocations that follow a
+// release.
+class ReversibleArena {
+ public:
+  // A position in the arena.
+  struct Mark {
+    Mark() : block(-1), offset(0) {}
+    int block;
+    size_t offset;
+  };
+
+  explicit ReversibleArena(size_t block_size)
+      : block_size_(block_size), current_block_(-1), offset_(0) {}
+
+  // Allocates size bytes, aligned on kArenaAlignment bytes.
+  void* Allocate(size_t size) {
+    size = (size + Solver::kArenaAlignment - 1) &
+           ~(Solver::kArenaAlignment - 1);
+    if (current_block_ < 0 || offset_ + size > blocks_[current_block_].size) {
+      NextBlock(size);
+    }
+    void* const memory = blocks_[current_block_].memory.get() + offset_;
+    offset_ += size;
+    return memory;
+  }
+
+  Mark GetMark() const {
+    Mark mark;
+    mark.block = current_block_;
+    mark.offset = offset_;
+    return mark;
+  }
+
+  // Releases all the memory allocated since the mark was taken.
+  void ReleaseTo(const Mark& mark) {
+    DCHECK(mark.block < current_block_ ||
+           (mark.block == current_block_ && mark.offset <= offset_));
+    current_block_ = mark.block;
+    offset_ = mark.offset;
+  }
+
+ private:
+  struct Block {
+    std::unique_ptr<char[]> memory;
+    size_t size;
+  };
+
+  // Moves to the next block, which must hold at least size bytes. A new block
+  // is inserted if the next one is missing or too small; the blocks after the
+  // current one are not referenced by any mark.
+  void NextBlock(size_t size) {
+    ++current_block_;
+    offset_ = 0;
+    if (current_block_ == blocks_.size() ||
+        blocks_[current_block_].size < size) {
+      Block block;
+      block.size = std::max(block_size_, size);
+      block.memory.reset(new char[block.size]);
+      blocks_.insert(blocks_.begin() + current_block_, std::move(block));
+    }
+  }
+
+  const size_t block_size_;
+  std::vector<Block> blocks_;
+  int current_block_;
+  size_t offset_;
+};
+
+// Size of the blocks of the arena of the objects allocated outside of search,
+// which are usually numerous.
+const size_t kModelArenaBlockSize = 1 << 20;
+// Size of the blocks of the arena of the objects allocated during search.
+const size_t kSearchArenaBlockSize = 64 << 10;
+}  // namespace
+
 // ------------------ StateMarker / StateInfo struct -----------
 
 struct StateInfo {  // This is an internal structure to store
@@ -463,6 +616,9 @@ struct StateMarker {
   int rev_object_array_memory_index_;
   int rev_memory_index_;
   int rev_memory_array_index_;
+  int rev_arena_object_index_;
+  ReversibleArena::Mark model_arena_mark_;
+  ReversibleArena::Mark search_arena_mark_;
   StateInfo info_;
 };
 
@@ -480,6 +636,9 @@ StateMarker::StateMarker(Solver::MarkerType t, const StateInfo& info)
       rev_double_memory_index_(0),
       rev_object_memory_index_(0),
       rev_object_array_memory_index_(0),
+      rev_memory_index_(0),
+      rev_memory_array_index_(0),
+      rev_arena_object_index_(0),
       info_(info) {}
 
 // ---------- Trail and Reversibility ----------
@@ -492,9 +651,12 @@ namespace {
 template <class T>
 struct addrval {
  public:
-  addrval() : address_(nullptr) {}
+  addrval() : address_(nullptr), old_value_() {}
   explicit addrval(T* adr) : address_(adr), old_value_(*adr) {}
+  addrval(T* adr, T old_value) : address_(adr), old_value_(old_value) {}
   void restore() const { (*address_) = old_value_; }
+  T* address() const { return address_; }
+  const T& old_value() const { return old_value_; }
 
  private:
   T* address_;
@@ -582,13 +744,196 @@ class ZlibTrailPacker : public TrailPacker<T> {
   DISALLOW_COPY_AND_ASSIGN(ZlibTrailPacker<T>);
 };
 
+// ----- Delta encoding packer -----
+
+// Conversions of the values of the trail to and from 64 bits integers, chosen
+// to give small integers for the usual values: small integers are kept as is,
+// pointers are encoded as the difference with the previous pointer.
+inline uint64 ZigZagEncode(int64 value) {
+  return (static_cast<uint64>(value) << 1) ^ static_cast<uint64>(value >> 63);
+}
+
+inline int64 ZigZagDecode(uint64 value) {
+  return static_cast<int64>(value >> 1) ^ -static_cast<int64>(value & 1);
+}
+
+template <class T>
+struct TrailValueCodec {
+  static uint64 Encode(T value, T previous) { return ZigZagEncode(value); }
+  static T Decode(uint64 code, T previous) {
+    return static_cast<T>(ZigZagDecode(code));
+  }
+};
+
+template <>
+struct TrailValueCodec<uint64> {
+  static uint64 Encode(uint64 value, uint64 previous) { return value; }
+  static uint64 Decode(uint64 code, uint64 previous) { return code; }
+};
+
+template <>
+struct TrailValueCodec<double> {
+  // The bytes of the double, reversed so that the exponent and the high bits
+  // of the mantissa, which carry the information of round values, come first.
+  static uint64 Encode(double value, double previous) {
+    uint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return ReverseBytes(bits);
+  }
+  static double Decode(uint64 code, double previous) {
+    const uint64 bits = ReverseBytes(code);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+  static uint64 ReverseBytes(uint64 bits) {
+    uint64 reversed = 0;
+    for (int i = 0; i < 8; ++i) {
+      reversed = (reversed << 8) | (bits & 0xFF);
+      bits >>= 8;
+    }
+    return reversed;
+  }
+};
+
+template <>
+struct TrailValueCodec<void*> {
+  static uint64 Encode(void* value, void* previous) {
+    return ZigZagEncode(reinterpret_cast<intptr_t>(value) -
+                        reinterpret_cast<intptr_t>(previous));
+  }
+  static void* Decode(uint64 code, void* previous) {
+    return reinterpret_cast<void*>(reinterpret_cast<intptr_t>(previous) +
+                                   ZigZagDecode(code));
+  }
+};
+
+// Packs a block of the trail as a sequence of variable-length integers (7 bits
+// per byte, the high bit marking the continuation). The address of each entry
+// is encoded as the difference with the previous address, in units of
+// sizeof(T) when possible: the saved values are often fields of the same
+// objects, or neighbours in arrays. The values are encoded by
+// TrailValueCodec<T>. This is several times faster than zlib on both sides.
+template <class T>
+class DeltaEncodingTrailPacker : public TrailPacker<T> {
+ public:
+  explicit DeltaEncodingTrailPacker(int block_size)
+      : TrailPacker<T>(block_size),
+        block_size_(block_size),
+        // Two 64 bits integers per entry, of at most 10 bytes each.
+        tmp_block_(new char[20 * block_size]) {}
+  ~DeltaEncodingTrailPacker() override {}
+
+  void Pack(const addrval<T>* block, std::string* packed_block) override {
+    DCHECK(block != nullptr);
+    DCHECK(packed_block != nullptr);
+    char* out = tmp_block_.get();
+    intptr_t previous_address = 0;
+    T previous_value = T();
+    for (int i = 0; i < block_size_; ++i) {
+      const intptr_t address = reinterpret_cast<intptr_t>(block[i].address());
+      out = WriteVarint(EncodeAddressDelta(address - previous_address), out);
+      out = WriteVarint(
+          TrailValueCodec<T>::Encode(block[i].old_value(), previous_value),
+          out);
+      previous_address = address;
+      previous_value = block[i].old_value();
+    }
+    packed_block->assign(tmp_block_.get(), out - tmp_block_.get());
+  }
+
+  void Unpack(const std::string& packed_block, addrval<T>* block) override {
+    DCHECK(block != nullptr);
+    const char* in = packed_block.data();
+    intptr_t address = 0;
+    T value = T();
+    for (int i = 0; i < block_size_; ++i) {
+      uint64 code;
+      in = ReadVarint(in, &code);
+      address += DecodeAddressDelta(code);
+      in = ReadVarint(in, &code);
+      value = TrailValueCodec<T>::Decode(code, value);
+      block[i] = addrval<T>(reinterpret_cast<T*>(address), value);
+    }
+    DCHECK_EQ(packed_block.data() + packed_block.size(), in);
+  }
+
+ private:
+  // The lowest bit tells whether the delta is a multiple of sizeof(T), in
+  // which case it is stored divided by sizeof(T).
+  static uint64 EncodeAddressDelta(intptr_t delta) {
+    if (delta % static_cast<intptr_t>(sizeof(T)) == 0) {
+      return ZigZagEncode(delta / static_cast<intptr_t>(sizeof(T))) << 1;
+    }
+    return (ZigZagEncode(delta) << 1) | 1;
+  }
+
+  static intptr_t DecodeAddressDelta(uint64 code) {
+    const intptr_t delta = ZigZagDecode(code >> 1);
+    return (code & 1) ? delta : delta * static_cast<intptr_t>(sizeof(T));
+  }
+
+  static char* WriteVarint(uint64 value, char* out) {
+    while (value >= 0x80) {
+      *out++ = static_cast<char>(value | 0x80);
+      value >>= 7;
+    }
+    *out++ = static_cast<char>(value);
+    return out;
+  }
+
+  static const char* ReadVarint(const char* in, uint64* value) {
+    uint64 result = 0;
+    int shift = 0;
+    uint8 byte;
+    do {
+      byte = static_cast<uint8>(*in++);
+      result |= static_cast<uint64>(byte & 0x7F) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    *value = result;
+    return in;
+  }
+
+  const int block_size_;
+  std::unique_ptr<char[]> tmp_block_;
+  DISALLOW_COPY_AND_ASSIGN(DeltaEncodingTrailPacker<T>);
+};
+
+template <class T>
+TrailPacker<T>* BuildTrailPacker(
+    int block_size,
+    ConstraintSolverParameters::TrailCompression compression_level) {
+  switch (compression_level) {
+    case ConstraintSolverParameters::NO_COMPRESSION:
+      return new NoCompressionTrailPacker<T>(block_size);
+    case ConstraintSolverParameters::COMPRESS_WITH_ZLIB:
+      return new ZlibTrailPacker<T>(block_size);
+    case ConstraintSolverParameters::COMPRESS_WITH_DELTA_ENCODING:
+      return new DeltaEncodingTrailPacker<T>(block_size);
+    default:
+      LOG(ERROR) << "Should not be here";
+      return new NoCompressionTrailPacker<T>(block_size);
+  }
+}
+
 template <class T>
 class CompressedTrail {
  public:
+  // If packing_thread is not nullptr, the full blocks are packed, and the
+  // blocks below the top of the trail are unpacked, by this thread. Otherwise
+  // this is done synchronously, with one uncompressed block kept as buffer.
   CompressedTrail(
       int block_size,
-      ConstraintSolverParameters::TrailCompression compression_level)
-      : block_size_(block_size),
+      ConstraintSolverParameters::TrailCompression compression_level,
+      ThreadPool* const packing_thread)
+      : packer_(BuildTrailPacker<T>(block_size, compression_level)),
+        background_packer_(packing_thread == nullptr
+                               ? nullptr
+                               : BuildTrailPacker<T>(block_size,
+                                                     compression_level)),
+        packing_thread_(packing_thread),
+        block_size_(block_size),
         blocks_(nullptr),
         free_blocks_(nullptr),
         data_(new addrval<T>[ block_size ]),
@@ -596,18 +941,6 @@ class CompressedTrail {
         buffer_used_(false),
         current_(0),
         size_(0) {
-    switch (compression_level) {
-      case ConstraintSolverParameters::NO_COMPRESSION: {
-        packer_.reset(new NoCompressionTrailPacker<T>(block_size));
-        break;
-      }
-      case ConstraintSolverParameters::COMPRESS_WITH_ZLIB: {
-        packer_.reset(new ZlibTrailPacker<T>(block_size));
-        break;
-      }
-      default: { LOG(ERROR) << "Should not be here"; }
-    }
-
     // We zero all memory used by addrval arrays.
     // Because of padding, all bytes may not be initialized, while compression
     // will read them all, even if the uninitialized bytes are never used.
@@ -616,6 +949,7 @@ class CompressedTrail {
     memset(data_.get(), 0, sizeof(*data_.get()) * block_size);
     memset(buffer_.get(), 0, sizeof(*buffer_.get()) * block_size);
   }
+  // The packing thread must have been stopped.
   ~CompressedTrail() {
     FreeBlocks(blocks_);
     FreeBlocks(free_blocks_);
@@ -629,7 +963,12 @@ class CompressedTrail {
     if (size_ > 0) {
       --current_;
       if (current_ <= 0) {
-        if (buffer_used_) {
+        if (packing_thread_ != nullptr) {
+          if (blocks_ != nullptr) {
+            PopBlockInBackgroundMode();
+            current_ = block_size_;
+          }
+        } else if (buffer_used_) {
           data_.swap(buffer_);
           current_ = block_size_;
           buffer_used_ = false;
@@ -644,7 +983,9 @@ class CompressedTrail {
   }
   void PushBack(const addrval<T>& addr_val) {
     if (current_ >= block_size_) {
-      if (buffer_used_) {  // Buffer is used.
+      if (packing_thread_ != nullptr) {
+        PushBlockInBackgroundMode();
+      } else if (buffer_used_) {  // Buffer is used.
         NewTopBlock();
         packer_->Pack(buffer_.get(), &blocks_->compressed);
         // O(1) operation.
@@ -662,15 +1003,30 @@ class CompressedTrail {
   int64 size() const { return size_; }
 
  private:
+  // Number of blocks kept uncompressed below the current block in background
+  // mode.
+  static const int kNumUncompressedBlocks = 2;
+
+  // In background mode, a block is either uncompressed (in raw) or packed (in
+  // compressed). The packing thread brings it to the state given by
+  // should_pack. All these fields are protected by mutex_ in background mode.
   struct Block {
     std::string compressed;
-    Block* next;
+    std::unique_ptr<addrval<T>[]> raw;
+    bool packed = true;
+    bool should_pack = true;
+    // True while the packing thread works on the block.
+    bool busy = false;
+    // False when the block is in free_blocks_.
+    bool in_use = false;
+    Block* next = nullptr;
   };
 
   void FreeTopBlock() {
     Block* block = blocks_;
     blocks_ = block->next;
     block->compressed.clear();
+    block->in_use = false;
     block->next = free_blocks_;
     free_blocks_ = block;
   }
@@ -682,6 +1038,7 @@ class CompressedTrail {
     } else {
       block = new Block;
     }
+    block->in_use = true;
     block->next = blocks_;
     blocks_ = block;
   }
@@ -693,7 +1050,99 @@ class CompressedTrail {
     }
   }
 
+  // Background mode: moves the full current block on top of the stack of
+  // blocks, and asks for the packing of the block that just went below the
+  // uncompressed ones.
+  void PushBlockInBackgroundMode() {
+    MutexLock lock(&mutex_);
+    NewTopBlock();
+    blocks_->raw.swap(data_);
+    blocks_->packed = false;
+    blocks_->should_pack = false;
+    data_ = NewBufferLocked();
+    Block* block = blocks_;
+    for (int i = 0; i < kNumUncompressedBlocks && block != nullptr; ++i) {
+      block = block->next;
+    }
+    if (block != nullptr && !block->should_pack) {
+      block->should_pack = true;
+      ScheduleLocked(block);
+    }
+  }
+
+  // Background mode: makes the top block of the stack the current block,
+  // unpacking it if needed, and asks for the unpacking of the next one.
+  void PopBlockInBackgroundMode() {
+    MutexLock lock(&mutex_);
+    Block* const block = blocks_;
+    block->should_pack = false;
+    while (block->busy) block_ready_.Wait(&mutex_);
+    if (block->packed) {
+      // The packing thread is late: unpack synchronously. This is done under
+      // the lock, as the packing thread does not work on this block.
+      packer_->Unpack(block->compressed, data_.get());
+    } else {
+      free_buffers_.push_back(std::move(data_));
+      data_ = std::move(block->raw);
+    }
+    block->packed = true;
+    block->should_pack = true;
+    FreeTopBlock();
+    Block* const next = blocks_;
+    if (next != nullptr && next->should_pack) {
+      next->should_pack = false;
+      ScheduleLocked(next);
+    }
+  }
+
+  std::unique_ptr<addrval<T>[]> NewBufferLocked() {
+    if (free_buffers_.empty()) {
+      return std::unique_ptr<addrval<T>[]>(new addrval<T>[block_size_]());
+    }
+    std::unique_ptr<addrval<T>[]> buffer = std::move(free_buffers_.back());
+    free_buffers_.pop_back();
+    return buffer;
+  }
+
+  void ScheduleLocked(Block* const block) {
+    packing_thread_->Add(
+        NewCallback(this, &CompressedTrail<T>::UpdateBlock, block));
+  }
+
+  // Runs in the packing thread: brings the given block to its wanted state.
+  // The search thread does not touch a block while it is busy.
+  void UpdateBlock(Block* const block) {
+    mutex_.Lock();
+    if (!block->in_use || block->busy || block->packed == block->should_pack) {
+      mutex_.Unlock();
+      return;
+    }
+    block->busy = true;
+    if (block->should_pack) {
+      const addrval<T>* const raw = block->raw.get();
+      mutex_.Unlock();
+      background_packer_->Pack(raw, &block->compressed);
+      mutex_.Lock();
+      free_buffers_.push_back(std::move(block->raw));
+      block->packed = true;
+    } else {
+      std::unique_ptr<addrval<T>[]> raw = NewBufferLocked();
+      mutex_.Unlock();
+      background_packer_->Unpack(block->compressed, raw.get());
+      mutex_.Lock();
+      block->raw = std::move(raw);
+      block->compressed.clear();
+      block->packed = false;
+    }
+    block->busy = false;
+    block_ready_.SignalAll();
+    mutex_.Unlock();
+  }
+
   std::unique_ptr<TrailPacker<T> > packer_;
+  // Used by the packing thread, in background mode.
+  std::unique_ptr<TrailPacker<T> > background_packer_;
+  ThreadPool* const packing_thread_;
   const int block_size_;
   Block* blocks_;
   Block* free_blocks_;
@@ -702,6 +1151,9 @@ class CompressedTrail {
   bool buffer_used_;
   int current_;
   int size_;
+  Mutex mutex_;
+  CondVar block_ready_;
+  std::vector<std::unique_ptr<addrval<T>[]>> free_buffers_;
 };
 }  // namespace
 
@@ -714,6 +1166,10 @@ class CompressedTrail {
 extern void RestoreBoolValue(IntVar* const var);
 
 struct Trail {
+  static const int kRestoreTimeSamplingPeriod = 64;
+
+  // Must be declared before the compressed trails, which use it.
+  std::unique_ptr<ThreadPool> packing_thread_;
   CompressedTrail<int> rev_ints_;
   CompressedTrail<int64> rev_int64s_;
   CompressedTrail<uint64> rev_uint64s_;
@@ -729,16 +1185,73 @@ struct Trail {
   std::vector<BaseObject**> rev_object_array_memory_;
   std::vector<void*> rev_memory_;
   std::vector<void**> rev_memory_array_;
+  // Objects built in one of the arenas, whose destructors are called on
+  // backtrack before the memory of the arenas is released.
+  std::vector<BaseObject*> rev_arena_objects_;
+  ReversibleArena model_arena_;
+  ReversibleArena search_arena_;
+  // Statistics, see Solver::trail_size_in_bytes() and the methods below it.
+  int64 max_size_in_bytes_;
+  int64 restored_states_;
+  int64 restored_bytes_;
+  int64 restore_time_ns_;
 
   Trail(int block_size,
-        ConstraintSolverParameters::TrailCompression compression_level)
-      : rev_ints_(block_size, compression_level),
-        rev_int64s_(block_size, compression_level),
-        rev_uint64s_(block_size, compression_level),
-        rev_doubles_(block_size, compression_level),
-        rev_ptrs_(block_size, compression_level) {}
+        ConstraintSolverParameters::TrailCompression compression_level,
+        bool pack_in_background)
+      : packing_thread_(BuildPackingThread(compression_level,
+                                           pack_in_background)),
+        rev_ints_(block_size, compression_level, packing_thread_.get()),
+        rev_int64s_(block_size, compression_level, packing_thread_.get()),
+        rev_uint64s_(block_size, compression_level, packing_thread_.get()),
+        rev_doubles_(block_size, compression_level, packing_thread_.get()),
+        rev_ptrs_(block_size, compression_level, packing_thread_.get()),
+        model_arena_(kModelArenaBlockSize),
+        search_arena_(kSearchArenaBlockSize),
+        max_size_in_bytes_(0),
+        restored_states_(0),
+        restored_bytes_(0),
+        restore_time_ns_(0) {}
+
+  ~Trail() {
+    // Waits for the pending jobs of the packing thread, which use the blocks
+    // of the compressed trails.
+    packing_thread_.reset();
+  }
+
+  static ThreadPool* BuildPackingThread(
+      ConstraintSolverParameters::TrailCompression compression_level,
+      bool pack_in_background) {
+    if (!pack_in_background ||
+        compression_level == ConstraintSolverParameters::NO_COMPRESSION) {
+      return nullptr;
+    }
+    ThreadPool* const thread = new ThreadPool("TrailPacking", 1);
+    thread->StartWorkers();
+    return thread;
+  }
+
+  // Size of the values saved on the trail, before compression.
+  int64 SizeInBytes() const {
+    return rev_ints_.size() * sizeof(addrval<int>) +
+           rev_int64s_.size() * sizeof(addrval<int64>) +
+           rev_uint64s_.size() * sizeof(addrval<uint64>) +
+           rev_doubles_.size() * sizeof(addrval<double>) +
+           rev_ptrs_.size() * sizeof(addrval<void*>) +
+           rev_boolvar_list_.size() * sizeof(IntVar*) +
+           rev_bools_.size() * (sizeof(bool*) + sizeof(bool));
+  }
+
+  void SampleSize() {
+    max_size_in_bytes_ = std::max(max_size_in_bytes_, SizeInBytes());
+  }
 
   void BacktrackTo(StateMarker* m) {
+    // Only one restore out of kRestoreTimeSamplingPeriod is timed, as reading
+    // the clock costs as much as restoring a small node.
+    const bool timed = restored_states_ % kRestoreTimeSamplingPeriod == 0;
+    const int64 start_time_ns = timed ? base::GetCurrentTimeNanos() : 0;
+    const int64 start_size_in_bytes = SizeInBytes();
     int target = m->rev_int_index_;
     for (int curr = rev_ints_.size(); curr > target; --curr) {
       const addrval<int>& cell = rev_ints_.Back();
@@ -843,6 +1356,21 @@ struct Trail {
       // delete [] version of the previous unsafe case.
     }
     rev_memory_array_.resize(target);
+
+    target = m->rev_arena_object_index_;
+    for (int curr = rev_arena_objects_.size() - 1; curr >= target; --curr) {
+      rev_arena_objects_[curr]->~BaseObject();
+    }
+    rev_arena_objects_.resize(target);
+    model_arena_.ReleaseTo(m->model_arena_mark_);
+    search_arena_.ReleaseTo(m->search_arena_mark_);
+
+    ++restored_states_;
+    restored_bytes_ += start_size_in_bytes - SizeInBytes();
+    if (timed) {
+      restore_time_ns_ += kRestoreTimeSamplingPeriod *
+                          (base::GetCurrentTimeNanos() - start_time_ns);
+    }
   }
 };
 
@@ -937,6 +1465,18 @@ void** Solver::UnsafeRevAllocArrayAux(void** ptr) {
   return ptr;
 }
 
+void* Solver::UnsafeArenaAlloc(size_t size) {
+  check_alloc_state();
+  // Objects allocated outside of search usually live as long as the model,
+  // they are kept apart to let the search arena reuse its blocks.
+  return state_ == OUTSIDE_SEARCH ? trail_->model_arena_.Allocate(size)
+                                  : trail_->search_arena_.Allocate(size);
+}
+
+void Solver::RegisterArenaObject(BaseObject* const object) {
+  trail_->rev_arena_objects_.push_back(object);
+}
+
 void InternalSaveBooleanVarValue(Solver* const solver, IntVar* const var) {
   solver->trail_->rev_boolvar_list_.push_back(var);
 }
@@ -1367,7 +1907,8 @@ Solver::Solver(const std::string& name, const ConstraintSolverParameters& parame
       parameters_(parameters),
       random_(ACMRandom::DeterministicSeed()),
       demon_profiler_(BuildDemonProfiler(this)),
-      local_search_profiler_(BuildLocalSearchProfiler(this)) {
+      local_search_profiler_(BuildLocalSearchProfiler(this)),
+      propagation_sampler_(BuildPropagationSampler(this)) {
   Init();
 }
 
@@ -1376,7 +1917,8 @@ Solver::Solver(const std::string& name)
       parameters_(DefaultSolverParameters()),
       random_(ACMRandom::DeterministicSeed()),
       demon_profiler_(BuildDemonProfiler(this)),
-      local_search_profiler_(BuildLocalSearchProfiler(this)) {
+      local_search_profiler_(BuildLocalSearchProfiler(this)),
+      propagation_sampler_(BuildPropagationSampler(this)) {
   Init();
 }
 
@@ -1384,7 +1926,8 @@ void Solver::Init() {
   CheckSolverParameters(parameters_);
   queue_.reset(new Queue(this));
   trail_.reset(
-      new Trail(parameters_.trail_block_size(), parameters_.compress_trail()));
+      new Trail(parameters_.trail_block_size(), parameters_.compress_trail(),
+                parameters_.pack_trail_in_background()));
   state_ = OUTSIDE_SEARCH;
   branches_ = 0;
   fails_ = 0;
@@ -1395,6 +1938,9 @@ void Solver::Init() {
   timer_.reset(new ClockTimer);
   searches_.assign(1, new Search(this, 0));
   fail_stamp_ = GG_ULONGLONG(1);
+  trail_stamp_ = GG_ULONGLONG(1);
+  running_demon_ = nullptr;
+  posted_constraint_ = nullptr;
   balancing_decision_.reset(new BalancingDecision);
   fail_intercept_ = nullptr;
   true_constraint_ = nullptr;
@@ -1402,6 +1948,8 @@ void Solver::Init() {
   fail_decision_.reset(new FailDecision());
   constraint_index_ = 0;
   additional_constraint_index_ = 0;
+  model_snapshot_size_ = 0;
+  num_model_snapshots_ = 0;
   num_int_vars_ = 0;
   propagation_monitor_.reset(BuildTrace(this));
   local_search_monitor_.reset(BuildLocalSearchMonitorMaster(this));
@@ -1411,6 +1959,7 @@ void Solver::Init() {
 
   for (int i = 0; i < kNumPriorities; ++i) {
     demon_runs_[i] = 0;
+    merged_demon_events_[i] = 0;
   }
   searches_.push_back(new Search(this));
   PushSentinel(SOLVER_CTOR_SENTINEL);
@@ -1419,6 +1968,7 @@ void Solver::Init() {
   InitBuilders();
   timer_->Restart();
   model_cache_.reset(BuildModelCache(this));
+  table_masks_cache_.reset(new TableMasksCache());
   AddPropagationMonitor(reinterpret_cast<PropagationMonitor*>(demon_profiler_));
   AddLocalSearchMonitor(
       reinterpret_cast<LocalSearchMonitor*>(local_search_profiler_));
@@ -1428,6 +1978,9 @@ Solver::~Solver() {
   // solver destructor called with searches open.
   CHECK_EQ(2, searches_.size());
   BacktrackToSentinel(INITIAL_SEARCH_SENTINEL);
+  for (; num_model_snapshots_ > 0; --num_model_snapshots_) {
+    PopState();
+  }
 
   StateInfo info;
   Solver::MarkerType finalType = PopState(&info);
@@ -1438,6 +1991,7 @@ Solver::~Solver() {
   STLDeleteElements(&searches_);
   DeleteDemonProfiler(demon_profiler_);
   DeleteLocalSearchProfiler(local_search_profiler_);
+  DeletePropagationSampler(propagation_sampler_);
   DeleteBuilders();
 }
 
@@ -1468,9 +2022,12 @@ std::string Solver::DebugString() const {
                       "d, delayed demon runs = %" GG_LL_FORMAT
                       "d, var demon runs = %" GG_LL_FORMAT
                       "d, normal demon runs = %" GG_LL_FORMAT
+                      "d, merged demon events = %" GG_LL_FORMAT
                       "d, Run time = %" GG_LL_FORMAT "d ms)",
                 branches_, fails_, decisions_, demon_runs_[DELAYED_PRIORITY],
                 demon_runs_[VAR_PRIORITY], demon_runs_[NORMAL_PRIORITY],
+                merged_demon_events_[DELAYED_PRIORITY] +
+                    merged_demon_events_[VAR_PRIORITY],
                 wall_time());
   return out;
 }
@@ -1484,7 +2041,12 @@ int64 Solver::wall_time() const { return timer_->GetInMs(); }
 
 int64 Solver::solutions() const { return TopLevelSearch()->solution_counter(); }
 
-void Solver::TopPeriodicCheck() { TopLevelSearch()->PeriodicCheck(); }
+void Solver::TopPeriodicCheck() {
+  if (propagation_sampler_ != nullptr) {
+    DrainPropagationSampler(propagation_sampler_);
+  }
+  TopLevelSearch()->PeriodicCheck();
+}
 
 int Solver::TopProgressPercent() { return TopLevelSearch()->ProgressPercent(); }
 
@@ -1516,9 +2078,14 @@ void Solver::PushState(Solver::MarkerType t, const StateInfo& info) {
     m->rev_object_array_memory_index_ = trail_->rev_object_array_memory_.size();
     m->rev_memory_index_ = trail_->rev_memory_.size();
     m->rev_memory_array_index_ = trail_->rev_memory_array_.size();
+    m->rev_arena_object_index_ = trail_->rev_arena_objects_.size();
+    m->model_arena_mark_ = trail_->model_arena_.GetMark();
+    m->search_arena_mark_ = trail_->search_arena_.GetMark();
+    trail_->SampleSize();
   }
   searches_.back()->marker_stack_.push_back(m);
   queue_->increase_stamp();
+  trail_stamp_++;
 }
 
 void Solver::AddBacktrackAction(Action a, bool fast) {
@@ -1532,6 +2099,10 @@ Solver::MarkerType Solver::PopState(StateInfo* info) {
   CHECK(info != nullptr);
   StateMarker* const m = searches_.back()->marker_stack_.back();
   if (m->type_ != REVERSIBLE_ACTION || m->info_.int_info == 0) {
+    if (propagation_sampler_ != nullptr) {
+      // The sampled demons and constraints may be deleted by the backtrack.
+      DrainPropagationSampler(propagation_sampler_);
+    }
     trail_->BacktrackTo(m);
   }
   Solver::MarkerType t = m->type_;
@@ -1539,6 +2110,7 @@ Solver::MarkerType Solver::PopState(StateInfo* info) {
   searches_.back()->marker_stack_.pop_back();
   delete m;
   queue_->increase_stamp();
+  trail_stamp_++;
   return t;
 }
 
@@ -1579,6 +2151,20 @@ uint64 Solver::stamp() const { return queue_->stamp(); }
 
 uint64 Solver::fail_stamp() const { return fail_stamp_; }
 
+int64 Solver::trail_size_in_bytes() const { return trail_->SizeInBytes(); }
+
+int64 Solver::max_trail_size_in_bytes() const {
+  return std::max(trail_->max_size_in_bytes_, trail_->SizeInBytes());
+}
+
+int64 Solver::restored_trail_states() const { return trail_->restored_states_; }
+
+int64 Solver::restored_trail_bytes() const { return trail_->restored_bytes_; }
+
+int64 Solver::trail_restore_time_ns() const {
+  return trail_->restore_time_ns_;
+}
+
 void Solver::set_action_on_fail(Action a) { queue_->set_action_on_fail(a); }
 
 void Solver::set_variable_to_clean_on_fail(IntVar* v) {
@@ -1685,11 +2271,15 @@ void Solver::ProcessConstraints() {
   additional_constraints_list_.clear();
   additional_constraints_parent_list_.clear();
 
-  for (constraint_index_ = 0; constraint_index_ < constraints_size;
-       ++constraint_index_) {
+  // The constraints of the snapshot of the model are already posted.
+  for (constraint_index_ = model_snapshot_size_;
+       constraint_index_ < constraints_size; ++constraint_index_) {
     Constraint* const constraint = constraints_list_[constraint_index_];
     propagation_monitor_->BeginConstraintInitialPropagation(constraint);
+    Constraint* const previous_posted_constraint = posted_constraint_;
+    posted_constraint_ = constraint;
     constraint->PostAndPropagate();
+    posted_constraint_ = previous_posted_constraint;
     propagation_monitor_->EndConstraintInitialPropagation(constraint);
   }
   CHECK_EQ(constraints_list_.size(), constraints_size);
@@ -1705,7 +2295,10 @@ void Solver::ProcessConstraints() {
     Constraint* const parent = constraints_list_[parent_index];
     propagation_monitor_->BeginNestedConstraintInitialPropagation(parent,
                                                                   nested);
+    Constraint* const previous_posted_constraint = posted_constraint_;
+    posted_constraint_ = nested;
     nested->PostAndPropagate();
+    posted_constraint_ = previous_posted_constraint;
     propagation_monitor_->EndNestedConstraintInitialPropagation(parent, nested);
   }
 }
@@ -1834,6 +2427,9 @@ void Solver::NewSearch(DecisionBuilder* const db,
     // TODO(user): Check if these two lines are still necessary.
     BacktrackToSentinel(INITIAL_SEARCH_SENTINEL);
     state_ = OUTSIDE_SEARCH;
+    if (propagation_sampler_ != nullptr) {
+      StartPropagationSampler(propagation_sampler_);
+    }
   }
 
   // ----- manages all monitors -----
@@ -2251,6 +2847,14 @@ void Solver::EndSearch() {
     if (parameters_.print_local_search_profile()) {
       LOG(INFO) << LocalSearchProfile();
     }
+    if (propagation_sampler_ != nullptr) {
+      StopPropagationSampler(propagation_sampler_);
+      const std::string& file_name = parameters_.sampling_profile_file();
+      LOG(INFO) << "Exporting sampled propagation profile to " << file_name;
+      file::SetContents(file_name, SampledPropagationProfile(),
+                        file::Defaults())
+          .IgnoreError();
+    }
   } else {  // We clean the nested Search.
     delete search;
     searches_.pop_back();
@@ -2340,6 +2944,30 @@ bool Solver::CheckConstraint(Constraint* const ct) {
   return Solve(MakeConstraintAdder(ct));
 }
 
+bool Solver::SnapshotModel() {
+  Search* const search = searches_.back();
+  CHECK(state_ == OUTSIDE_SEARCH && search->sentinel_pushed_ == 0)
+      << "SnapshotModel() is only available outside of search.";
+  // The state of the snapshot lies below the initial sentinel of all the
+  // following searches, so they never backtrack over it.
+  PushState();
+  state_ = IN_ROOT_NODE;
+  CP_TRY(search) {
+    ProcessConstraints();
+    search->ClearBuffer();
+    state_ = OUTSIDE_SEARCH;
+    model_snapshot_size_ = constraints_list_.size();
+    ++num_model_snapshots_;
+    return true;
+  }
+  CP_ON_FAIL {
+    queue_->AfterFailure();
+    PopState();
+    state_ = OUTSIDE_SEARCH;
+    return false;
+  }
+}
+
 bool Solver::SolveAndCommit(DecisionBuilder* const db,
                             SearchMonitor* const m1) {
   std::vector<SearchMonitor*> monitors;
@@ -2387,6 +3015,8 @@ void Solver::Fail() {
   }
   ConstraintSolverFailsHere();
   fails_++;
+  running_demon_ = nullptr;
+  posted_constraint_ = nullptr;
   searches_.back()->BeginFail();
   searches_.back()->JumpBack();
 }
@@ -69,6 +69,7 @@
 #include "base/hash.h"
 #include <iosfwd>
 #include <memory>
+#include <new>
 #include <string>
 #include <utility>
 #include <vector>
@@ -110,6 +111,7 @@ class DecisionVisitor;
 class Demon;
 class DemonProfiler;
 class LocalSearchProfiler;
+class PropagationSampler;
 class Dimension;
 class DisjunctiveConstraint;
 class ExpressionCache;
@@ -147,6 +149,7 @@ class SolutionPool;
 class Solver;
 class ConstraintSolverParameters;
 class SymmetryBreaker;
+class TableMasksCache;
 struct StateInfo;
 struct Trail;
 template <class T>
@@ -219,6 +222,10 @@ struct DefaultPhaseParameters {
   // Should we use Nogoods when restarting. The default is false.
   bool use_no_goods;
 
+  // Maximum number of nogoods kept by the search. When it is exceeded, the
+  // least active nogoods are deleted at the next restart.
+  int max_num_no_goods;
+
   // Should we use last conflict method. The default is false.
   bool use_last_conflict;
 
@@ -268,6 +275,9 @@ class Solver {
   // Number of priorities for demons.
   static const int kNumPriorities = 3;
 
+  // Number of costs for delayed demons.
+  static const int kNumDemonCosts = 3;
+
   // This enum describes the strategy used to select the next branching
   // variable at each node during the search.
   enum IntVarStrategy {
@@ -640,6 +650,19 @@ class Solver {
     NORMAL_PRIORITY = 2,
   };
 
+  // This enum orders the pending delayed demons: the cheapest ones run first,
+  // and the events they raise on variables are propagated before the next
+  // delayed demon runs. This way, the expensive global propagators run on
+  // domains already reduced by the cheap ones.
+  enum DemonCost {
+    // Constant or logarithmic time propagation.
+    CHEAP_DEMON = 0,
+    // Linear time propagation. This is the default cost of a demon.
+    LINEAR_DEMON = 1,
+    // Super-linear propagation, like edge finding.
+    EXPENSIVE_DEMON = 2,
+  };
+
   // This enum is used in Solver::MakeIntervalVarRelation to specify the
   // temporal relation between the two intervals t1 and t2.
   enum BinaryIntervalRelation {
@@ -829,6 +852,26 @@ class Solver {
     return reinterpret_cast<T*>(SafeRevAllocArray(object));
   }
 
+#if !defined(SWIG)
+  // Like RevAlloc(new T(args...)), but the object is built in an arena of the
+  // solver instead of on the heap. The objects built outside of search share
+  // a long-lived arena; the other ones are built in a search arena, whose
+  // memory is released at once when backtracking out of the current state
+  // (after calling the destructors of the objects). This makes the creation
+  // and the deletion of many small objects, like demons, much cheaper.
+  template <typename T, typename... Args>
+  T* RevAllocInArena(Args&&... args) {
+    static_assert(alignof(T) <= kArenaAlignment, "Alignment is too large.");
+    T* const object =
+        new (UnsafeArenaAlloc(sizeof(T))) T(std::forward<Args>(args)...);
+    RegisterArenaObject(object);
+    return object;
+  }
+
+  // Alignment of the memory returned by the arenas of the solver.
+  static const size_t kArenaAlignment = 16;
+#endif  // !defined(SWIG)
+
   // propagation
 
   // Adds the constraint 'c' to the model.
@@ -973,6 +1016,24 @@ class Solver {
   // inconsistent, or if adding the constraint makes it inconsistent.
   bool CheckConstraint(Constraint* const constraint);
 
+  // Posts the constraints added to the model so far and runs their initial
+  // propagation, outside of any search, and keeps the resulting state as the
+  // starting point of all the following searches: they no longer create the
+  // demons of these constraints nor propagate them initially. This is meant
+  // for models solved many times with different data: the data must then be
+  // held by variables (for instance the constants of the model), whose
+  // domains are set by each search, e.g. with MakeRestoreAssignment()
+  // composed with the search phase. The domain reductions of each search are
+  // undone at its end, so the snapshot can be solved again with other data.
+  // Constraints added afterwards are posted by each search, or by the next
+  // snapshot. Returns false, and keeps nothing, if the model is infeasible.
+  // It can only be called outside of search.
+  bool SnapshotModel();
+
+  // Returns the number of constraints of the model posted and propagated by
+  // SnapshotModel().
+  int model_snapshot_size() const { return model_snapshot_size_; }
+
   // State of the solver.
   SolverState state() const { return state_; }
 
@@ -995,6 +1056,12 @@ class Solver {
   // Loads the model into the solver, appends search monitors to monitors,
   // and returns true upon success.
   bool LoadModel(const CpModel& proto, std::vector<SearchMonitor*>* monitors);
+  // Same as above, and also fills variable_groups with the variables of each
+  // variable group of the model (i.e. the variables of the decision builder
+  // given to ExportModel()), in order. Both monitors and variable_groups can
+  // be nullptr.
+  bool LoadModel(const CpModel& proto, std::vector<SearchMonitor*>* monitors,
+                 std::vector<std::vector<IntVar*>>* variable_groups);
   // Upgrades the model to the latest version.
   static bool UpgradeModel(CpModel* const proto);
 
@@ -1052,6 +1119,13 @@ class Solver {
   // The number of demons executed during search for a given priority.
   int64 demon_runs(DemonPriority p) const { return demon_runs_[p]; }
 
+  // The number of events that did not enqueue a demon of the given priority,
+  // because this demon was already waiting in the queue. Each of them is a
+  // demon run saved.
+  int64 merged_demon_events(DemonPriority p) const {
+    return merged_demon_events_[p];
+  }
+
   // The number of failures encountered since the creation of the solver.
   int64 failures() const { return fails_; }
 
@@ -1071,6 +1145,26 @@ class Solver {
   // The fail_stamp() is incremented after each backtrack.
   uint64 fail_stamp() const;
 
+  // The trail_stamp() is incremented each time a state is pushed or popped.
+  // Unlike stamp(), it does not change between the propagation waves of a
+  // node, so that the reversible classes save a value at most once per node.
+  uint64 trail_stamp() const { return trail_stamp_; }
+
+  // Statistics on the trail, where the reversible values are saved to be
+  // restored on backtrack. Sizes are the ones of the uncompressed values.
+  // The current size of the trail, and its peak size, sampled each time a
+  // state is pushed.
+  int64 trail_size_in_bytes() const;
+  int64 max_trail_size_in_bytes() const;
+  // The number of states restored since the creation of the solver, the
+  // number of bytes of trail they unwound, and the time spent doing it in ns,
+  // estimated by timing a sample of the restores.
+  // restored_trail_bytes() / restored_trail_states() is the mean trail size of
+  // a node of the search tree.
+  int64 restored_trail_states() const;
+  int64 restored_trail_bytes() const;
+  int64 trail_restore_time_ns() const;
+
   // ---------- Make Factory ----------
 
   // All factories (MakeXXX methods) encapsulate creation of objects
@@ -2237,6 +2331,12 @@ class Solver {
   // portion of the search tree.
   NoGoodManager* MakeNoGoodManager();
 
+  // Creates a nogood manager that watches two terms of each nogood, and only
+  // revisits a nogood when one of its watched terms becomes true. At most
+  // max_num_no_goods nogoods are kept: the least active ones (the ones that
+  // propagated the least recently) are deleted at the next restart.
+  NoGoodManager* MakeWatchedNoGoodManager(int max_num_no_goods);
+
   // ----- Tree Monitor -----
   // Creates a tree monitor that outputs a detailed overview of the
   // decision phase in cpviz format. The XML data is written to files
@@ -2831,6 +2931,12 @@ class Solver {
   // search profiles.
   std::string LocalSearchProfile() const;
 
+  // Returns the samples of the sampling propagation profiler, aggregated by
+  // demon or constraint, in the collapsed-stack format of flame graphs
+  // ("frame;frame;frame count" lines). The parameter sampling_profile_file
+  // used to create the solver must be set.
+  std::string SampledPropagationProfile() const;
+
   // Returns true whether the current search has been
   // created using a Solve() call instead of a NewSearch one. It
   // returns false if the solver is not in search at all.
@@ -2876,12 +2982,16 @@ class Solver {
   Search* ActiveSearch() const;
   // Returns the cache of the model.
   ModelCache* Cache() const;
+  // Returns the cache of the masks of the table constraints.
+  TableMasksCache* TableMasks() const;
   // Returns whether we are instrumenting demons.
   bool InstrumentsDemons() const;
   // Returns whether we are profiling the solver.
   bool IsProfilingEnabled() const;
   // Returns whether we are profiling local search.
   bool IsLocalSearchProfilingEnabled() const;
+  // Returns whether the propagation is sampled by a signal-based profiler.
+  bool IsSamplingProfilingEnabled() const;
   // Returns whether we are tracing variables.
   bool InstrumentsVariables() const;
   // Returns whether all variables should be named.
@@ -2916,6 +3026,7 @@ class Solver {
   friend class SearchLimit;
   friend class RoutingModel;
   friend class LocalSearchProfiler;
+  friend class PropagationSampler;
 
 #if !defined(SWIG)
   friend void InternalSaveBooleanVarValue(Solver* const, IntVar* const);
@@ -3010,6 +3121,15 @@ class Solver {
     return reinterpret_cast<T**>(
         UnsafeRevAllocArrayAux(reinterpret_cast<void**>(ptr)));
   }
+  // Allocates memory in the arena of the current state (see
+  // RevAllocInArena()). It is released on backtrack, without calling any
+  // destructor.
+  void* UnsafeArenaAlloc(size_t size);
+  template <class T>
+  T** UnsafeArenaAllocArray(int size) {
+    return static_cast<T**>(UnsafeArenaAlloc(size * sizeof(T*)));
+  }
+  void RegisterArenaObject(BaseObject* const object);
 
   void InitCachedIntConstants();
   void InitCachedConstraint();
@@ -3065,6 +3185,7 @@ class Solver {
   int64 fails_;
   int64 decisions_;
   int64 demon_runs_[kNumPriorities];
+  int64 merged_demon_events_[kNumPriorities];
   int64 neighbors_;
   int64 filtered_neighbors_;
   int64 accepted_neighbors_;
@@ -3072,6 +3193,7 @@ class Solver {
   std::vector<Search*> searches_;
   ACMRandom random_;
   uint64 fail_stamp_;
+  uint64 trail_stamp_;
   std::unique_ptr<Decision> balancing_decision_;
   // intercept failures
   std::function<void()> fail_intercept_;
@@ -3079,6 +3201,11 @@ class Solver {
   DemonProfiler* const demon_profiler_;
   // Local search profiler monitor
   LocalSearchProfiler* const local_search_profiler_;
+  // Sampling propagation profiler, and the demon and the constraint it
+  // samples: the demon being run and the constraint being posted.
+  PropagationSampler* const propagation_sampler_;
+  Demon* running_demon_;
+  Constraint* posted_constraint_;
 
   // interval of constants cached, inclusive:
   enum { MIN_CACHED_INT_CONST = -8, MAX_CACHED_INT_CONST = 8 };
@@ -3091,6 +3218,10 @@ class Solver {
   std::unique_ptr<Decision> fail_decision_;
   int constraint_index_;
   int additional_constraint_index_;
+  // Constraints posted by SnapshotModel(), and number of markers it pushed on
+  // the trail.
+  int model_snapshot_size_;
+  int num_model_snapshots_;
   int num_int_vars_;
 
   // Support for model loading.
@@ -3100,6 +3231,7 @@ class Solver {
   hash_map<std::string, SequenceVariableBuilder> sequence_builders_;
 
   std::unique_ptr<ModelCache> model_cache_;
+  std::unique_ptr<TableMasksCache> table_masks_cache_;
   std::unique_ptr<PropagationMonitor> propagation_monitor_;
   PropagationMonitor* print_trace_;
   std::unique_ptr<LocalSearchMonitor> local_search_monitor_;
@@ -3278,7 +3410,7 @@ class Demon : public BaseObject {
  public:
   // This indicates the priority of a demon. Immediate demons are treated
   // separately and corresponds to variables.
-  Demon() : stamp_(GG_ULONGLONG(0)) {}
+  Demon() : stamp_(GG_ULONGLONG(0)), cost_(Solver::LINEAR_DEMON) {}
   ~Demon() override {}
 
   // This is the main callback of the demon.
@@ -3298,11 +3430,17 @@ class Demon : public BaseObject {
   // This method un-inhibits the demon that was inhibited.
   void desinhibit(Solver* const s);
 
+  // The cost of the demon orders the delayed demons in the queue (see
+  // Solver::DemonCost). It is ignored for the other priorities.
+  Solver::DemonCost cost() const { return cost_; }
+  void set_cost(Solver::DemonCost cost) { cost_ = cost; }
+
  private:
   friend class Queue;
   void set_stamp(int64 stamp) { stamp_ = stamp; }
   uint64 stamp() const { return stamp_; }
   uint64 stamp_;
+  Solver::DemonCost cost_;
   DISALLOW_COPY_AND_ASSIGN(Demon);
 };
 
@@ -3708,9 +3846,9 @@ class Rev {
 
   void SetValue(Solver* const s, const T& val) {
     if (val != value_) {
-      if (stamp_ < s->stamp()) {
+      if (stamp_ < s->trail_stamp()) {
         s->SaveValue(&value_);
-        stamp_ = s->stamp();
+        stamp_ = s->trail_stamp();
       }
       value_ = val;
     }
@@ -3764,9 +3902,9 @@ class RevArray {
 
   void SetValue(Solver* const s, int index, const T& val) {
     if (val != values_[index]) {
-      if (stamps_[index] < s->stamp()) {
+      if (stamps_[index] < s->trail_stamp()) {
         s->SaveValue(&values_[index]);
-        stamps_[index] = s->stamp();
+        stamps_[index] = s->trail_stamp();
       }
       values_[index] = val;
     }
@@ -4259,6 +4397,9 @@ class NoGood {
   bool Apply(Solver* const solver);
   // Pretty print.
   std::string DebugString() const;
+  // Returns the number of terms, and the term with the given index.
+  int size() const { return terms_.size(); }
+  NoGoodTerm* term(int index) const { return terms_[index]; }
   // TODO(user) : support interval variables and more types of constraints.
 
  private:
@@ -46,6 +46,7 @@
 // and exposed in this file:
 //   - SearchLog, the root class of all periodic outputs during search.
 //   - ModelCache, A caching layer to avoid creating twice the same object.
+//   - TableMasksCache, the masks shared by the compact table constraints.
 
 #ifndef OR_TOOLS_CONSTRAINT_SOLVER_CONSTRAINT_SOLVERI_H_
 #define OR_TOOLS_CONSTRAINT_SOLVER_CONSTRAINT_SOLVERI_H_
@@ -55,8 +56,10 @@
 #include <cstddef>
 #include <functional>
 #include "base/hash.h"
+#include <map>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "base/commandlineflags.h"
@@ -179,7 +182,8 @@ class SimpleRevFIFO {
 
   void Push(Solver* const s, T val) {
     if (pos_.Value() == 0) {
-      Chunk* const chunk = s->UnsafeRevAlloc(new Chunk(chunks_));
+      Chunk* const chunk =
+          new (s->UnsafeArenaAlloc(sizeof(Chunk))) Chunk(chunks_);
       s->SaveAndSetValue(reinterpret_cast<void**>(&chunks_),
                          reinterpret_cast<void*>(chunk));
       pos_.SetValue(s, CHUNK_SIZE - 1);
@@ -296,7 +300,7 @@ class RevImmutableMultiMap {
  public:
   RevImmutableMultiMap(Solver* const solver, int initial_size)
       : solver_(solver),
-        array_(solver->UnsafeRevAllocArray(new Cell*[initial_size])),
+        array_(solver->UnsafeArenaAllocArray<Cell>(initial_size)),
         size_(initial_size),
         num_items_(0) {
     memset(array_, 0, sizeof(*array_) * size_.Value());
@@ -337,8 +341,8 @@ class RevImmutableMultiMap {
   // Inserts (key, value) in the multi-map.
   void Insert(const K& key, const V& value) {
     const int position = Hash1(key) % size_.Value();
-    Cell* const cell =
-        solver_->UnsafeRevAlloc(new Cell(key, value, array_[position]));
+    Cell* const cell = new (solver_->UnsafeArenaAlloc(sizeof(Cell)))
+        Cell(key, value, array_[position]);
     solver_->SaveAndSetValue(reinterpret_cast<void**>(&array_[position]),
                              reinterpret_cast<void*>(cell));
     num_items_.Incr(solver_);
@@ -377,7 +381,7 @@ class RevImmutableMultiMap {
     solver_->SaveAndSetValue(
         reinterpret_cast<void**>(&array_),
         reinterpret_cast<void*>(
-            solver_->UnsafeRevAllocArray(new Cell*[size_.Value()])));
+            solver_->UnsafeArenaAllocArray<Cell>(size_.Value())));
     memset(array_, 0, size_.Value() * sizeof(*array_));
     for (int i = 0; i < old_size; ++i) {
       Cell* tmp = old_cell_array[i];
@@ -538,7 +542,7 @@ class CallMethod0 : public Demon {
 template <class T>
 Demon* MakeConstraintDemon0(Solver* const s, T* const ct, void (T::*method)(),
                             const std::string& name) {
-  return s->RevAlloc(new CallMethod0<T>(ct, method, name));
+  return s->RevAllocInArena<CallMethod0<T>>(ct, method, name);
 }
 
 template <class P>
@@ -578,7 +582,7 @@ class CallMethod1 : public Demon {
 template <class T, class P>
 Demon* MakeConstraintDemon1(Solver* const s, T* const ct, void (T::*method)(P),
                             const std::string& name, P param1) {
-  return s->RevAlloc(new CallMethod1<T, P>(ct, method, name, param1));
+  return s->RevAllocInArena<CallMethod1<T, P>>(ct, method, name, param1);
 }
 
 // Demon proxy to a method on the constraint with two arguments.
@@ -618,8 +622,8 @@ template <class T, class P, class Q>
 Demon* MakeConstraintDemon2(Solver* const s, T* const ct,
                             void (T::*method)(P, Q), const std::string& name,
                             P param1, Q param2) {
-  return s->RevAlloc(
-      new CallMethod2<T, P, Q>(ct, method, name, param1, param2));
+  return s->RevAllocInArena<CallMethod2<T, P, Q>>(ct, method, name, param1,
+                                                  param2);
 }
 // Demon proxy to a method on the constraint with three arguments.
 template <class T, class P, class Q, class R>
@@ -661,8 +665,8 @@ template <class T, class P, class Q, class R>
 Demon* MakeConstraintDemon3(Solver* const s, T* const ct,
                             void (T::*method)(P, Q, R), const std::string& name,
                             P param1, Q param2, R param3) {
-  return s->RevAlloc(
-      new CallMethod3<T, P, Q, R>(ct, method, name, param1, param2, param3));
+  return s->RevAllocInArena<CallMethod3<T, P, Q, R>>(ct, method, name, param1,
+                                                     param2, param3);
 }
 // @}
 
@@ -700,7 +704,7 @@ class DelayedCallMethod0 : public Demon {
 template <class T>
 Demon* MakeDelayedConstraintDemon0(Solver* const s, T* const ct,
                                    void (T::*method)(), const std::string& name) {
-  return s->RevAlloc(new DelayedCallMethod0<T>(ct, method, name));
+  return s->RevAllocInArena<DelayedCallMethod0<T>>(ct, method, name);
 }
 
 // Low-priority demon proxy to a method on the constraint with one argument.
@@ -735,7 +739,8 @@ template <class T, class P>
 Demon* MakeDelayedConstraintDemon1(Solver* const s, T* const ct,
                                    void (T::*method)(P), const std::string& name,
                                    P param1) {
-  return s->RevAlloc(new DelayedCallMethod1<T, P>(ct, method, name, param1));
+  return s->RevAllocInArena<DelayedCallMethod1<T, P>>(ct, method, name,
+                                                      param1);
 }
 
 // Low-priority demon proxy to a method on the constraint with two arguments.
@@ -779,8 +784,8 @@ template <class T, class P, class Q>
 Demon* MakeDelayedConstraintDemon2(Solver* const s, T* const ct,
                                    void (T::*method)(P, Q), const std::string& name,
                                    P param1, Q param2) {
-  return s->RevAlloc(
-      new DelayedCallMethod2<T, P, Q>(ct, method, name, param1, param2));
+  return s->RevAllocInArena<DelayedCallMethod2<T, P, Q>>(ct, method, name,
+                                                         param1, param2);
 }
 // @}
 
@@ -1251,6 +1256,15 @@ class PathOperator : public IntVarLocalSearchOperator {
   // Number of next variables.
   int number_of_nexts() const { return number_of_nexts_; }
 
+  // Restricts the neighborhood to "granular" moves: get_neighbors(node)
+  // returns the nodes close to node (for instance its nearest neighbors), and
+  // the base node of index NeighborRestrictedBaseIndex() then only takes the
+  // values which are neighbors of NeighborReferenceNode(), in addition to path
+  // starts and ends. Other positions are skipped without building neighbors,
+  // which makes the number of neighbors of quadratic neighborhoods close to
+  // linear. A nullptr get_neighbors removes the restriction.
+  void SetNeighbors(std::function<const std::vector<int>&(int64)> get_neighbors);
+
  protected:
   // This method should not be overridden. Override MakeNeighbor() instead.
   bool MakeOneNeighbor() override;
@@ -1275,6 +1289,25 @@ class PathOperator : public IntVarLocalSearchOperator {
   // TODO(user): ideally this should be OnSamePath(int64 node1, int64 node2);
   // it's currently way more complicated to implement.
   virtual bool OnSamePathAsPreviousBase(int64 base_index) { return false; }
+  // Index of the base node restricted by SetNeighbors(); by default the
+  // second base node, operators with a single base node are not restricted.
+  virtual int NeighborRestrictedBaseIndex() const { return 1; }
+  // Node the neighbors of which the restricted base node can take, or -1 if the
+  // restricted base node can take any value. By default the first base node,
+  // unless it is a path start or end.
+  virtual int64 NeighborReferenceNode() const {
+    const int64 base_node = BaseNode(0);
+    return IsPathEnd(base_node) || base_node == StartNode(0) ? -1 : base_node;
+  }
+  // Returns the node after the first base node in the current solution, or -1
+  // if one of them is a path end. This is the reference node of operators
+  // which make the restricted base node the new predecessor of this node.
+  int64 NodeAfterFirstBaseNode() const {
+    const int64 base_node = BaseNode(0);
+    if (IsPathEnd(base_node)) return -1;
+    const int64 next = OldNext(base_node);
+    return IsPathEnd(next) ? -1 : next;
+  }
   // Returns the index of the node to which the base node of index base_index
   // must be set to when it reaches the end of a path.
   // By default, it is set to the start of the current path.
@@ -1357,6 +1390,13 @@ class PathOperator : public IntVarLocalSearchOperator {
   bool CheckChainValidity(int64 chain_start, int64 chain_end,
                           int64 exclude) const;
   void Synchronize();
+  // Returns true if the restricted base node can take its current value.
+  bool RestrictedBaseNodeIsNeighbor();
+  // Moves the restricted base node to the next node on its path which is a
+  // neighbor of the reference node, or to its end position.
+  void SkipNonNeighbors();
+  // Marks the neighbors of reference in neighbor_marks_.
+  void MarkNeighbors(int64 reference);
 
   std::vector<int> base_nodes_;
   std::vector<int> end_nodes_;
@@ -1366,6 +1406,10 @@ class PathOperator : public IntVarLocalSearchOperator {
   bool just_started_;
   bool first_start_;
   std::function<int(int64)> start_empty_path_class_;
+  std::function<const std::vector<int>&(int64)> get_neighbors_;
+  int restricted_base_index_;
+  std::vector<bool> neighbor_marks_;
+  int64 marked_reference_;
 };
 
 // ----- Operator Factories ------
@@ -1909,6 +1953,56 @@ class ModelCache {
   Solver* const solver_;
 };
 
+// A cache of the read-only masks of the compact table constraints. The masks
+// of a column of a tuple set only depend on this tuple set, on the affine
+// transformation y = a * x + b between the values x of the variable and the
+// values y of the tuples, and on the range of the variable. The constraints
+// posted on the same (lazily shared) tuple set with variables of the same
+// range share their masks instead of building their own copy.
+class TableMasksCache {
+ public:
+  // The masks of the values of a column: the bit t of masks[v] is set iff the
+  // value of the tuple t in this column corresponds to the value
+  // original_min + v of the variable. An empty mask means that no tuple has
+  // this value. starts[v] and ends[v] are the indices of the first and the
+  // last non null words of a non empty masks[v].
+  struct ColumnMasks {
+    std::vector<std::vector<uint64>> masks;
+    std::vector<int> starts;
+    std::vector<int> ends;
+  };
+
+  TableMasksCache();
+  ~TableMasksCache();
+
+  // Returns the masks of the given column for the variable range
+  // [original_min, original_min + span - 1], or nullptr if they are not in
+  // the cache.
+  const ColumnMasks* Find(const IntTupleSet& tuples, int column, int64 a,
+                          int64 b, int64 original_min, int64 span) const;
+
+  // Adds the masks of the given column to the cache, which takes ownership of
+  // them, and returns them.
+  const ColumnMasks* Insert(const IntTupleSet& tuples, int column, int64 a,
+                            int64 b, int64 original_min, int64 span,
+                            ColumnMasks* const masks);
+
+  // The number of masks built, and the number of them found in the cache.
+  int64 num_inserted() const { return masks_.size(); }
+  int64 num_hits() const { return num_hits_; }
+
+ private:
+  // The tuple sets are identified by the address of their shared data.
+  typedef std::tuple<const int64*, int, int64, int64, int64, int64> Key;
+
+  std::map<Key, std::unique_ptr<ColumnMasks>> masks_;
+  // Copies of the tuple sets of the keys, which keep their data alive.
+  hash_map<const int64*, IntTupleSet> tuple_sets_;
+  mutable int64 num_hits_;
+
+  DISALLOW_COPY_AND_ASSIGN(TableMasksCache);
+};
+
 // Argument Holder: useful when visiting a model.
 #if !defined(SWIG)
 class ArgumentHolder {
@@ -46,6 +46,7 @@ const int kDefaultHeuristicNumFailuresLimit = 30;
 const int kDefaultSeed = 0;
 const double kDefaultRestartLogSize = -1.0;
 const bool kDefaultUseNoGoods = true;
+const int kDefaultMaxNumNoGoods = 10000;
 const bool kDefaultUseLastConflict = true;
 }  // namespace
 
@@ -61,6 +62,7 @@ DefaultPhaseParameters::DefaultPhaseParameters()
       restart_log_size(kDefaultRestartLogSize),
       display_level(DefaultPhaseParameters::NORMAL),
       use_no_goods(kDefaultUseNoGoods),
+      max_num_no_goods(kDefaultMaxNumNoGoods),
       use_last_conflict(kDefaultUseLastConflict),
       decision_builder(nullptr) {}
 
@@ -700,7 +702,8 @@ class RestartMonitor : public SearchMonitor {
         min_log_search_space_(std::numeric_limits<double>::infinity()),
         no_good_manager_(parameters_.restart_log_size >= 0 &&
                                  parameters_.use_no_goods
-                             ? solver->MakeNoGoodManager()
+                             ? solver->MakeWatchedNoGoodManager(
+                                   parameters_.max_num_no_goods)
                              : nullptr),
         branches_between_restarts_(0),
         min_restart_period_(ComputeBranchRestart(parameters_.restart_log_size)),
@@ -13,12 +13,25 @@
 
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include "base/hash.h"
+#include <map>
 #include <string>
+#include <thread>
+#include <typeinfo>
 #include <utility>
 #include <vector>
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+#if !defined(_MSC_VER)
+#include <signal.h>
+#include <sys/time.h>
+#endif
 
 #include "base/integral_types.h"
 #include "base/logging.h"
@@ -26,6 +39,8 @@
 #include "base/file.h"
 #include "base/stl_util.h"
 #include "base/hash.h"
+#include "base/join.h"
+#include "base/mutex.h"
 #include "constraint_solver/constraint_solver.h"
 #include "constraint_solver/constraint_solveri.h"
 #include "constraint_solver/demon_profiler.pb.h"
@@ -451,6 +466,296 @@ Demon* Solver::RegisterDemon(Demon* const demon) {
   return demon;
 }
 
+// ----- Sampling Profiler -----
+
+// PropagationSampler samples the propagation at a fixed interval of CPU time:
+// a SIGPROF timer interrupts the solver, and the signal handler records the
+// demon being run, or the constraint being posted, in a ring buffer. The
+// samples are named and aggregated later, from the solver thread, before the
+// backtracks that may delete the sampled objects. Unlike DemonProfiler, which
+// times each demon run through the propagation monitor, this only costs two
+// stores per demon run.
+//
+// The timer is shared by the whole process: a sample is only recorded when
+// the signal is received by a thread running a sampled solver, and all
+// samplers use the period of the first one started. The sampler is only
+// registered on the thread that started it: if it is stopped from another
+// thread, e.g. when the solver is deleted there in the middle of a search,
+// only the timer is released.
+class PropagationSampler {
+ public:
+  explicit PropagationSampler(Solver* const solver)
+      : solver_(solver),
+        num_recorded_(0),
+        num_drained_(0),
+        num_dropped_(0),
+        started_(false),
+        previous_sampler_(nullptr) {}
+
+  ~PropagationSampler() { Stop(); }
+
+  // Starts sampling the propagation of the solver, on the current thread.
+  void Start() {
+    if (started_) {
+      return;
+    }
+    started_ = true;
+    start_thread_ = std::this_thread::get_id();
+    previous_sampler_ = current_sampler_;
+    current_sampler_ = this;
+#if !defined(_MSC_VER)
+    MutexLock lock(TimerMutex());
+    if (num_started_samplers_++ == 0) {
+      struct sigaction action;
+      memset(&action, 0, sizeof(action));
+      action.sa_handler = &PropagationSampler::HandleSignal;
+      sigemptyset(&action.sa_mask);
+      action.sa_flags = SA_RESTART;
+      sigaction(SIGPROF, &action, &previous_action_);
+      const int period_us =
+          std::max(1, solver_->parameters_.sampling_profile_period_us());
+      struct itimerval timer;
+      timer.it_interval.tv_sec = period_us / 1000000;
+      timer.it_interval.tv_usec = period_us % 1000000;
+      timer.it_value = timer.it_interval;
+      setitimer(ITIMER_PROF, &timer, nullptr);
+    }
+#else
+    LOG(WARNING) << "The sampling profiler is not supported on this platform.";
+#endif
+  }
+
+  // Stops sampling. The pending samples are aggregated by the next call to
+  // Drain() or CollapsedStacks().
+  void Stop() {
+    if (!started_) {
+      return;
+    }
+    started_ = false;
+#if !defined(_MSC_VER)
+    {
+      MutexLock lock(TimerMutex());
+      if (--num_started_samplers_ == 0) {
+        struct itimerval timer;
+        memset(&timer, 0, sizeof(timer));
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        sigaction(SIGPROF, &previous_action_, nullptr);
+      }
+    }
+#endif
+    // The thread local variable of the thread that called Start() cannot be
+    // restored from another thread, whose own variable must not be changed.
+    if (std::this_thread::get_id() == start_thread_) {
+      current_sampler_ = previous_sampler_;
+    }
+    previous_sampler_ = nullptr;
+  }
+
+  // Names and aggregates the samples recorded since the last call. It must
+  // be called from the solver thread, while the sampled objects are alive.
+  void Drain() {
+    const int64 num_recorded = num_recorded_.load(std::memory_order_acquire);
+    for (int64 i = num_drained_.load(std::memory_order_relaxed);
+         i < num_recorded; ++i) {
+      samples_per_stack_[Stack(samples_[i % kNumSamples])]++;
+    }
+    num_drained_.store(num_recorded, std::memory_order_release);
+  }
+
+  // Returns the aggregated samples as "frame;frame;frame count" lines.
+  std::string CollapsedStacks() {
+    Drain();
+    std::string out;
+    for (const auto& stack_and_count : samples_per_stack_) {
+      StringAppendF(&out, "%s %" GG_LL_FORMAT "d\n",
+                    stack_and_count.first.c_str(), stack_and_count.second);
+    }
+    const int64 num_dropped = num_dropped_.load(std::memory_order_relaxed);
+    if (num_dropped > 0) {
+      StringAppendF(&out, "%s;dropped %" GG_LL_FORMAT "d\n",
+                    ModelFrame().c_str(), num_dropped);
+    }
+    return out;
+  }
+
+ private:
+  // The sampled demon or constraint. The demon, if any, is the one reported.
+  struct Sample {
+    const Demon* demon;
+    const Constraint* constraint;
+  };
+
+  // Size of the ring buffer of the samples.
+  static const int kNumSamples = 4096;
+  // Frames longer than this are truncated.
+  static const int kMaxFrameSize = 128;
+
+  static void HandleSignal(int signal_number) {
+    PropagationSampler* const sampler = current_sampler_;
+    if (sampler != nullptr) {
+      sampler->RecordSample();
+    }
+  }
+
+  static Mutex* TimerMutex() {
+    static Mutex* const mutex = new Mutex;
+    return mutex;
+  }
+
+  // Called from the signal handler: it only reads the solver and writes in
+  // the preallocated ring buffer.
+  void RecordSample() {
+    const int64 num_recorded = num_recorded_.load(std::memory_order_relaxed);
+    if (num_recorded - num_drained_.load(std::memory_order_acquire) >=
+        kNumSamples) {
+      num_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    Sample* const sample = &samples_[num_recorded % kNumSamples];
+    sample->demon = solver_->running_demon_;
+    sample->constraint = solver_->posted_constraint_;
+    num_recorded_.store(num_recorded + 1, std::memory_order_release);
+  }
+
+  std::string ModelFrame() const {
+    const std::string& name = solver_->model_name();
+    return name.empty() ? "model" : Frame(name);
+  }
+
+  // Returns the stack of a sample: the model, the type of the demon or the
+  // constraint, and its debug string. The stacks of the objects are cached:
+  // the type is part of the key as the memory of an object deleted on
+  // backtrack can be reused by another one.
+  const std::string& Stack(const Sample& sample) {
+    const BaseObject* const object =
+        sample.demon != nullptr
+            ? static_cast<const BaseObject*>(sample.demon)
+            : static_cast<const BaseObject*>(sample.constraint);
+    if (object == nullptr) {
+      if (search_stack_.empty()) {
+        search_stack_ = ModelFrame() + ";search";
+      }
+      return search_stack_;
+    }
+    const std::type_info& type = typeid(*object);
+    std::string& stack = stack_of_object_[std::make_pair(object, &type)];
+    if (stack.empty()) {
+      stack = StrCat(ModelFrame(), ";", Frame(TypeName(type)), ";",
+                     Frame(object->DebugString()));
+    }
+    return stack;
+  }
+
+  // Returns the demangled name of a type, without the namespaces of the
+  // library.
+  static std::string TypeName(const std::type_info& type) {
+    std::string name = type.name();
+#if defined(__GNUC__)
+    int status = 0;
+    char* const demangled =
+        abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if (status == 0 && demangled != nullptr) {
+      name = demangled;
+    }
+    free(demangled);
+#endif
+    for (const char* const prefix :
+         {"operations_research::", "(anonymous namespace)::"}) {
+      const int prefix_size = strlen(prefix);
+      for (size_t pos = name.find(prefix); pos != std::string::npos;
+           pos = name.find(prefix, pos)) {
+        name.erase(pos, prefix_size);
+      }
+    }
+    return name;
+  }
+
+  // Makes a frame of the collapsed-stack format out of a string.
+  static std::string Frame(const std::string& name) {
+    std::string frame = name.substr(0, kMaxFrameSize);
+    if (name.size() > kMaxFrameSize) {
+      frame += "...";
+    }
+    for (char& c : frame) {
+      if (c == ';') {
+        c = ',';
+      } else if (c == '\n' || c == '\r') {
+        c = ' ';
+      }
+    }
+    return frame;
+  }
+
+  // The sampler of the solver propagating on the current thread, which is
+  // the one called by the signal handler. SIGPROF is delivered to the thread
+  // that consumed the CPU time, hence a thread local variable. See its
+  // definition for its TLS model.
+  static thread_local PropagationSampler* current_sampler_;
+  static int num_started_samplers_;
+#if !defined(_MSC_VER)
+  static struct sigaction previous_action_;
+#endif
+
+  Solver* const solver_;
+  Sample samples_[kNumSamples];
+  std::atomic<int64> num_recorded_;
+  std::atomic<int64> num_drained_;
+  std::atomic<int64> num_dropped_;
+  bool started_;
+  // The thread on which Start() was called, and the sampler registered on it
+  // before this one.
+  std::thread::id start_thread_;
+  PropagationSampler* previous_sampler_;
+  std::map<std::pair<const BaseObject*, const std::type_info*>, std::string>
+      stack_of_object_;
+  std::string search_stack_;
+  std::map<std::string, int64> samples_per_stack_;
+
+  DISALLOW_COPY_AND_ASSIGN(PropagationSampler);
+};
+
+// With the default TLS model of a shared library, the first access to a
+// thread local variable on a thread can call __tls_get_addr, which may
+// allocate and is not async-signal-safe. The initial-exec model reads it at a
+// fixed offset from the thread pointer, which is safe in the signal handler.
+// The attribute is only taken into account on the definition.
+#if defined(__GNUC__)
+__attribute__((tls_model("initial-exec")))
+#endif
+thread_local PropagationSampler* PropagationSampler::current_sampler_ =
+    nullptr;
+int PropagationSampler::num_started_samplers_ = 0;
+#if !defined(_MSC_VER)
+struct sigaction PropagationSampler::previous_action_;
+#endif
+
+std::string Solver::SampledPropagationProfile() const {
+  return propagation_sampler_ == nullptr
+             ? ""
+             : propagation_sampler_->CollapsedStacks();
+}
+
+PropagationSampler* BuildPropagationSampler(Solver* const solver) {
+  return solver->IsSamplingProfilingEnabled() ? new PropagationSampler(solver)
+                                              : nullptr;
+}
+
+void DeletePropagationSampler(PropagationSampler* const sampler) {
+  delete sampler;
+}
+
+void StartPropagationSampler(PropagationSampler* const sampler) {
+  sampler->Start();
+}
+
+void StopPropagationSampler(PropagationSampler* const sampler) {
+  sampler->Stop();
+}
+
+void DrainPropagationSampler(PropagationSampler* const sampler) {
+  sampler->Drain();
+}
+
 // ----- Exported Methods for Unit Tests -----
 
 void RegisterDemon(Solver* const solver, Demon* const demon,
@@ -62,6 +62,7 @@ class Diffn : public Constraint {
     }
     delayed_demon_ = MakeDelayedConstraintDemon0(s, this, &Diffn::PropagateAll,
                                                  "PropagateAll");
+    delayed_demon_->set_cost(Solver::EXPENSIVE_DEMON);
     if (solver()->parameters().diffn_use_cumulative() &&
         IsArrayInRange(x_, 0LL, kint64max) &&
         IsArrayInRange(y_, 0LL, kint64max)) {
@@ -627,6 +627,191 @@ class SafeSumConstraint : public TreeArrayConstraint {
   Demon* sum_demon_;
 };
 
+// ----- BatchedScalProdConstraint -----
+
+// Number of terms scanned at once by BatchedScalProdConstraint::SumChanged().
+const int kBatchedScalProdBlockSize = 64;
+
+// This constraint implements sum(coefs[i] * vars[i]) == target_var for large
+// arrays. Instead of a tree of partial sums, the bounds of the terms are kept
+// in two flat reversible arrays and their sums are maintained incrementally.
+// When the bounds of the target change, only the terms whose range is larger
+// than the smallest slack can be reduced. They are found by scanning the
+// arrays block by block with a branch-free loop that the compiler vectorizes,
+// and only the blocks that contain such terms are visited again.
+// The caller must ensure that the sums of the bounds of the terms cannot
+// overflow (see UseBatchedScalProd()).
+class BatchedScalProdConstraint : public CastConstraint {
+ public:
+  BatchedScalProdConstraint(Solver* const solver,
+                            const std::vector<IntVar*>& vars,
+                            const std::vector<int64>& coefs,
+                            IntVar* const target_var)
+      : CastConstraint(solver, target_var),
+        vars_(vars),
+        coefs_(coefs),
+        term_mins_(vars.size(), 0),
+        term_maxs_(vars.size(), 0),
+        sum_min_(0),
+        sum_max_(0),
+        sum_demon_(nullptr) {
+    DCHECK_EQ(vars_.size(), coefs_.size());
+  }
+
+  ~BatchedScalProdConstraint() override {}
+
+  void Post() override {
+    for (int i = 0; i < vars_.size(); ++i) {
+      if (coefs_[i] != 0 && !vars_[i]->Bound()) {
+        Demon* const demon = MakeConstraintDemon1(
+            solver(), this, &BatchedScalProdConstraint::TermChanged,
+            "TermChanged", i);
+        vars_[i]->WhenRange(demon);
+      }
+    }
+    sum_demon_ = solver()->RegisterDemon(MakeDelayedConstraintDemon0(
+        solver(), this, &BatchedScalProdConstraint::SumChanged, "SumChanged"));
+    target_var_->WhenRange(sum_demon_);
+  }
+
+  void InitialPropagate() override {
+    Solver* const s = solver();
+    int64 sum_min = 0;
+    int64 sum_max = 0;
+    for (int i = 0; i < vars_.size(); ++i) {
+      const int64 term_min = TermMin(i);
+      const int64 term_max = TermMax(i);
+      term_mins_.SetValue(s, i, term_min);
+      term_maxs_.SetValue(s, i, term_max);
+      sum_min += term_min;
+      sum_max += term_max;
+    }
+    sum_min_.SetValue(s, sum_min);
+    sum_max_.SetValue(s, sum_max);
+    target_var_->SetRange(sum_min, sum_max);
+    SumChanged();
+  }
+
+  void TermChanged(int index) {
+    Solver* const s = solver();
+    const int64 term_min = TermMin(index);
+    const int64 term_max = TermMax(index);
+    sum_min_.Add(s, term_min - term_mins_[index]);
+    sum_max_.Add(s, term_max - term_maxs_[index]);
+    term_mins_.SetValue(s, index, term_min);
+    term_maxs_.SetValue(s, index, term_max);
+    target_var_->SetRange(sum_min_.Value(), sum_max_.Value());
+    EnqueueDelayedDemon(sum_demon_);
+  }
+
+  void SumChanged() {
+    const int64 sum_min = sum_min_.Value();
+    const int64 sum_max = sum_max_.Value();
+    const int64 target_min = target_var_->Min();
+    const int64 target_max = target_var_->Max();
+    if (target_min <= sum_min && target_max >= sum_max) {
+      return;
+    }
+    // Each term can exceed its min by at most slack_up, and can be below its
+    // max by at most slack_down.
+    const int64 slack_up = CapSub(target_max, sum_min);
+    const int64 slack_down = CapSub(sum_max, target_min);
+    if (slack_up < 0 || slack_down < 0) {
+      solver()->Fail();
+    }
+    const int64 slack = std::min(slack_up, slack_down);
+    const int size = vars_.size();
+    // The terms are only modified by TermChanged(), on their own index, after
+    // they have been reduced below. Reading the arrays directly is thus safe.
+    const int64* const term_mins = &term_mins_[0];
+    const int64* const term_maxs = &term_maxs_[0];
+    for (int start = 0; start < size; start += kBatchedScalProdBlockSize) {
+      const int end = std::min(start + kBatchedScalProdBlockSize, size);
+      // The sign bit of slack - range is set iff the term can be reduced.
+      // Written this way, the loop is vectorized even without 64-bit vector
+      // comparisons. Both operands are non-negative, so it cannot overflow.
+      uint64 reducible = 0;
+      for (int i = start; i < end; ++i) {
+        reducible |= static_cast<uint64>(slack - (term_maxs[i] - term_mins[i]));
+      }
+      reducible >>= 63;
+      if (reducible == 0) {
+        continue;
+      }
+      for (int i = start; i < end; ++i) {
+        if (term_maxs[i] - term_mins[i] > slack) {
+          SetTermRange(i, CapSub(term_maxs[i], slack_down),
+                       CapAdd(term_mins[i], slack_up));
+        }
+      }
+    }
+  }
+
+  std::string DebugString() const override {
+    return StringPrintf("BatchedScalProd([%s], [%s]) == %s",
+                        JoinDebugStringPtr(vars_, ", ").c_str(),
+                        strings::Join(coefs_, ", ").c_str(),
+                        target_var_->DebugString().c_str());
+  }
+
+  void Accept(ModelVisitor* const visitor) const override {
+    const bool all_ones = AreAllOnes(coefs_);
+    const char* const type =
+        all_ones ? ModelVisitor::kSumEqual : ModelVisitor::kScalProdEqual;
+    visitor->BeginVisitConstraint(type, this);
+    visitor->VisitIntegerVariableArrayArgument(ModelVisitor::kVarsArgument,
+                                               vars_);
+    if (!all_ones) {
+      visitor->VisitIntegerArrayArgument(ModelVisitor::kCoefficientsArgument,
+                                         coefs_);
+    }
+    // A bound target is visited as a value, as PositiveBooleanScalProdEqCst
+    // does.
+    if (target_var_->Bound()) {
+      visitor->VisitIntegerArgument(ModelVisitor::kValueArgument,
+                                    target_var_->Min());
+    } else {
+      visitor->VisitIntegerExpressionArgument(ModelVisitor::kTargetArgument,
+                                              target_var_);
+    }
+    visitor->EndVisitConstraint(type, this);
+  }
+
+ private:
+  int64 TermMin(int index) const {
+    const int64 coef = coefs_[index];
+    return coef * (coef > 0 ? vars_[index]->Min() : vars_[index]->Max());
+  }
+
+  int64 TermMax(int index) const {
+    const int64 coef = coefs_[index];
+    return coef * (coef > 0 ? vars_[index]->Max() : vars_[index]->Min());
+  }
+
+  // Restricts coefs_[index] * vars_[index] to [term_min, term_max].
+  void SetTermRange(int index, int64 term_min, int64 term_max) {
+    const int64 coef = coefs_[index];
+    IntVar* const var = vars_[index];
+    if (coef == 1) {
+      var->SetRange(term_min, term_max);
+    } else if (coef > 0) {
+      var->SetRange(PosIntDivUp(term_min, coef),
+                    PosIntDivDown(term_max, coef));
+    } else {
+      var->SetRange(PosIntDivUp(CapOpp(term_max), -coef),
+                    PosIntDivDown(CapOpp(term_min), -coef));
+    }
+  }
+
+  const std::vector<IntVar*> vars_;
+  const std::vector<int64> coefs_;
+  RevArray<int64> term_mins_;
+  RevArray<int64> term_maxs_;
+  NumericalRev<int64> sum_min_;
+  NumericalRev<int64> sum_max_;
+  Demon* sum_demon_;
+};
+
 // ---------- Min Array ----------
 
 // This constraint implements std::min(vars) == min_var.
@@ -2639,6 +2824,60 @@ class ExprLinearizer : public ModelParser {
 
 // ----- Factory functions -----
 
+// Returns true if sum(coefs[i] * vars[i]) has enough terms to use the batched
+// propagator, and if the bounds of the terms are small enough for their sums
+// to be computed without overflow. An empty 'coefs' stands for coefficients
+// all equal to 1.
+bool UseBatchedScalProd(Solver* const solver, const std::vector<IntVar*>& vars,
+                        const std::vector<int64>& coefs) {
+  const int threshold = solver->parameters().batched_sum_threshold();
+  if (threshold <= 0 || vars.size() < threshold) {
+    return false;
+  }
+  int64 magnitude = 0;
+  for (int i = 0; i < vars.size(); ++i) {
+    const int64 coef = coefs.empty() ? 1 : coefs[i];
+    const int64 var_magnitude =
+        std::max(CapOpp(vars[i]->Min()), vars[i]->Max());
+    magnitude = CapAdd(magnitude,
+                       CapProd(var_magnitude, std::max(CapOpp(coef), coef)));
+    if (magnitude >= kint64max / 2) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns a variable equal to sum(coefs[i] * vars[i]), maintained by a
+// BatchedScalProdConstraint. UseBatchedScalProd() must hold.
+IntVar* MakeBatchedScalProdVar(Solver* const solver,
+                               const std::vector<IntVar*>& vars,
+                               const std::vector<int64>& coefs) {
+  IntExpr* const cache = solver->Cache()->FindVarArrayConstantArrayExpression(
+      vars, coefs, ModelCache::VAR_ARRAY_CONSTANT_ARRAY_SCAL_PROD);
+  if (cache != nullptr) {
+    return cache->Var();
+  }
+  int64 sum_min = 0;
+  int64 sum_max = 0;
+  for (int i = 0; i < vars.size(); ++i) {
+    const int64 value_at_min = coefs[i] * vars[i]->Min();
+    const int64 value_at_max = coefs[i] * vars[i]->Max();
+    sum_min += std::min(value_at_min, value_at_max);
+    sum_max += std::max(value_at_min, value_at_max);
+  }
+  const std::string name =
+      StringPrintf("ScalProd([%s], [%s])", JoinNamePtr(vars, ", ").c_str(),
+                   strings::Join(coefs, ", ").c_str());
+  IntVar* const scal_prod_var = solver->MakeIntVar(sum_min, sum_max, name);
+  solver->AddConstraint(solver->RevAlloc(
+      new BatchedScalProdConstraint(solver, vars, coefs, scal_prod_var)));
+  solver->Cache()->InsertVarArrayConstantArrayExpression(
+      scal_prod_var, vars, coefs,
+      ModelCache::VAR_ARRAY_CONSTANT_ARRAY_SCAL_PROD);
+  return scal_prod_var;
+}
+
 void DeepLinearize(Solver* const solver, const std::vector<IntVar*>& pre_vars,
                    const std::vector<int64>& pre_coefs, std::vector<IntVar*>* vars,
                    std::vector<int64>* coefs, int64* constant) {
@@ -2723,6 +2962,10 @@ Constraint* MakeScalProdEqualityFct(Solver* const solver,
     }
   }
 
+  if (UseBatchedScalProd(solver, vars, coefs)) {
+    return solver->RevAlloc(new BatchedScalProdConstraint(
+        solver, vars, coefs, solver->MakeIntConst(cst)));
+  }
   // Simplications.
   int constants = 0;
   int positives = 0;
@@ -2848,6 +3091,10 @@ Constraint* MakeScalProdEqualityVarFct(Solver* const solver,
     return solver->RevAlloc(new PositiveBooleanScalProdEqVar(
         solver, vars, coefs, solver->MakeSum(target, -constant)->Var()));
   }
+  if (UseBatchedScalProd(solver, vars, coefs)) {
+    return solver->RevAlloc(new BatchedScalProdConstraint(
+        solver, vars, coefs, solver->MakeSum(target, -constant)->Var()));
+  }
   std::vector<IntVar*> terms;
   for (int i = 0; i < size; ++i) {
     terms.push_back(solver->MakeProd(vars[i], coefs[i])->Var());
@@ -2884,6 +3131,10 @@ Constraint* MakeScalProdGreaterOrEqualFct(Solver* solver,
     }
     return solver->MakeSumGreaterOrEqual(terms, 1);
   }
+  if (UseBatchedScalProd(solver, vars, coefs)) {
+    return solver->MakeGreaterOrEqual(
+        MakeBatchedScalProdVar(solver, vars, coefs), cst);
+  }
   std::vector<IntVar*> terms;
   for (int i = 0; i < size; ++i) {
     terms.push_back(solver->MakeProd(vars[i], coefs[i])->Var());
@@ -2922,6 +3173,10 @@ Constraint* MakeScalProdLessOrEqualFct(Solver* solver,
     return solver->RevAlloc(
         new BooleanScalProdLessConstant(solver, vars, coefs, upper_bound));
   }
+  if (UseBatchedScalProd(solver, vars, coefs)) {
+    return solver->MakeLessOrEqual(
+        MakeBatchedScalProdVar(solver, vars, coefs), upper_bound);
+  }
   // Some simplications
   int constants = 0;
   int positives = 0;
@@ -3046,6 +3301,9 @@ IntExpr* MakeSumArrayAux(Solver* const solver, const std::vector<IntVar*>& vars,
     if (AreAllBooleans(vars)) {
       solver->AddConstraint(
           solver->RevAlloc(new SumBooleanEqualToVar(solver, vars, sum_var)));
+    } else if (UseBatchedScalProd(solver, vars, {})) {
+      solver->AddConstraint(solver->RevAlloc(new BatchedScalProdConstraint(
+          solver, vars, std::vector<int64>(size, 1), sum_var)));
     } else if (size <= solver->parameters().array_split_size()) {
       solver->AddConstraint(
           solver->RevAlloc(new SmallSumConstraint(solver, vars, sum_var)));
@@ -3152,6 +3410,10 @@ IntExpr* MakeScalProdAux(Solver* solver, const std::vector<IntVar*>& vars,
       }
     }
   }
+  if (UseBatchedScalProd(solver, vars, coefs)) {
+    return solver->MakeSum(MakeBatchedScalProdVar(solver, vars, coefs),
+                           constant);
+  }
   std::vector<IntVar*> terms;
   for (int i = 0; i < size; ++i) {
     terms.push_back(solver->MakeProd(vars[i], coefs[i])->Var());
@@ -3419,7 +3681,10 @@ Constraint* Solver::MakeSumEquality(const std::vector<IntVar*>& vars, int64 cst)
     } else if (vars.size() == 2) {
       return MakeEquality(vars[0], MakeDifference(cst, vars[1]));
     }
-    if (DetectSumOverflow(vars)) {
+    if (UseBatchedScalProd(this, vars, {})) {
+      return RevAlloc(new BatchedScalProdConstraint(
+          this, vars, std::vector<int64>(size, 1), MakeIntConst(cst)));
+    } else if (DetectSumOverflow(vars)) {
       return RevAlloc(new SafeSumConstraint(this, vars, MakeIntConst(cst)));
     } else if (size <= parameters_.array_split_size()) {
       return RevAlloc(new SmallSumConstraint(this, vars, MakeIntConst(cst)));
@@ -3444,7 +3709,10 @@ Constraint* Solver::MakeSumEquality(const std::vector<IntVar*>& vars,
   } else if (size == 2) {
     return MakeEquality(MakeSum(vars[0], vars[1]), var);
   } else {
-    if (DetectSumOverflow(vars)) {
+    if (UseBatchedScalProd(this, vars, {})) {
+      return RevAlloc(new BatchedScalProdConstraint(
+          this, vars, std::vector<int64>(size, 1), var));
+    } else if (DetectSumOverflow(vars)) {
       return RevAlloc(new SafeSumConstraint(this, vars, var));
     } else if (size <= parameters_.array_split_size()) {
       return RevAlloc(new SmallSumConstraint(this, vars, var));
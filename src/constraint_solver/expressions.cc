@@ -1613,7 +1613,7 @@ class SimpleBitSet : public DomainIntVar::BitSet {
       const int bs =
           (i == size_.Value() - 1) ? 63 - BitPos64(size_.Value()) : 0;
       bits_[i] = kAllBits64 >> bs;
-      stamps_[i] = s->stamp() - 1;
+      stamps_[i] = s->trail_stamp() - 1;
     }
   }
 
@@ -1632,7 +1632,7 @@ class SimpleBitSet : public DomainIntVar::BitSet {
     stamps_ = new uint64[bsize_];
     for (int i = 0; i < bsize_; ++i) {
       bits_[i] = GG_ULONGLONG(0);
-      stamps_[i] = s->stamp() - 1;
+      stamps_[i] = s->trail_stamp() - 1;
     }
     for (int i = 0; i < sorted_values.size(); ++i) {
       const int64 val = sorted_values[i];
@@ -1703,7 +1703,7 @@ class SimpleBitSet : public DomainIntVar::BitSet {
     // Bitset.
     const int64 val_offset = val - omin_;
     const int offset = BitOffset64(val_offset);
-    const uint64 current_stamp = solver_->stamp();
+    const uint64 current_stamp = solver_->trail_stamp();
     if (stamps_[offset] < current_stamp) {
       stamps_[offset] = current_stamp;
       solver_->SaveValue(&bits_[offset]);
@@ -1810,7 +1810,7 @@ class SmallBitSet : public DomainIntVar::BitSet {
   SmallBitSet(Solver* const s, int64 vmin, int64 vmax)
       : BitSet(s),
         bits_(GG_ULONGLONG(0)),
-        stamp_(s->stamp() - 1),
+        stamp_(s->trail_stamp() - 1),
         omin_(vmin),
         omax_(vmax),
         size_(vmax - vmin + 1) {
@@ -1822,7 +1822,7 @@ class SmallBitSet : public DomainIntVar::BitSet {
               int64 vmax)
       : BitSet(s),
         bits_(GG_ULONGLONG(0)),
-        stamp_(s->stamp() - 1),
+        stamp_(s->trail_stamp() - 1),
         omin_(vmin),
         omax_(vmax),
         size_(sorted_values.size()) {
@@ -1916,7 +1916,7 @@ class SmallBitSet : public DomainIntVar::BitSet {
     DCHECK_LE(val, omax_);
     if (bit(val)) {
       // Bitset.
-      const uint64 current_stamp = solver_->stamp();
+      const uint64 current_stamp = solver_->trail_stamp();
       if (stamp_ < current_stamp) {
         stamp_ = current_stamp;
         solver_->SaveValue(&bits_);
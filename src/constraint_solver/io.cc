@@ -2025,8 +2025,12 @@ Constraint* BuildScalProdEqual(CpModelLoader* const builder,
   VERIFY(builder->ScanArguments(ModelVisitor::kCoefficientsArgument, proto,
                                 &values));
   int64 value = 0;
-  VERIFY(builder->ScanArguments(ModelVisitor::kValueArgument, proto, &value));
-  return builder->solver()->MakeScalProdEquality(vars, values, value);
+  if (builder->ScanArguments(ModelVisitor::kValueArgument, proto, &value)) {
+    return builder->solver()->MakeScalProdEquality(vars, values, value);
+  }
+  IntExpr* target = nullptr;
+  VERIFY(builder->ScanArguments(ModelVisitor::kTargetArgument, proto, &target));
+  return builder->solver()->MakeScalProdEquality(vars, values, target->Var());
 }
 
 // ----- kScalProdGreaterOrEqual -----
@@ -2462,6 +2466,12 @@ bool Solver::LoadModel(const CpModel& model_proto) {
 
 bool Solver::LoadModel(const CpModel& model_proto,
                        std::vector<SearchMonitor*>* monitors) {
+  return LoadModel(model_proto, monitors, nullptr);
+}
+
+bool Solver::LoadModel(const CpModel& model_proto,
+                       std::vector<SearchMonitor*>* monitors,
+                       std::vector<std::vector<IntVar*>>* variable_groups) {
   if (model_proto.version() > kModelVersion) {
     LOG(ERROR) << "Model protocol buffer version is greater than"
                << " the one compiled in the reader (" << model_proto.version()
@@ -2522,6 +2532,13 @@ bool Solver::LoadModel(const CpModel& model_proto,
       monitors->push_back(objective);
     }
   }
+  if (variable_groups != nullptr) {
+    for (const CpVariableGroup& group_proto : model_proto.variable_groups()) {
+      variable_groups->push_back(std::vector<IntVar*>());
+      builder.ScanArguments(ModelVisitor::kVarsArgument, group_proto,
+                            &variable_groups->back());
+    }
+  }
   return true;
 }
 
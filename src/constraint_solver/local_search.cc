@@ -341,12 +341,29 @@ PathOperator::PathOperator(const std::vector<IntVar*>& next_vars,
       base_paths_(number_of_base_nodes),
       just_started_(false),
       first_start_(true),
-      start_empty_path_class_(std::move(start_empty_path_class)) {
+      start_empty_path_class_(std::move(start_empty_path_class)),
+      restricted_base_index_(-1),
+      marked_reference_(-1) {
   if (!ignore_path_vars_) {
     AddVars(path_vars);
   }
 }
 
+void PathOperator::SetNeighbors(
+    std::function<const std::vector<int>&(int64)> get_neighbors) {
+  get_neighbors_ = std::move(get_neighbors);
+  restricted_base_index_ = -1;
+  neighbor_marks_.clear();
+  marked_reference_ = -1;
+  if (get_neighbors_ != nullptr) {
+    const int restricted_base_index = NeighborRestrictedBaseIndex();
+    if (restricted_base_index < base_nodes_.size()) {
+      restricted_base_index_ = restricted_base_index;
+      neighbor_marks_.resize(number_of_nexts_, false);
+    }
+  }
+}
+
 void PathOperator::OnStart() {
   InitializeBaseNodes();
   OnNodeInitialization();
@@ -354,6 +371,9 @@ void PathOperator::OnStart() {
 
 bool PathOperator::MakeOneNeighbor() {
   while (IncrementPosition()) {
+    if (restricted_base_index_ >= 0 && !RestrictedBaseNodeIsNeighbor()) {
+      continue;
+    }
     // Need to revert changes here since MakeNeighbor might have returned false
     // and have done changes in the previous iteration.
     RevertChanges(true);
@@ -465,6 +485,9 @@ bool PathOperator::IncrementPosition() {
     for (int i = base_node_size - 1; i >= 0; --i) {
       if (base_nodes_[i] < number_of_nexts_) {
         base_nodes_[i] = OldNext(base_nodes_[i]);
+        if (i == restricted_base_index_) {
+          SkipNonNeighbors();
+        }
         break;
       }
       base_nodes_[i] = StartNode(i);
@@ -637,6 +660,48 @@ void PathOperator::InitializeBaseNodes() {
   just_started_ = true;
 }
 
+bool PathOperator::RestrictedBaseNodeIsNeighbor() {
+  const int64 reference = NeighborReferenceNode();
+  const int64 base_node = base_nodes_[restricted_base_index_];
+  if (reference < 0 || IsPathEnd(base_node) ||
+      base_node == StartNode(restricted_base_index_)) {
+    return true;
+  }
+  MarkNeighbors(reference);
+  return neighbor_marks_[base_node];
+}
+
+void PathOperator::SkipNonNeighbors() {
+  const int64 reference = NeighborReferenceNode();
+  if (reference < 0) {
+    return;
+  }
+  MarkNeighbors(reference);
+  int& base_node = base_nodes_[restricted_base_index_];
+  const int end_node = end_nodes_[restricted_base_index_];
+  // Stopping on the end position is necessary for IncrementPosition() to
+  // detect that the neighborhood has been fully explored.
+  while (!IsPathEnd(base_node) && !neighbor_marks_[base_node] &&
+         base_node != end_node) {
+    base_node = OldNext(base_node);
+  }
+}
+
+void PathOperator::MarkNeighbors(int64 reference) {
+  if (reference == marked_reference_) {
+    return;
+  }
+  if (marked_reference_ >= 0) {
+    for (const int neighbor : get_neighbors_(marked_reference_)) {
+      neighbor_marks_[neighbor] = false;
+    }
+  }
+  for (const int neighbor : get_neighbors_(reference)) {
+    neighbor_marks_[neighbor] = true;
+  }
+  marked_reference_ = reference;
+}
+
 bool PathOperator::OnSamePath(int64 node1, int64 node2) const {
   if (IsInactive(node1) != IsInactive(node2)) {
     return false;
@@ -738,9 +803,16 @@ bool TwoOpt::MakeNeighbor() {
       return false;
     }
   } else {
-    const int64 to_move = Next(last_);
-    DCHECK_EQ(Next(to_move), BaseNode(1));
-    return MoveChain(last_, to_move, BaseNode(0));
+    // Extends the reversed chain up to BaseNode(1); this moves a single node
+    // unless positions have been skipped by a neighbor restriction.
+    do {
+      const int64 to_move = Next(last_);
+      if (IsPathEnd(to_move) || !MoveChain(last_, to_move, BaseNode(0))) {
+        last_ = -1;
+        return false;
+      }
+    } while (Next(last_) != BaseNode(1));
+    return true;
   }
 }
 
@@ -787,6 +859,11 @@ class Relocate : public PathOperator {
     // version.
     return single_path_;
   }
+  // The chain is inserted after BaseNode(1), which must thus be a neighbor of
+  // its first node.
+  int64 NeighborReferenceNode() const override {
+    return NodeAfterFirstBaseNode();
+  }
 
  private:
   const int64 chain_length_;
@@ -828,6 +905,13 @@ class Exchange : public PathOperator {
   bool MakeNeighbor() override;
 
   std::string DebugString() const override { return "Exchange"; }
+
+ protected:
+  // The node after BaseNode(0) is moved after BaseNode(1), which must thus be
+  // one of its neighbors.
+  int64 NeighborReferenceNode() const override {
+    return NodeAfterFirstBaseNode();
+  }
 };
 
 bool Exchange::MakeNeighbor() {
@@ -870,6 +954,13 @@ class Cross : public PathOperator {
   bool MakeNeighbor() override;
 
   std::string DebugString() const override { return "Cross"; }
+
+ protected:
+  // The chain ending at BaseNode(1) is moved before the node after
+  // BaseNode(0), which BaseNode(1) must thus be a neighbor of.
+  int64 NeighborReferenceNode() const override {
+    return NodeAfterFirstBaseNode();
+  }
 };
 
 bool Cross::MakeNeighbor() {
@@ -906,6 +997,9 @@ class BaseInactiveNodeToPathOperator : public PathOperator {
 
  protected:
   bool MakeOneNeighbor() override;
+  // The inactive node is inserted after nodes which are its neighbors.
+  int NeighborRestrictedBaseIndex() const override { return 0; }
+  int64 NeighborReferenceNode() const override { return inactive_node_; }
   int64 GetInactiveNode() const { return inactive_node_; }
 
  private:
@@ -12,9 +12,11 @@
 // limitations under the License.
 
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
+#include "base/hash.h"
 #include "base/integral_types.h"
 #include "base/logging.h"
 #include "base/macros.h"
@@ -52,6 +54,11 @@ class NoGoodTerm {
 
   virtual TermStatus Evaluate() const = 0;
   virtual void Refute() = 0;
+  // The variable whose domain changes can change the status of the term.
+  virtual IntVar* Variable() const = 0;
+  // Returns true if the term can only become always true when its variable
+  // becomes bound.
+  virtual bool TrueOnlyWhenBound() const = 0;
   virtual std::string DebugString() const = 0;
 
  private:
@@ -87,6 +94,10 @@ class IntegerVariableNoGoodTerm : public NoGoodTerm {
     }
   }
 
+  IntVar* Variable() const override { return integer_variable_; }
+
+  bool TrueOnlyWhenBound() const override { return assign_; }
+
   std::string DebugString() const override {
     return StringPrintf("(%s %s %lld)", integer_variable_->name().c_str(),
                         assign_ ? "==" : "!=", value_);
@@ -184,6 +195,271 @@ class NaiveNoGoodManager : public NoGoodManager {
  private:
   std::vector<NoGood*> nogoods_;
 };
+
+// ----- WatchedNoGoodManager -----
+
+// This manager watches two terms per nogood that are not always true. A
+// nogood is only revisited when one of its watched terms may have become
+// true, which is detected by demons on the variables of the terms: a term
+// var == value can only become true when var is bound, a term var != value
+// when the domain of var changes. If the watched term is true and the nogood
+// is not satisfied by its other watched term, another term that is not
+// always true is watched instead. If there is none, the other watched term
+// is refuted, or the solver fails if it is also true. As usual for watched
+// literals, the watches do not need to be restored on backtrack.
+//
+// The demons are attached at the root node after each restart, and are
+// removed by the next restart. The nogoods added since the last restart are
+// applied naively until then; as the default search adds its nogoods right
+// before restarting, this is rare. When there are more than
+// max_num_no_goods nogoods, the least active ones are deleted at restart
+// time: the activity of a nogood is bumped each time it propagates or fails,
+// and decays at each restart.
+class WatchedNoGoodManager : public NoGoodManager {
+ public:
+  WatchedNoGoodManager(Solver* const solver, int max_num_no_goods)
+      : NoGoodManager(solver),
+        max_num_no_goods_(max_num_no_goods),
+        num_watched_(0),
+        attached_(false),
+        activity_increment_(1.0) {}
+  ~WatchedNoGoodManager() override { Clear(); }
+
+  void Clear() override {
+    for (const WatchedNoGood& watched : nogoods_) {
+      delete watched.nogood;
+    }
+    nogoods_.clear();
+    ClearWatches();
+  }
+
+  void Init() override { ClearWatches(); }
+
+  void RestartSearch() override { ClearWatches(); }
+
+  void AddNoGood(NoGood* const nogood) override {
+    WatchedNoGood watched;
+    watched.nogood = nogood;
+    for (int i = 0; i < nogood->size(); ++i) {
+      NoGoodTerm* const term = nogood->term(i);
+      const int var_index = VariableIndex(term->Variable());
+      watched.lists.push_back(term->TrueOnlyWhenBound()
+                                  ? BoundWatchList(var_index)
+                                  : DomainWatchList(var_index));
+    }
+    watched.activity = activity_increment_;
+    nogoods_.push_back(watched);
+  }
+
+  int NoGoodCount() const override { return nogoods_.size(); }
+
+  void Apply() override {
+    Solver* const s = solver();
+    if (!attached_ && s->SearchDepth() == 0) {
+      DecayActivities();
+      if (static_cast<int>(nogoods_.size()) > max_num_no_goods_) {
+        DeleteInactiveNoGoods();
+      }
+      AttachAndPropagate();
+    }
+    // The nogoods that are not watched yet are applied naively.
+    for (int i = attached_ ? num_watched_ : 0; i < nogoods_.size(); ++i) {
+      nogoods_[i].nogood->Apply(s);
+    }
+  }
+
+  // Called by the demon of the given watch list.
+  void ProcessWatchList(int list) {
+    std::vector<Watch>& watches = watches_[list];
+    int i = 0;
+    while (i < watches.size()) {
+      const Watch watch = watches[i];
+      WatchedNoGood& watched = nogoods_[watch.nogood];
+      NoGood* const nogood = watched.nogood;
+      if (nogood->term(watched.terms[watch.slot])->Evaluate() !=
+          NoGoodTerm::ALWAYS_TRUE) {
+        ++i;
+        continue;
+      }
+      const int other = watched.terms[1 - watch.slot];
+      const NoGoodTerm::TermStatus other_status =
+          nogood->term(other)->Evaluate();
+      if (other_status == NoGoodTerm::ALWAYS_FALSE) {
+        // The nogood is satisfied until the other term is restored.
+        ++i;
+        continue;
+      }
+      const int replacement =
+          FindWatchableTerm(nogood, watched.terms[0], watched.terms[1]);
+      if (replacement != -1) {
+        watched.terms[watch.slot] = replacement;
+        watches[i] = watches.back();
+        watches.pop_back();
+        watches_[watched.lists[replacement]].push_back(watch);
+        continue;
+      }
+      BumpActivity(&watched);
+      if (other_status == NoGoodTerm::UNDECIDED) {
+        nogood->term(other)->Refute();
+      } else {
+        solver()->Fail();
+      }
+      ++i;
+    }
+  }
+
+  std::string DebugString() const override {
+    return StringPrintf("WatchedNoGoodManager(%d)", NoGoodCount());
+  }
+
+ private:
+  static const double kActivityDecay;
+  static const double kMaxActivity;
+
+  struct WatchedNoGood {
+    NoGood* nogood;
+    // The watch list of each term.
+    std::vector<int> lists;
+    // The indices of the two watched terms, if the nogood is watched.
+    int terms[2];
+    double activity;
+  };
+
+  struct Watch {
+    int nogood;
+    // 0 or 1, the index of the watched term in WatchedNoGood::terms.
+    int slot;
+  };
+
+  class WatchDemon : public Demon {
+   public:
+    WatchDemon(WatchedNoGoodManager* const manager, int list)
+        : manager_(manager), list_(list) {}
+    ~WatchDemon() override {}
+
+    void Run(Solver* const s) override { manager_->ProcessWatchList(list_); }
+
+    std::string DebugString() const override {
+      return StringPrintf("WatchDemon(%d)", list_);
+    }
+
+   private:
+    WatchedNoGoodManager* const manager_;
+    const int list_;
+  };
+
+  // Each variable has two watch lists: the terms that can only become true
+  // when it is bound, and the other ones.
+  static int BoundWatchList(int var_index) { return 2 * var_index; }
+  static int DomainWatchList(int var_index) { return 2 * var_index + 1; }
+
+  void ClearWatches() {
+    attached_ = false;
+    num_watched_ = 0;
+    for (std::vector<Watch>& watches : watches_) {
+      watches.clear();
+    }
+  }
+
+  int VariableIndex(IntVar* const var) {
+    const auto it = var_indices_.find(var);
+    if (it != var_indices_.end()) {
+      return it->second;
+    }
+    const int index = vars_.size();
+    var_indices_[var] = index;
+    vars_.push_back(var);
+    watches_.resize(2 * vars_.size());
+    return index;
+  }
+
+  // Returns the index of a term that is not always true, and that is neither
+  // first nor second, or -1 if there is none.
+  static int FindWatchableTerm(NoGood* const nogood, int first, int second) {
+    for (int i = 0; i < nogood->size(); ++i) {
+      if (i != first && i != second &&
+          nogood->term(i)->Evaluate() != NoGoodTerm::ALWAYS_TRUE) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // Watches two terms of each nogood, attaches the demons to the variables
+  // and applies the nogoods that have less than two terms to watch. This must
+  // be done at the root node, where the demons last until the next restart.
+  void AttachAndPropagate() {
+    Solver* const s = solver();
+    std::vector<int> to_apply;
+    for (int n = 0; n < nogoods_.size(); ++n) {
+      WatchedNoGood& watched = nogoods_[n];
+      const int first = FindWatchableTerm(watched.nogood, -1, -1);
+      const int second =
+          first == -1 ? -1 : FindWatchableTerm(watched.nogood, first, -1);
+      if (second == -1) {
+        to_apply.push_back(n);
+        continue;
+      }
+      watched.terms[0] = first;
+      watched.terms[1] = second;
+      watches_[watched.lists[first]].push_back({n, 0});
+      watches_[watched.lists[second]].push_back({n, 1});
+    }
+    for (int i = 0; i < vars_.size(); ++i) {
+      vars_[i]->WhenBound(
+          s->RevAlloc(new WatchDemon(this, BoundWatchList(i))));
+      vars_[i]->WhenDomain(
+          s->RevAlloc(new WatchDemon(this, DomainWatchList(i))));
+    }
+    num_watched_ = nogoods_.size();
+    attached_ = true;
+    // At the root node, these nogoods are either satisfied for good, or
+    // refute their only undecided term.
+    for (const int n : to_apply) {
+      nogoods_[n].nogood->Apply(s);
+    }
+  }
+
+  void BumpActivity(WatchedNoGood* const watched) {
+    watched->activity += activity_increment_;
+    if (watched->activity > kMaxActivity) {
+      for (WatchedNoGood& nogood : nogoods_) {
+        nogood.activity /= kMaxActivity;
+      }
+      activity_increment_ /= kMaxActivity;
+    }
+  }
+
+  void DecayActivities() { activity_increment_ /= kActivityDecay; }
+
+  // Keeps the max_num_no_goods_ / 2 most active nogoods. Must be called when
+  // no nogood is watched.
+  void DeleteInactiveNoGoods() {
+    DCHECK(!attached_);
+    std::sort(nogoods_.begin(), nogoods_.end(),
+              [](const WatchedNoGood& a, const WatchedNoGood& b) {
+                return a.activity > b.activity;
+              });
+    const int kept = max_num_no_goods_ / 2;
+    for (int i = kept; i < nogoods_.size(); ++i) {
+      delete nogoods_[i].nogood;
+    }
+    nogoods_.resize(kept);
+  }
+
+  const int max_num_no_goods_;
+  std::vector<WatchedNoGood> nogoods_;
+  // The nogoods with an index lower than num_watched_ are watched.
+  int num_watched_;
+  bool attached_;
+  double activity_increment_;
+  hash_map<IntVar*, int> var_indices_;
+  std::vector<IntVar*> vars_;
+  std::vector<std::vector<Watch>> watches_;
+};
+
+const double WatchedNoGoodManager::kActivityDecay = 0.95;
+const double WatchedNoGoodManager::kMaxActivity = 1e100;
 }  // namespace
 
 // ----- API -----
@@ -192,4 +468,8 @@ NoGoodManager* Solver::MakeNoGoodManager() {
   return RevAlloc(new NaiveNoGoodManager(this));
 }
 
+NoGoodManager* Solver::MakeWatchedNoGoodManager(int max_num_no_goods) {
+  return RevAlloc(new WatchedNoGoodManager(this, max_num_no_goods));
+}
+
 }  // namespace operations_research
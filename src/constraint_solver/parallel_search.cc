@@ -0,0 +1,575 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "constraint_solver/parallel_search.h"
+
+#include "base/callback.h"
+#include "base/hash.h"
+#include "base/logging.h"
+#include "base/map_util.h"
+#include "base/stringprintf.h"
+#include "base/threadpool.h"
+#include "constraint_solver/constraint_solveri.h"
+#include "constraint_solver/model.pb.h"
+
+namespace operations_research {
+
+namespace {
+// Extracts the variable and the value of the decisions that are domain
+// reductions of a single integer variable.
+class DecisionInspector : public DecisionVisitor {
+ public:
+  enum Kind { UNKNOWN, SET_VALUE, SPLIT_LOWER_HALF, SPLIT_UPPER_HALF };
+
+  DecisionInspector() : kind_(UNKNOWN), var_(nullptr), value_(0) {}
+  ~DecisionInspector() override {}
+
+  void Inspect(const Decision* const decision) {
+    kind_ = UNKNOWN;
+    decision->Accept(this);
+  }
+
+  void VisitSetVariableValue(IntVar* const var, int64 value) override {
+    kind_ = SET_VALUE;
+    var_ = var;
+    value_ = value;
+  }
+
+  void VisitSplitVariableDomain(IntVar* const var, int64 value,
+                                bool start_with_lower_half) override {
+    kind_ = start_with_lower_half ? SPLIT_LOWER_HALF : SPLIT_UPPER_HALF;
+    var_ = var;
+    value_ = value;
+  }
+
+  Kind kind() const { return kind_; }
+  IntVar* var() const { return var_; }
+  int64 value() const { return value_; }
+
+ private:
+  Kind kind_;
+  IntVar* var_;
+  int64 value_;
+};
+}  // namespace
+
+// ----- Worker -----
+
+// A worker solver and the open nodes of its current search. The stack of open
+// nodes is shared with the thieves, and protected by a mutex.
+class ParallelSearch::Worker {
+ public:
+  explicit Worker(int index)
+      : solver_(StringPrintf("ParallelSearchWorker%d", index)),
+        vars_(),
+        var_indices_(),
+        objective_var_(nullptr),
+        depth_(0),
+        path_applied_(false),
+        inspector_(),
+        mutex_(),
+        base_path_(),
+        stack_() {}
+
+  // Loads the model exported by ParallelSearch::Solve(). Its only variable
+  // group holds the decision variables, then the objective variable if any.
+  void Load(const CpModel& model, int num_vars, bool has_objective) {
+    std::vector<std::vector<IntVar*>> variable_groups;
+    CHECK(solver_.LoadModel(model, nullptr, &variable_groups));
+    CHECK_EQ(1, variable_groups.size());
+    vars_ = variable_groups[0];
+    CHECK_EQ(num_vars + (has_objective ? 1 : 0), vars_.size());
+    if (has_objective) {
+      objective_var_ = vars_.back();
+      vars_.pop_back();
+    }
+    for (int i = 0; i < vars_.size(); ++i) {
+      // The first index is kept if a variable appears several times.
+      var_indices_.insert(std::make_pair(vars_[i], i));
+    }
+  }
+
+  Solver* solver() { return &solver_; }
+  const std::vector<IntVar*>& vars() const { return vars_; }
+  IntVar* objective_var() const { return objective_var_; }
+
+  // Number of stealable decisions on the current search path.
+  int depth() const { return depth_.Value(); }
+  void SetDepth(int depth) { depth_.SetValue(&solver_, depth); }
+
+  // Applies the path of the current node, once per search.
+  void ApplyPath() {
+    if (path_applied_.Value()) return;
+    path_applied_.SetValue(&solver_, true);
+    // The base path is only modified by this thread.
+    for (const PathStep& step : base_path_) {
+      IntVar* const var = vars_[step.var];
+      switch (step.type) {
+        case PathStep::EQUAL:
+          var->SetValue(step.value);
+          break;
+        case PathStep::NOT_EQUAL:
+          var->RemoveValue(step.value);
+          break;
+        case PathStep::LESS_OR_EQUAL:
+          var->SetMax(step.value);
+          break;
+        case PathStep::GREATER_OR_EQUAL:
+          var->SetMin(step.value);
+          break;
+      }
+    }
+  }
+
+  // Sets the path of the next node to explore.
+  void StartNode(const std::vector<PathStep>& path) {
+    MutexLock lock(&mutex_);
+    base_path_ = path;
+    stack_.clear();
+  }
+
+  // Called when the exploration of the current node is over.
+  void FinishNode() {
+    MutexLock lock(&mutex_);
+    stack_.clear();
+  }
+
+  // Called when the left branch of the stealable decision at the given depth
+  // is taken. Returns true if its right branch can be stolen.
+  bool OnApply(int depth, const Decision* const decision) {
+    OpenNode node;
+    inspector_.Inspect(decision);
+    const int var_index =
+        inspector_.kind() == DecisionInspector::UNKNOWN
+            ? -1
+            : FindWithDefault(var_indices_, inspector_.var(), -1);
+    node.path_is_known = var_index >= 0;
+    if (node.path_is_known) {
+      const int64 value = inspector_.value();
+      switch (inspector_.kind()) {
+        case DecisionInspector::SET_VALUE:
+          node.left = {var_index, PathStep::EQUAL, value};
+          node.right = {var_index, PathStep::NOT_EQUAL, value};
+          break;
+        case DecisionInspector::SPLIT_LOWER_HALF:
+          node.left = {var_index, PathStep::LESS_OR_EQUAL, value};
+          node.right = {var_index, PathStep::GREATER_OR_EQUAL, value + 1};
+          break;
+        default:
+          node.left = {var_index, PathStep::GREATER_OR_EQUAL, value + 1};
+          node.right = {var_index, PathStep::LESS_OR_EQUAL, value};
+          break;
+      }
+    }
+    MutexLock lock(&mutex_);
+    DCHECK_LE(depth, stack_.size());
+    stack_.resize(depth);
+    if (depth > 0 && !stack_[depth - 1].path_is_known) {
+      node.path_is_known = false;
+    }
+    stack_.push_back(node);
+    return node.path_is_known;
+  }
+
+  // Called when the right branch of the stealable decision at the given depth
+  // is about to be taken. Returns false if it was stolen.
+  bool OnRefute(int depth) {
+    MutexLock lock(&mutex_);
+    DCHECK_LT(depth, stack_.size());
+    stack_.resize(depth + 1);
+    if (stack_[depth].stolen) {
+      stack_.pop_back();
+      return false;
+    }
+    stack_[depth].in_right_branch = true;
+    return true;
+  }
+
+  // Steals the shallowest open right branch of the current search, and fills
+  // the path to it. Returns false if there is none.
+  bool Steal(std::vector<PathStep>* path) {
+    MutexLock lock(&mutex_);
+    for (int depth = 0; depth < stack_.size(); ++depth) {
+      OpenNode* const node = &stack_[depth];
+      if (!node->path_is_known) return false;
+      if (node->in_right_branch || node->stolen) continue;
+      node->stolen = true;
+      *path = base_path_;
+      for (int i = 0; i < depth; ++i) {
+        path->push_back(stack_[i].in_right_branch ? stack_[i].right
+                                                  : stack_[i].left);
+      }
+      path->push_back(node->right);
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  // A stealable decision of the current search path.
+  struct OpenNode {
+    PathStep left;
+    PathStep right;
+    // True if this decision, and all the ones above it, are described by
+    // left and right.
+    bool path_is_known = false;
+    bool in_right_branch = false;
+    bool stolen = false;
+  };
+
+  Solver solver_;
+  std::vector<IntVar*> vars_;
+  hash_map<const IntVar*, int> var_indices_;
+  IntVar* objective_var_;
+  Rev<int> depth_;
+  Rev<bool> path_applied_;
+  DecisionInspector inspector_;
+
+  Mutex mutex_;
+  std::vector<PathStep> base_path_ GUARDED_BY(mutex_);
+  std::vector<OpenNode> stack_ GUARDED_BY(mutex_);
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+// ----- Decisions and decision builder of the workers -----
+
+// Wraps a decision of the user decision builder, to maintain the stack of open
+// nodes of the worker.
+class ParallelSearch::StealableDecision : public Decision {
+ public:
+  StealableDecision(ParallelSearch* const search, Worker* const worker,
+                    Decision* const decision, int depth)
+      : search_(search), worker_(worker), decision_(decision), depth_(depth) {}
+  ~StealableDecision() override {}
+
+  void Apply(Solver* const s) override {
+    if (worker_->OnApply(depth_, decision_)) search_->NotifyNewOpenNode();
+    worker_->SetDepth(depth_ + 1);
+    decision_->Apply(s);
+  }
+
+  void Refute(Solver* const s) override {
+    if (!worker_->OnRefute(depth_)) s->Fail();
+    worker_->SetDepth(depth_ + 1);
+    decision_->Refute(s);
+  }
+
+  void Accept(DecisionVisitor* const visitor) const override {
+    decision_->Accept(visitor);
+  }
+
+  std::string DebugString() const override { return decision_->DebugString(); }
+
+ private:
+  ParallelSearch* const search_;
+  Worker* const worker_;
+  Decision* const decision_;
+  const int depth_;
+};
+
+class ParallelSearch::WorkerDecisionBuilder : public DecisionBuilder {
+ public:
+  WorkerDecisionBuilder(ParallelSearch* const search, Worker* const worker,
+                        DecisionBuilder* const db)
+      : search_(search), worker_(worker), db_(db) {}
+  ~WorkerDecisionBuilder() override {}
+
+  Decision* Next(Solver* const s) override {
+    worker_->ApplyPath();
+    Decision* const decision = db_->Next(s);
+    if (decision == nullptr) return nullptr;
+    return s->RevAlloc(
+        new StealableDecision(search_, worker_, decision, worker_->depth()));
+  }
+
+  void AppendMonitors(Solver* const solver,
+                      std::vector<SearchMonitor*>* const extras) override {
+    db_->AppendMonitors(solver, extras);
+  }
+
+  void Accept(ModelVisitor* const visitor) const override {
+    db_->Accept(visitor);
+  }
+
+  std::string DebugString() const override {
+    return StringPrintf("WorkerDecisionBuilder(%s)",
+                        db_->DebugString().c_str());
+  }
+
+ private:
+  ParallelSearch* const search_;
+  Worker* const worker_;
+  DecisionBuilder* const db_;
+};
+
+// An OptimizeVar that also takes into account the best objective value found
+// by all the workers.
+class ParallelSearch::SharedOptimizeVar : public OptimizeVar {
+ public:
+  SharedOptimizeVar(ParallelSearch* const search, Solver* const solver,
+                    IntVar* const var)
+      : OptimizeVar(solver, search->maximize_, var, search->step_),
+        search_(search) {}
+  ~SharedOptimizeVar() override {}
+
+  void EnterSearch() override {
+    OptimizeVar::EnterSearch();
+    ImportBestObjective();
+  }
+
+  void BeginNextDecision(DecisionBuilder* const db) override {
+    ImportBestObjective();
+    ApplyBound();
+  }
+
+  void RefuteDecision(Decision* const d) override {
+    ImportBestObjective();
+    ApplyBound();
+  }
+
+ private:
+  void ImportBestObjective() {
+    if (!search_->has_solution_.load()) return;
+    const int64 best = search_->best_objective_.load();
+    if (!found_initial_solution_ || (maximize_ ? best > best_ : best < best_)) {
+      best_ = best;
+      found_initial_solution_ = true;
+    }
+  }
+
+  ParallelSearch* const search_;
+};
+
+// ----- ParallelSearch -----
+
+ParallelSearch::ParallelSearch(Solver* const solver,
+                               const std::vector<IntVar*>& vars,
+                               OptimizeVar* const objective, int num_workers)
+    : solver_(solver),
+      vars_(vars),
+      objective_(objective),
+      num_workers_(num_workers),
+      workers_(),
+      mutex_(),
+      work_available_(),
+      root_is_pending_(false),
+      num_idle_workers_(0),
+      done_(false),
+      num_waiting_workers_(0),
+      stopped_(false),
+      timer_(),
+      time_limit_ms_(kint64max),
+      limit_reached_(false),
+      has_solution_(false),
+      best_objective_(0),
+      maximize_(false),
+      step_(1),
+      solution_limit_(1),
+      solution_(),
+      objective_value_(0),
+      search_completed_(false),
+      branches_(0),
+      failures_(0),
+      num_steals_(0),
+      num_solutions_(0) {
+  CHECK(solver != nullptr);
+  CHECK_GT(num_workers, 0);
+}
+
+ParallelSearch::~ParallelSearch() {}
+
+bool ParallelSearch::Solve(const DecisionBuilderFactory& factory,
+                           int64 time_limit_ms) {
+  // The decision variables, and the objective variable, are exported as the
+  // variable group of a decision builder.
+  std::vector<IntVar*> exported_vars = vars_;
+  std::vector<SearchMonitor*> monitors;
+  if (objective_ != nullptr) {
+    exported_vars.push_back(objective_->Var());
+    monitors.push_back(objective_);
+  }
+  CpModel model;
+  solver_->ExportModel(monitors, &model,
+                       solver_->MakePhase(exported_vars,
+                                          Solver::CHOOSE_FIRST_UNBOUND,
+                                          Solver::ASSIGN_MIN_VALUE));
+  if (objective_ != nullptr) {
+    maximize_ = model.objective().maximize();
+    step_ = model.objective().step();
+  }
+
+  root_is_pending_ = true;
+  num_idle_workers_ = 0;
+  done_ = false;
+  num_waiting_workers_ = 0;
+  stopped_ = false;
+  time_limit_ms_ = time_limit_ms;
+  limit_reached_ = false;
+  has_solution_ = false;
+  solution_.clear();
+  num_steals_ = 0;
+  num_solutions_ = 0;
+  workers_.clear();
+  for (int i = 0; i < num_workers_; ++i) {
+    workers_.emplace_back(new Worker(i));
+  }
+  timer_.Restart();
+  {
+    ThreadPool pool("ParallelSearch", num_workers_);
+    pool.StartWorkers();
+    for (int i = 0; i < num_workers_; ++i) {
+      pool.Add(NewCallback(this, &ParallelSearch::RunWorker, i,
+                           static_cast<const CpModel*>(&model), &factory));
+    }
+  }
+
+  search_completed_ = !limit_reached_;
+  branches_ = 0;
+  failures_ = 0;
+  for (const std::unique_ptr<Worker>& worker : workers_) {
+    branches_ += worker->solver()->branches();
+    failures_ += worker->solver()->failures();
+  }
+  VLOG(1) << "Parallel search: " << branches_ << " branches, " << failures_
+          << " failures, " << num_steals_ << " steals.";
+  return has_solution_;
+}
+
+void ParallelSearch::RunWorker(int index, const CpModel* model,
+                               const DecisionBuilderFactory* factory) {
+  Worker* const worker = workers_[index].get();
+  worker->Load(*model, vars_.size(), objective_ != nullptr);
+  Solver* const solver = worker->solver();
+  DecisionBuilder* const db = solver->RevAlloc(new WorkerDecisionBuilder(
+      this, worker, (*factory)(solver, worker->vars())));
+  std::vector<SearchMonitor*> monitors;
+  if (objective_ != nullptr) {
+    monitors.push_back(solver->RevAlloc(
+        new SharedOptimizeVar(this, solver, worker->objective_var())));
+  }
+  monitors.push_back(solver->MakeCustomLimit([this]() { return MustStop(); }));
+
+  std::vector<PathStep> path;
+  while (GetWork(worker, &path)) {
+    worker->StartNode(path);
+    solver->NewSearch(db, monitors);
+    while (solver->NextSolution()) {
+      RecordSolution(worker);
+      if (stopped_.load()) break;
+    }
+    solver->EndSearch();
+    worker->FinishNode();
+  }
+}
+
+bool ParallelSearch::MustStop() {
+  if (stopped_.load()) return true;
+  if (time_limit_ms_ != kint64max && timer_.GetInMs() >= time_limit_ms_) {
+    limit_reached_ = true;
+    Stop();
+    return true;
+  }
+  return false;
+}
+
+bool ParallelSearch::GetWork(Worker* const worker,
+                             std::vector<PathStep>* path) {
+  MutexLock lock(&mutex_);
+  ++num_idle_workers_;
+  for (;;) {
+    if (done_) return false;
+    if (root_is_pending_) {
+      root_is_pending_ = false;
+      path->clear();
+      --num_idle_workers_;
+      return true;
+    }
+    // num_waiting_workers_ is incremented before looking for an open node, so
+    // that a node created concurrently is either found here, or signaled by
+    // NotifyNewOpenNode().
+    ++num_waiting_workers_;
+    if (TryStealLocked(worker, path)) {
+      --num_waiting_workers_;
+      --num_idle_workers_;
+      ++num_steals_;
+      return true;
+    }
+    if (num_idle_workers_ == num_workers_) {
+      // No worker is exploring a node, the search is over.
+      --num_waiting_workers_;
+      done_ = true;
+      work_available_.SignalAll();
+      return false;
+    }
+    work_available_.Wait(&mutex_);
+    --num_waiting_workers_;
+  }
+}
+
+bool ParallelSearch::TryStealLocked(Worker* const thief,
+                                    std::vector<PathStep>* path) {
+  int thief_index = 0;
+  while (workers_[thief_index].get() != thief) ++thief_index;
+  for (int i = 1; i < num_workers_; ++i) {
+    Worker* const victim = workers_[(thief_index + i) % num_workers_].get();
+    if (victim->Steal(path)) return true;
+  }
+  return false;
+}
+
+void ParallelSearch::NotifyNewOpenNode() {
+  if (num_waiting_workers_.load() == 0) return;
+  MutexLock lock(&mutex_);
+  work_available_.SignalAll();
+}
+
+void ParallelSearch::RecordSolution(Worker* const worker) {
+  MutexLock lock(&mutex_);
+  if (objective_ != nullptr) {
+    ++num_solutions_;
+    const int64 value = worker->objective_var()->Value();
+    if (has_solution_ &&
+        (maximize_ ? value <= objective_value_ : value >= objective_value_)) {
+      return;
+    }
+    objective_value_ = value;
+    best_objective_ = value;
+  } else {
+    // Other workers may find solutions before they notice the stop.
+    if (num_solutions_ >= solution_limit_) return;
+    if (++num_solutions_ >= solution_limit_) {
+      limit_reached_ = true;
+      StopLocked();
+    }
+    if (has_solution_) return;
+  }
+  solution_.resize(vars_.size());
+  for (int i = 0; i < vars_.size(); ++i) {
+    solution_[i] = worker->vars()[i]->Min();
+  }
+  has_solution_ = true;
+}
+
+void ParallelSearch::Stop() {
+  MutexLock lock(&mutex_);
+  StopLocked();
+}
+
+void ParallelSearch::StopLocked() {
+  stopped_ = true;
+  done_ = true;
+  work_available_.SignalAll();
+}
+
+}  // namespace operations_research
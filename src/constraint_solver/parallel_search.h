@@ -0,0 +1,195 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A parallel tree search for the models of the constraint solver.
+//
+// The model of a solver is exported to a CpModel protocol buffer and loaded in
+// one worker solver per thread. Each worker runs its own depth-first search
+// with the decision builder returned by a user-given factory. The search tree
+// is split dynamically by work stealing: an idle worker takes the shallowest
+// open right branch of another worker. This works because the decisions are
+// inspected with a DecisionVisitor: the path from the root to a node is a list
+// of domain reductions (x == v, x != v, x <= v or x >= v) on the decision
+// variables, that the thief applies before starting its own search from this
+// node. The victim skips the right branch when it backtracks to it. Only the
+// nodes whose path is made of such decisions on the decision variables given
+// to the factory can be stolen; the other nodes are explored by the worker
+// that created them.
+//
+// For an optimization problem, the best objective value is shared by all the
+// workers through their OptimizeVar, which tightens the objective bound at
+// each node. For a satisfaction problem, the search stops when the solution
+// limit is reached, by default at the first solution.
+//
+// Usage:
+//   Solver solver("model");
+//   ... create the variables x and the constraints ...
+//   OptimizeVar* const objective = solver.MakeMinimize(cost, 1);
+//   ParallelSearch search(&solver, x, objective, /*num_workers=*/8);
+//   const bool found = search.Solve(
+//       [](Solver* const s, const std::vector<IntVar*>& vars) {
+//         return s->MakePhase(vars, Solver::CHOOSE_MIN_SIZE_LOWEST_MIN,
+//                             Solver::ASSIGN_MIN_VALUE);
+//       },
+//       /*time_limit_ms=*/60000);
+//   ... search.solution() holds the values of x in the best solution ...
+//
+// All the constraints of the model must support the export to protocol
+// buffers (see Solver::ExportModel()).
+
+#ifndef OR_TOOLS_CONSTRAINT_SOLVER_PARALLEL_SEARCH_H_
+#define OR_TOOLS_CONSTRAINT_SOLVER_PARALLEL_SEARCH_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "base/timer.h"
+#include "constraint_solver/constraint_solver.h"
+
+namespace operations_research {
+
+class ParallelSearch {
+ public:
+  // Builds the decision builder of a worker, given its solver and its copy of
+  // the decision variables. The decision builder must only assign the decision
+  // variables (and variables they define) for the nodes to be stolen.
+  typedef std::function<DecisionBuilder*(Solver* const solver,
+                                         const std::vector<IntVar*>& vars)>
+      DecisionBuilderFactory;
+
+  // The model is the one of the given solver. The decision variables are given
+  // to the factory and their values are reported in solution(). The objective
+  // can be nullptr for a satisfaction problem.
+  ParallelSearch(Solver* const solver, const std::vector<IntVar*>& vars,
+                 OptimizeVar* const objective, int num_workers);
+  ~ParallelSearch();
+
+  // Sets the number of solutions after which the search of a satisfaction
+  // problem stops; kint64max enumerates all the solutions. The default is 1.
+  // The limit is ignored for an optimization problem.
+  void set_solution_limit(int64 solution_limit) {
+    solution_limit_ = solution_limit;
+  }
+
+  // Runs the search with the given time limit (kint64max for no limit), and
+  // returns true if a solution was found.
+  bool Solve(const DecisionBuilderFactory& factory, int64 time_limit_ms);
+
+  // Values of the decision variables in the best solution found, or in the
+  // first solution found for a satisfaction problem, and the objective value
+  // of this solution.
+  const std::vector<int64>& solution() const { return solution_; }
+  int64 objective_value() const { return objective_value_; }
+
+  // Returns true if the whole search tree was explored, i.e. if the last call
+  // to Solve() proved the optimality of its solution, the infeasibility of the
+  // problem, or found all its solutions.
+  bool search_completed() const { return search_completed_; }
+
+  // Statistics of the last call to Solve(), summed over all the workers.
+  int64 branches() const { return branches_; }
+  int64 failures() const { return failures_; }
+  int64 num_steals() const { return num_steals_; }
+  // Number of solutions found by the workers. For an optimization problem,
+  // this includes the solutions that only improved the best solution known by
+  // their worker.
+  int64 num_solutions() const { return num_solutions_; }
+
+ private:
+  // A domain reduction of a decision variable.
+  struct PathStep {
+    enum Type { EQUAL, NOT_EQUAL, LESS_OR_EQUAL, GREATER_OR_EQUAL };
+    int var;
+    Type type;
+    int64 value;
+  };
+
+  class Worker;
+  class WorkerDecisionBuilder;
+  class StealableDecision;
+  class SharedOptimizeVar;
+
+  // The main loop of a worker thread: loads the model and explores the nodes
+  // returned by GetWork().
+  void RunWorker(int index, const CpModel* model,
+                 const DecisionBuilderFactory* factory);
+
+  // Returns true if the search must stop, because of the time limit or
+  // because a solution of a satisfaction problem was found.
+  bool MustStop();
+
+  // Waits until the given worker gets a node to explore, and fills its path.
+  // Returns false when the search is over.
+  bool GetWork(Worker* const worker, std::vector<PathStep>* path);
+
+  // Tries to steal an open node from another worker.
+  bool TryStealLocked(Worker* const thief, std::vector<PathStep>* path)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Wakes up the idle workers, if any, when a new node can be stolen.
+  void NotifyNewOpenNode();
+
+  // Counts the solution of the given worker, and records it if it is better
+  // than the current best one. For a satisfaction problem, only the first
+  // solution is recorded, and the search is stopped when the solution limit is
+  // reached.
+  void RecordSolution(Worker* const worker);
+
+  // Stops all the workers.
+  void Stop();
+  void StopLocked() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  Solver* const solver_;
+  const std::vector<IntVar*> vars_;
+  OptimizeVar* const objective_;
+  const int num_workers_;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  Mutex mutex_;
+  CondVar work_available_;
+  bool root_is_pending_ GUARDED_BY(mutex_);
+  int num_idle_workers_ GUARDED_BY(mutex_);
+  bool done_ GUARDED_BY(mutex_);
+  std::atomic<int> num_waiting_workers_;
+  std::atomic<bool> stopped_;
+  WallTimer timer_;
+  int64 time_limit_ms_;
+  std::atomic<bool> limit_reached_;
+
+  // Best objective value, for the workers. Only valid if has_solution_.
+  std::atomic<bool> has_solution_;
+  std::atomic<int64> best_objective_;
+  bool maximize_;
+  int64 step_;
+  int64 solution_limit_;
+
+  std::vector<int64> solution_;
+  int64 objective_value_;
+  bool search_completed_;
+  int64 branches_;
+  int64 failures_;
+  std::atomic<int64> num_steals_;
+  int64 num_solutions_ GUARDED_BY(mutex_);
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelSearch);
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_CONSTRAINT_SOLVER_PARALLEL_SEARCH_H_
@@ -932,6 +932,7 @@ class FullDisjunctiveConstraint : public DisjunctiveConstraint {
     Demon* const d = MakeDelayedConstraintDemon0(
         solver(), this, &FullDisjunctiveConstraint::InitialPropagate,
         "InitialPropagate");
+    d->set_cost(Solver::EXPENSIVE_DEMON);
     for (int32 i = 0; i < straight_.size(); ++i) {
       straight_.interval(i)->WhenAnything(d);
     }
@@ -1380,6 +1381,7 @@ class EdgeFinder : public Constraint {
     // Add the demons
     Demon* const demon = MakeDelayedConstraintDemon0(
         solver(), this, &EdgeFinder::InitialPropagate, "RangeChanged");
+    demon->set_cost(Solver::EXPENSIVE_DEMON);
     for (Task* const task : tasks_) {
       // Delay propagation, as this constraint is not incremental: we pay
       // O(n log n) each time the constraint is awakened.
@@ -1699,6 +1701,7 @@ class CumulativeTimeTable : public Constraint {
     Demon* demon = MakeDelayedConstraintDemon0(
         solver(), this, &CumulativeTimeTable::InitialPropagate,
         "InitialPropagate");
+    demon->set_cost(Solver::EXPENSIVE_DEMON);
     for (Task* const task : by_start_min_) {
       task->WhenAnything(demon);
     }
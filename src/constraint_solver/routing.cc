@@ -15,6 +15,7 @@
 #include "constraint_solver/routing.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
 #include <cstring>
@@ -29,8 +30,11 @@
 #include "base/logging.h"
 #include "google/protobuf/text_format.h"
 #include "base/map_util.h"
+#include "base/mutex.h"
+#include "base/random.h"
 #include "base/stl_util.h"
 #include "base/thorough_hash.h"
+#include "base/threadpool.h"
 #include "base/hash.h"
 #include "constraint_solver/model.pb.h"
 #include "graph/linear_assignment.h"
@@ -61,9 +65,22 @@ DEFINE_int64(sweep_sectors, 1,
 // Cache settings.
 // TODO(user): Investigate if these settings could be moved to
 // RoutingSearchParameters or if we can get rid of them entirely.
-DEFINE_bool(routing_cache_callbacks, false, "Cache callback calls.");
+DEFINE_bool(routing_cache_callbacks, false,
+            "Cache callback calls. Cached callbacks are evaluated on all pairs "
+            "of nodes when they are added to the model.");
 DEFINE_int64(routing_max_cache_size, 1000,
-             "Maximum cache size when callback caching is on.");
+             "Maximum cache size when callback caching is on. See "
+             "routing_max_compressed_cache_size for larger caches.");
+DEFINE_int64(routing_max_compressed_cache_size, 20000,
+             "Maximum cache size when callback caching and compression are "
+             "on. Caches larger than routing_max_cache_size are only kept if "
+             "their values fit on 32 bits; a cache of 20000 nodes then takes "
+             "0.8 or 1.6 GB.");
+DEFINE_int32(routing_cache_num_threads, 1,
+             "Number of threads used to fill the callback caches. Callbacks "
+             "must be thread-safe if it is greater than 1.");
+DEFINE_bool(routing_compress_cache, true,
+            "Store cached callback values on 16 or 32 bits when they fit.");
 
 // Trace settings
 
@@ -689,6 +706,8 @@ void PairRelocateOperator::OnNodeInitialization() {
   }
 }
 
+}  // namespace
+
 LocalSearchOperator* MakePairRelocate(
     Solver* const solver, const std::vector<IntVar*>& vars,
     const std::vector<IntVar*>& secondary_vars,
@@ -698,6 +717,8 @@ LocalSearchOperator* MakePairRelocate(
       vars, secondary_vars, std::move(start_empty_path_class), pairs));
 }
 
+namespace {
+
 // Operator which inserts inactive nodes into a path and makes a pair of
 // active nodes inactive.
 class NodePairSwapActiveOperator : public PathWithPreviousNodesOperator {
@@ -885,50 +906,440 @@ LocalSearchOperator* PairNodeSwapActive(
            vars, secondary_vars, std::move(start_empty_path_class), pairs))});
 }
 
+// Ruin-and-recreate operator, based on the string removals of "Slack
+// Induction by String Removals for Vehicle Routing Problems" (Christiaens and
+// Vanden Berghe). A neighbor is built from a seed node: nodes are considered
+// by increasing arc cost from the seed, in the first cost class of vehicles
+// with costs, and for each node on a route which has not been ruined yet, a
+// string of consecutive nodes containing it is removed from the route;
+// inactive nodes met on the way are released too. The number of ruined routes
+// and the length of the strings are drawn randomly so that
+// average_removed_nodes nodes are removed on average, with at most
+// max_string_size nodes per string. Removed nodes (and their pickup and
+// delivery siblings) are then reinserted by the 'recreate' filtered heuristic,
+// from the current routes without the removed nodes; no constraint
+// propagation is involved and the resulting neighbor is a complete solution,
+// filtered like the neighbors of other operators. Each node serves in turn as
+// seed, in a random order drawn from the random generator of the solver.
+class RuinAndRecreateOperator : public IntVarLocalSearchOperator {
+ public:
+  RuinAndRecreateOperator(RoutingModel* model,
+                          const std::vector<IntVar*>& vehicle_vars,
+                          RoutingFilteredDecisionBuilder* recreate,
+                          int average_removed_nodes, int max_string_size);
+  ~RuinAndRecreateOperator() override {}
+  void OnStart() override;
+  std::string DebugString() const override { return "RuinAndRecreate"; }
+
+ protected:
+  bool MakeOneNeighbor() override;
+
+ private:
+  // Removes strings of nodes around seed from the current solution.
+  void Ruin(int64 seed);
+  // Removes the string of 'length' consecutive nodes containing 'node' from
+  // its route.
+  void RemoveString(int64 node, int length);
+  // Removes 'node' and its pickup and delivery sibling.
+  void Remove(int64 node);
+  // Reinserts the removed nodes; returns true if the resulting solution
+  // differs from the current solution.
+  bool Recreate();
+  // Returns the next of 'node' in the current solution without the removed
+  // nodes, or -1 if 'node' is removed.
+  int64 GetRuinedNext(int64 node) const;
+
+  RoutingModel* const model_;
+  RoutingFilteredDecisionBuilder* const recreate_;
+  const int num_nexts_;
+  const double average_removed_nodes_;
+  const int max_string_size_;
+  const int64 relatedness_cost_class_;
+  std::vector<int64> siblings_;
+  ACMRandom rand_;
+  // Routes of the current solution, without start and end nodes, and route
+  // (-1 if inactive) and position of each node on its route.
+  std::vector<std::vector<int64>> routes_;
+  std::vector<int> node_routes_;
+  std::vector<int> node_positions_;
+  double average_route_size_;
+  std::vector<int64> seeds_;
+  int seed_index_;
+  std::vector<bool> removed_;
+  std::vector<int64> removed_nodes_;
+  std::vector<bool> ruined_routes_;
+  std::vector<std::pair<int64, int64>> costed_nodes_;
+  std::vector<int> new_vehicles_;
+};
+
+RuinAndRecreateOperator::RuinAndRecreateOperator(
+    RoutingModel* model, const std::vector<IntVar*>& vehicle_vars,
+    RoutingFilteredDecisionBuilder* recreate, int average_removed_nodes,
+    int max_string_size)
+    : IntVarLocalSearchOperator(model->Nexts()),
+      model_(model),
+      recreate_(recreate),
+      num_nexts_(model->Size()),
+      average_removed_nodes_(std::max(1, average_removed_nodes)),
+      max_string_size_(std::max(1, max_string_size)),
+      // Cost class 0 is reserved for vehicles without costs.
+      relatedness_cost_class_(model->GetNonZeroCostClassesCount() > 0 ? 1 : 0),
+      siblings_(model->Size(), -1),
+      rand_(model->solver()->Rand32(kint32max)),
+      routes_(model->vehicles()),
+      node_routes_(model->Size(), -1),
+      node_positions_(model->Size(), -1),
+      average_route_size_(0),
+      seed_index_(0),
+      removed_(model->Size(), false),
+      ruined_routes_(model->vehicles(), false) {
+  AddVars(vehicle_vars);
+  for (const RoutingModel::NodePair& pair :
+       model->GetPickupAndDeliveryPairs()) {
+    siblings_[pair.first] = pair.second;
+    siblings_[pair.second] = pair.first;
+  }
+  for (int64 node = 0; node < num_nexts_; ++node) {
+    if (!model->IsStart(node)) {
+      seeds_.push_back(node);
+    }
+  }
+}
+
+void RuinAndRecreateOperator::OnStart() {
+  node_routes_.assign(num_nexts_, -1);
+  int num_active_nodes = 0;
+  int num_used_routes = 0;
+  for (int vehicle = 0; vehicle < model_->vehicles(); ++vehicle) {
+    std::vector<int64>& route = routes_[vehicle];
+    route.clear();
+    for (int64 node = OldValue(model_->Start(vehicle)); !model_->IsEnd(node);
+         node = OldValue(node)) {
+      node_routes_[node] = vehicle;
+      node_positions_[node] = route.size();
+      route.push_back(node);
+    }
+    if (!route.empty()) {
+      num_active_nodes += route.size();
+      ++num_used_routes;
+    }
+  }
+  average_route_size_ =
+      num_used_routes == 0
+          ? 0
+          : static_cast<double>(num_active_nodes) / num_used_routes;
+  for (int i = seeds_.size() - 1; i > 0; --i) {
+    std::swap(seeds_[i], seeds_[rand_.Uniform(i + 1)]);
+  }
+  seed_index_ = 0;
+}
+
+bool RuinAndRecreateOperator::MakeOneNeighbor() {
+  while (seed_index_ < seeds_.size()) {
+    Ruin(seeds_[seed_index_]);
+    ++seed_index_;
+    if (Recreate()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void RuinAndRecreateOperator::Ruin(int64 seed) {
+  for (const int64 node : removed_nodes_) {
+    removed_[node] = false;
+  }
+  removed_nodes_.clear();
+  ruined_routes_.assign(model_->vehicles(), false);
+  const double max_string_size =
+      std::min<double>(max_string_size_, average_route_size_);
+  const double max_ruined_routes =
+      4 * average_removed_nodes_ / (1 + max_string_size) - 1;
+  const int num_ruined_routes = 1 + static_cast<int>(rand_.UniformDouble(
+                                         std::max(1.0, max_ruined_routes)));
+  costed_nodes_.clear();
+  for (const int64 node : seeds_) {
+    costed_nodes_.push_back(
+        {node == seed ? kint64min
+                      : model_->GetArcCostForClass(seed, node,
+                                                   relatedness_cost_class_),
+         node});
+  }
+  // Only the closest nodes are usually needed to ruin num_ruined_routes
+  // routes: nodes are sorted by batches of doubling size.
+  const int min_batch_size = 4 * static_cast<int>(average_removed_nodes_);
+  int num_sorted_nodes = 0;
+  int ruined_routes = 0;
+  for (int i = 0;
+       i < costed_nodes_.size() && ruined_routes < num_ruined_routes; ++i) {
+    if (i == num_sorted_nodes) {
+      num_sorted_nodes =
+          std::min<int>(costed_nodes_.size(),
+                        i + std::max(i, min_batch_size));
+      std::partial_sort(costed_nodes_.begin() + i,
+                        costed_nodes_.begin() + num_sorted_nodes,
+                        costed_nodes_.end());
+    }
+    const int64 node = costed_nodes_[i].second;
+    if (removed_[node]) continue;
+    const int route = node_routes_[node];
+    if (route == -1) {
+      Remove(node);
+    } else if (!ruined_routes_[route]) {
+      ruined_routes_[route] = true;
+      ++ruined_routes;
+      const int max_length = std::min(routes_[route].size(),
+                                      static_cast<size_t>(max_string_size));
+      RemoveString(node, 1 + rand_.Uniform(max_length));
+    }
+  }
+}
+
+void RuinAndRecreateOperator::RemoveString(int64 node, int length) {
+  const std::vector<int64>& route = routes_[node_routes_[node]];
+  const int first = std::max(
+      0, std::min<int>(node_positions_[node] - rand_.Uniform(length),
+                       route.size() - length));
+  for (int position = first; position < first + length; ++position) {
+    Remove(route[position]);
+  }
+}
+
+void RuinAndRecreateOperator::Remove(int64 node) {
+  if (removed_[node]) return;
+  removed_[node] = true;
+  removed_nodes_.push_back(node);
+  if (siblings_[node] != -1) {
+    Remove(siblings_[node]);
+  }
+}
+
+int64 RuinAndRecreateOperator::GetRuinedNext(int64 node) const {
+  if (removed_[node]) return -1;
+  int64 next = OldValue(node);
+  if (next == node) return node;
+  while (next < num_nexts_ && removed_[next]) {
+    next = OldValue(next);
+  }
+  return next;
+}
+
+bool RuinAndRecreateOperator::Recreate() {
+  const Assignment* const solution = recreate_->BuildSolutionFromRoutes(
+      [this](int64 node) { return GetRuinedNext(node); });
+  if (solution == nullptr) return false;
+  const Assignment::IntContainer& container = solution->IntVarContainer();
+  if (Size() == num_nexts_) {
+    bool changed = false;
+    for (int64 node = 0; node < num_nexts_; ++node) {
+      const int64 next = container.Element(node).Value();
+      if (next != OldValue(node)) {
+        SetValue(node, next);
+        changed = true;
+      }
+    }
+    return changed;
+  }
+  // As with path operators, the vehicle variable of a node is part of the
+  // neighbor whenever its next variable is, and vice versa.
+  new_vehicles_.assign(num_nexts_, -1);
+  for (int vehicle = 0; vehicle < model_->vehicles(); ++vehicle) {
+    for (int64 node = model_->Start(vehicle); !model_->IsEnd(node);
+         node = container.Element(node).Value()) {
+      new_vehicles_[node] = vehicle;
+    }
+  }
+  bool changed = false;
+  for (int64 node = 0; node < num_nexts_; ++node) {
+    const int64 next = container.Element(node).Value();
+    if (next != OldValue(node) ||
+        new_vehicles_[node] != OldValue(num_nexts_ + node)) {
+      SetValue(node, next);
+      SetValue(num_nexts_ + node, new_vehicles_[node]);
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+}  // namespace
+
+LocalSearchOperator* MakeRuinAndRecreate(
+    RoutingModel* model, const std::vector<IntVar*>& vehicle_vars,
+    RoutingFilteredDecisionBuilder* recreate, int average_removed_nodes,
+    int max_string_size) {
+  return model->solver()->RevAlloc(
+      new RuinAndRecreateOperator(model, vehicle_vars, recreate,
+                                  average_removed_nodes, max_string_size));
+}
+
+namespace {
+
 // Cached callbacks
 
-class RoutingCache : public RoutingModel::NodeEvaluator2 {
+// Cache storing the values of a node evaluator as T.
+template <typename T>
+class RoutingMatrixCache : public RoutingCache {
  public:
-  // Creates a new cached callback based on 'callback'. The cache object does
-  // not take ownership of the callback; the user must ensure that the callback
-  // gets deleted when it or the cache is no longer used.
-  //
-  // When used in the RoutingModel class, the constructor should not be called
-  // directly, but through RoutingModel::NewCachedCallback that ensures that the
-  // base callback is deleted properly.
-  RoutingCache(RoutingModel::NodeEvaluator2* callback, int size)
-      : cached_(size), cache_(size), callback_(CHECK_NOTNULL(callback)) {
-    for (RoutingModel::NodeIndex i(0); i < RoutingModel::NodeIndex(size); ++i) {
-      cached_[i].resize(size, false);
-      cache_[i].resize(size, 0);
-    }
-    CHECK(callback->IsRepeatable());
+  RoutingMatrixCache(int size, uint64 fingerprint, std::vector<T> values)
+      : RoutingCache(size, fingerprint), values_(std::move(values)) {
+    DCHECK_EQ(static_cast<int64>(size) * size, values_.size());
   }
-  bool IsRepeatable() const override { return true; }
+  ~RoutingMatrixCache() override {}
+
   int64 Run(RoutingModel::NodeIndex i, RoutingModel::NodeIndex j) override {
-    // This method does lazy caching of results of callbacks: first
-    // checks if it has been run with these parameters before, and
-    // returns previous result if so, or runs underlaying callback and
-    // stores its result.
-    // Not MT-safe.
-    if (cached_[i][j]) {
-      return cache_[i][j];
-    } else {
-      const int64 cached_value = callback_->Run(i, j);
-      cached_[i][j] = true;
-      cache_[i][j] = cached_value;
-      return cached_value;
+    return values_[static_cast<size_t>(i.value()) * size_ + j.value()];
+  }
+
+  bool HasSameValues(const RoutingCache& other) const override {
+    const RoutingMatrixCache<T>* const other_matrix =
+        dynamic_cast<const RoutingMatrixCache<T>*>(&other);
+    return other_matrix != nullptr && values_ == other_matrix->values_;
+  }
+
+ private:
+  const std::vector<T> values_;
+};
+
+// Evaluates a node evaluator on all pairs of nodes and stores the values as T
+// in a row-major matrix. Several threads can call Run() at the same time; each
+// call evaluates rows until all of them have been filled.
+template <typename T>
+class RoutingMatrixFiller {
+ public:
+  RoutingMatrixFiller(RoutingModel::NodeEvaluator2* callback, int size)
+      : callback_(callback),
+        size_(size),
+        values_(static_cast<size_t>(size) * size),
+        row_fingerprints_(size, 0),
+        row_mins_(size, kint64max),
+        row_maxs_(size, kint64min),
+        next_row_(0) {}
+
+  void Run() {
+    std::vector<int64> row_values(size_);
+    for (int row = next_row_++; row < size_; row = next_row_++) {
+      const RoutingModel::NodeIndex from(row);
+      T* const values = &values_[static_cast<size_t>(row) * size_];
+      int64 row_min = kint64max;
+      int64 row_max = kint64min;
+      for (int col = 0; col < size_; ++col) {
+        const int64 value = callback_->Run(from, RoutingModel::NodeIndex(col));
+        row_values[col] = value;
+        values[col] = static_cast<T>(value);
+        row_min = std::min(row_min, value);
+        row_max = std::max(row_max, value);
+      }
+      row_fingerprints_[row] =
+          ThoroughHash(reinterpret_cast<const char*>(row_values.data()),
+                       size_ * sizeof(row_values[0]));
+      row_mins_[row] = row_min;
+      row_maxs_[row] = row_max;
     }
   }
 
+  // Evaluates the callback with the given number of threads.
+  void Fill(int num_threads) {
+    num_threads = std::min(num_threads, size_);
+    if (num_threads <= 1) {
+      Run();
+      return;
+    }
+    // The destructor of the pool waits for all the threads to finish.
+    ThreadPool pool("RoutingCache", num_threads);
+    pool.StartWorkers();
+    for (int i = 0; i < num_threads; ++i) {
+      pool.Add(NewCallback(this, &RoutingMatrixFiller<T>::Run));
+    }
+  }
+
+  // The following must be called after Fill().
+  int64 Min() const {
+    return size_ == 0 ? 0 : *std::min_element(row_mins_.begin(),
+                                              row_mins_.end());
+  }
+  int64 Max() const {
+    return size_ == 0 ? 0 : *std::max_element(row_maxs_.begin(),
+                                              row_maxs_.end());
+  }
+  uint64 Fingerprint() const {
+    uint64 fingerprint = 0;
+    for (const uint64 row_fingerprint : row_fingerprints_) {
+      // MixTwoUInt64 never returns 0.
+      fingerprint = fingerprint != 0
+                        ? MixTwoUInt64(fingerprint, row_fingerprint)
+                        : row_fingerprint;
+    }
+    return fingerprint;
+  }
+  std::vector<T>* mutable_values() { return &values_; }
+
  private:
-  ITIVector<RoutingModel::NodeIndex, ITIVector<RoutingModel::NodeIndex, bool>>
-      cached_;
-  ITIVector<RoutingModel::NodeIndex, ITIVector<RoutingModel::NodeIndex, int64>>
-      cache_;
   RoutingModel::NodeEvaluator2* const callback_;
+  const int size_;
+  std::vector<T> values_;
+  // Only the entries of a row are written by the thread filling it.
+  std::vector<uint64> row_fingerprints_;
+  std::vector<int64> row_mins_;
+  std::vector<int64> row_maxs_;
+  std::atomic<int> next_row_;
+
+  DISALLOW_COPY_AND_ASSIGN(RoutingMatrixFiller);
 };
 
+}  // namespace
+
+RoutingCache* RoutingCache::Build(RoutingModel::NodeEvaluator2* callback,
+                                  int size, int num_threads, bool compress) {
+  CHECK(callback != nullptr);
+  CHECK(callback->IsRepeatable());
+  if (compress) {
+    // Most evaluators return small values: the matrix is first filled on 32
+    // bits, and only filled again on 64 bits if some value does not fit.
+    RoutingCache* const cache = BuildCompressed(callback, size, num_threads);
+    if (cache != nullptr) return cache;
+  }
+  RoutingMatrixFiller<int64> filler(callback, size);
+  filler.Fill(num_threads);
+  return new RoutingMatrixCache<int64>(size, filler.Fingerprint(),
+                                       std::move(*filler.mutable_values()));
+}
+
+RoutingCache* RoutingCache::BuildCompressed(
+    RoutingModel::NodeEvaluator2* callback, int size, int num_threads) {
+  CHECK(callback != nullptr);
+  CHECK(callback->IsRepeatable());
+  RoutingMatrixFiller<int32> filler(callback, size);
+  filler.Fill(num_threads);
+  const int64 min_value = filler.Min();
+  const int64 max_value = filler.Max();
+  if (min_value >= 0 && max_value <= kuint16max) {
+    const std::vector<int32>& values = *filler.mutable_values();
+    return new RoutingMatrixCache<uint16>(
+        size, filler.Fingerprint(),
+        std::vector<uint16>(values.begin(), values.end()));
+  }
+  if (min_value >= kint32min && max_value <= kint32max) {
+    return new RoutingMatrixCache<int32>(size, filler.Fingerprint(),
+                                         std::move(*filler.mutable_values()));
+  }
+  return nullptr;
+}
+
+RoutingCache* RoutingCache::FindOrAddSharedCache(
+    RoutingCache* cache,
+    hash_map<uint64, RoutingModel::NodeEvaluator2*>* caches) {
+  RoutingCache* const shared_cache = static_cast<RoutingCache*>(
+      LookupOrInsert(caches, cache->fingerprint(), cache));
+  if (shared_cache != cache && shared_cache->HasSameValues(*cache)) {
+    delete cache;
+    return shared_cache;
+  }
+  return cache;
+}
+
+namespace {
+
 class StateDependentRoutingCache : public RoutingModel::VariableNodeEvaluator2 {
  public:
   // Creates a new cached callback based on 'callback'. The cache object does
@@ -1036,6 +1447,8 @@ ConstraintSolverParameters::TrailCompression GetTrailCompression(
       return ConstraintSolverParameters::NO_COMPRESSION;
     case RoutingModelParameters::ZLIB:
       return ConstraintSolverParameters::COMPRESS_WITH_ZLIB;
+    case RoutingModelParameters::DELTA_ENCODING:
+      return ConstraintSolverParameters::COMPRESS_WITH_DELTA_ENCODING;
     default:
             return ConstraintSolverParameters::NO_COMPRESSION;
   }
@@ -1085,7 +1498,8 @@ RoutingModel::RoutingModel(int nodes, int vehicles,
       preassignment_(nullptr),
       limit_(nullptr),
       ls_limit_(nullptr),
-      lns_limit_(nullptr) {
+      lns_limit_(nullptr),
+      solution_pool_(nullptr) {
   VLOG(1) << "Model parameters:\n" << parameters.DebugString();
   ConstraintSolverParameters solver_parameters =
       parameters.has_solver_parameters() ? parameters.solver_parameters()
@@ -1128,7 +1542,8 @@ RoutingModel::RoutingModel(int nodes, int vehicles,
       preassignment_(nullptr),
       limit_(nullptr),
       ls_limit_(nullptr),
-      lns_limit_(nullptr) {
+      lns_limit_(nullptr),
+      solution_pool_(nullptr) {
   VLOG(1) << "Model parameters:\n" << parameters.DebugString();
   ConstraintSolverParameters solver_parameters =
       parameters.has_solver_parameters() ? parameters.solver_parameters()
@@ -1181,7 +1596,8 @@ RoutingModel::RoutingModel(int nodes, int vehicles,
       preassignment_(nullptr),
       limit_(nullptr),
       ls_limit_(nullptr),
-      lns_limit_(nullptr) {
+      lns_limit_(nullptr),
+      solution_pool_(nullptr) {
   VLOG(1) << "Model parameters:\n" << parameters.DebugString();
   ConstraintSolverParameters solver_parameters =
       parameters.has_solver_parameters() ? parameters.solver_parameters()
@@ -1280,6 +1696,7 @@ RoutingSearchParameters RoutingModel::DefaultSearchParameters() {
       "  use_full_path_lns: false"
       "  use_tsp_lns: false"
       "  use_inactive_lns: false"
+      "  use_ruin_and_recreate: false"
       "}"
       "local_search_metaheuristic: AUTOMATIC "
       "guided_local_search_lambda_coefficient: 0.1 "
@@ -1289,7 +1706,10 @@ RoutingSearchParameters RoutingModel::DefaultSearchParameters() {
       "time_limit_ms: 0x7FFFFFFFFFFFFFFF "   // kint64max
       "lns_time_limit_ms: 100 "
       "use_light_propagation: true "
-      "fingerprint_arc_cost_evaluators: true ";
+      "fingerprint_arc_cost_evaluators: true "
+      "local_search_nearest_neighbors: 0 "
+      "ruin_average_removed_nodes: 10 "
+      "ruin_max_string_size: 10 ";
   RoutingSearchParameters parameters;
   if (!google::protobuf::TextFormat::ParseFromString(kSearchParameters, &parameters)) {
     LOG(ERROR) << "Unsupported default search parameters: "
@@ -3374,6 +3794,254 @@ const Assignment* RoutingModel::SolveFromAssignmentWithParameters(
   }
 }
 
+// ----- Parallel solve -----
+
+namespace {
+// Best solution found by the workers of a parallel solve. Solutions are
+// stored as the values of the local search variables of the workers, which
+// are the same, in the same order, in all workers.
+class SharedRoutingSolution : public BaseObject {
+ public:
+  SharedRoutingSolution() : cost_(kint64max), version_(0), worker_(-1) {}
+  ~SharedRoutingSolution() override {}
+
+  // Stores the values of vars if cost is better than the shared cost. Called
+  // concurrently by all workers.
+  void Publish(int worker, int64 cost, const std::vector<IntVar*>& vars) {
+    if (cost >= cost_.load()) {
+      return;
+    }
+    MutexLock lock(&mutex_);
+    if (cost >= cost_.load()) {
+      return;
+    }
+    values_.resize(vars.size());
+    for (int i = 0; i < vars.size(); ++i) {
+      values_[i] = vars[i]->Value();
+    }
+    worker_.store(worker);
+    cost_.store(cost);
+    ++version_;
+  }
+  // Copies the shared solution to the integer variables of assignment.
+  void Read(Assignment* const assignment) {
+    MutexLock lock(&mutex_);
+    Assignment::IntContainer* const container =
+        assignment->MutableIntVarContainer();
+    CHECK_EQ(values_.size(), container->Size());
+    for (int i = 0; i < values_.size(); ++i) {
+      container->MutableElement(i)->SetValue(values_[i]);
+    }
+  }
+  int64 cost() const { return cost_.load(); }
+  int64 version() const { return version_.load(); }
+  // Worker which published the shared solution, -1 if there is none.
+  int worker() const { return worker_.load(); }
+  std::string DebugString() const override { return "SharedRoutingSolution"; }
+
+ private:
+  Mutex mutex_;
+  std::vector<int64> values_;
+  std::atomic<int64> cost_;
+  std::atomic<int64> version_;
+  std::atomic<int> worker_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedRoutingSolution);
+};
+
+// Publishes the improving solutions of a worker to the shared solution.
+class SharedSolutionPublisher : public SearchMonitor {
+ public:
+  SharedSolutionPublisher(Solver* const solver, int worker, IntVar* const cost,
+                          const std::vector<IntVar*>& vars,
+                          SharedRoutingSolution* const shared_solution)
+      : SearchMonitor(solver),
+        worker_(worker),
+        cost_(cost),
+        vars_(vars),
+        shared_solution_(shared_solution),
+        best_cost_(kint64max) {}
+  ~SharedSolutionPublisher() override {}
+  void EnterSearch() override { best_cost_ = kint64max; }
+  bool AtSolution() override {
+    const int64 cost = cost_->Min();
+    if (cost < best_cost_) {
+      best_cost_ = cost;
+      shared_solution_->Publish(worker_, cost, vars_);
+    }
+    return false;
+  }
+  // Cost of the best solution found by the worker in the current search.
+  int64 best_cost() const { return best_cost_; }
+  std::string DebugString() const override {
+    return "SharedSolutionPublisher";
+  }
+
+ private:
+  const int worker_;
+  IntVar* const cost_;
+  const std::vector<IntVar*> vars_;
+  SharedRoutingSolution* const shared_solution_;
+  int64 best_cost_;
+};
+
+// Solution pool of a worker; behaves like the default solution pool, except
+// that the local search is restarted from the shared solution when another
+// worker has published a solution better than the best one of this worker.
+class SharedRoutingSolutionPool : public SolutionPool {
+ public:
+  SharedRoutingSolutionPool(int worker,
+                            SharedRoutingSolution* const shared_solution)
+      : worker_(worker),
+        shared_solution_(shared_solution),
+        publisher_(nullptr),
+        last_version_(0),
+        import_pending_(false) {}
+  ~SharedRoutingSolutionPool() override {}
+
+  // The publisher of the worker, which tracks its best solution; must be set
+  // before the search starts.
+  void set_publisher(const SharedSolutionPublisher* const publisher) {
+    publisher_ = publisher;
+  }
+  void Initialize(Assignment* const assignment) override {
+    reference_assignment_.reset(new Assignment(assignment));
+  }
+  void RegisterNewSolution(Assignment* const assignment) override {
+    reference_assignment_->Copy(assignment);
+  }
+  void GetNextSolution(Assignment* const assignment) override {
+    if (import_pending_) {
+      shared_solution_->Read(reference_assignment_.get());
+      import_pending_ = false;
+    }
+    assignment->Copy(reference_assignment_.get());
+  }
+  bool SyncNeeded(Assignment* const local_assignment) override {
+    const int64 version = shared_solution_->version();
+    if (version == last_version_) {
+      return false;
+    }
+    last_version_ = version;
+    import_pending_ = shared_solution_->worker() != worker_ &&
+                      shared_solution_->cost() < publisher_->best_cost();
+    return import_pending_;
+  }
+  std::string DebugString() const override {
+    return "SharedRoutingSolutionPool";
+  }
+
+ private:
+  const int worker_;
+  SharedRoutingSolution* const shared_solution_;
+  const SharedSolutionPublisher* publisher_;
+  std::unique_ptr<Assignment> reference_assignment_;
+  int64 last_version_;
+  bool import_pending_;
+};
+
+// Diversifies the search parameters of the workers other than the first one,
+// which keeps the parameters of the caller.
+RoutingSearchParameters WorkerSearchParameters(
+    const RoutingSearchParameters& search_parameters, int worker) {
+  RoutingSearchParameters worker_parameters = search_parameters;
+  if (worker == 0) {
+    return worker_parameters;
+  }
+  static const LocalSearchMetaheuristic::Value kMetaheuristics[] = {
+      LocalSearchMetaheuristic::GUIDED_LOCAL_SEARCH,
+      LocalSearchMetaheuristic::TABU_SEARCH,
+      LocalSearchMetaheuristic::SIMULATED_ANNEALING};
+  worker_parameters.set_local_search_metaheuristic(
+      kMetaheuristics[(worker - 1) % arraysize(kMetaheuristics)]);
+  if (worker % 2 == 1) {
+    worker_parameters.mutable_local_search_operators()->set_use_full_path_lns(
+        true);
+  }
+  worker_parameters.set_log_search(false);
+  return worker_parameters;
+}
+
+void RunRoutingWorker(RoutingModel* model,
+                      const RoutingSearchParameters* search_parameters) {
+  model->SolveWithParameters(*search_parameters);
+}
+}  // namespace
+
+const Assignment* RoutingModel::SolveInParallelWithParameters(
+    int num_workers, const WorkerModelBuilder& model_builder,
+    const RoutingSearchParameters& search_parameters) {
+  if (closed_) {
+    LOG(ERROR) << "The model must not be closed before a parallel solve.";
+    return nullptr;
+  }
+  CHECK_GE(num_workers, 1);
+  // The shared solution is owned by the solver of the current model, the
+  // publisher of which outlives the parallel search.
+  SharedRoutingSolution* const shared_solution =
+      solver_->RevAlloc(new SharedRoutingSolution());
+  std::vector<std::unique_ptr<RoutingModel>> worker_models(num_workers);
+  std::vector<RoutingModel*> models(num_workers, this);
+  for (int worker = 1; worker < num_workers; ++worker) {
+    worker_models[worker] = model_builder(worker);
+    models[worker] = worker_models[worker].get();
+    CHECK(models[worker] != nullptr);
+    // The models are closed below, with the parameters of their worker.
+    if (models[worker]->closed_) {
+      LOG(ERROR) << "The model of worker " << worker
+                 << " must not be closed.";
+      return nullptr;
+    }
+    CHECK_EQ(Size(), models[worker]->Size());
+    CHECK_EQ(vehicles(), models[worker]->vehicles());
+  }
+  std::vector<RoutingSearchParameters> worker_parameters(num_workers);
+  for (int worker = 0; worker < num_workers; ++worker) {
+    RoutingModel* const model = models[worker];
+    Solver* const solver = model->solver();
+    worker_parameters[worker] =
+        WorkerSearchParameters(search_parameters, worker);
+    SharedRoutingSolutionPool* const solution_pool = solver->RevAlloc(
+        new SharedRoutingSolutionPool(worker, shared_solution));
+    model->solution_pool_ = solution_pool;
+    // Worker 0 keeps the seed of the current solver.
+    if (worker > 0) {
+      solver->ReSeed(worker);
+    }
+    model->CloseModelWithParameters(worker_parameters[worker]);
+    // The cost and the local search variables only exist once the model is
+    // closed.
+    std::vector<IntVar*> vars = model->nexts_;
+    if (!model->CostsAreHomogeneousAcrossVehicles()) {
+      vars.insert(vars.end(), model->vehicle_vars_.begin(),
+                  model->vehicle_vars_.end());
+    }
+    SharedSolutionPublisher* const publisher =
+        solver->RevAlloc(new SharedSolutionPublisher(
+            solver, worker, model->CostVar(), vars, shared_solution));
+    solution_pool->set_publisher(publisher);
+    model->AddSearchMonitor(publisher);
+  }
+  {
+    ThreadPool pool("RoutingWorkers", num_workers);
+    pool.StartWorkers();
+    for (int worker = 0; worker < num_workers; ++worker) {
+      pool.Add(NewCallback(&RunRoutingWorker, models[worker],
+                           &worker_parameters[worker]));
+    }
+  }
+  const int best_worker = shared_solution->worker();
+  if (best_worker == -1) {
+    return nullptr;
+  }
+  if (best_worker == 0) {
+    return collect_assignments_->solution(0);
+  }
+  // Replays the best solution of another worker in the current model.
+  shared_solution->Read(assignment_);
+  return DoRestoreAssignment();
+}
+
 // Computing a lower bound to the cost of a vehicle routing problem solving a
 // a linear assignment problem (minimum-cost perfect bipartite matching).
 // A bipartite graph is created with left nodes representing the nodes of the
@@ -4214,13 +4882,111 @@ SearchLimit* RoutingModel::GetOrCreateLargeNeighborhoodSearchLimit() {
   return lns_limit_;
 }
 
+namespace {
+// Nearest neighbors of the nodes of a routing model, used to make path
+// neighborhoods granular. For each cost class, the num_neighbors cheapest
+// successors of each node are its neighbors; the relation is then made
+// symmetric so that it does not depend on the order of the base nodes of
+// operators. Vehicle starts are never neighbors: path operators always
+// consider moves to the extremities of routes.
+class RoutingNearestNeighbors : public BaseObject {
+ public:
+  RoutingNearestNeighbors(RoutingModel* const model, int num_neighbors)
+      : neighbors_(model->Size()) {
+    const int size = model->Size();
+    std::vector<bool> is_start(size, false);
+    for (int vehicle = 0; vehicle < model->vehicles(); ++vehicle) {
+      is_start[model->Start(vehicle)] = true;
+    }
+    std::vector<std::pair<int64, int>> costed_successors;
+    // The cost class of index 0 is reserved for vehicles with zero cost.
+    for (int cost_class = 1; cost_class < model->GetCostClassesCount();
+         ++cost_class) {
+      for (int node = 0; node < size; ++node) {
+        costed_successors.clear();
+        const IntVar* const next = model->NextVar(node);
+        for (int successor = 0; successor < size; ++successor) {
+          if (successor != node && !is_start[successor] &&
+              next->Contains(successor)) {
+            costed_successors.push_back(
+                {model->GetArcCostForClass(node, successor, cost_class),
+                 successor});
+          }
+        }
+        if (costed_successors.size() > num_neighbors) {
+          std::nth_element(costed_successors.begin(),
+                           costed_successors.begin() + num_neighbors,
+                           costed_successors.end());
+          costed_successors.resize(num_neighbors);
+        }
+        for (const std::pair<int64, int>& costed_successor :
+             costed_successors) {
+          neighbors_[node].push_back(costed_successor.second);
+          if (!is_start[node]) {
+            neighbors_[costed_successor.second].push_back(node);
+          }
+        }
+      }
+    }
+    for (std::vector<int>& neighbors : neighbors_) {
+      std::sort(neighbors.begin(), neighbors.end());
+      neighbors.erase(std::unique(neighbors.begin(), neighbors.end()),
+                      neighbors.end());
+      neighbors.shrink_to_fit();
+    }
+  }
+  ~RoutingNearestNeighbors() override {}
+
+  const std::vector<int>& Neighbors(int64 node) const {
+    return neighbors_[node];
+  }
+  std::string DebugString() const override {
+    return "RoutingNearestNeighbors";
+  }
+
+ private:
+  std::vector<std::vector<int>> neighbors_;
+
+  DISALLOW_COPY_AND_ASSIGN(RoutingNearestNeighbors);
+};
+}  // namespace
+
+LocalSearchOperator* RoutingModel::RestrictToNearestNeighbors(
+    LocalSearchOperator* path_operator) {
+  neighbor_restricted_operators_.push_back(
+      static_cast<PathOperator*>(path_operator));
+  return path_operator;
+}
+
+void RoutingModel::SetNearestNeighbors(
+    const RoutingSearchParameters& search_parameters) {
+  const int num_neighbors = search_parameters.local_search_nearest_neighbors();
+  std::function<const std::vector<int>&(int64)> get_neighbors = nullptr;
+  if (num_neighbors > 0 && GetNonZeroCostClassesCount() > 0) {
+    std::function<const std::vector<int>&(int64)>& get_nearest_neighbors =
+        get_nearest_neighbors_[num_neighbors];
+    if (get_nearest_neighbors == nullptr) {
+      const RoutingNearestNeighbors* const nearest_neighbors =
+          solver_->RevAlloc(new RoutingNearestNeighbors(this, num_neighbors));
+      get_nearest_neighbors =
+          [nearest_neighbors](int64 node) -> const std::vector<int>& {
+        return nearest_neighbors->Neighbors(node);
+      };
+    }
+    get_neighbors = get_nearest_neighbors;
+  }
+  for (PathOperator* const path_operator : neighbor_restricted_operators_) {
+    path_operator->SetNeighbors(get_neighbors);
+  }
+}
+
 LocalSearchOperator* RoutingModel::CreateInsertionOperator() {
   std::vector<IntVar*> empty;
   LocalSearchOperator* insertion_operator =
-      MakeLocalSearchOperator<MakeActiveOperator>(
+      RestrictToNearestNeighbors(MakeLocalSearchOperator<MakeActiveOperator>(
           solver_.get(), nexts_,
           CostsAreHomogeneousAcrossVehicles() ? empty : vehicle_vars_,
-          vehicle_start_class_callback_);
+          vehicle_start_class_callback_));
   if (!pickup_delivery_pairs_.empty()) {
     insertion_operator = solver_->ConcatenateOperators(
         {MakePairActive(
@@ -4232,6 +4998,28 @@ LocalSearchOperator* RoutingModel::CreateInsertionOperator() {
   return insertion_operator;
 }
 
+LocalSearchOperator* RoutingModel::GetOrCreateRuinAndRecreateOperator(
+    const RoutingSearchParameters& search_parameters) {
+  if (local_search_operators_[RUIN_AND_RECREATE] != nullptr) {
+    return local_search_operators_[RUIN_AND_RECREATE];
+  }
+  // The insertion heuristic has its own filters: the local search filters
+  // must remain synchronized with the current solution while neighbors are
+  // built.
+  RoutingFilteredDecisionBuilder* const recreate =
+      solver_->RevAlloc(new GlobalCheapestInsertionFilteredDecisionBuilder(
+          this, NewPermanentCallback(this, &RoutingModel::GetArcCostForVehicle),
+          NewPermanentCallback(this, &RoutingModel::UnperformedPenaltyOrValue,
+                               0),
+          CreateFeasibilityFilters()));
+  local_search_operators_[RUIN_AND_RECREATE] = MakeRuinAndRecreate(
+      this, CostsAreHomogeneousAcrossVehicles() ? std::vector<IntVar*>()
+                                                : vehicle_vars_,
+      recreate, search_parameters.ruin_average_removed_nodes(),
+      search_parameters.ruin_max_string_size());
+  return local_search_operators_[RUIN_AND_RECREATE];
+}
+
 LocalSearchOperator* RoutingModel::CreateMakeInactiveOperator() {
   std::vector<IntVar*> empty;
   LocalSearchOperator* make_inactive_operator =
@@ -4286,11 +5074,13 @@ void RoutingModel::CreateNeighborhoodOperators() {
   local_search_operators_.clear();
   local_search_operators_.resize(LOCAL_SEARCH_OPERATOR_COUNTER, nullptr);
   CP_ROUTING_ADD_OPERATOR2(RELOCATE, Relocate);
+  RestrictToNearestNeighbors(local_search_operators_[RELOCATE]);
   std::vector<IntVar*> empty;
-  local_search_operators_[RELOCATE_PAIR] = MakePairRelocate(
-      solver_.get(), nexts_,
-      CostsAreHomogeneousAcrossVehicles() ? empty : vehicle_vars_,
-      vehicle_start_class_callback_, pickup_delivery_pairs_);
+  local_search_operators_[RELOCATE_PAIR] =
+      RestrictToNearestNeighbors(MakePairRelocate(
+          solver_.get(), nexts_,
+          CostsAreHomogeneousAcrossVehicles() ? empty : vehicle_vars_,
+          vehicle_start_class_callback_, pickup_delivery_pairs_));
   local_search_operators_[RELOCATE_NEIGHBORS] = MakeRelocateNeighbors(
       solver_.get(), nexts_,
       CostsAreHomogeneousAcrossVehicles() ? empty : vehicle_vars_,
@@ -4306,8 +5096,11 @@ void RoutingModel::CreateNeighborhoodOperators() {
            CostsAreHomogeneousAcrossVehicles() ? empty : vehicle_vars_,
            vehicle_start_class_callback_, pickup_delivery_pairs_)});
   CP_ROUTING_ADD_OPERATOR2(EXCHANGE, Exchange);
+  RestrictToNearestNeighbors(local_search_operators_[EXCHANGE]);
   CP_ROUTING_ADD_OPERATOR2(CROSS, Cross);
+  RestrictToNearestNeighbors(local_search_operators_[CROSS]);
   CP_ROUTING_ADD_OPERATOR2(TWO_OPT, TwoOpt);
+  RestrictToNearestNeighbors(local_search_operators_[TWO_OPT]);
   CP_ROUTING_ADD_OPERATOR(OR_OPT, OROPT);
   CP_ROUTING_ADD_CALLBACK_OPERATOR(LIN_KERNIGHAN, LK);
   local_search_operators_[MAKE_ACTIVE] = CreateInsertionOperator();
@@ -4332,7 +5125,10 @@ void RoutingModel::CreateNeighborhoodOperators() {
   }
 
 LocalSearchOperator* RoutingModel::GetNeighborhoodOperators(
-    const RoutingSearchParameters& search_parameters) const {
+    const RoutingSearchParameters& search_parameters) {
+  // The operators are created once and shared by all the searches set up by
+  // the model, each of which sets its own neighbor restriction.
+  SetNearestNeighbors(search_parameters);
   std::vector<LocalSearchOperator*> operators = extra_operators_;
   if (pickup_delivery_pairs_.size() > 0) {
     CP_ROUTING_PUSH_OPERATOR(RELOCATE_PAIR, relocate_pair, operators);
@@ -4382,6 +5178,11 @@ LocalSearchOperator* RoutingModel::GetNeighborhoodOperators(
   if (disjunctions_.size() != 0) {
     CP_ROUTING_PUSH_OPERATOR(INACTIVE_LNS, inactive_lns, operators);
   }
+  // The ruin-and-recreate operator and its insertion heuristic are only built
+  // when used.
+  if (search_parameters.local_search_operators().use_ruin_and_recreate()) {
+    operators.push_back(GetOrCreateRuinAndRecreateOperator(search_parameters));
+  }
   return solver_->ConcatenateOperators(operators);
 }
 
@@ -4476,25 +5277,29 @@ RoutingModel::GetOrCreateLocalSearchFilters() {
 const std::vector<LocalSearchFilter*>&
 RoutingModel::GetOrCreateFeasibilityFilters() {
   if (feasibility_filters_.empty()) {
-    for (const RoutingDimension* const dimension : dimensions_) {
-      feasibility_filters_.push_back(
-          MakePathCumulFilter(*this, *dimension, nullptr));
-    }
-    if (!disjunctions_.empty()) {
-      feasibility_filters_.push_back(MakeNodeDisjunctionFilter(*this, nullptr));
-    }
-    feasibility_filters_.push_back(solver_->MakeVariableDomainFilter());
-    if (pickup_delivery_pairs_.size() > 0) {
-      feasibility_filters_.push_back(
-          MakeNodePrecedenceFilter(*this, pickup_delivery_pairs_));
-    }
-    feasibility_filters_.push_back(MakeVehicleVarFilter(*this));
+    feasibility_filters_ = CreateFeasibilityFilters();
     feasibility_filters_.insert(feasibility_filters_.end(),
                                 extra_filters_.begin(), extra_filters_.end());
   }
   return feasibility_filters_;
 }
 
+std::vector<LocalSearchFilter*> RoutingModel::CreateFeasibilityFilters() {
+  std::vector<LocalSearchFilter*> filters;
+  for (const RoutingDimension* const dimension : dimensions_) {
+    filters.push_back(MakePathCumulFilter(*this, *dimension, nullptr));
+  }
+  if (!disjunctions_.empty()) {
+    filters.push_back(MakeNodeDisjunctionFilter(*this, nullptr));
+  }
+  filters.push_back(solver_->MakeVariableDomainFilter());
+  if (pickup_delivery_pairs_.size() > 0) {
+    filters.push_back(MakeNodePrecedenceFilter(*this, pickup_delivery_pairs_));
+  }
+  filters.push_back(MakeVehicleVarFilter(*this));
+  return filters;
+}
+
 DecisionBuilder* RoutingModel::CreateSolutionFinalizer() {
   std::vector<DecisionBuilder*> decision_builders;
   decision_builders.push_back(solver_->MakePhase(
@@ -4707,11 +5512,19 @@ RoutingModel::GetFilteredFirstSolutionDecisionBuilderOrNull(
 
 LocalSearchPhaseParameters* RoutingModel::CreateLocalSearchParameters(
     const RoutingSearchParameters& search_parameters) {
-  return solver_->MakeLocalSearchPhaseParameters(
-      GetNeighborhoodOperators(search_parameters),
+  LocalSearchOperator* const ls_operator =
+      GetNeighborhoodOperators(search_parameters);
+  DecisionBuilder* const sub_decision_builder =
       solver_->MakeSolveOnce(CreateSolutionFinalizer(),
-                             GetOrCreateLargeNeighborhoodSearchLimit()),
-      GetOrCreateLocalSearchLimit(), GetOrCreateLocalSearchFilters());
+                             GetOrCreateLargeNeighborhoodSearchLimit());
+  if (solution_pool_ != nullptr) {
+    return solver_->MakeLocalSearchPhaseParameters(
+        solution_pool_, ls_operator, sub_decision_builder,
+        GetOrCreateLocalSearchLimit(), GetOrCreateLocalSearchFilters());
+  }
+  return solver_->MakeLocalSearchPhaseParameters(
+      ls_operator, sub_decision_builder, GetOrCreateLocalSearchLimit(),
+      GetOrCreateLocalSearchFilters());
 }
 
 DecisionBuilder* RoutingModel::CreateLocalSearchDecisionBuilder(
@@ -4868,15 +5681,33 @@ void RoutingModel::AddIntervalToAssignment(IntervalVar* const interval) {
 RoutingModel::NodeEvaluator2* RoutingModel::NewCachedCallback(
     NodeEvaluator2* callback) {
   const int size = node_to_index_.size();
-  if (FLAGS_routing_cache_callbacks && size <= FLAGS_routing_max_cache_size) {
+  const bool compressed_only = size > FLAGS_routing_max_cache_size;
+  if (FLAGS_routing_cache_callbacks &&
+      (!compressed_only || (FLAGS_routing_compress_cache &&
+                            size <= FLAGS_routing_max_compressed_cache_size))) {
     NodeEvaluator2* cached_evaluator = nullptr;
     if (!FindCopy(cached_node_callbacks_, callback, &cached_evaluator)) {
-      cached_evaluator = new RoutingCache(callback, size);
+      RoutingCache* const cache =
+          compressed_only
+              ? RoutingCache::BuildCompressed(callback, size,
+                                              FLAGS_routing_cache_num_threads)
+              : RoutingCache::Build(callback, size,
+                                    FLAGS_routing_cache_num_threads,
+                                    FLAGS_routing_compress_cache);
+      // A large cache whose values need 64 bits is not kept: the callback is
+      // then used directly, and not evaluated again if added again.
+      cached_evaluator = callback;
+      if (cache != nullptr) {
+        // Callbacks returning the same values, typically an arc cost evaluator
+        // and the transit evaluator of a distance dimension, share one cache.
+        cached_evaluator =
+            RoutingCache::FindOrAddSharedCache(cache, &node_callback_caches_);
+        owned_node_callbacks_.insert(cached_evaluator);
+      }
       cached_node_callbacks_[callback] = cached_evaluator;
       // Make sure that both the cache and the base callback get deleted
       // properly.
       owned_node_callbacks_.insert(callback);
-      owned_node_callbacks_.insert(cached_evaluator);
     }
     return cached_evaluator;
   } else {
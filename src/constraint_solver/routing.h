@@ -679,6 +679,29 @@ class RoutingModel {
   const Assignment* SolveFromAssignmentWithParameters(
       const Assignment* assignment,
       const RoutingSearchParameters& search_parameters);
+#ifndef SWIG
+  // Builds the model solved by a parallel worker; see
+  // SolveInParallelWithParameters().
+  typedef std::function<std::unique_ptr<RoutingModel>(int worker)>
+      WorkerModelBuilder;
+  // Solves the current routing model with num_workers local searches running
+  // in parallel, each one in its own solver and with its own metaheuristic,
+  // seed and neighborhoods; workers publish their improving solutions and
+  // restart their local search from the best solution of the other workers
+  // when it is better than their own. Worker 0 is the current model; the
+  // other workers are built by model_builder, which must build a model
+  // identical to the current one (same nodes, vehicles, dimensions and
+  // constraints, added in the same order) but with its own callbacks, as
+  // callbacks are called concurrently. The built models must not be closed.
+  // model_builder is called on the calling thread, before the search starts.
+  // Worker 0 keeps the seed of its solver, the other ones are reseeded with
+  // their index. Returns the best solution found, as an assignment of the
+  // current model, or nullptr if no solution was found or if the current model
+  // or a built model is closed.
+  const Assignment* SolveInParallelWithParameters(
+      int num_workers, const WorkerModelBuilder& model_builder,
+      const RoutingSearchParameters& search_parameters);
+#endif
   // Computes a lower bound to the routing problem solving a linear assignment
   // problem. The routing model must be closed before calling this method.
   // Note that problems with node disjunction constraints (including optional
@@ -1042,6 +1065,7 @@ class RoutingModel {
     FULL_PATH_LNS,
     TSP_LNS,
     INACTIVE_LNS,
+    RUIN_AND_RECREATE,
     LOCAL_SEARCH_OPERATOR_COUNTER
   };
 
@@ -1165,10 +1189,26 @@ class RoutingModel {
   LocalSearchOperator* CreateInsertionOperator();
   LocalSearchOperator* CreateMakeInactiveOperator();
   void CreateNeighborhoodOperators();
+  // Registers a path operator to be restricted to moves between nearest
+  // neighbors when local_search_nearest_neighbors is set; returns the
+  // operator.
+  LocalSearchOperator* RestrictToNearestNeighbors(
+      LocalSearchOperator* path_operator);
+  // Sets the neighbors of the registered path operators from the
+  // local_search_nearest_neighbors of the search parameters, computing them
+  // the first time a number of neighbors is used.
+  void SetNearestNeighbors(const RoutingSearchParameters& search_parameters);
   LocalSearchOperator* GetNeighborhoodOperators(
-      const RoutingSearchParameters& search_parameters) const;
+      const RoutingSearchParameters& search_parameters);
+  // Returns the ruin-and-recreate operator, built with the ruin parameters of
+  // the first search using it.
+  LocalSearchOperator* GetOrCreateRuinAndRecreateOperator(
+      const RoutingSearchParameters& search_parameters);
   const std::vector<LocalSearchFilter*>& GetOrCreateLocalSearchFilters();
   const std::vector<LocalSearchFilter*>& GetOrCreateFeasibilityFilters();
+  // Creates new instances of the feasibility filters, without the extra
+  // filters which are shared with the local search filters.
+  std::vector<LocalSearchFilter*> CreateFeasibilityFilters();
   DecisionBuilder* CreateSolutionFinalizer();
   void CreateFirstSolutionDecisionBuilders(
       const RoutingSearchParameters& search_parameters);
@@ -1227,6 +1267,9 @@ class RoutingModel {
   std::function<int(int64)> vehicle_start_class_callback_;
   // Cached callbacks
   hash_map<const NodeEvaluator2*, NodeEvaluator2*> cached_node_callbacks_;
+  // Caches of node callbacks (see RoutingCache), indexed by the fingerprint of
+  // their values.
+  hash_map<uint64, NodeEvaluator2*> node_callback_caches_;
   hash_map<const VariableNodeEvaluator2*, VariableNodeEvaluator2*>
       cached_state_dependent_callbacks_;
   // Disjunctions
@@ -1276,6 +1319,14 @@ class RoutingModel {
   SearchLimit* limit_;
   SearchLimit* ls_limit_;
   SearchLimit* lns_limit_;
+  // Path operators restricted to moves between nearest neighbors.
+  std::vector<PathOperator*> neighbor_restricted_operators_;
+  // For each number of neighbors used so far, returns the nearest neighbors
+  // of a node.
+  hash_map<int, std::function<const std::vector<int>&(int64)>>
+      get_nearest_neighbors_;
+  // Solution pool of the local search, nullptr if the default pool is used.
+  SolutionPool* solution_pool_;
 
   // Callbacks to be deleted
   hash_set<const NodeEvaluator2*> owned_node_callbacks_;
@@ -1286,6 +1337,65 @@ class RoutingModel {
   DISALLOW_COPY_AND_ASSIGN(RoutingModel);
 };
 
+#ifndef SWIG
+// Cache of the values of a node evaluator on all pairs of nodes, used by
+// RoutingModel to cache its callbacks. The values are computed up front and
+// stored in a flat row-major matrix, so that a cached value is read with a
+// single memory access and concurrent reads are safe. Values are stored on 16
+// or 32 bits when they fit.
+class RoutingCache : public RoutingModel::NodeEvaluator2 {
+ public:
+  ~RoutingCache() override {}
+
+  // Creates a new cache holding the values of 'callback' on all pairs of nodes
+  // in [0, size). The cache object does not take ownership of the callback;
+  // the user must ensure that the callback gets deleted when it or the cache
+  // is no longer used. The callback is evaluated by 'num_threads' threads; it
+  // must be thread-safe when num_threads > 1. If 'compress' is true, the
+  // values are stored on 16 or 32 bits when they all fit.
+  //
+  // When used in the RoutingModel class, the cache should not be created
+  // directly, but through RoutingModel::NewCachedCallback that ensures that the
+  // base callback is deleted properly, and that callbacks with the same values
+  // share the same cache.
+  static RoutingCache* Build(RoutingModel::NodeEvaluator2* callback, int size,
+                             int num_threads, bool compress);
+
+  // Same as Build() with 'compress' true, but returns nullptr instead of a
+  // cache storing values on 64 bits if some values do not fit on 32 bits.
+  static RoutingCache* BuildCompressed(RoutingModel::NodeEvaluator2* callback,
+                                       int size, int num_threads);
+
+  // Returns the cache of 'caches', indexed by fingerprint, which holds the
+  // same values as 'cache'; 'cache' is then deleted. Otherwise returns
+  // 'cache', which is added to 'caches' unless another cache with the same
+  // fingerprint is already there.
+  static RoutingCache* FindOrAddSharedCache(
+      RoutingCache* cache,
+      hash_map<uint64, RoutingModel::NodeEvaluator2*>* caches);
+
+  bool IsRepeatable() const override { return true; }
+
+  // Returns a fingerprint of the cached values; it does not depend on the type
+  // used to store them.
+  uint64 fingerprint() const { return fingerprint_; }
+
+  // Returns true if 'other' caches exactly the same values, stored with the
+  // same type.
+  virtual bool HasSameValues(const RoutingCache& other) const = 0;
+
+ protected:
+  RoutingCache(int size, uint64 fingerprint)
+      : size_(size), fingerprint_(fingerprint) {}
+
+  const int size_;
+  const uint64 fingerprint_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(RoutingCache);
+};
+#endif  // SWIG
+
 // Routing model visitor.
 class RoutingModelVisitor : public BaseObject {
  public:
@@ -1653,6 +1763,12 @@ class IntVarFilteredDecisionBuilder : public DecisionBuilder {
   int64 number_of_rejects() const { return number_of_rejects_; }
 
  protected:
+  // Builds a solution with BuildSolution() in assignment(), starting from an
+  // empty assignment; returns false if no solution was found. Unlike Next(),
+  // the solution is not restored in the solver.
+  bool BuildAssignment();
+  // Returns the assignment in which the solution is built.
+  const Assignment* assignment() const { return assignment_; }
   // Commits the modifications to the current solution if these modifications
   // are "filter-feasible", returns false otherwise; in any case discards
   // all modifications.
@@ -1720,10 +1836,23 @@ class RoutingFilteredDecisionBuilder : public IntVarFilteredDecisionBuilder {
   void MakeDisjunctionNodesUnperformed(int64 node);
   // Make all unassigned nodes unperformed.
   void MakeUnassignedNodesUnperformed();
+  // Builds a solution starting from the partial routes given by next_accessor
+  // instead of the bound next variables of the model: next_accessor returns
+  // the next of a node, or -1 if it is unknown. The solver state is not
+  // modified. Returns the solution, or nullptr if none was found.
+  const Assignment* BuildSolutionFromRoutes(
+      const std::function<int64(int64)>& next_accessor);
+
+ protected:
+  // Returns the next of 'node' in the partial solution from which routes are
+  // initialized, or -1 if it is unknown.
+  int64 GetKnownNext(int64 node) const;
 
  private:
+
   RoutingModel* const model_;
   std::vector<int64> start_chain_ends_;
+  std::function<int64(int64)> next_accessor_;
 };
 
 class CheapestInsertionFilteredDecisionBuilder
@@ -2088,5 +2217,21 @@ RoutingLocalSearchFilter* MakeNodePrecedenceFilter(
     const RoutingModel& routing_model, const RoutingModel::NodePairs& pairs);
 RoutingLocalSearchFilter* MakeVehicleVarFilter(
     const RoutingModel& routing_model);
+
+// Moves a pair of nodes to another position, the first node of the pair before
+// the second one on the same path.
+LocalSearchOperator* MakePairRelocate(
+    Solver* const solver, const std::vector<IntVar*>& vars,
+    const std::vector<IntVar*>& secondary_vars,
+    std::function<int(int64)> start_empty_path_class,
+    const RoutingModel::NodePairs& pairs);
+// Removes strings of nodes close to a seed node from the current solution and
+// reinserts them with the 'recreate' heuristic; each neighbor is a complete
+// solution. Removes average_removed_nodes nodes on average, with at most
+// max_string_size consecutive nodes per route.
+LocalSearchOperator* MakeRuinAndRecreate(
+    RoutingModel* model, const std::vector<IntVar*>& vehicle_vars,
+    RoutingFilteredDecisionBuilder* recreate, int average_removed_nodes,
+    int max_string_size);
 }  // namespace operations_research
 #endif  // OR_TOOLS_CONSTRAINT_SOLVER_ROUTING_H_
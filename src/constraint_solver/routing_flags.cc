@@ -45,10 +45,15 @@ DEFINE_bool(routing_no_tsp, true,
             "Routing: forbids use of TSPOpt neighborhood.");
 DEFINE_bool(routing_no_tsplns, true,
             "Routing: forbids use of TSPLNS neighborhood.");
+DEFINE_bool(routing_no_ruin_and_recreate, true,
+            "Routing: forbids use of the ruin-and-recreate neighborhood.");
 DEFINE_bool(routing_use_chain_make_inactive, false,
             "Routing: use chain version of MakeInactive neighborhood.");
 DEFINE_bool(routing_use_extended_swap_active, false,
             "Routing: use extended version of SwapActive neighborhood.");
+DEFINE_int32(routing_nearest_neighbors, 0,
+             "Routing: if positive, restricts path neighborhoods to moves "
+             "between nodes among each other's nearest neighbors.");
 
 // Meta-heuristics
 DEFINE_bool(routing_guided_local_search, false, "Routing: use GLS.");
@@ -166,6 +171,10 @@ void AddLocalSearchNeighborhoodOperatorsFromFlags(
   local_search_operators->set_use_inactive_lns(!FLAGS_routing_no_lns);
   local_search_operators->set_use_full_path_lns(!FLAGS_routing_no_fullpathlns);
   local_search_operators->set_use_tsp_lns(!FLAGS_routing_no_tsplns);
+  local_search_operators->set_use_ruin_and_recreate(
+      !FLAGS_routing_no_ruin_and_recreate);
+  parameters->set_local_search_nearest_neighbors(
+      FLAGS_routing_nearest_neighbors);
 }
 
 void SetSearchLimitsFromFlags(RoutingSearchParameters* parameters) {
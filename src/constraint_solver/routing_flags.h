@@ -34,8 +34,10 @@ DECLARE_bool(routing_no_make_active);
 DECLARE_bool(routing_no_lkh);
 DECLARE_bool(routing_no_tsp);
 DECLARE_bool(routing_no_tsplns);
+DECLARE_bool(routing_no_ruin_and_recreate);
 DECLARE_bool(routing_use_chain_make_inactive);
 DECLARE_bool(routing_use_extended_swap_active);
+DECLARE_int32(routing_nearest_neighbors);
 
 // Meta-heuristics
 DECLARE_bool(routing_guided_local_search);
@@ -646,6 +646,17 @@ class PathCumulFilter : public BasePathFilter {
                   int64 chain_end) override;
   bool FinalizeAcceptPath() override;
   void OnBeforeSynchronizePaths() override;
+  void OnSynchronizePathFromStart(int64 start) override;
+
+  // Checks the feasibility of the path starting at path_start with regards to
+  // cumul bounds by only scanning the chain (chain_start...chain_end): the
+  // part of the path before the chain is summarized by the cumul min of
+  // chain_start and the part after the chain by the latest arrival at
+  // chain_end. Sets 'accept' and returns true if the check could be done,
+  // returns false if the chain does not lead to chain_end, in which case the
+  // whole path must be scanned.
+  bool AcceptChainFromPathSummaries(int64 path_start, int64 chain_start,
+                                    int64 chain_end, bool* accept);
 
   bool FilterSpanCost() const { return global_span_cost_coefficient_ != 0; }
 
@@ -705,6 +716,26 @@ class PathCumulFilter : public BasePathFilter {
   int64 delta_max_end_cumul_;
   // Note: small_ordered_set only support non-hash sets.
   small_ordered_set<std::set<int>> delta_paths_;
+  // Path summaries of the cumul bounds (time windows). With them, a path is
+  // checked in time linear in the length of its changed chain instead of the
+  // whole path. This is not constant time: reversals by 2-opt or chains moved
+  // by cross can be long. They are only maintained when the dimension has no
+  // forbidden intervals and no cost: no span cost, no vehicle span cost or
+  // upper bound, and no soft cumul bounds. Otherwise, or when a changed chain
+  // does not lead to the node ending it, the whole path is scanned. Waiting
+  // times, durations and time warps are not summarized.
+  // For each node on a synchronized path, current_path_cumul_mins_ is the
+  // earliest cumul value of the node from the path start, and
+  // current_latest_arrivals_ the latest value of the cumul of the previous
+  // node plus the transit (and min slack) to the node for which the rest of
+  // the path remains feasible (kint64min if there is none).
+  // current_transit_slacks_ is the transit plus min slack from a node to its
+  // next node.
+  bool use_path_summaries_;
+  std::vector<int64> current_path_cumul_mins_;
+  std::vector<int64> current_latest_arrivals_;
+  std::vector<int64> current_transit_slacks_;
+  std::vector<int64> path_nodes_;
   const std::string name_;
 
   bool lns_detected_;
@@ -731,6 +762,7 @@ PathCumulFilter::PathCumulFilter(const RoutingModel& routing_model,
       cost_var_(routing_model.CostVar()),
       vehicle_capacities_(dimension.vehicle_capacities()),
       delta_max_end_cumul_(kint64min),
+      use_path_summaries_(false),
       name_(dimension.name()),
       lns_detected_(false) {
   for (const int64 upper_bound : vehicle_span_upper_bounds_) {
@@ -795,6 +827,19 @@ PathCumulFilter::PathCumulFilter(const RoutingModel& routing_model,
     start_to_vehicle_[routing_model.Start(i)] = i;
     evaluators_[i] = &dimension.transit_evaluator(i);
   }
+  use_path_summaries_ = !FilterSpanCost() && !FilterCumulSoftBounds() &&
+                        !FilterSlackCost() && !FilterCumulSoftLowerBounds();
+  for (const SortedDisjointIntervalList& intervals : forbidden_intervals_) {
+    if (intervals.NumIntervals() > 0) {
+      use_path_summaries_ = false;
+      break;
+    }
+  }
+  if (use_path_summaries_) {
+    current_path_cumul_mins_.resize(cumuls_.size(), 0);
+    current_latest_arrivals_.resize(cumuls_.size(), kint64min);
+    current_transit_slacks_.resize(Size(), 0);
+  }
 }
 
 int64 PathCumulFilter::GetCumulSoftCost(int64 node, int64 cumul_value) const {
@@ -923,8 +968,101 @@ void PathCumulFilter::OnBeforeSynchronizePaths() {
   }
 }
 
+// Maintains path summaries from which AcceptChainFromPathSummaries() checks
+// a path in time linear in the length of its changed chain in the new path,
+// instead of the length of the whole path: cumul mins are propagated forward
+// from the path start and latest arrivals backward from the path end. Moves
+// changing few arcs can still have long chains, e.g. reversals by 2-opt or
+// chains moved between paths by cross.
+void PathCumulFilter::OnSynchronizePathFromStart(int64 start) {
+  if (!use_path_summaries_) return;
+  const int vehicle = start_to_vehicle_[start];
+  const int64 capacity = vehicle_capacities_[vehicle];
+  path_nodes_.clear();
+  int64 node = start;
+  int64 cumul = cumuls_[node]->Min();
+  current_path_cumul_mins_[node] = cumul;
+  while (node < Size()) {
+    path_nodes_.push_back(node);
+    const int64 next = Value(node);
+    const int64 transit_slack =
+        CapAdd((*evaluators_[vehicle])(node, next), slacks_[node]->Min());
+    current_transit_slacks_[node] = transit_slack;
+    cumul = CapAdd(cumul, transit_slack);
+    if (cumul > std::min(capacity, cumuls_[next]->Max())) {
+      // The path is infeasible from here; saturating cumul mins makes any
+      // chain starting after this node infeasible.
+      cumul = kint64max;
+    }
+    cumul = std::max(cumuls_[next]->Min(), cumul);
+    current_path_cumul_mins_[next] = cumul;
+    node = next;
+  }
+  int64 latest_arrival = std::min(capacity, cumuls_[node]->Max());
+  current_latest_arrivals_[node] = latest_arrival;
+  for (int i = path_nodes_.size() - 1; i >= 0; --i) {
+    node = path_nodes_[i];
+    const int64 transit_slack = current_transit_slacks_[node];
+    if (latest_arrival == kint64min ||
+        CapAdd(cumuls_[node]->Min(), transit_slack) > latest_arrival) {
+      latest_arrival = kint64min;
+    } else {
+      latest_arrival = CapSub(latest_arrival, transit_slack);
+      // The cumul of the path start is not checked against its bounds.
+      if (i > 0) {
+        latest_arrival =
+            std::min(latest_arrival, std::min(capacity, cumuls_[node]->Max()));
+      }
+    }
+    current_latest_arrivals_[node] = latest_arrival;
+  }
+}
+
+bool PathCumulFilter::AcceptChainFromPathSummaries(int64 path_start,
+                                                   int64 chain_start,
+                                                   int64 chain_end,
+                                                   bool* accept) {
+  const int vehicle = start_to_vehicle_[path_start];
+  const int64 capacity = vehicle_capacities_[vehicle];
+  int64 node = chain_start;
+  int64 cumul = current_path_cumul_mins_[node];
+  if (cumul == kint64max) {
+    *accept = false;
+    return true;
+  }
+  int64 arrival = cumul;
+  int chain_length = 0;
+  while (node != chain_end) {
+    if (node >= Size() || ++chain_length > Size()) return false;
+    const int64 next = GetNext(node);
+    if (next == kUnassigned) {
+      // LNS detected, return true since other paths were ok up to now.
+      lns_detected_ = true;
+      *accept = true;
+      return true;
+    }
+    arrival = CapAdd(cumul, CapAdd((*evaluators_[vehicle])(node, next),
+                                   slacks_[node]->Min()));
+    if (arrival > std::min(capacity, cumuls_[next]->Max())) {
+      *accept = false;
+      return true;
+    }
+    cumul = std::max(cumuls_[next]->Min(), arrival);
+    node = next;
+  }
+  *accept = arrival <= current_latest_arrivals_[chain_end];
+  return true;
+}
+
 bool PathCumulFilter::AcceptPath(int64 path_start, int64 chain_start,
                                  int64 chain_end) {
+  if (use_path_summaries_) {
+    bool accept = true;
+    if (AcceptChainFromPathSummaries(path_start, chain_start, chain_end,
+                                     &accept)) {
+      return accept;
+    }
+  }
   int64 node = path_start;
   int64 cumul = cumuls_[node]->Min();
   cumul_cost_delta_ = CapAdd(cumul_cost_delta_, GetCumulSoftCost(node, cumul));
@@ -1315,6 +1453,15 @@ IntVarFilteredDecisionBuilder::IntVarFilteredDecisionBuilder(
 }
 
 Decision* IntVarFilteredDecisionBuilder::Next(Solver* solver) {
+  if (BuildAssignment()) {
+    assignment_->Restore();
+  } else {
+    solver->Fail();
+  }
+  return nullptr;
+}
+
+bool IntVarFilteredDecisionBuilder::BuildAssignment() {
   number_of_decisions_ = 0;
   number_of_rejects_ = 0;
   // Wiping assignment when starting a new search.
@@ -1325,11 +1472,9 @@ Decision* IntVarFilteredDecisionBuilder::Next(Solver* solver) {
   if (BuildSolution()) {
     VLOG(2) << "Number of decisions: " << number_of_decisions_;
     VLOG(2) << "Number of rejected decisions: " << number_of_rejects_;
-    assignment_->Restore();
-  } else {
-    solver->Fail();
+    return true;
   }
-  return nullptr;
+  return false;
 }
 
 bool IntVarFilteredDecisionBuilder::Commit() {
@@ -1409,8 +1554,9 @@ bool RoutingFilteredDecisionBuilder::InitializeRoutes() {
   start_chain_ends_.resize(model()->vehicles(), -1);
   for (int vehicle = 0; vehicle < model()->vehicles(); ++vehicle) {
     int64 node = model()->Start(vehicle);
-    while (!model()->IsEnd(node) && Var(node)->Bound()) {
-      const int64 next = Var(node)->Min();
+    while (!model()->IsEnd(node)) {
+      const int64 next = GetKnownNext(node);
+      if (next == -1) break;
       SetValue(node, next);
       node = next;
     }
@@ -1429,9 +1575,9 @@ bool RoutingFilteredDecisionBuilder::InitializeRoutes() {
     int current = node;
     while (!model()->IsEnd(current) && !touched[current]) {
       touched[current] = true;
-      IntVar* const next_var = Var(current);
-      if (next_var->Bound()) {
-        current = next_var->Value();
+      const int64 next = GetKnownNext(current);
+      if (next != -1) {
+        current = next;
       }
     }
     // Merge the sub-chain starting from 'node' and ending at 'current' with
@@ -1449,15 +1595,37 @@ bool RoutingFilteredDecisionBuilder::InitializeRoutes() {
       SetValue(node, next);
       node = next;
       while (!model()->IsEnd(node)) {
-        next = Var(node)->Min();
+        next = GetKnownNext(node);
         SetValue(node, next);
         node = next;
       }
     }
   }
+  // Nodes which are their own next are unperformed.
+  for (int node = 0; node < Size(); ++node) {
+    if (GetKnownNext(node) == node) {
+      SetValue(node, node);
+    }
+  }
   return Commit();
 }
 
+const Assignment* RoutingFilteredDecisionBuilder::BuildSolutionFromRoutes(
+    const std::function<int64(int64)>& next_accessor) {
+  next_accessor_ = next_accessor;
+  const bool found = BuildAssignment();
+  next_accessor_ = nullptr;
+  return found ? assignment() : nullptr;
+}
+
+int64 RoutingFilteredDecisionBuilder::GetKnownNext(int64 node) const {
+  if (next_accessor_ != nullptr) {
+    return next_accessor_(node);
+  }
+  IntVar* const next_var = Var(node);
+  return next_var->Bound() ? next_var->Min() : -1;
+}
+
 void RoutingFilteredDecisionBuilder::MakeDisjunctionNodesUnperformed(
     int64 node) {
   model()->ForEachNodeInDisjunctionWithMaxCardinalityFromIndex(
@@ -220,6 +220,12 @@ class BasePositiveTableConstraint : public Constraint {
         tuples_.Value(tuple_index, var_index));
   }
 
+  const IntTupleSet& tuples() const { return tuples_; }
+
+  const AffineTransformation& transformation(int var_index) const {
+    return transformations_[var_index];
+  }
+
   bool IsTupleSupported(int tuple_index) {
     for (int var_index = 0; var_index < arity_; ++var_index) {
       int64 value = 0;
@@ -408,9 +414,7 @@ class CompactPositiveTableConstraint : public BasePositiveTableConstraint {
       : BasePositiveTableConstraint(s, vars, tuples),
         word_length_(BitLength64(tuples.NumTuples())),
         active_tuples_(tuples.NumTuples()),
-        masks_(arity_),
-        mask_starts_(arity_),
-        mask_ends_(arity_),
+        masks_(arity_, nullptr),
         original_min_(arity_, 0),
         temp_mask_(word_length_, 0),
         supports_(arity_),
@@ -436,8 +440,7 @@ class CompactPositiveTableConstraint : public BasePositiveTableConstraint {
 
   void InitialPropagate() override {
     BuildMasks();
-    FillMasksAndActiveTuples();
-    ComputeMasksBoundaries();
+    FillActiveTuples();
     BuildSupports();
     RemoveUnsupportedValues();
   }
@@ -567,7 +570,7 @@ class CompactPositiveTableConstraint : public BasePositiveTableConstraint {
 
     switch (var_size) {
       case 1: {
-        changed = AndMaskWithActive(masks_[var_index][var_min - omin]);
+        changed = AndMaskWithActive(Mask(var_index, var_min - omin));
         break;
       }
       case 2: {
@@ -588,13 +591,13 @@ class CompactPositiveTableConstraint : public BasePositiveTableConstraint {
         if (number_of_operations < var_size) {
           // Let's scan the removed values since last run.
           for (int64 value = old_min; value < var_min; ++value) {
-            changed |= SubtractMaskFromActive(masks_[var_index][value - omin]);
+            changed |= SubtractMaskFromActive(Mask(var_index, value - omin));
           }
           for (const int64 value : InitAndGetValues(holes_[var_index])) {
-            changed |= SubtractMaskFromActive(masks_[var_index][value - omin]);
+            changed |= SubtractMaskFromActive(Mask(var_index, value - omin));
           }
           for (int64 value = var_max + 1; value <= old_max; ++value) {
-            changed |= SubtractMaskFromActive(masks_[var_index][value - omin]);
+            changed |= SubtractMaskFromActive(Mask(var_index, value - omin));
           }
         } else {
           ClearTempMask();
@@ -636,31 +639,71 @@ class CompactPositiveTableConstraint : public BasePositiveTableConstraint {
  private:
   // ----- Initialization -----
 
+  // Gets the masks of the variables from the cache of the solver, and builds
+  // the missing ones.
   void BuildMasks() {
-    // Build masks.
+    TableMasksCache* const cache = solver()->TableMasks();
     for (int i = 0; i < arity_; ++i) {
       original_min_[i] = vars_[i]->Min();
       const int64 span = vars_[i]->Max() - original_min_[i] + 1;
-      masks_[i].resize(span);
+      const AffineTransformation& t = transformation(i);
+      masks_[i] = cache->Find(tuples(), i, t.a, t.b, original_min_[i], span);
+      if (masks_[i] == nullptr) {
+        masks_[i] = cache->Insert(tuples(), i, t.a, t.b, original_min_[i],
+                                  span, BuildColumnMasks(i, span));
+      }
+    }
+  }
+
+  // The masks only depend on the values of the tuples in the column, and not
+  // on the current domains of the other variables: the tuples that are not
+  // supported are removed from the active tuples instead.
+  TableMasksCache::ColumnMasks* BuildColumnMasks(int var_index, int64 span) {
+    TableMasksCache::ColumnMasks* const column = new TableMasksCache::ColumnMasks;
+    column->masks.resize(span);
+    column->starts.resize(span, 0);
+    column->ends.resize(span, 0);
+    const int64 original_min = original_min_[var_index];
+    for (int tuple_index = 0; tuple_index < tuple_count_; ++tuple_index) {
+      int64 value = 0;
+      if (!TupleValue(tuple_index, var_index, &value) ||
+          value < original_min || value - original_min >= span) {
+        continue;
+      }
+      std::vector<uint64>& mask = column->masks[value - original_min];
+      if (mask.empty()) {
+        mask.assign(word_length_, 0);
+      }
+      SetBit64(mask.data(), tuple_index);
     }
+    for (int value_index = 0; value_index < span; ++value_index) {
+      const std::vector<uint64>& mask = column->masks[value_index];
+      if (mask.empty()) {
+        continue;
+      }
+      int start = 0;
+      while (start < word_length_ && mask[start] == 0) {
+        start++;
+      }
+      DCHECK_LT(start, word_length_);
+      int end = word_length_ - 1;
+      while (end > start && mask[end] == 0) {
+        end--;
+      }
+      DCHECK_LE(start, end);
+      DCHECK_NE(mask[start], 0);
+      DCHECK_NE(mask[end], 0);
+      column->starts[value_index] = start;
+      column->ends[value_index] = end;
+    }
+    return column;
   }
 
-  void FillMasksAndActiveTuples() {
+  void FillActiveTuples() {
     std::vector<uint64> actives(word_length_, 0);
     for (int tuple_index = 0; tuple_index < tuple_count_; ++tuple_index) {
       if (IsTupleSupported(tuple_index)) {
         SetBit64(actives.data(), tuple_index);
-        // Fill in all masks.
-        for (int var_index = 0; var_index < arity_; ++var_index) {
-          const int64 value = UnsafeTupleValue(tuple_index, var_index);
-          const int64 value_index = value - original_min_[var_index];
-          DCHECK_GE(value_index, 0);
-          DCHECK_LT(value_index, masks_[var_index].size());
-          if (masks_[var_index][value_index].empty()) {
-            masks_[var_index][value_index].assign(word_length_, 0);
-          }
-          SetBit64(masks_[var_index][value_index].data(), tuple_index);
-        }
       }
     }
     active_tuples_.Init(solver(), actives);
@@ -672,7 +715,9 @@ class CompactPositiveTableConstraint : public BasePositiveTableConstraint {
       IntVar* const var = vars_[var_index];
       to_remove_.clear();
       for (const int64 value : InitAndGetValues(iterators_[var_index])) {
-        if (masks_[var_index][value - original_min_[var_index]].empty()) {
+        const int64 value_index = value - original_min_[var_index];
+        if (Mask(var_index, value_index).empty() ||
+            !Supported(var_index, value_index)) {
           to_remove_.push_back(value);
         }
       }
@@ -682,37 +727,9 @@ class CompactPositiveTableConstraint : public BasePositiveTableConstraint {
     }
   }
 
-  void ComputeMasksBoundaries() {
-    for (int var_index = 0; var_index < arity_; ++var_index) {
-      mask_starts_[var_index].resize(masks_[var_index].size());
-      mask_ends_[var_index].resize(masks_[var_index].size());
-      for (int value_index = 0; value_index < masks_[var_index].size();
-           ++value_index) {
-        const std::vector<uint64>& mask = masks_[var_index][value_index];
-        if (mask.empty()) {
-          continue;
-        }
-        int start = 0;
-        while (start < word_length_ && mask[start] == 0) {
-          start++;
-        }
-        DCHECK_LT(start, word_length_);
-        int end = word_length_ - 1;
-        while (end > start && mask[end] == 0) {
-          end--;
-        }
-        DCHECK_LE(start, end);
-        DCHECK_NE(mask[start], 0);
-        DCHECK_NE(mask[end], 0);
-        mask_starts_[var_index][value_index] = start;
-        mask_ends_[var_index][value_index] = end;
-      }
-    }
-  }
-
   void BuildSupports() {
     for (int var_index = 0; var_index < arity_; ++var_index) {
-      supports_[var_index].resize(masks_[var_index].size());
+      supports_[var_index].assign(masks_[var_index]->masks.size(), 0);
     }
   }
 
@@ -734,28 +751,31 @@ class CompactPositiveTableConstraint : public BasePositiveTableConstraint {
     return result;
   }
 
+  const std::vector<uint64>& Mask(int var_index, int64 value_index) const {
+    DCHECK_GE(value_index, 0);
+    DCHECK_LT(value_index, masks_[var_index]->masks.size());
+    return masks_[var_index]->masks[value_index];
+  }
+
   bool Supported(int var_index, int64 value_index) {
     DCHECK_GE(var_index, 0);
     DCHECK_LT(var_index, arity_);
-    DCHECK_GE(value_index, 0);
-    DCHECK_LT(value_index, masks_[var_index].size());
-    const std::vector<uint64>& mask = masks_[var_index][value_index];
+    const std::vector<uint64>& mask = Mask(var_index, value_index);
     DCHECK(!mask.empty());
     return active_tuples_.Intersects(mask, &supports_[var_index][value_index]);
   }
 
   void OrTempMask(int var_index, int64 value_index) {
-    const std::vector<uint64>& mask = masks_[var_index][value_index];
+    const std::vector<uint64>& mask = Mask(var_index, value_index);
     if (!mask.empty()) {
-      const int mask_span = mask_ends_[var_index][value_index] -
-                            mask_starts_[var_index][value_index] + 1;
-      if (active_tuples_.ActiveWordSize() < mask_span) {
+      const int mask_start = masks_[var_index]->starts[value_index];
+      const int mask_end = masks_[var_index]->ends[value_index];
+      if (active_tuples_.ActiveWordSize() < mask_end - mask_start + 1) {
         for (int i : active_tuples_.active_words()) {
           temp_mask_[i] |= mask[i];
         }
       } else {
-        for (int i = mask_starts_[var_index][value_index];
-             i <= mask_ends_[var_index][value_index]; ++i) {
+        for (int i = mask_start; i <= mask_end; ++i) {
           temp_mask_[i] |= mask[i];
         }
       }
@@ -769,11 +789,12 @@ class CompactPositiveTableConstraint : public BasePositiveTableConstraint {
     // comparing the number of operations in both case, with constant factor.
     // TODO(user): experiment with different constant values.
     if (active_tuples_.ActiveWordSize() < word_length_ / 4) {
+      const std::vector<uint64>& mask = Mask(var_index, value_index);
       for (int i : active_tuples_.active_words()) {
-        temp_mask_[i] = masks_[var_index][value_index][i];
+        temp_mask_[i] = mask[i];
       }
     } else {
-      temp_mask_ = masks_[var_index][value_index];
+      temp_mask_ = Mask(var_index, value_index);
     }
   }
 
@@ -792,11 +813,8 @@ class CompactPositiveTableConstraint : public BasePositiveTableConstraint {
   int64 word_length_;
   // The active bitset.
   UnsortedNullableRevBitset active_tuples_;
-  // The masks per value per variable.
-  std::vector<std::vector<std::vector<uint64>>> masks_;
-  // The range of active indices in the masks.
-  std::vector<std::vector<int>> mask_starts_;
-  std::vector<std::vector<int>> mask_ends_;
+  // The masks per value per variable, owned by the cache of the solver.
+  std::vector<const TableMasksCache::ColumnMasks*> masks_;
   // The min on the vars at creation time.
   std::vector<int64> original_min_;
   // A temporary mask use for computation.
@@ -1103,7 +1121,7 @@ class SmallCompactPositiveTableConstraint : public BasePositiveTableConstraint {
   void ApplyMask(int var_index, uint64 mask) {
     if ((~mask & active_tuples_) != 0) {
       // Check if we need to save the active_tuples in this node.
-      const uint64 current_stamp = solver()->stamp();
+      const uint64 current_stamp = solver()->trail_stamp();
       if (stamp_ < current_stamp) {
         stamp_ = current_stamp;
         solver()->SaveValue(&active_tuples_);
@@ -1266,6 +1284,39 @@ const int TransitionConstraint::kNextStatePosition = 2;
 const int TransitionConstraint::kTransitionTupleSize = 3;
 }  // namespace
 
+// ----- TableMasksCache -----
+
+TableMasksCache::TableMasksCache() : num_hits_(0) {}
+
+TableMasksCache::~TableMasksCache() {}
+
+const TableMasksCache::ColumnMasks* TableMasksCache::Find(
+    const IntTupleSet& tuples, int column, int64 a, int64 b,
+    int64 original_min, int64 span) const {
+  const auto it =
+      masks_.find(Key(tuples.RawData(), column, a, b, original_min, span));
+  if (it == masks_.end()) {
+    return nullptr;
+  }
+  ++num_hits_;
+  return it->second.get();
+}
+
+const TableMasksCache::ColumnMasks* TableMasksCache::Insert(
+    const IntTupleSet& tuples, int column, int64 a, int64 b,
+    int64 original_min, int64 span, ColumnMasks* const masks) {
+  InsertIfNotPresent(&tuple_sets_, tuples.RawData(), tuples);
+  std::unique_ptr<ColumnMasks>& entry =
+      masks_[Key(tuples.RawData(), column, a, b, original_min, span)];
+  DCHECK(entry == nullptr);
+  entry.reset(masks);
+  return masks;
+}
+
+TableMasksCache* Solver::TableMasks() const {
+  return table_masks_cache_.get();
+}
+
 // --------- API ----------
 
 Constraint* Solver::MakeAllowedAssignments(const std::vector<IntVar*>& vars,
@@ -72,7 +72,7 @@ RevBitSet::~RevBitSet() {
 }
 
 void RevBitSet::Save(Solver* const solver, int offset) {
-  const uint64 current_stamp = solver->stamp();
+  const uint64 current_stamp = solver->trail_stamp();
   if (current_stamp > stamps_[offset]) {
     stamps_[offset] = current_stamp;
     solver->SaveValue(&bits_[offset]);
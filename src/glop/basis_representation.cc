@@ -14,6 +14,10 @@
 
 #include "glop/basis_representation.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
 #include "base/stl_util.h"
 #include "glop/status.h"
 #include "lp_data/lp_utils.h"
@@ -173,6 +177,371 @@ void EtaFactorization::RightSolve(DenseColumn* d) const {
   }
 }
 
+// --------------------------------------------------------
+// ForrestTomlinFactorization
+// --------------------------------------------------------
+
+const double ForrestTomlinFactorization::kHyperSparseRatio = 0.05;
+const Fractional ForrestTomlinFactorization::kUpdateAccuracyTolerance = 1e-6;
+
+ForrestTomlinFactorization::ForrestTomlinFactorization() : num_entries_(0) {
+  Clear();
+}
+
+ForrestTomlinFactorization::~ForrestTomlinFactorization() {}
+
+void ForrestTomlinFactorization::Clear() {
+  pivot_row_.clear();
+  pivot_col_.clear();
+  row_position_.clear();
+  col_position_.clear();
+  diagonal_.clear();
+  columns_.clear();
+  rows_.clear();
+  num_entries_ = EntryIndex(0);
+  eta_row_.clear();
+  eta_start_.assign(1, 0);
+  eta_entry_row_.clear();
+  eta_entry_coefficient_.clear();
+}
+
+void ForrestTomlinFactorization::Initialize(
+    const LuFactorization& lu_factorization, RowIndex num_rows) {
+  Clear();
+  const ColIndex num_cols = RowToColIndex(num_rows);
+  pivot_row_.resize(num_rows.value());
+  pivot_col_.resize(num_rows.value());
+  row_position_.resize(num_rows, 0);
+  col_position_.resize(num_cols, 0);
+  diagonal_.resize(num_cols, 0.0);
+  columns_.resize(num_cols, std::vector<ColumnEntry>());
+  rows_.resize(num_rows, std::vector<RowEntry>());
+  column_scratchpad_.AssignToZero(num_rows);
+  row_scratchpad_.AssignToZero(num_cols);
+  is_queued_.assign(num_rows.value(), false);
+
+  // The column col of V = U.Q is the column Q(col) of U. Since U is upper
+  // triangular, its pivot row is Q(col) and its position in the pivot sequence
+  // is also Q(col).
+  const ColumnPermutation& col_perm = lu_factorization.GetColumnPermutation();
+  for (ColIndex col(0); col < num_cols; ++col) {
+    const ColIndex permuted_col = col_perm.empty() ? col : col_perm[col];
+    const RowIndex pivot_row = ColToRowIndex(permuted_col);
+    const int position = permuted_col.value();
+    pivot_row_[position] = pivot_row;
+    pivot_col_[position] = col;
+    row_position_[pivot_row] = position;
+    col_position_[col] = position;
+    for (const auto& e : lu_factorization.GetColumnOfU(col)) {
+      if (e.row() == pivot_row) {
+        diagonal_[col] = e.coefficient();
+      } else {
+        AddEntry(e.row(), col, e.coefficient());
+      }
+    }
+  }
+}
+
+void ForrestTomlinFactorization::AddEntry(RowIndex row, ColIndex col,
+                                          Fractional coefficient) {
+  columns_[col].push_back(ColumnEntry(row, coefficient));
+  rows_[row].push_back(RowEntry(col, coefficient));
+  ++num_entries_;
+}
+
+void ForrestTomlinFactorization::RemoveEntryFromRow(RowIndex row,
+                                                    ColIndex col) {
+  std::vector<RowEntry>* const entries = &rows_[row];
+  for (int i = 0; i < entries->size(); ++i) {
+    if ((*entries)[i].col == col) {
+      (*entries)[i] = entries->back();
+      entries->pop_back();
+      return;
+    }
+  }
+  LOG(DFATAL) << "Entry (" << row << ", " << col << ") not found in its row.";
+}
+
+void ForrestTomlinFactorization::RemoveEntryFromColumn(RowIndex row,
+                                                       ColIndex col) {
+  std::vector<ColumnEntry>* const entries = &columns_[col];
+  for (int i = 0; i < entries->size(); ++i) {
+    if ((*entries)[i].row == row) {
+      (*entries)[i] = entries->back();
+      entries->pop_back();
+      return;
+    }
+  }
+  LOG(DFATAL) << "Entry (" << row << ", " << col << ") not found in its column.";
+}
+
+bool ForrestTomlinFactorization::Update(ColIndex leaving_col, Fractional pivot,
+                                        DenseColumn* spike,
+                                        std::vector<RowIndex>* non_zeros) {
+  DCHECK_EQ(ColToRowIndex(diagonal_.size()), spike->size());
+  const int last_position = pivot_row_.size() - 1;
+  const int leaving_position = col_position_[leaving_col];
+  const RowIndex leaving_row = pivot_row_[leaving_position];
+  const Fractional old_diagonal = diagonal_[leaving_col];
+
+  // Removes the leaving column from V.
+  for (const ColumnEntry& e : columns_[leaving_col]) {
+    RemoveEntryFromRow(e.row, leaving_col);
+  }
+  num_entries_ -= columns_[leaving_col].size();
+  columns_[leaving_col].clear();
+
+  // Moves the leaving column and its pivot row to the end of the sequence.
+  pivot_row_.erase(pivot_row_.begin() + leaving_position);
+  pivot_col_.erase(pivot_col_.begin() + leaving_position);
+  pivot_row_.push_back(leaving_row);
+  pivot_col_.push_back(leaving_col);
+  for (int position = leaving_position; position <= last_position;
+       ++position) {
+    row_position_[pivot_row_[position]] = position;
+    col_position_[pivot_col_[position]] = position;
+  }
+
+  // The entries of the leaving row are moved to row_scratchpad_, they are the
+  // ones that need to be eliminated. Note that they are all in the columns
+  // that were after the leaving column in the pivot sequence.
+  std::vector<int>* const queue = &position_queue_;
+  const std::greater<int> min_heap;
+  DenseRow* const row = &row_scratchpad_;
+  for (const RowEntry& e : rows_[leaving_row]) {
+    RemoveEntryFromColumn(leaving_row, e.col);
+    (*row)[e.col] = e.coefficient;
+    queue->push_back(col_position_[e.col]);
+    is_queued_[col_position_[e.col]] = true;
+  }
+  num_entries_ -= rows_[leaving_row].size();
+  rows_[leaving_row].clear();
+  std::make_heap(queue->begin(), queue->end(), min_heap);
+
+  // Inserts the spike as the new leaving column. Its coefficient on the
+  // leaving row will become the new diagonal once the elimination is done.
+  if (non_zeros->empty()) ComputeNonZeros(*spike, non_zeros);
+  for (const auto& spike_row : *non_zeros) {
+    const Fractional value = (*spike)[spike_row];
+    if (value == 0.0) continue;
+    (*spike)[spike_row] = 0.0;
+    if (spike_row == leaving_row) {
+      (*row)[leaving_col] = value;
+    } else {
+      AddEntry(spike_row, leaving_col, value);
+    }
+  }
+  non_zeros->clear();
+
+  // Eliminates the leaving row entries in pivot sequence order. Only the
+  // positions after the one being eliminated can be filled, so we just need to
+  // process the non-zeros by increasing position.
+  eta_row_.push_back(leaving_row);
+  while (!queue->empty()) {
+    std::pop_heap(queue->begin(), queue->end(), min_heap);
+    const int position = queue->back();
+    queue->pop_back();
+    is_queued_[position] = false;
+    if (position == last_position) continue;
+    const ColIndex col = pivot_col_[position];
+    const Fractional value = (*row)[col];
+    (*row)[col] = 0.0;
+    if (value == 0.0) continue;
+    const Fractional multiplier = value / diagonal_[col];
+    const RowIndex pivot_row = pivot_row_[position];
+    eta_entry_row_.push_back(pivot_row);
+    eta_entry_coefficient_.push_back(multiplier);
+    for (const RowEntry& e : rows_[pivot_row]) {
+      Fractional* const target = &(*row)[e.col];
+      const int target_position = col_position_[e.col];
+      if (*target == 0.0 && !is_queued_[target_position]) {
+        queue->push_back(target_position);
+        std::push_heap(queue->begin(), queue->end(), min_heap);
+        is_queued_[target_position] = true;
+      }
+      *target -= multiplier * e.coefficient;
+    }
+  }
+  if (eta_entry_row_.size() == static_cast<size_t>(eta_start_.back())) {
+    eta_row_.pop_back();
+  } else {
+    eta_start_.push_back(eta_entry_row_.size());
+  }
+
+  const Fractional new_diagonal = (*row)[leaving_col];
+  (*row)[leaving_col] = 0.0;
+  diagonal_[leaving_col] = new_diagonal;
+  DCHECK(IsAllZero(*row));
+
+  const Fractional expected_diagonal = old_diagonal * pivot;
+  return new_diagonal != 0.0 &&
+         std::abs(new_diagonal - expected_diagonal) <=
+             kUpdateAccuracyTolerance *
+                 std::max(Fractional(1.0), std::abs(expected_diagonal));
+}
+
+void ForrestTomlinFactorization::ApplyRowEtas(
+    DenseColumn* x, std::vector<RowIndex>* non_zeros) const {
+  RETURN_IF_NULL(x);
+  const int num_etas = eta_row_.size();
+  for (int i = 0; i < num_etas; ++i) {
+    Fractional sum = 0.0;
+    for (int j = eta_start_[i]; j < eta_start_[i + 1]; ++j) {
+      sum += eta_entry_coefficient_[j] * (*x)[eta_entry_row_[j]];
+    }
+    if (sum == 0.0) continue;
+    const RowIndex row = eta_row_[i];
+    if ((*x)[row] == 0.0 && !non_zeros->empty()) non_zeros->push_back(row);
+    (*x)[row] -= sum;
+  }
+}
+
+void ForrestTomlinFactorization::ApplyTransposedRowEtas(
+    DenseRow* y, ColIndexVector* non_zeros) const {
+  RETURN_IF_NULL(y);
+  for (int i = eta_row_.size() - 1; i >= 0; --i) {
+    const Fractional value = (*y)[RowToColIndex(eta_row_[i])];
+    if (value == 0.0) continue;
+    for (int j = eta_start_[i]; j < eta_start_[i + 1]; ++j) {
+      const ColIndex col = RowToColIndex(eta_entry_row_[j]);
+      if ((*y)[col] == 0.0 && !non_zeros->empty()) non_zeros->push_back(col);
+      (*y)[col] -= eta_entry_coefficient_[j] * value;
+    }
+  }
+}
+
+void ForrestTomlinFactorization::RightSolve(
+    DenseColumn* x, std::vector<RowIndex>* non_zeros) const {
+  RETURN_IF_NULL(x);
+  const RowIndex num_rows = x->size();
+  DCHECK_EQ(ColToRowIndex(diagonal_.size()), num_rows);
+
+  // The input is indexed by the rows of V and the output by its columns, so we
+  // work on a copy of the input.
+  DCHECK(IsAllZero(column_scratchpad_));
+  x->swap(column_scratchpad_);
+  DenseColumn* const input = &column_scratchpad_;
+  const bool use_hyper_sparse =
+      non_zeros != nullptr && !non_zeros->empty() &&
+      non_zeros->size() < kHyperSparseRatio * num_rows.value();
+
+  std::vector<int>* const queue = &position_queue_;
+  const std::less<int> max_heap;
+  if (use_hyper_sparse) {
+    for (const auto& row : *non_zeros) {
+      const int position = row_position_[row];
+      if (is_queued_[position]) continue;
+      is_queued_[position] = true;
+      queue->push_back(position);
+    }
+    std::make_heap(queue->begin(), queue->end(), max_heap);
+    non_zeros->clear();
+  }
+  int position = pivot_row_.size();
+  while (true) {
+    if (use_hyper_sparse) {
+      if (queue->empty()) break;
+      std::pop_heap(queue->begin(), queue->end(), max_heap);
+      position = queue->back();
+      queue->pop_back();
+      is_queued_[position] = false;
+    } else {
+      if (position == 0) break;
+      --position;
+    }
+    const RowIndex pivot_row = pivot_row_[position];
+    const Fractional value = (*input)[pivot_row];
+    if (value == 0.0) continue;
+    (*input)[pivot_row] = 0.0;
+    const ColIndex col = pivot_col_[position];
+    const Fractional result = value / diagonal_[col];
+    (*x)[ColToRowIndex(col)] = result;
+    if (use_hyper_sparse) non_zeros->push_back(ColToRowIndex(col));
+    for (const ColumnEntry& e : columns_[col]) {
+      if (use_hyper_sparse && (*input)[e.row] == 0.0) {
+        const int target_position = row_position_[e.row];
+        if (!is_queued_[target_position]) {
+          is_queued_[target_position] = true;
+          queue->push_back(target_position);
+          std::push_heap(queue->begin(), queue->end(), max_heap);
+        }
+      }
+      (*input)[e.row] -= e.coefficient * result;
+    }
+  }
+  if (!use_hyper_sparse && non_zeros != nullptr) {
+    ComputeNonZeros(*x, non_zeros);
+  }
+}
+
+void ForrestTomlinFactorization::LeftSolve(DenseRow* y,
+                                           ColIndexVector* non_zeros) const {
+  RETURN_IF_NULL(y);
+  const ColIndex num_cols = y->size();
+  DCHECK_EQ(diagonal_.size(), num_cols);
+
+  // Same algorithm as RightSolve() but with the rows of V, and by increasing
+  // position in the pivot sequence.
+  DCHECK(IsAllZero(row_scratchpad_));
+  y->swap(row_scratchpad_);
+  DenseRow* const input = &row_scratchpad_;
+  const bool use_hyper_sparse =
+      non_zeros != nullptr && !non_zeros->empty() &&
+      non_zeros->size() < kHyperSparseRatio * num_cols.value();
+  std::vector<int>* const queue = &position_queue_;
+  const std::greater<int> min_heap;
+  if (use_hyper_sparse) {
+    for (const auto& col : *non_zeros) {
+      const int position = col_position_[col];
+      if (is_queued_[position]) continue;
+      is_queued_[position] = true;
+      queue->push_back(position);
+    }
+    std::make_heap(queue->begin(), queue->end(), min_heap);
+    non_zeros->clear();
+  }
+  const int num_positions = pivot_col_.size();
+  int position = -1;
+  while (true) {
+    if (use_hyper_sparse) {
+      if (queue->empty()) break;
+      std::pop_heap(queue->begin(), queue->end(), min_heap);
+      position = queue->back();
+      queue->pop_back();
+      is_queued_[position] = false;
+    } else {
+      ++position;
+      if (position == num_positions) break;
+    }
+    const ColIndex pivot_col = pivot_col_[position];
+    const Fractional value = (*input)[pivot_col];
+    if (value == 0.0) continue;
+    (*input)[pivot_col] = 0.0;
+    const RowIndex row = pivot_row_[position];
+    const Fractional result = value / diagonal_[pivot_col];
+    (*y)[RowToColIndex(row)] = result;
+    if (use_hyper_sparse) non_zeros->push_back(RowToColIndex(row));
+    for (const RowEntry& e : rows_[row]) {
+      if (use_hyper_sparse && (*input)[e.col] == 0.0) {
+        const int target_position = col_position_[e.col];
+        if (!is_queued_[target_position]) {
+          is_queued_[target_position] = true;
+          queue->push_back(target_position);
+          std::push_heap(queue->begin(), queue->end(), min_heap);
+        }
+      }
+      (*input)[e.col] -= e.coefficient * result;
+    }
+  }
+  if (!use_hyper_sparse && non_zeros != nullptr) {
+    ComputeNonZeros(*y, non_zeros);
+  }
+}
+
+EntryIndex ForrestTomlinFactorization::num_entries() const {
+  return num_entries_ + EntryIndex(eta_entry_row_.size());
+}
+
 // --------------------------------------------------------
 // BasisFactorization
 // --------------------------------------------------------
@@ -182,6 +551,7 @@ BasisFactorization::BasisFactorization(const MatrixView& matrix,
       matrix_(matrix),
       basis_(basis),
       tau_is_computed_(false),
+      forrest_tomlin_initial_num_entries_(0),
       max_num_updates_(0),
       num_updates_(0),
       eta_factorization_(),
@@ -199,6 +569,7 @@ void BasisFactorization::Clear() {
   eta_factorization_.Clear();
   lu_factorization_.Clear();
   rank_one_factorization_.Clear();
+  forrest_tomlin_factorization_.Clear();
   storage_.Reset(matrix_.num_rows());
   right_storage_.Reset(matrix_.num_rows());
   left_pool_mapping_.assign(matrix_.num_cols(), kInvalidCol);
@@ -285,13 +656,52 @@ Status BasisFactorization::MiddleProductFormUpdate(
   return Status::OK;
 }
 
+bool BasisFactorization::ForrestTomlinUpdate(ColIndex entering_col,
+                                             RowIndex leaving_variable_row,
+                                             Fractional pivot) {
+  // V = U.Q is only copied at the first update because the column permutation
+  // is changed by the client just after a refactorization.
+  if (IsRefactorized()) {
+    forrest_tomlin_factorization_.Initialize(lu_factorization_,
+                                             matrix_.num_rows());
+    forrest_tomlin_initial_num_entries_ =
+        forrest_tomlin_factorization_.num_entries();
+  }
+
+  // The spike is the entering column after the L and row-eta solves.
+  ClearAndResizeVectorWithNonZeros(matrix_.num_rows(), &scratchpad_,
+                                   &scratchpad_non_zeros_);
+  lu_factorization_.RightSolveLForSparseColumn(
+      matrix_.column(entering_col), &scratchpad_, &scratchpad_non_zeros_);
+  forrest_tomlin_factorization_.ApplyRowEtas(&scratchpad_,
+                                             &scratchpad_non_zeros_);
+  if (!forrest_tomlin_factorization_.Update(
+          RowToColIndex(leaving_variable_row), pivot, &scratchpad_,
+          &scratchpad_non_zeros_)) {
+    VLOG(1) << "Inaccurate Forrest-Tomlin update.";
+    return false;
+  }
+
+  // Even if V stays sparse, the row-eta matrices accumulate. It is faster to
+  // refactorize than to keep solving with a factor that became too dense.
+  const double kMaxFillInGrowth = 2.0;
+  return forrest_tomlin_factorization_.num_entries().value() <=
+         kMaxFillInGrowth * forrest_tomlin_initial_num_entries_.value() +
+             matrix_.num_rows().value();
+}
+
 Status BasisFactorization::Update(ColIndex entering_col,
                                   RowIndex leaving_variable_row,
                                   const std::vector<RowIndex>& eta_non_zeros,
                                   DenseColumn* dense_eta) {
   if (num_updates_ < max_num_updates_) {
     SCOPED_TIME_STAT(&stats_);
-    if (use_middle_product_form_update_) {
+    if (use_forrest_tomlin_update_) {
+      if (!ForrestTomlinUpdate(entering_col, leaving_variable_row,
+                               (*dense_eta)[leaving_variable_row])) {
+        return ForceRefactorization();
+      }
+    } else if (use_middle_product_form_update_) {
       RETURN_IF_ERROR(
           MiddleProductFormUpdate(entering_col, leaving_variable_row));
     } else {
@@ -309,7 +719,10 @@ void BasisFactorization::LeftSolve(DenseRow* y) const {
   SCOPED_TIME_STAT(&stats_);
   RETURN_IF_NULL(y);
   BumpDeterministicTimeForSolve(matrix_.num_rows().value());
-  if (use_middle_product_form_update_) {
+  if (use_forrest_tomlin_update_) {
+    ForrestTomlinLeftSolveU(y, nullptr);
+    lu_factorization_.LeftSolveL(y);
+  } else if (use_middle_product_form_update_) {
     lu_factorization_.LeftSolveU(y);
     rank_one_factorization_.LeftSolve(y);
     lu_factorization_.LeftSolveL(y);
@@ -324,7 +737,11 @@ void BasisFactorization::LeftSolveWithNonZeros(
   SCOPED_TIME_STAT(&stats_);
   RETURN_IF_NULL(y);
   BumpDeterministicTimeForSolve(matrix_.num_rows().value());
-  if (use_middle_product_form_update_) {
+  if (use_forrest_tomlin_update_) {
+    non_zeros->clear();
+    ForrestTomlinLeftSolveU(y, non_zeros);
+    lu_factorization_.LeftSolveLWithNonZeros(y, non_zeros, nullptr);
+  } else if (use_middle_product_form_update_) {
     lu_factorization_.LeftSolveUWithNonZeros(y, non_zeros);
     rank_one_factorization_.LeftSolveWithNonZeros(y, non_zeros);
     lu_factorization_.LeftSolveLWithNonZeros(y, non_zeros, nullptr);
@@ -339,7 +756,10 @@ void BasisFactorization::RightSolve(DenseColumn* d) const {
   SCOPED_TIME_STAT(&stats_);
   RETURN_IF_NULL(d);
   BumpDeterministicTimeForSolve(matrix_.num_rows().value());
-  if (use_middle_product_form_update_) {
+  if (use_forrest_tomlin_update_) {
+    lu_factorization_.RightSolveL(d);
+    ForrestTomlinRightSolveU(d, nullptr);
+  } else if (use_middle_product_form_update_) {
     lu_factorization_.RightSolveL(d);
     rank_one_factorization_.RightSolve(d);
     lu_factorization_.RightSolveU(d);
@@ -354,7 +774,11 @@ void BasisFactorization::RightSolveWithNonZeros(
   SCOPED_TIME_STAT(&stats_);
   RETURN_IF_NULL(d);
   BumpDeterministicTimeForSolve(non_zeros->size());
-  if (use_middle_product_form_update_) {
+  if (use_forrest_tomlin_update_) {
+    lu_factorization_.RightSolveL(d);
+    non_zeros->clear();
+    ForrestTomlinRightSolveU(d, non_zeros);
+  } else if (use_middle_product_form_update_) {
     lu_factorization_.RightSolveL(d);
     rank_one_factorization_.RightSolve(d);
 
@@ -375,7 +799,12 @@ DenseColumn* BasisFactorization::RightSolveForTau(ScatteredColumnReference a)
     const {
   SCOPED_TIME_STAT(&stats_);
   BumpDeterministicTimeForSolve(matrix_.num_rows().value());
-  if (use_middle_product_form_update_) {
+  if (use_forrest_tomlin_update_) {
+    tau_ = a.dense_column;
+    lu_factorization_.RightSolveL(&tau_);
+    tau_non_zeros_.clear();
+    ForrestTomlinRightSolveU(&tau_, &tau_non_zeros_);
+  } else if (use_middle_product_form_update_) {
     if (tau_computation_can_be_optimized_) {
       // Once used, the intermediate result is overriden, so RightSolveForTau()
       // can no longer use the optimized algorithm.
@@ -413,6 +842,14 @@ void BasisFactorization::LeftSolveForUnitRow(ColIndex j, DenseRow* y,
   ClearAndResizeVectorWithNonZeros(RowToColIndex(matrix_.num_rows()), y,
                                    non_zeros);
 
+  if (use_forrest_tomlin_update_) {
+    (*y)[j] = 1.0;
+    non_zeros->push_back(j);
+    ForrestTomlinLeftSolveU(y, non_zeros);
+    lu_factorization_.LeftSolveLWithNonZeros(y, non_zeros, nullptr);
+    return;
+  }
+
   if (!use_middle_product_form_update_) {
     (*y)[j] = 1.0;
     non_zeros->push_back(j);
@@ -462,6 +899,14 @@ void BasisFactorization::RightSolveForProblemColumn(
   SCOPED_TIME_STAT(&stats_);
   RETURN_IF_NULL(d);
   BumpDeterministicTimeForSolve(matrix_.column(col).num_entries().value());
+  if (use_forrest_tomlin_update_) {
+    ClearAndResizeVectorWithNonZeros(matrix_.num_rows(), d, non_zeros);
+    lu_factorization_.RightSolveLForSparseColumn(matrix_.column(col), d,
+                                                 non_zeros);
+    ForrestTomlinRightSolveU(d, non_zeros);
+    return;
+  }
+
   if (!use_middle_product_form_update_) {
     lu_factorization_.SparseRightSolve(matrix_.column(col), matrix_.num_rows(),
                                        d);
@@ -488,6 +933,44 @@ void BasisFactorization::RightSolveForProblemColumn(
   lu_factorization_.RightSolveUWithNonZeros(d, non_zeros);
 }
 
+void BasisFactorization::ForrestTomlinRightSolveU(
+    DenseColumn* d, std::vector<RowIndex>* non_zeros) const {
+  if (IsRefactorized()) {
+    if (non_zeros == nullptr) {
+      lu_factorization_.RightSolveU(d);
+    } else {
+      lu_factorization_.RightSolveUWithNonZeros(d, non_zeros);
+    }
+    return;
+  }
+  if (non_zeros != nullptr) {
+    forrest_tomlin_factorization_.ApplyRowEtas(d, non_zeros);
+  } else {
+    std::vector<RowIndex> unused_non_zeros;
+    forrest_tomlin_factorization_.ApplyRowEtas(d, &unused_non_zeros);
+  }
+  forrest_tomlin_factorization_.RightSolve(d, non_zeros);
+}
+
+void BasisFactorization::ForrestTomlinLeftSolveU(
+    DenseRow* y, ColIndexVector* non_zeros) const {
+  if (IsRefactorized()) {
+    if (non_zeros == nullptr) {
+      lu_factorization_.LeftSolveU(y);
+    } else {
+      lu_factorization_.LeftSolveUWithNonZeros(y, non_zeros);
+    }
+    return;
+  }
+  forrest_tomlin_factorization_.LeftSolve(y, non_zeros);
+  if (non_zeros != nullptr) {
+    forrest_tomlin_factorization_.ApplyTransposedRowEtas(y, non_zeros);
+  } else {
+    ColIndexVector unused_non_zeros;
+    forrest_tomlin_factorization_.ApplyTransposedRowEtas(y, &unused_non_zeros);
+  }
+}
+
 Fractional BasisFactorization::RightSolveSquaredNorm(const SparseColumn& a)
     const {
   SCOPED_TIME_STAT(&stats_);
@@ -599,7 +1082,8 @@ void BasisFactorization::BumpDeterministicTimeForSolve(int num_entries) const {
       (1.0 + density) * DeterministicTimeForFpOperations(
                             lu_factorization_.NumberOfEntries().value()) +
       DeterministicTimeForFpOperations(
-          rank_one_factorization_.num_entries().value());
+          rank_one_factorization_.num_entries().value() +
+          forrest_tomlin_factorization_.num_entries().value());
 }
 
 }  // namespace glop
@@ -137,8 +137,127 @@ class EtaFactorization {
   DISALLOW_COPY_AND_ASSIGN(EtaFactorization);
 };
 
+// The Forrest-Tomlin update of a LU factorization. If the basis was factorized
+// as B = P^{-1}.L.U.Q, this class keeps a modifiable copy of V = U.Q. V is a
+// "permuted upper triangular" matrix: there is an ordering of its rows and
+// columns (the pivot sequence) for which it is upper triangular.
+//
+// Replacing the leaving column of B by the entering column only changes one
+// column of V. The update moves this column and its pivot row to the end of the
+// pivot sequence, and eliminates the entries of the pivot row that are now
+// below the diagonal with a row-eta matrix R. After k updates, we have:
+//   B = P^{-1}.L.R_1^{-1}. ... .R_k^{-1}.V_k
+//
+// Contrary to the eta or middle product form updates, V is modified in place.
+// Its sparsity is thus preserved and the solves stay cheap for longer.
+//
+// Reference: J. J. H. Forrest, J. A. Tomlin, "Updated triangular factors of the
+// basis to maintain sparsity in the product form simplex method", Mathematical
+// Programming 2 (1972), pp. 263-278.
+class ForrestTomlinFactorization {
+ public:
+  ForrestTomlinFactorization();
+  virtual ~ForrestTomlinFactorization();
+
+  // Deletes V and all the row-eta matrices.
+  void Clear();
+
+  // Initializes V with the U.Q factor of the given factorization. This must be
+  // called after the column permutation Q is in its final state.
+  void Initialize(const LuFactorization& lu_factorization, RowIndex num_rows);
+
+  // Replaces the column 'leaving_col' of V by the given spike and restores the
+  // permuted triangular structure. The spike must be the entering column of B
+  // after the L and row-eta solves, i.e. R_k. ... .R_1.L^{-1}.P.a. Both 'spike'
+  // and 'non_zeros' are consumed: they are left all zero and empty. If
+  // 'non_zeros' is initially empty, the spike is scanned densely.
+  //
+  // 'pivot' is the simplex pivot, i.e. the coefficient at position leaving_col
+  // of B^{-1}.a. Since the new diagonal coefficient is mathematically equal to
+  // the old one times 'pivot', this is used to check the accuracy of the
+  // update. If false is returned, the update was not accurate enough and this
+  // class must be re-initialized from a new factorization.
+  bool Update(ColIndex leaving_col, Fractional pivot, DenseColumn* spike,
+              std::vector<RowIndex>* non_zeros) MUST_USE_RESULT;
+
+  // Computes x = R_k. ... .R_1.x. If 'non_zeros' is not empty, it is assumed
+  // to contain the non-zero positions of x and is kept up to date.
+  void ApplyRowEtas(DenseColumn* x, std::vector<RowIndex>* non_zeros) const;
+
+  // Computes y = y.R_k. ... .R_1 with the same convention as ApplyRowEtas().
+  void ApplyTransposedRowEtas(DenseRow* y, ColIndexVector* non_zeros) const;
+
+  // Solves V.x = b and y.V = c, where b (resp. c) is the initial value of x
+  // (resp. y). If 'non_zeros' is non-null and contains the non-zero positions
+  // of the input, a hyper-sparse solve may be used. In any case, if it is
+  // non-null it is filled with the non-zero positions of the result.
+  void RightSolve(DenseColumn* x, std::vector<RowIndex>* non_zeros) const;
+  void LeftSolve(DenseRow* y, ColIndexVector* non_zeros) const;
+
+  // Returns the number of entries in V plus the number of entries of all the
+  // row-eta matrices.
+  EntryIndex num_entries() const;
+
+ private:
+  struct ColumnEntry {
+    ColumnEntry(RowIndex r, Fractional c) : row(r), coefficient(c) {}
+    RowIndex row;
+    Fractional coefficient;
+  };
+  struct RowEntry {
+    RowEntry(ColIndex c, Fractional v) : col(c), coefficient(v) {}
+    ColIndex col;
+    Fractional coefficient;
+  };
+
+  // Adds a non-diagonal entry to V, or removes the one at position (row, col).
+  void AddEntry(RowIndex row, ColIndex col, Fractional coefficient);
+  void RemoveEntryFromRow(RowIndex row, ColIndex col);
+  void RemoveEntryFromColumn(RowIndex row, ColIndex col);
+
+  // Uses a hyper-sparse solve only if there is less than this ratio of
+  // non-zeros in the input.
+  static const double kHyperSparseRatio;
+
+  // Maximum relative difference between the new diagonal coefficient computed
+  // by Update() and its theoretical value.
+  static const Fractional kUpdateAccuracyTolerance;
+
+  // The pivot sequence: V[pivot_row_[i], pivot_col_[i]] is the i-th diagonal
+  // coefficient, and the position of a row or column in it.
+  std::vector<RowIndex> pivot_row_;
+  std::vector<ColIndex> pivot_col_;
+  StrictITIVector<RowIndex, int> row_position_;
+  StrictITIVector<ColIndex, int> col_position_;
+
+  // The non-diagonal entries of V are stored both column-wise and row-wise.
+  // The diagonal coefficients are indexed by column.
+  DenseRow diagonal_;
+  StrictITIVector<ColIndex, std::vector<ColumnEntry>> columns_;
+  StrictITIVector<RowIndex, std::vector<RowEntry>> rows_;
+  EntryIndex num_entries_;
+
+  // The row-eta matrices R_i = I - e_{eta_row_[i]}.Tr(m_i). The entries of m_i
+  // are stored in eta_entry_*_ between eta_start_[i] and eta_start_[i + 1].
+  std::vector<RowIndex> eta_row_;
+  std::vector<int> eta_start_;
+  std::vector<RowIndex> eta_entry_row_;
+  std::vector<Fractional> eta_entry_coefficient_;
+
+  // Scratchpads used by the solves and by Update(). They are always all zero
+  // (or all false) between two calls.
+  mutable DenseColumn column_scratchpad_;
+  mutable DenseRow row_scratchpad_;
+  mutable std::vector<bool> is_queued_;
+  mutable std::vector<int> position_queue_;
+
+  DISALLOW_COPY_AND_ASSIGN(ForrestTomlinFactorization);
+};
+
 // A basis factorization is the product of an eta factorization and
 // a L.U decomposition, i.e. B = L.U.E_0.E_1. ... .E_{k-1}
+// Depending on the parameters, the updates can also be done with the middle
+// product form update or with the Forrest-Tomlin update (see above).
 // It is used to solve two systems:
 //   - B.d = a where a is the entering column.
 //   - y.B = c where c is the objective row.
@@ -153,8 +272,10 @@ class BasisFactorization {
   // Sets the parameters for this component.
   void SetParameters(const GlopParameters& parameters) {
     max_num_updates_ = parameters.basis_refactorization_period();
+    use_forrest_tomlin_update_ = parameters.use_forrest_tomlin_update();
     use_middle_product_form_update_ =
-        parameters.use_middle_product_form_update();
+        parameters.use_middle_product_form_update() &&
+        !use_forrest_tomlin_update_;
     parameters_ = parameters;
     lu_factorization_.SetParameters(parameters);
   }
@@ -290,6 +411,22 @@ class BasisFactorization {
   Status MiddleProductFormUpdate(ColIndex entering_col,
                                  RowIndex leaving_variable_row) MUST_USE_RESULT;
 
+  // Updates the factorization using the Forrest-Tomlin update. 'pivot' is the
+  // coefficient of B^{-1}.matrix_.column(entering_col) on the leaving row.
+  // Returns false if the update is not accurate enough or if the updated
+  // factor became too dense, in which case the basis must be refactorized.
+  bool ForrestTomlinUpdate(ColIndex entering_col, RowIndex leaving_variable_row,
+                           Fractional pivot) MUST_USE_RESULT;
+
+  // Parts of the solves specific to the Forrest-Tomlin update: they replace the
+  // solves with U (i.e. U.Q) of the LU factorization. They just use the latter
+  // if there was no update since the last refactorization. 'non_zeros' can be
+  // null, otherwise it follows the convention of the ForrestTomlinFactorization
+  // solves.
+  void ForrestTomlinRightSolveU(DenseColumn* d,
+                                std::vector<RowIndex>* non_zeros) const;
+  void ForrestTomlinLeftSolveU(DenseRow* y, ColIndexVector* non_zeros) const;
+
   // Increases the deterministic time for a solve operation with a vector having
   // this number of non-zero entries (it can be an approximation).
   void BumpDeterministicTimeForSolve(int num_entries) const;
@@ -351,7 +488,13 @@ class BasisFactorization {
   mutable ColMapping left_pool_mapping_;
   mutable ColMapping right_pool_mapping_;
 
+  // The Forrest-Tomlin update of U and the number of entries of the factor just
+  // after the last refactorization (used to detect a too large fill-in).
+  ForrestTomlinFactorization forrest_tomlin_factorization_;
+  EntryIndex forrest_tomlin_initial_num_entries_;
+
   bool use_middle_product_form_update_;
+  bool use_forrest_tomlin_update_;
   int max_num_updates_;
   int num_updates_;
   EtaFactorization eta_factorization_;
@@ -0,0 +1,681 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "glop/branch_and_bound.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/logging.h"
+#include "glop/status.h"
+
+namespace operations_research {
+namespace glop {
+
+namespace {
+
+// Once a solution is known, a dive is abandoned when the bound of the current
+// node is past this fraction of the gap between the best open node bound and
+// the pruning threshold.
+const Fractional kMaxDiveGapFraction = 0.5;
+
+// Minimum degradation used in the product score of a branching candidate, so
+// that a direction without degradation does not hide the other one.
+const Fractional kMinDegradation = 1e-6;
+
+// Maximum number of passes over the constraints of the root bound propagation.
+const int kMaxNumPropagationPasses = 10;
+
+bool IsInfeasibleStatus(ProblemStatus status) {
+  return status == ProblemStatus::PRIMAL_INFEASIBLE ||
+         status == ProblemStatus::DUAL_UNBOUNDED;
+}
+
+}  // namespace
+
+BranchAndBound::BranchAndBound()
+    : parameters_(),
+      node_parameters_(),
+      strong_branching_parameters_(),
+      simplex_(),
+      lp_(),
+      root_lower_bounds_(),
+      root_upper_bounds_(),
+      num_structural_cols_(0),
+      integer_cols_(),
+      objective_sign_(1.0),
+      applied_changes_(),
+      heap_(),
+      depth_first_stack_(),
+      pool_memory_(0),
+      pool_is_full_(false),
+      pseudo_costs_(),
+      average_pseudo_cost_(),
+      solution_hint_(),
+      best_solution_(),
+      has_solution_(false),
+      objective_value_(0.0),
+      best_bound_(0.0),
+      pruned_bound_(kInfinity),
+      num_nodes_(0),
+      num_simplex_iterations_(0) {
+  SetParameters(parameters_);
+}
+
+BranchAndBound::~BranchAndBound() {}
+
+void BranchAndBound::SetParameters(const GlopParameters& parameters) {
+  parameters_ = parameters;
+  node_parameters_ = parameters;
+  node_parameters_.set_use_dual_simplex(true);
+  node_parameters_.set_allow_simplex_algorithm_change(false);
+  strong_branching_parameters_ = node_parameters_;
+  strong_branching_parameters_.set_max_number_of_iterations(
+      parameters.mip_strong_branching_max_iterations());
+}
+
+ProblemStatus BranchAndBound::Solve(const LinearProgram& lp) {
+  std::unique_ptr<TimeLimit> time_limit =
+      TimeLimit::FromParameters(parameters_);
+  return SolveWithTimeLimit(lp, time_limit.get());
+}
+
+ProblemStatus BranchAndBound::SolveWithTimeLimit(const LinearProgram& lp,
+                                                 TimeLimit* time_limit) {
+  heap_.clear();
+  depth_first_stack_.clear();
+  applied_changes_.clear();
+  pool_memory_ = 0;
+  pool_is_full_ = false;
+  has_solution_ = false;
+  pruned_bound_ = kInfinity;
+  num_nodes_ = 0;
+  num_simplex_iterations_ = 0;
+  objective_sign_ = lp.IsMaximizationProblem() ? -1.0 : 1.0;
+  objective_value_ = objective_sign_ * kInfinity;
+  best_bound_ = -objective_sign_ * kInfinity;
+  num_structural_cols_ = lp.num_variables();
+  best_solution_.assign(num_structural_cols_, 0.0);
+  pseudo_costs_.assign(num_structural_cols_, PseudoCost());
+  average_pseudo_cost_ = PseudoCost();
+
+  // Copy the problem, round the bounds of the integer variables and put it in
+  // the equation form expected by the RevisedSimplex.
+  const Fractional tolerance = parameters_.mip_integrality_tolerance();
+  lp_.PopulateFromLinearProgram(lp);
+  integer_cols_.clear();
+  for (ColIndex col(0); col < num_structural_cols_; ++col) {
+    if (!lp.is_variable_integer()[col]) continue;
+    integer_cols_.push_back(col);
+    const Fractional lower_bound =
+        std::ceil(lp.variable_lower_bounds()[col] - tolerance);
+    const Fractional upper_bound =
+        std::floor(lp.variable_upper_bounds()[col] + tolerance);
+    if (lower_bound > upper_bound) {
+      best_bound_ = objective_sign_ * kInfinity;
+      return ProblemStatus::PRIMAL_INFEASIBLE;
+    }
+    lp_.SetVariableBounds(col, lower_bound, upper_bound);
+  }
+  if (parameters_.use_preprocessing() && !PropagateRootBounds()) {
+    best_bound_ = objective_sign_ * kInfinity;
+    return ProblemStatus::PRIMAL_INFEASIBLE;
+  }
+  if (solution_hint_.size() == num_structural_cols_) {
+    if (IsFeasibleSolution(lp, solution_hint_,
+                           parameters_.primal_feasibility_tolerance())) {
+      RecordSolution(lp, solution_hint_);
+    } else {
+      VLOG(1) << "The solution hint is not feasible, it is ignored.";
+    }
+  }
+  lp_.AddSlackVariablesForAllRows(/*detect_integer_constraints=*/false);
+  root_lower_bounds_ = lp_.variable_lower_bounds();
+  root_upper_bounds_ = lp_.variable_upper_bounds();
+  simplex_.ClearStateForNextSolve();
+
+  const int64 max_num_nodes = parameters_.mip_max_number_of_nodes();
+  DenseRow values(num_structural_cols_, 0.0);
+  std::vector<ColIndex> candidates;
+  bool is_root = true;
+  bool search_is_incomplete = false;
+  bool limit_reached = false;
+  std::unique_ptr<Node> node(new Node());
+  while (node != nullptr) {
+    if (time_limit->LimitReached() ||
+        (max_num_nodes >= 0 && num_nodes_ >= max_num_nodes)) {
+      limit_reached = true;
+      break;
+    }
+    if (node->bound >= PruningThreshold()) {
+      pruned_bound_ = std::min(pruned_bound_, node->bound);
+      node = PopOpenNode();
+      continue;
+    }
+
+    // Nodes coming from the pool are warm-started from the basis of their
+    // parent. When diving, the parent basis is already the current one.
+    SetNodeBounds(*node);
+    if (!node->parent_basis.IsEmpty()) {
+      simplex_.LoadStateForNextSolve(node->parent_basis);
+    }
+    const GlopParameters& parameters =
+        is_root ? parameters_ : node_parameters_;
+    ProblemStatus status = SolveRelaxation(parameters, time_limit);
+    if (status != ProblemStatus::OPTIMAL && !IsInfeasibleStatus(status) &&
+        !simplex_.objective_limit_reached() && !is_root &&
+        !time_limit->LimitReached()) {
+      // Numerical trouble with the warm-start, retry from scratch.
+      VLOG(1) << "Node status " << GetProblemStatusString(status)
+              << ", solving it again from scratch.";
+      simplex_.ClearStateForNextSolve();
+      status = SolveRelaxation(parameters, time_limit);
+    }
+    ++num_nodes_;
+
+    if (IsInfeasibleStatus(status)) {
+      node = PopOpenNode();
+      continue;
+    }
+    if (simplex_.objective_limit_reached()) {
+      pruned_bound_ = std::min(pruned_bound_, PruningThreshold());
+      node = PopOpenNode();
+      continue;
+    }
+    if (status != ProblemStatus::OPTIMAL) {
+      if (time_limit->LimitReached()) {
+        limit_reached = true;
+        break;
+      }
+      if (is_root) {
+        return status == ProblemStatus::PRIMAL_UNBOUNDED ||
+                       status == ProblemStatus::DUAL_INFEASIBLE
+                   ? ProblemStatus::PRIMAL_UNBOUNDED
+                   : status;
+      }
+      LOG(WARNING) << "Dropping a node with status "
+                   << GetProblemStatusString(status);
+      search_is_incomplete = true;
+      node = PopOpenNode();
+      continue;
+    }
+    is_root = false;
+
+    const Fractional objective = RelaxationObjective();
+    if (node->branching_col != kInvalidCol) {
+      UpdatePseudoCost(node->branching_col, node->branching_up,
+                       node->branching_distance, objective - node->bound);
+    }
+    if (objective >= PruningThreshold()) {
+      pruned_bound_ = std::min(pruned_bound_, objective);
+      node = PopOpenNode();
+      continue;
+    }
+
+    candidates.clear();
+    for (ColIndex col(0); col < num_structural_cols_; ++col) {
+      values[col] = simplex_.GetVariableValue(col);
+    }
+    for (const ColIndex col : integer_cols_) {
+      const Fractional fractionality = values[col] - std::floor(values[col]);
+      if (fractionality > tolerance && fractionality < 1.0 - tolerance) {
+        candidates.push_back(col);
+      }
+    }
+    if (candidates.empty()) {
+      if (!RecordSolution(lp, values)) {
+        // The node cannot be branched on, and its relaxation may still contain
+        // a solution, so the search can no longer prove anything.
+        LOG(WARNING) << "Dropping a node whose rounded solution is infeasible.";
+        search_is_incomplete = true;
+      }
+      node = PopOpenNode();
+      continue;
+    }
+
+    // Branch. One child is solved right away (dive) and the other one goes to
+    // the pool of open nodes.
+    const BasisState basis = simplex_.GetState();
+    bool up_first = false;
+    const ColIndex col = candidates[SelectBranchingCandidate(
+        candidates, values, basis, objective, time_limit, &up_first)];
+    const Fractional value = values[col];
+    std::unique_ptr<Node> children[2];
+    for (const bool up : {false, true}) {
+      std::unique_ptr<Node> child(new Node());
+      child->bound = objective;
+      child->depth = node->depth + 1;
+      child->bound_changes.reserve(node->bound_changes.size() + 1);
+      child->bound_changes = node->bound_changes;
+      child->bound_changes.push_back(
+          {col, up ? std::ceil(value) : lp_.variable_lower_bounds()[col],
+           up ? lp_.variable_upper_bounds()[col] : std::floor(value)});
+      child->branching_col = col;
+      child->branching_up = up;
+      child->branching_distance =
+          up ? std::ceil(value) - value : value - std::floor(value);
+      children[up] = std::move(child);
+    }
+    children[!up_first]->parent_basis = basis;
+    AddOpenNode(std::move(children[!up_first]));
+    node = std::move(children[up_first]);
+
+    // Stop the dive if the node is too far from the best bound.
+    if (has_solution_ && !pool_is_full_ && !heap_.empty()) {
+      const Fractional best_open_bound = heap_.front()->bound;
+      if (objective > best_open_bound + kMaxDiveGapFraction *
+                                            (PruningThreshold() -
+                                             best_open_bound)) {
+        node->parent_basis = basis;
+        AddOpenNode(std::move(node));
+        node = PopOpenNode();
+      }
+    }
+  }
+
+  // Compute the final status and bound.
+  Fractional bound = -kInfinity;
+  ProblemStatus status = ProblemStatus::INIT;
+  if (limit_reached || search_is_incomplete) {
+    if (has_solution_) status = ProblemStatus::PRIMAL_FEASIBLE;
+    if (!search_is_incomplete) {
+      bound = std::min(pruned_bound_,
+                       std::min(node->bound, BestOpenNodeBound()));
+    }
+  } else {
+    status = has_solution_ ? ProblemStatus::OPTIMAL
+                           : ProblemStatus::PRIMAL_INFEASIBLE;
+    bound = pruned_bound_;
+  }
+  if (has_solution_) {
+    bound = std::min(bound, objective_sign_ * objective_value_);
+  }
+  best_bound_ = objective_sign_ * bound;
+  VLOG(1) << "Branch and bound: " << GetProblemStatusString(status) << ", "
+          << num_nodes_ << " nodes, " << num_simplex_iterations_
+          << " simplex iterations, objective " << objective_value_
+          << ", bound " << best_bound_;
+  return status;
+}
+
+// static
+int64 BranchAndBound::NodeMemory(const Node& node) {
+  return sizeof(Node) +
+         node.bound_changes.capacity() * sizeof(BoundChange) +
+         node.parent_basis.statuses.size().value() * sizeof(VariableStatus);
+}
+
+// static
+bool BranchAndBound::HasWorseBound(const std::unique_ptr<Node>& a,
+                                   const std::unique_ptr<Node>& b) {
+  if (a->bound != b->bound) return a->bound > b->bound;
+  return a->depth < b->depth;
+}
+
+void BranchAndBound::SetNodeBounds(const Node& node) {
+  for (const BoundChange& change : applied_changes_) {
+    lp_.SetVariableBounds(change.col, root_lower_bounds_[change.col],
+                          root_upper_bounds_[change.col]);
+  }
+  for (const BoundChange& change : node.bound_changes) {
+    lp_.SetVariableBounds(change.col, change.lower_bound, change.upper_bound);
+  }
+  applied_changes_ = node.bound_changes;
+}
+
+ProblemStatus BranchAndBound::SolveRelaxation(const GlopParameters& parameters,
+                                              TimeLimit* time_limit) {
+  if (has_solution_) {
+    // Let the dual simplex stop as soon as the node can be pruned. Note that
+    // the limits are expressed for the original optimization direction.
+    GlopParameters parameters_with_limit = parameters;
+    if (objective_sign_ > 0.0) {
+      parameters_with_limit.set_objective_upper_limit(PruningThreshold());
+    } else {
+      parameters_with_limit.set_objective_lower_limit(-PruningThreshold());
+    }
+    simplex_.SetParameters(parameters_with_limit);
+  } else {
+    simplex_.SetParameters(parameters);
+  }
+  const Status status = simplex_.Solve(lp_, time_limit);
+  num_simplex_iterations_ += simplex_.GetNumberOfIterations();
+  if (!status.ok()) {
+    LOG(WARNING) << "Error while solving a node: " << status.error_message();
+    return ProblemStatus::ABNORMAL;
+  }
+  return simplex_.GetProblemStatus();
+}
+
+Fractional BranchAndBound::RelaxationObjective() const {
+  return objective_sign_ * simplex_.GetObjectiveValue();
+}
+
+int BranchAndBound::SelectBranchingCandidate(
+    const std::vector<ColIndex>& candidates, const DenseRow& values,
+    const BasisState& parent_basis, Fractional parent_objective,
+    TimeLimit* time_limit, bool* up_first) {
+  // Select the candidates whose pseudo-costs are not reliable yet, the most
+  // fractional ones first.
+  const int reliability_threshold = parameters_.mip_reliability_threshold();
+  std::vector<std::pair<Fractional, int>> unreliable;
+  for (int i = 0; i < candidates.size(); ++i) {
+    const PseudoCost& pseudo_cost = pseudo_costs_[candidates[i]];
+    if (std::min(pseudo_cost.down_count, pseudo_cost.up_count) <
+        reliability_threshold) {
+      const Fractional value = values[candidates[i]];
+      unreliable.push_back(
+          {std::abs(value - std::floor(value) - 0.5), i});
+    }
+  }
+  std::sort(unreliable.begin(), unreliable.end());
+  if (unreliable.size() >
+      parameters_.mip_max_num_strong_branching_candidates()) {
+    unreliable.resize(parameters_.mip_max_num_strong_branching_candidates());
+  }
+
+  // Strong branching: solve both children with a limited number of dual
+  // simplex iterations starting from the parent basis. A child that can be
+  // pruned makes its variable the best possible choice.
+  for (const std::pair<Fractional, int>& entry : unreliable) {
+    if (time_limit->LimitReached()) break;
+    const ColIndex col = candidates[entry.second];
+    const Fractional value = values[col];
+    const Fractional lower_bound = lp_.variable_lower_bounds()[col];
+    const Fractional upper_bound = lp_.variable_upper_bounds()[col];
+    bool prunable_child = false;
+    for (const bool up : {false, true}) {
+      lp_.SetVariableBounds(col, up ? std::ceil(value) : lower_bound,
+                            up ? upper_bound : std::floor(value));
+      simplex_.LoadStateForNextSolve(parent_basis);
+      const ProblemStatus status =
+          SolveRelaxation(strong_branching_parameters_, time_limit);
+      if (IsInfeasibleStatus(status) || simplex_.objective_limit_reached()) {
+        prunable_child = true;
+        *up_first = !up;
+        break;
+      }
+      if (status == ProblemStatus::OPTIMAL ||
+          status == ProblemStatus::DUAL_FEASIBLE) {
+        // Note that a DUAL_FEASIBLE status means the iteration limit was
+        // reached, the objective is then a valid but weaker bound.
+        UpdatePseudoCost(
+            col, up, up ? std::ceil(value) - value : value - std::floor(value),
+            RelaxationObjective() - parent_objective);
+      }
+    }
+    lp_.SetVariableBounds(col, lower_bound, upper_bound);
+    if (prunable_child) {
+      simplex_.LoadStateForNextSolve(parent_basis);
+      return entry.second;
+    }
+  }
+  if (!unreliable.empty()) simplex_.LoadStateForNextSolve(parent_basis);
+
+  // Product score of the estimated degradations in both directions.
+  int best_index = 0;
+  Fractional best_score = -1.0;
+  for (int i = 0; i < candidates.size(); ++i) {
+    const ColIndex col = candidates[i];
+    const Fractional fractionality = values[col] - std::floor(values[col]);
+    const Fractional down = fractionality * PseudoCostEstimate(col, false);
+    const Fractional up = (1.0 - fractionality) * PseudoCostEstimate(col, true);
+    const Fractional score =
+        std::max(down, kMinDegradation) * std::max(up, kMinDegradation);
+    if (score > best_score) {
+      best_score = score;
+      best_index = i;
+      *up_first = up < down;
+    }
+  }
+  return best_index;
+}
+
+void BranchAndBound::UpdatePseudoCost(ColIndex col, bool up,
+                                      Fractional distance,
+                                      Fractional degradation) {
+  if (distance <= 0.0) return;
+  const Fractional unit_degradation = std::max(0.0, degradation) / distance;
+  PseudoCost* const pseudo_cost = &pseudo_costs_[col];
+  if (up) {
+    pseudo_cost->up_sum += unit_degradation;
+    ++pseudo_cost->up_count;
+    average_pseudo_cost_.up_sum += unit_degradation;
+    ++average_pseudo_cost_.up_count;
+  } else {
+    pseudo_cost->down_sum += unit_degradation;
+    ++pseudo_cost->down_count;
+    average_pseudo_cost_.down_sum += unit_degradation;
+    ++average_pseudo_cost_.down_count;
+  }
+}
+
+Fractional BranchAndBound::PseudoCostEstimate(ColIndex col, bool up) const {
+  const PseudoCost& pseudo_cost = pseudo_costs_[col];
+  if (up) {
+    if (pseudo_cost.up_count > 0) {
+      return pseudo_cost.up_sum / pseudo_cost.up_count;
+    }
+    return average_pseudo_cost_.up_count > 0
+               ? average_pseudo_cost_.up_sum / average_pseudo_cost_.up_count
+               : 1.0;
+  }
+  if (pseudo_cost.down_count > 0) {
+    return pseudo_cost.down_sum / pseudo_cost.down_count;
+  }
+  return average_pseudo_cost_.down_count > 0
+             ? average_pseudo_cost_.down_sum / average_pseudo_cost_.down_count
+             : 1.0;
+}
+
+bool BranchAndBound::PropagateRootBounds() {
+  const Fractional tolerance = parameters_.mip_integrality_tolerance();
+  const SparseMatrix& transpose = lp_.GetTransposeSparseMatrix();
+  const DenseRow& lower_bounds = lp_.variable_lower_bounds();
+  const DenseRow& upper_bounds = lp_.variable_upper_bounds();
+  for (int pass = 0; pass < kMaxNumPropagationPasses; ++pass) {
+    bool bounds_changed = false;
+    for (RowIndex row(0); row < lp_.num_constraints(); ++row) {
+      const SparseColumn& terms = transpose.column(RowToColIndex(row));
+
+      // The finite part of the minimum and maximum activities of the row, and
+      // the number of its infinite terms.
+      Fractional min_activity = 0.0;
+      Fractional max_activity = 0.0;
+      int num_infinite_min_terms = 0;
+      int num_infinite_max_terms = 0;
+      for (const SparseColumn::Entry e : terms) {
+        const ColIndex col = RowToColIndex(e.row());
+        const Fractional coeff = e.coefficient();
+        const Fractional min_value =
+            coeff > 0.0 ? lower_bounds[col] : upper_bounds[col];
+        const Fractional max_value =
+            coeff > 0.0 ? upper_bounds[col] : lower_bounds[col];
+        if (IsFinite(min_value)) {
+          min_activity += coeff * min_value;
+        } else {
+          ++num_infinite_min_terms;
+        }
+        if (IsFinite(max_value)) {
+          max_activity += coeff * max_value;
+        } else {
+          ++num_infinite_max_terms;
+        }
+      }
+
+      // Bound coeff * x by the row bounds minus the activity bounds of the
+      // other terms. A column appears once in a row, so its bounds did not
+      // change since they were used in the activities above.
+      const Fractional row_lower_bound = lp_.constraint_lower_bounds()[row];
+      const Fractional row_upper_bound = lp_.constraint_upper_bounds()[row];
+      for (const SparseColumn::Entry e : terms) {
+        const ColIndex col = RowToColIndex(e.row());
+        if (!lp_.is_variable_integer()[col]) continue;
+        const Fractional coeff = e.coefficient();
+        Fractional lower_bound = lower_bounds[col];
+        Fractional upper_bound = upper_bounds[col];
+        const Fractional min_value = coeff > 0.0 ? lower_bound : upper_bound;
+        const Fractional max_value = coeff > 0.0 ? upper_bound : lower_bound;
+        const bool min_is_finite = IsFinite(min_value);
+        const bool max_is_finite = IsFinite(max_value);
+        if (IsFinite(row_upper_bound) &&
+            num_infinite_min_terms == (min_is_finite ? 0 : 1)) {
+          const Fractional other_min_activity =
+              min_is_finite ? min_activity - coeff * min_value : min_activity;
+          const Fractional limit =
+              (row_upper_bound - other_min_activity) / coeff;
+          if (coeff > 0.0) {
+            upper_bound = std::min(upper_bound, std::floor(limit + tolerance));
+          } else {
+            lower_bound = std::max(lower_bound, std::ceil(limit - tolerance));
+          }
+        }
+        if (IsFinite(row_lower_bound) &&
+            num_infinite_max_terms == (max_is_finite ? 0 : 1)) {
+          const Fractional other_max_activity =
+              max_is_finite ? max_activity - coeff * max_value : max_activity;
+          const Fractional limit =
+              (row_lower_bound - other_max_activity) / coeff;
+          if (coeff > 0.0) {
+            lower_bound = std::max(lower_bound, std::ceil(limit - tolerance));
+          } else {
+            upper_bound = std::min(upper_bound, std::floor(limit + tolerance));
+          }
+        }
+        if (lower_bound > upper_bound) return false;
+        if (lower_bound != lower_bounds[col] ||
+            upper_bound != upper_bounds[col]) {
+          lp_.SetVariableBounds(col, lower_bound, upper_bound);
+          bounds_changed = true;
+        }
+      }
+    }
+    if (!bounds_changed) break;
+  }
+  return true;
+}
+
+bool BranchAndBound::RecordSolution(const LinearProgram& lp,
+                                    const DenseRow& values) {
+  Fractional sum = 0.0;
+  DenseRow solution(num_structural_cols_, 0.0);
+  for (ColIndex col(0); col < num_structural_cols_; ++col) {
+    solution[col] = lp_.is_variable_integer()[col] ? std::round(values[col])
+                                                   : values[col];
+    sum += solution[col] * lp_.objective_coefficients()[col];
+  }
+  const Fractional objective = lp_.ApplyObjectiveScalingAndOffset(sum);
+  if (has_solution_ && objective_sign_ * objective >=
+                           objective_sign_ * objective_value_) {
+    return true;
+  }
+  if (!IsFeasibleSolution(lp, solution,
+                          parameters_.mip_integrality_tolerance())) {
+    VLOG(1) << "Rejected a rounded solution with objective " << objective
+            << ": it is not feasible.";
+    return false;
+  }
+  has_solution_ = true;
+  objective_value_ = objective;
+  best_solution_.swap(solution);
+  VLOG(1) << "New solution with objective " << objective_value_ << " after "
+          << num_nodes_ << " nodes.";
+  return true;
+}
+
+bool BranchAndBound::IsFeasibleSolution(const LinearProgram& lp,
+                                        const DenseRow& values,
+                                        Fractional tolerance) const {
+  const Fractional integrality_tolerance =
+      parameters_.mip_integrality_tolerance();
+  DenseColumn activities(lp.num_constraints(), 0.0);
+  DenseColumn magnitudes(lp.num_constraints(), 1.0);
+  for (ColIndex col(0); col < lp.num_variables(); ++col) {
+    const Fractional value = values[col];
+    if (value < lp.variable_lower_bounds()[col] - tolerance ||
+        value > lp.variable_upper_bounds()[col] + tolerance) {
+      return false;
+    }
+    if (lp.is_variable_integer()[col] &&
+        std::abs(value - std::round(value)) > integrality_tolerance) {
+      return false;
+    }
+    for (const SparseColumn::Entry e : lp.GetSparseColumn(col)) {
+      activities[e.row()] += e.coefficient() * value;
+      magnitudes[e.row()] +=
+          std::abs(e.coefficient()) * std::max(1.0, std::abs(value));
+    }
+  }
+  for (RowIndex row(0); row < lp.num_constraints(); ++row) {
+    const Fractional row_tolerance = tolerance * magnitudes[row];
+    if (activities[row] < lp.constraint_lower_bounds()[row] - row_tolerance ||
+        activities[row] > lp.constraint_upper_bounds()[row] + row_tolerance) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Fractional BranchAndBound::PruningThreshold() const {
+  if (!has_solution_) return kInfinity;
+  const Fractional objective = objective_sign_ * objective_value_;
+  return objective -
+         std::max(parameters_.mip_absolute_gap_limit(),
+                  parameters_.mip_relative_gap_limit() * std::abs(objective));
+}
+
+void BranchAndBound::AddOpenNode(std::unique_ptr<Node> node) {
+  if (pool_is_full_) {
+    depth_first_stack_.push_back(std::move(node));
+    return;
+  }
+  pool_memory_ += NodeMemory(*node);
+  heap_.push_back(std::move(node));
+  std::push_heap(heap_.begin(), heap_.end(), HasWorseBound);
+  if (pool_memory_ >
+      parameters_.mip_max_node_pool_memory_in_mb() * 1024.0 * 1024.0) {
+    VLOG(1) << "The node pool is full, switching to depth-first search.";
+    pool_is_full_ = true;
+  }
+}
+
+std::unique_ptr<BranchAndBound::Node> BranchAndBound::PopOpenNode() {
+  std::unique_ptr<Node> node;
+  if (!depth_first_stack_.empty()) {
+    node = std::move(depth_first_stack_.back());
+    depth_first_stack_.pop_back();
+    return node;
+  }
+  if (heap_.empty()) return node;
+  std::pop_heap(heap_.begin(), heap_.end(), HasWorseBound);
+  node = std::move(heap_.back());
+  heap_.pop_back();
+  pool_memory_ -= NodeMemory(*node);
+  if (pool_is_full_ &&
+      pool_memory_ <
+          parameters_.mip_max_node_pool_memory_in_mb() * 512.0 * 1024.0) {
+    pool_is_full_ = false;
+  }
+  return node;
+}
+
+Fractional BranchAndBound::BestOpenNodeBound() const {
+  Fractional bound = heap_.empty() ? kInfinity : heap_.front()->bound;
+  for (const std::unique_ptr<Node>& node : depth_first_stack_) {
+    bound = std::min(bound, node->bound);
+  }
+  return bound;
+}
+
+}  // namespace glop
+}  // namespace operations_research
@@ -0,0 +1,269 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// An LP-based branch and bound for mixed integer programs, built directly on
+// top of the RevisedSimplex.
+//
+// All the nodes of the search tree share the same matrix and objective and only
+// differ from the root linear program by the bounds of some integer variables.
+// This is exactly the case in which the dual simplex can be warm-started, so:
+// - When diving, a child is re-optimized from the optimal basis of its parent
+//   that is still loaded in the RevisedSimplex.
+// - When a node is picked from the pool of open nodes, the basis of its parent
+//   (saved as a BasisState alongside the node) is loaded before the solve.
+//
+// Branching uses pseudo-costs, i.e. the average objective degradation per unit
+// of change of a variable in each direction, measured on the solved children.
+// A pseudo-cost is considered reliable once it has been measured
+// mip_reliability_threshold times. Before that, it is initialized by strong
+// branching with a limited number of dual simplex iterations (this is known as
+// reliability branching).
+//
+// Node selection is a hybrid of depth-first and best-bound search: the search
+// dives, always solving one of the two children just created, until the node
+// is pruned or is too far from the best bound. It then restarts from the open
+// node with the best bound. To keep the memory bounded, once the pool of open
+// nodes uses more than mip_max_node_pool_memory_in_mb, the search becomes a
+// pure depth-first search and stops adding nodes to the pool until it shrinks
+// back under half this limit.
+//
+// When use_preprocessing is true, the root node is presolved by propagating
+// the minimum and maximum activities of the constraints on the bounds of the
+// integer variables, until a fixed point or a limited number of passes. This
+// only tightens bounds, so the nodes keep the variables of the given problem.
+//
+// Reference: T. Achterberg, T. Koch, A. Martin, "Branching rules revisited",
+// Operations Research Letters 33 (2005), pp. 42-54.
+
+#ifndef OR_TOOLS_GLOP_BRANCH_AND_BOUND_H_
+#define OR_TOOLS_GLOP_BRANCH_AND_BOUND_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "glop/parameters.pb.h"
+#include "glop/revised_simplex.h"
+#include "lp_data/lp_data.h"
+#include "lp_data/lp_types.h"
+#include "util/time_limit.h"
+
+namespace operations_research {
+namespace glop {
+
+class BranchAndBound {
+ public:
+  BranchAndBound();
+  ~BranchAndBound();
+
+  // Sets and gets the solver parameters. The mip_* fields of GlopParameters
+  // control the tree search, the other ones are passed to the RevisedSimplex.
+  void SetParameters(const GlopParameters& parameters);
+  const GlopParameters& GetParameters() const { return parameters_; }
+
+  // Solves the given mixed integer program, i.e. the given linear program with
+  // the additional integrality constraints of its integer variables. Returns:
+  // - OPTIMAL if the best solution found is proven optimal (up to the gap
+  //   limits).
+  // - PRIMAL_FEASIBLE if a solution was found but a limit was reached before
+  //   proving its optimality.
+  // - PRIMAL_INFEASIBLE if the problem was proven infeasible.
+  // - PRIMAL_UNBOUNDED if the linear relaxation is unbounded.
+  // - INIT if a limit was reached before any solution was found.
+  // - ABNORMAL or IMPRECISE if the linear relaxation could not be solved.
+  ProblemStatus Solve(const LinearProgram& lp) MUST_USE_RESULT;
+
+  // Same as Solve() but use the given time limit rather than constructing a new
+  // one from the current GlopParameters.
+  ProblemStatus SolveWithTimeLimit(const LinearProgram& lp,
+                                   TimeLimit* time_limit) MUST_USE_RESULT;
+
+  // Sets the values of all the variables of a solution to use as the initial
+  // best solution of the next solves. It is ignored if it does not have one
+  // value per variable of the solved problem or if it is not feasible. An empty
+  // hint clears it.
+  void SetSolutionHint(const DenseRow& values) { solution_hint_ = values; }
+
+  // Accessors to the result of the last Solve(). The variable values and the
+  // objective value are only meaningful if a solution was found, i.e. if the
+  // returned status was OPTIMAL or PRIMAL_FEASIBLE. The best bound is always a
+  // valid bound on the optimal objective value.
+  const DenseRow& variable_values() const { return best_solution_; }
+  Fractional objective_value() const { return objective_value_; }
+  Fractional best_bound() const { return best_bound_; }
+  int64 num_nodes() const { return num_nodes_; }
+  int64 num_simplex_iterations() const { return num_simplex_iterations_; }
+
+ private:
+  // The new bounds [lower_bound, upper_bound] of the column col.
+  struct BoundChange {
+    ColIndex col;
+    Fractional lower_bound;
+    Fractional upper_bound;
+  };
+
+  // An open node of the search tree.
+  struct Node {
+    // Lower bound on the objective (of the minimization version of the
+    // problem) of any solution in the subtree of this node. This is the
+    // objective value of the parent linear relaxation.
+    Fractional bound = -kInfinity;
+    int depth = 0;
+
+    // The bound changes with respect to the root, in the order in which they
+    // were made. Later changes of the same column take precedence.
+    std::vector<BoundChange> bound_changes;
+
+    // The optimal basis of the parent, loaded before solving the node. It is
+    // empty for the root and for the child solved right away by a dive, which
+    // re-optimizes from the basis already in the RevisedSimplex.
+    BasisState parent_basis;
+
+    // The branching decision that created this node. Used to update the
+    // pseudo-costs once the node linear relaxation is solved.
+    ColIndex branching_col = kInvalidCol;
+    bool branching_up = false;
+    Fractional branching_distance = 0.0;
+  };
+
+  // Pseudo-cost information for one integer variable.
+  struct PseudoCost {
+    Fractional down_sum = 0.0;
+    Fractional up_sum = 0.0;
+    int down_count = 0;
+    int up_count = 0;
+  };
+
+  // Approximate memory used by a node in the pool, in bytes.
+  static int64 NodeMemory(const Node& node);
+
+  // Heap order: the root of heap_ is the node with the smallest bound, and the
+  // deepest one in case of ties.
+  static bool HasWorseBound(const std::unique_ptr<Node>& a,
+                            const std::unique_ptr<Node>& b);
+
+  // Replaces the bounds of the current node in lp_ by the ones of the given
+  // node.
+  void SetNodeBounds(const Node& node);
+
+  // Solves the linear relaxation of the current lp_ with the given simplex
+  // parameters. Returns the status of the RevisedSimplex or ABNORMAL on error.
+  ProblemStatus SolveRelaxation(const GlopParameters& parameters,
+                                TimeLimit* time_limit);
+
+  // Objective value of the last relaxation, for the minimization version of the
+  // problem.
+  Fractional RelaxationObjective() const;
+
+  // Returns the index in candidates of the column to branch on, and fills
+  // *up_first with the preferred direction for the dive. This may run strong
+  // branching, in which case the basis of the RevisedSimplex is restored from
+  // parent_basis before returning.
+  int SelectBranchingCandidate(const std::vector<ColIndex>& candidates,
+                               const DenseRow& values,
+                               const BasisState& parent_basis,
+                               Fractional parent_objective,
+                               TimeLimit* time_limit, bool* up_first);
+
+  // Adds a measured objective degradation to the pseudo-cost of col.
+  void UpdatePseudoCost(ColIndex col, bool up, Fractional distance,
+                        Fractional degradation);
+
+  // Estimated objective degradation per unit change of col in one direction.
+  Fractional PseudoCostEstimate(ColIndex col, bool up) const;
+
+  // Tightens the bounds of the integer variables of lp_ using the activity
+  // bounds of its constraints. Returns false if this proves that the problem
+  // is infeasible. Must be called before the slack variables are added.
+  bool PropagateRootBounds();
+
+  // Records the given values, with their integer variables rounded, as the new
+  // best solution if it is better than the current one. The rounded values are
+  // checked against lp, the problem given to Solve(), since rounding the values
+  // of a relaxation within the integrality tolerance may move it out of the
+  // feasible region. Returns false, without recording anything, if they are
+  // not feasible.
+  bool RecordSolution(const LinearProgram& lp, const DenseRow& values);
+
+  // Returns true if the given values satisfy the bounds, the constraints and
+  // the integrality of the variables of lp. The bounds are checked up to the
+  // given tolerance, the constraints up to the tolerance times one plus the
+  // sum of their |coefficient| * max(1, |value|), which covers the rounding of
+  // the integer variables, and the integrality up to mip_integrality_tolerance.
+  bool IsFeasibleSolution(const LinearProgram& lp, const DenseRow& values,
+                          Fractional tolerance) const;
+
+  // Objective value above which a node can be pruned.
+  Fractional PruningThreshold() const;
+
+  // Node pool operations. Nodes are taken from the depth-first stack first,
+  // then from the best-bound heap.
+  void AddOpenNode(std::unique_ptr<Node> node);
+  std::unique_ptr<Node> PopOpenNode();
+  Fractional BestOpenNodeBound() const;
+
+  // The parameters used for the root node, the other nodes (dual simplex) and
+  // strong branching (dual simplex with an iteration limit).
+  GlopParameters parameters_;
+  GlopParameters node_parameters_;
+  GlopParameters strong_branching_parameters_;
+  RevisedSimplex simplex_;
+
+  // The problem in equation form and its root bounds.
+  LinearProgram lp_;
+  DenseRow root_lower_bounds_;
+  DenseRow root_upper_bounds_;
+  ColIndex num_structural_cols_;
+  std::vector<ColIndex> integer_cols_;
+
+  // +1.0 for a minimization problem and -1.0 for a maximization problem.
+  Fractional objective_sign_;
+
+  // The bound changes currently applied to lp_.
+  std::vector<BoundChange> applied_changes_;
+
+  // The open nodes: a min-heap on the bound and the depth-first stack used
+  // when the pool is over its memory limit.
+  std::vector<std::unique_ptr<Node>> heap_;
+  std::vector<std::unique_ptr<Node>> depth_first_stack_;
+  int64 pool_memory_;
+  bool pool_is_full_;
+
+  // The pseudo-costs of the columns and their sum over all the columns, used
+  // for the columns without any measure yet.
+  StrictITIVector<ColIndex, PseudoCost> pseudo_costs_;
+  PseudoCost average_pseudo_cost_;
+
+  // See SetSolutionHint().
+  DenseRow solution_hint_;
+
+  // The best solution found so far and the search statistics.
+  DenseRow best_solution_;
+  bool has_solution_;
+  Fractional objective_value_;
+  Fractional best_bound_;
+
+  // The smallest bound of the nodes pruned because they could not improve the
+  // best solution by more than the gap limits.
+  Fractional pruned_bound_;
+  int64 num_nodes_;
+  int64 num_simplex_iterations_;
+
+  DISALLOW_COPY_AND_ASSIGN(BranchAndBound);
+};
+
+}  // namespace glop
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GLOP_BRANCH_AND_BOUND_H_
@@ -14,7 +14,11 @@
 
 #include "glop/lp_solver.h"
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cmath>
+#include <condition_variable>  // NOLINT
+#include <mutex>  // NOLINT
 #include <stack>
 #include <vector>
 
@@ -23,7 +27,9 @@
 #include "base/timer.h"
 
 #include "base/join.h"
+#include "base/mutex.h"
 #include "base/strutil.h"
+#include "base/threadpool.h"
 #include "glop/preprocessor.h"
 #include "glop/proto_utils.h"
 #include "glop/status.h"
@@ -99,7 +105,10 @@ void DumpLinearProgramIfRequiredByFlags(const LinearProgram& linear_program,
 // LPSolver
 // --------------------------------------------------------
 
-LPSolver::LPSolver() : num_solves_(0) {}
+LPSolver::LPSolver()
+    : num_revised_simplex_iterations_(0),
+      last_solve_used_dual_simplex_(false),
+      num_solves_(0) {}
 
 void LPSolver::SetParameters(const GlopParameters& parameters) {
   parameters_ = parameters;
@@ -405,6 +414,10 @@ int LPSolver::GetNumberOfSimplexIterations() const {
   return num_revised_simplex_iterations_;
 }
 
+bool LPSolver::LastSolveUsedDualSimplex() const {
+  return last_solve_used_dual_simplex_;
+}
+
 
 double LPSolver::DeterministicTime() const {
   return revised_simplex_ == nullptr ? 0.0
@@ -462,38 +475,161 @@ void LPSolver::ResizeSolution(RowIndex num_rows, ColIndex num_cols) {
   constraint_statuses_.resize(num_rows, ConstraintStatus::FREE);
 }
 
+namespace {
+
+// State shared by the algorithms raced by
+// LPSolver::RunConcurrentRevisedSimplex().
+struct SimplexRace {
+  static const int kNumAlgorithms = 2;  // Primal and dual simplex.
+
+  SimplexRace() : stop(false), winner(-1), num_finished(0) {
+    for (int i = 0; i < kNumAlgorithms; ++i) is_ok[i] = false;
+  }
+
+  // Registered as the external limit of all the racing algorithms. It is set
+  // by the winner, or when the external limit of the caller is reached.
+  std::atomic<bool> stop;
+
+  // Signaled each time an algorithm finishes.
+  std::mutex mutex;
+  std::condition_variable finished;
+  int winner GUARDED_BY(mutex);
+  int num_finished GUARDED_BY(mutex);
+  bool is_ok[kNumAlgorithms] GUARDED_BY(mutex);
+};
+
+// Returns true if the given status is a final answer for the lp, in which case
+// the other algorithms of a race can be stopped.
+bool IsConclusiveStatus(ProblemStatus status) {
+  return status == ProblemStatus::OPTIMAL ||
+         status == ProblemStatus::PRIMAL_INFEASIBLE ||
+         status == ProblemStatus::DUAL_INFEASIBLE ||
+         status == ProblemStatus::INFEASIBLE_OR_UNBOUNDED ||
+         status == ProblemStatus::PRIMAL_UNBOUNDED ||
+         status == ProblemStatus::DUAL_UNBOUNDED;
+}
+
+// Runs the algorithm with the given index of a race. The first one to reach a
+// conclusive status wins and stops the others.
+void RunRacingSimplex(const LinearProgram* lp, int index,
+                      RevisedSimplex* revised_simplex, TimeLimit* time_limit,
+                      SimplexRace* race) {
+  const bool is_ok = revised_simplex->Solve(*lp, time_limit).ok();
+  std::lock_guard<std::mutex> lock(race->mutex);
+  race->is_ok[index] = is_ok;
+  if (is_ok && race->winner == -1 &&
+      IsConclusiveStatus(revised_simplex->GetProblemStatus())) {
+    race->winner = index;
+    race->stop = true;
+  }
+  ++race->num_finished;
+  race->finished.notify_all();
+}
+
+}  // namespace
+
+bool LPSolver::RunConcurrentRevisedSimplex(TimeLimit* time_limit) {
+  const int kNumAlgorithms = SimplexRace::kNumAlgorithms;
+
+  // The lp is read concurrently, so its lazily computed fields must be up to
+  // date before the race starts.
+  current_linear_program_.IsCleanedUp();
+
+  // The winner of the previous Solve() is reused for its algorithm so that it
+  // can be warm-started. The index of an algorithm is 1 for the dual simplex.
+  std::unique_ptr<RevisedSimplex> revised_simplex[kNumAlgorithms];
+  revised_simplex[last_solve_used_dual_simplex_ ? 1 : 0] =
+      std::move(revised_simplex_);
+  std::unique_ptr<TimeLimit> racing_time_limit[kNumAlgorithms];
+  SimplexRace race;
+  {
+    ThreadPool pool("ConcurrentSimplex", kNumAlgorithms);
+    for (int i = 0; i < kNumAlgorithms; ++i) {
+      if (revised_simplex[i] == nullptr) {
+        revised_simplex[i].reset(new RevisedSimplex());
+      }
+      GlopParameters parameters = parameters_;
+      parameters.set_use_dual_simplex(i == 1);
+      parameters.set_allow_simplex_algorithm_change(false);
+      revised_simplex[i]->SetParameters(parameters);
+      racing_time_limit[i].reset(
+          new TimeLimit(time_limit->GetTimeLeft(),
+                        time_limit->GetDeterministicTimeLeft()));
+      racing_time_limit[i]->RegisterExternalBooleanAsLimit(&race.stop);
+      pool.Add(NewCallback(&RunRacingSimplex, &current_linear_program_, i,
+                           revised_simplex[i].get(),
+                           racing_time_limit[i].get(), &race));
+    }
+    pool.StartWorkers();
+
+    // A TimeLimit only has one external Boolean, so the one of the caller
+    // (e.g. set by MPSolver::InterruptSolve()) is forwarded to race.stop while
+    // waiting for the racing algorithms.
+    const std::atomic<bool>* const external_stop =
+        time_limit->ExternalBooleanAsLimit();
+    std::unique_lock<std::mutex> lock(race.mutex);
+    while (race.num_finished < kNumAlgorithms) {
+      if (external_stop != nullptr && *external_stop) race.stop = true;
+      race.finished.wait_for(lock, std::chrono::milliseconds(10));
+    }
+  }
+
+  // If no algorithm reached a conclusive status (i.e. the time limit was
+  // reached), the primal simplex result is preferred.
+  int winner = race.winner;
+  for (int i = 0; winner == -1 && i < kNumAlgorithms; ++i) {
+    if (race.is_ok[i]) winner = i;
+  }
+  if (winner == -1) return false;
+  VLOG(1) << (winner == 1 ? "Dual" : "Primal")
+          << " simplex won the concurrent race.";
+  time_limit->AdvanceDeterministicTime(
+      racing_time_limit[winner]->GetElapsedDeterministicTime());
+  last_solve_used_dual_simplex_ = winner == 1;
+  revised_simplex_ = std::move(revised_simplex[winner]);
+  return true;
+}
+
 void LPSolver::RunRevisedSimplexIfNeeded(ProblemSolution* solution,
                                          TimeLimit* time_limit) {
   // Note that the transpose matrix is no longer needed at this point.
   // This helps reduce the peak memory usage of the solver.
   current_linear_program_.ClearTransposeMatrix();
   if (solution->status != ProblemStatus::INIT) return;
-  if (revised_simplex_ == nullptr) {
-    revised_simplex_.reset(new RevisedSimplex());
-  }
-  revised_simplex_->SetParameters(parameters_);
-  if (revised_simplex_->Solve(current_linear_program_, time_limit).ok()) {
-    num_revised_simplex_iterations_ = revised_simplex_->GetNumberOfIterations();
-    solution->status = revised_simplex_->GetProblemStatus();
-
-    const ColIndex num_cols = revised_simplex_->GetProblemNumCols();
-    DCHECK_EQ(solution->primal_values.size(), num_cols);
-    for (ColIndex col(0); col < num_cols; ++col) {
-      solution->primal_values[col] = revised_simplex_->GetVariableValue(col);
-      solution->variable_statuses[col] =
-          revised_simplex_->GetVariableStatus(col);
-    }
-
-    const RowIndex num_rows = revised_simplex_->GetProblemNumRows();
-    DCHECK_EQ(solution->dual_values.size(), num_rows);
-    for (RowIndex row(0); row < num_rows; ++row) {
-      solution->dual_values[row] = revised_simplex_->GetDualValue(row);
-      solution->constraint_statuses[row] =
-          revised_simplex_->GetConstraintStatus(row);
+  if (parameters_.use_concurrent_simplex()) {
+    if (!RunConcurrentRevisedSimplex(time_limit)) {
+      VLOG(1) << "Error during the concurrent revised simplex algorithms.";
+      solution->status = ProblemStatus::ABNORMAL;
+      return;
     }
   } else {
-    VLOG(1) << "Error during the revised simplex algorithm.";
-    solution->status = ProblemStatus::ABNORMAL;
+    if (revised_simplex_ == nullptr) {
+      revised_simplex_.reset(new RevisedSimplex());
+    }
+    revised_simplex_->SetParameters(parameters_);
+    last_solve_used_dual_simplex_ = parameters_.use_dual_simplex();
+    if (!revised_simplex_->Solve(current_linear_program_, time_limit).ok()) {
+      VLOG(1) << "Error during the revised simplex algorithm.";
+      solution->status = ProblemStatus::ABNORMAL;
+      return;
+    }
+  }
+  num_revised_simplex_iterations_ = revised_simplex_->GetNumberOfIterations();
+  solution->status = revised_simplex_->GetProblemStatus();
+
+  const ColIndex num_cols = revised_simplex_->GetProblemNumCols();
+  DCHECK_EQ(solution->primal_values.size(), num_cols);
+  for (ColIndex col(0); col < num_cols; ++col) {
+    solution->primal_values[col] = revised_simplex_->GetVariableValue(col);
+    solution->variable_statuses[col] = revised_simplex_->GetVariableStatus(col);
+  }
+
+  const RowIndex num_rows = revised_simplex_->GetProblemNumRows();
+  DCHECK_EQ(solution->dual_values.size(), num_rows);
+  for (RowIndex row(0); row < num_rows; ++row) {
+    solution->dual_values[row] = revised_simplex_->GetDualValue(row);
+    solution->constraint_statuses[row] =
+        revised_simplex_->GetConstraintStatus(row);
   }
 }
 
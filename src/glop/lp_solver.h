@@ -121,6 +121,12 @@ class LPSolver {
   // Returns the number of simplex iterations used by the last Solve().
   int GetNumberOfSimplexIterations() const;
 
+  // Returns true if the solution of the last Solve() was computed by the dual
+  // simplex rather than by the primal simplex. With use_concurrent_simplex,
+  // this tells which algorithm finished first, which can be used to choose
+  // use_dual_simplex for similar problems.
+  bool LastSolveUsedDualSimplex() const;
+
 
   // Returns the "deterministic time" since the creation of the solver. Note
   // That this time is only increased when some operations take place in this
@@ -149,6 +155,11 @@ class LPSolver {
   void RunRevisedSimplexIfNeeded(ProblemSolution* solution,
                                  TimeLimit* time_limit);
 
+  // Runs the primal and the dual simplex concurrently on
+  // current_linear_program_ and moves the winner into revised_simplex_.
+  // Returns false if both algorithms failed.
+  bool RunConcurrentRevisedSimplex(TimeLimit* time_limit);
+
 
   // Checks that the returned solution values and statuses are consistent.
   // Returns true if this is the case. See the code for the exact check
@@ -231,6 +242,9 @@ class LPSolver {
   // The number of revised simplex iterations used by the last Solve().
   int num_revised_simplex_iterations_;
 
+  // Whether revised_simplex_ last ran the dual simplex algorithm.
+  bool last_solve_used_dual_simplex_;
+
 
   // The current ProblemSolution.
   // TODO(user): use a ProblemSolution directly?
@@ -14,7 +14,11 @@
 #include "glop/markowitz.h"
 
 #include <limits>
+#include <memory>
+#include "base/callback.h"
 #include "base/stringprintf.h"
+#include "base/synchronization.h"
+#include "base/threadpool.h"
 #include "lp_data/lp_utils.h"
 
 namespace operations_research {
@@ -84,6 +88,14 @@ Status Markowitz::ComputeRowAndColumnPermutation(const MatrixView& basis_matrix,
     DCHECK_EQ((*row_perm)[pivot_row], kInvalidRow);
     DCHECK_EQ((*col_perm)[pivot_col], kInvalidCol);
 
+    // Note that the pivot found above is simply dropped in this case, the dense
+    // LU will choose its own pivots.
+    if (num_rows.value() == num_cols.value() &&
+        ShouldSwitchToDenseFactorization(end_index - index, min_markowitz)) {
+      RETURN_IF_ERROR(FactorizeDenseResidualMatrix(row_perm, col_perm, &index));
+      break;
+    }
+
     // Update residual_matrix_non_zero_.
     // TODO(user): This step can be skipped, once a fully dense matrix is
     // obtained. But note that permuted_lower_column_needs_solve_ needs to be
@@ -482,6 +494,235 @@ int64 Markowitz::FindPivot(const RowPermutation& row_perm,
   return min_markowitz_number;
 }
 
+namespace {
+
+// Number of columns of the panels used by DenseBlockedLu().
+const int kDenseBlockSize = 64;
+
+// Minimum number of trailing columns updated by each thread of
+// DenseBlockedLu(). Smaller updates are not worth the thread synchronization.
+const int kMinDenseColumnsPerThread = 32;
+
+// Applies the pivots of the panel [block_start, block_end) of the dense LU
+// below to the columns [first_col, last_col) of the trailing matrix. For each
+// of them, this both solves the upper part with the unit lower triangular
+// block of the panel and subtracts the product of the rest of the panel with
+// this solution. The columns are independent, so disjoint column ranges can
+// be updated concurrently.
+void UpdateDenseTrailingColumns(Fractional* a, int size, int block_start,
+                                int block_end, int first_col, int last_col) {
+  const int64 stride = size;
+  for (int j = first_col; j < last_col; ++j) {
+    Fractional* const column_j = a + j * stride;
+    for (int k = block_start; k < block_end; ++k) {
+      const Fractional multiplier = column_j[k];
+      if (multiplier == 0.0) continue;
+      const Fractional* const column_k = a + k * stride;
+      for (int i = k + 1; i < size; ++i) {
+        column_j[i] -= column_k[i] * multiplier;
+      }
+    }
+  }
+}
+
+// Same as UpdateDenseTrailingColumns() for the panel starting at block_start,
+// and then waits for the other updates of the same panel. The last thread to
+// leave the barrier deletes it.
+void UpdateDenseTrailingColumnsAndBlock(Fractional* a, int size,
+                                        int block_start, int first_col,
+                                        int last_col, Barrier* barrier) {
+  UpdateDenseTrailingColumns(a, size, block_start,
+                             std::min(size, block_start + kDenseBlockSize),
+                             first_col, last_col);
+  if (barrier->Block()) delete barrier;
+}
+
+// Returns the number of column ranges of a trailing update of
+// num_trailing_cols columns.
+int NumDenseUpdateChunks(int num_threads, int num_trailing_cols) {
+  return std::max(
+      1, std::min(num_threads, num_trailing_cols / kMinDenseColumnsPerThread));
+}
+
+// Computes in place the LU factorization with partial pivoting of the given
+// size x size matrix stored in column-major order. On return, the strict lower
+// part of the matrix holds L (its diagonal is implicitly 1.0) and its upper part
+// holds U. row_order[k] is the index of the initial row used as the k-th pivot
+// row. Returns the number of pivots found before a column without any entry of
+// magnitude greater than singularity_threshold, i.e. size if the matrix is
+// non-singular.
+//
+// The columns are factorized by panels of kDenseBlockSize columns. Each panel
+// is then applied at once to the trailing columns, i.e. this is a Schur
+// complement update with kDenseBlockSize pivots. It is split in column ranges
+// updated by up to num_threads threads, from a pool created once for all the
+// panels.
+int DenseBlockedLu(int size, Fractional singularity_threshold, int num_threads,
+                   std::vector<Fractional>* matrix,
+                   std::vector<int>* row_order) {
+  Fractional* const a = matrix->data();
+  const int64 stride = size;
+  row_order->resize(size);
+  for (int i = 0; i < size; ++i) (*row_order)[i] = i;
+  // The first panel has the largest trailing update, hence the most chunks.
+  const int max_num_chunks =
+      NumDenseUpdateChunks(num_threads, size - std::min(size, kDenseBlockSize));
+  std::unique_ptr<ThreadPool> pool;
+  if (max_num_chunks > 1) {
+    pool.reset(new ThreadPool("DenseBlockedLu", max_num_chunks - 1));
+    pool->StartWorkers();
+  }
+  for (int block_start = 0; block_start < size;
+       block_start += kDenseBlockSize) {
+    const int block_end = std::min(size, block_start + kDenseBlockSize);
+
+    // Right-looking factorization of the panel.
+    for (int k = block_start; k < block_end; ++k) {
+      Fractional* const column_k = a + k * stride;
+      int pivot = k;
+      Fractional max_magnitude = fabs(column_k[k]);
+      for (int i = k + 1; i < size; ++i) {
+        if (fabs(column_k[i]) > max_magnitude) {
+          max_magnitude = fabs(column_k[i]);
+          pivot = i;
+        }
+      }
+      if (max_magnitude <= singularity_threshold) return k;
+      if (pivot != k) {
+        std::swap((*row_order)[k], (*row_order)[pivot]);
+        for (int j = 0; j < size; ++j) {
+          std::swap(a[k + j * stride], a[pivot + j * stride]);
+        }
+      }
+      const Fractional pivot_coefficient = column_k[k];
+      for (int i = k + 1; i < size; ++i) {
+        column_k[i] /= pivot_coefficient;
+      }
+      for (int j = k + 1; j < block_end; ++j) {
+        Fractional* const column_j = a + j * stride;
+        const Fractional multiplier = column_j[k];
+        if (multiplier == 0.0) continue;
+        for (int i = k + 1; i < size; ++i) {
+          column_j[i] -= column_k[i] * multiplier;
+        }
+      }
+    }
+
+    // Update of the trailing columns. The calling thread takes the first range
+    // of columns, the other ones are given to the pool, and all of them meet
+    // at a barrier before the next panel is factorized.
+    const int num_trailing_cols = size - block_end;
+    const int num_chunks = NumDenseUpdateChunks(num_threads, num_trailing_cols);
+    const int chunk_size = (num_trailing_cols + num_chunks - 1) / num_chunks;
+    if (num_chunks == 1) {
+      UpdateDenseTrailingColumns(a, size, block_start, block_end, block_end,
+                                 size);
+    } else {
+      Barrier* const barrier = new Barrier(num_chunks);
+      for (int chunk = 1; chunk < num_chunks; ++chunk) {
+        const int first_col = block_end + chunk * chunk_size;
+        const int last_col = std::min(size, first_col + chunk_size);
+        pool->Add(NewCallback(&UpdateDenseTrailingColumnsAndBlock, a, size,
+                              block_start, first_col, last_col, barrier));
+      }
+      UpdateDenseTrailingColumnsAndBlock(a, size, block_start, block_end,
+                                         block_end + chunk_size, barrier);
+    }
+  }
+  return size;
+}
+
+}  // namespace
+
+bool Markowitz::ShouldSwitchToDenseFactorization(int residual_size,
+                                                 int64 min_markowitz) {
+  if (!parameters_.use_dense_lu_tail() ||
+      residual_size < parameters_.markowitz_dense_switch_min_size() ||
+      residual_size > parameters_.markowitz_dense_switch_max_size()) {
+    return false;
+  }
+
+  // A pivot without fill-in comes from a singleton row or column, the residual
+  // matrix is not dense. Otherwise FindPivot() popped the residual columns by
+  // increasing degree, so the first examined column has the smallest degree.
+  if (min_markowitz == 0 || examined_col_.empty()) return false;
+  return residual_matrix_non_zero_.ColDegree(examined_col_.front()) >=
+         parameters_.markowitz_dense_switch_density() * residual_size;
+}
+
+Status Markowitz::FactorizeDenseResidualMatrix(RowPermutation* row_perm,
+                                               ColumnPermutation* col_perm,
+                                               int* index) {
+  SCOPED_TIME_STAT(&stats_);
+  const RowIndex num_rows = row_perm->size();
+  const ColIndex num_cols = col_perm->size();
+  std::vector<RowIndex> residual_rows;
+  StrictITIVector<RowIndex, int> dense_row_index(num_rows, -1);
+  for (RowIndex row(0); row < num_rows; ++row) {
+    if ((*row_perm)[row] != kInvalidRow) continue;
+    dense_row_index[row] = residual_rows.size();
+    residual_rows.push_back(row);
+  }
+  std::vector<ColIndex> residual_cols;
+  for (ColIndex col(0); col < num_cols; ++col) {
+    if ((*col_perm)[col] == kInvalidCol) residual_cols.push_back(col);
+  }
+  const int size = residual_rows.size();
+  DCHECK_EQ(size, residual_cols.size());
+  stats_.dense_residual_size.Add(size);
+
+  // Gathers the residual matrix. Its columns are computed exactly like the
+  // candidate columns of FindPivot(), and this also completes the columns of
+  // permuted_upper_ with the rows already pivoted by the sparse algorithm.
+  std::vector<Fractional> dense_matrix(static_cast<int64>(size) * size, 0.0);
+  for (int j = 0; j < size; ++j) {
+    Fractional* const dense_column =
+        &dense_matrix[static_cast<int64>(j) * size];
+    for (const SparseColumn::Entry e :
+         ComputeColumn(*row_perm, residual_cols[j])) {
+      DCHECK_NE(dense_row_index[e.row()], -1);
+      dense_column[dense_row_index[e.row()]] = e.coefficient();
+    }
+  }
+
+  std::vector<int> row_order;
+  const int num_pivots = DenseBlockedLu(
+      size, parameters_.markowitz_singularity_threshold(),
+      parameters_.markowitz_dense_num_threads(), &dense_matrix, &row_order);
+
+  // Appends the dense L and U columns, in pivot order. The row indices are the
+  // initial ones, like for the columns added by the sparse algorithm.
+  SparseColumn lower_column;
+  SparseColumn upper_column;
+  for (int k = 0; k < num_pivots; ++k) {
+    const ColIndex col = residual_cols[k];
+    const RowIndex pivot_row = residual_rows[row_order[k]];
+    const Fractional* const dense_column =
+        &dense_matrix[static_cast<int64>(k) * size];
+    upper_column.PopulateFromSparseVector(permuted_upper_.column(col));
+    lower_column.Clear();
+    for (int i = 0; i < size; ++i) {
+      if (i == k || dense_column[i] == 0.0) continue;
+      SparseColumn* const target = i < k ? &upper_column : &lower_column;
+      target->SetCoefficient(residual_rows[row_order[i]], dense_column[i]);
+    }
+    upper_.AddTriangularColumnWithGivenDiagonalEntry(upper_column, pivot_row,
+                                                     dense_column[k]);
+    lower_.AddTriangularColumnWithGivenDiagonalEntry(lower_column, pivot_row,
+                                                     1.0);
+    permuted_lower_.ClearAndReleaseColumn(col);
+    permuted_upper_.ClearAndReleaseColumn(col);
+    (*col_perm)[col] = ColIndex(*index);
+    (*row_perm)[pivot_row] = RowIndex(*index);
+    ++(*index);
+  }
+  if (num_pivots < size) {
+    RETURN_AND_LOG_ERROR(Status::ERROR_LU,
+                         "The matrix is singular! (dense residual matrix)");
+  }
+  return Status::OK;
+}
+
 void Markowitz::UpdateDegree(ColIndex col, int degree) {
   DCHECK(is_col_by_degree_initialized_);
 
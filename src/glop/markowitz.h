@@ -49,6 +49,12 @@
 // row. The product minimized above is thus an upper bound of the number of
 // fill-in created during a step.
 //
+// Once even the sparsest candidate column of the residual matrix is dense
+// enough, there is no sparsity left to exploit. The residual matrix is then
+// gathered in a dense array and factorized with a blocked dense LU with partial
+// pivoting whose trailing updates can run in parallel. This is off by default,
+// see use_dense_lu_tail in parameters.proto.
+//
 // References:
 //
 // J. R. Gilbert and T. Peierls, "Sparse partial pivoting in time proportional
@@ -304,11 +310,13 @@ class Markowitz {
           basis_residual_singleton_column_ratio(
               "basis_residual_singleton_column_ratio", this),
           pivots_without_fill_in_ratio("pivots_without_fill_in_ratio", this),
-          degree_two_pivot_columns("degree_two_pivot_columns", this) {}
+          degree_two_pivot_columns("degree_two_pivot_columns", this),
+          dense_residual_size("dense_residual_size", this) {}
     RatioDistribution basis_singleton_column_ratio;
     RatioDistribution basis_residual_singleton_column_ratio;
     RatioDistribution pivots_without_fill_in_ratio;
     RatioDistribution degree_two_pivot_columns;
+    IntegerDistribution dense_residual_size;
   };
   Stats stats_;
 
@@ -363,6 +371,22 @@ class Markowitz {
                   const ColumnPermutation& col_perm, RowIndex* pivot_row,
                   ColIndex* pivot_col, Fractional* pivot_coefficient);
 
+  // Returns true if the residual matrix is dense enough to be factorized by
+  // FactorizeDenseResidualMatrix(), i.e. if its column with the smallest degree
+  // has at least markowitz_dense_switch_density * residual_size entries.
+  // 'residual_size' is its number of rows and 'min_markowitz' the value
+  // returned by the last call to FindPivot(), which gives access to this
+  // column.
+  bool ShouldSwitchToDenseFactorization(int residual_size, int64 min_markowitz);
+
+  // Factorizes the remaining square residual matrix with a dense LU and appends
+  // the result to lower_ and upper_. The permutations and 'index' are updated
+  // as if each dense pivot had been chosen by FindPivot(). Returns an error
+  // if the matrix is singular.
+  Status FactorizeDenseResidualMatrix(RowPermutation* row_perm,
+                                      ColumnPermutation* col_perm,
+                                      int* index) MUST_USE_RESULT;
+
   // Updates the degree of a given column in the internal structure of the
   // class.
   void UpdateDegree(ColIndex col, int degree);
@@ -49,6 +49,19 @@ Preprocessor::~Preprocessor() {}
   RunAndPushIfRelevant(std::unique_ptr<Preprocessor>(new name()), #name, \
                        time_limit, lp)
 
+// Runs the given preprocessor of the presolve loop unless it already did
+// nothing on the current lp. See the worklist comment in Run().
+#define RUN_LOOP_PREPROCESSOR(name)                    \
+  do {                                                 \
+    const int stamp = preprocessors_.size();           \
+    if (unchanged_lp_stamp[index] != stamp) {          \
+      RUN_PREPROCESSOR(name);                          \
+      unchanged_lp_stamp[index] =                      \
+          preprocessors_.size() == stamp ? stamp : -1; \
+    }                                                  \
+    ++index;                                           \
+  } while (false)
+
 bool MainLpPreprocessor::Run(LinearProgram* lp, TimeLimit* time_limit) {
   RETURN_VALUE_IF_NULL(lp, false);
   initial_num_rows_ = lp->num_constraints();
@@ -59,17 +72,33 @@ bool MainLpPreprocessor::Run(LinearProgram* lp, TimeLimit* time_limit) {
 
     // We run it a few times because running one preprocessor may allow another
     // one to remove more stuff.
+    //
+    // The preprocessors of this loop are kept in a worklist: since each of them
+    // is a deterministic function of the lp, one that did nothing does not
+    // need to rescan the lp until another preprocessor modified it. The lp is
+    // modified iff a preprocessor is pushed on preprocessors_, so the stack
+    // size is used as a modification stamp. The only exception is the
+    // relaxation of the implied free constraints by
+    // ForcingAndImpliedFreeConstraintPreprocessor, which is why the (cheap)
+    // FreeConstraintPreprocessor that deletes them is always run.
+    //
+    // Note that this only skips whole preprocessors: one that runs still scans
+    // all the rows and columns of the lp, not only the modified ones.
     const int kMaxNumPasses = 20;
+    const int kNumLoopPreprocessors = 7;
+    std::vector<int> unchanged_lp_stamp(kNumLoopPreprocessors, -1);
     for (int i = 0; i < kMaxNumPasses; ++i) {
       const int old_stack_size = preprocessors_.size();
-      RUN_PREPROCESSOR(FixedVariablePreprocessor);
-      RUN_PREPROCESSOR(SingletonPreprocessor);
-      RUN_PREPROCESSOR(ForcingAndImpliedFreeConstraintPreprocessor);
+      int index = 0;
+      RUN_LOOP_PREPROCESSOR(FixedVariablePreprocessor);
+      RUN_LOOP_PREPROCESSOR(SingletonPreprocessor);
+      RUN_LOOP_PREPROCESSOR(ForcingAndImpliedFreeConstraintPreprocessor);
       RUN_PREPROCESSOR(FreeConstraintPreprocessor);
-      RUN_PREPROCESSOR(UnconstrainedVariablePreprocessor);
-      RUN_PREPROCESSOR(DoubletonEqualityRowPreprocessor);
-      RUN_PREPROCESSOR(ImpliedFreePreprocessor);
-      RUN_PREPROCESSOR(DoubletonFreeColumnPreprocessor);
+      RUN_LOOP_PREPROCESSOR(UnconstrainedVariablePreprocessor);
+      RUN_LOOP_PREPROCESSOR(DoubletonEqualityRowPreprocessor);
+      RUN_LOOP_PREPROCESSOR(ImpliedFreePreprocessor);
+      RUN_LOOP_PREPROCESSOR(DoubletonFreeColumnPreprocessor);
+      DCHECK_EQ(kNumLoopPreprocessors, index);
 
       // Abort early if none of the preprocessors did something. Technically
       // this is true if none of the preprocessors above needs postsolving,
@@ -115,6 +144,7 @@ bool MainLpPreprocessor::Run(LinearProgram* lp, TimeLimit* time_limit) {
   return !preprocessors_.empty();
 }
 
+#undef RUN_LOOP_PREPROCESSOR
 #undef RUN_PREPROCESSOR
 
 void MainLpPreprocessor::RunAndPushIfRelevant(
@@ -433,7 +463,8 @@ bool ProportionalColumnPreprocessor::Run(LinearProgram* lp,
                                          TimeLimit* time_limit) {
   RETURN_VALUE_IF_NULL(lp, false);
   ColMapping mapping = FindProportionalColumns(
-      lp->GetSparseMatrix(), parameters_.preprocessor_zero_tolerance());
+      lp->GetSparseMatrix(), parameters_.preprocessor_zero_tolerance(),
+      parameters_.preprocessor_num_threads());
 
   // Compute some statistics and make each class representative point to itself
   // in the mapping. Also store the columns that are proportional to at least
@@ -804,7 +835,8 @@ bool ProportionalRowPreprocessor::Run(LinearProgram* lp,
   // itself for the loop below. TODO(user): Already return such a mapping from
   // FindProportionalColumns()?
   ColMapping mapping = FindProportionalColumns(
-      transpose, parameters_.preprocessor_zero_tolerance());
+      transpose, parameters_.preprocessor_zero_tolerance(),
+      parameters_.preprocessor_num_threads());
   DenseBooleanColumn is_a_representative(num_rows, false);
   int num_proportional_rows = 0;
   for (RowIndex row(0); row < num_rows; ++row) {
@@ -0,0 +1,115 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "linear_solver/batch_solver.h"
+
+#include "base/callback.h"
+#include "base/logging.h"
+
+namespace operations_research {
+
+MPBatchSolver::MPBatchSolver(int num_workers)
+    : workers_(),
+      mutex_(),
+      response_ready_(),
+      idle_workers_(),
+      completed_(),
+      num_pending_(0),
+      pool_(new ThreadPool("MPBatchSolver", num_workers)) {
+  CHECK_GT(num_workers, 0);
+  for (int i = 0; i < num_workers; ++i) {
+    workers_.emplace_back(new Worker());
+    idle_workers_.push_back(workers_.back().get());
+  }
+  pool_->StartWorkers();
+}
+
+MPBatchSolver::~MPBatchSolver() { pool_.reset(); }
+
+void MPBatchSolver::Submit(int64 tag, const MPModelRequest& request) {
+  Submit(tag, std::unique_ptr<MPModelRequest>(new MPModelRequest(request)));
+}
+
+void MPBatchSolver::Submit(int64 tag, std::unique_ptr<MPModelRequest> request) {
+  {
+    MutexLock lock(&mutex_);
+    ++num_pending_;
+  }
+  // NewCallback() is qualified, otherwise the argument-dependent lookup also
+  // finds google::protobuf::NewCallback().
+  pool_->Add(::NewCallback(this, &MPBatchSolver::SolveRequest, tag,
+                           request.release()));
+}
+
+void MPBatchSolver::SolveRequest(int64 tag, MPModelRequest* request) {
+  std::unique_ptr<MPModelRequest> owned_request(request);
+  MPSolutionResponse response;
+  const MPSolver::OptimizationProblemType problem_type =
+      static_cast<MPSolver::OptimizationProblemType>(request->solver_type());
+  if (!MPSolver::SupportsProblemType(problem_type)) {
+    response.set_status(MPSOLVER_SOLVER_TYPE_UNAVAILABLE);
+  } else {
+    // There is always an idle worker since there are as many of them as
+    // threads in the pool.
+    Worker* worker = nullptr;
+    {
+      MutexLock lock(&mutex_);
+      DCHECK(!idle_workers_.empty());
+      worker = idle_workers_.back();
+      idle_workers_.pop_back();
+    }
+    const int index = static_cast<int>(problem_type);
+    if (index >= worker->solvers.size()) worker->solvers.resize(index + 1);
+    if (worker->solvers[index] == nullptr) {
+      worker->solvers[index].reset(new MPSolver("MPBatchSolver", problem_type));
+    }
+    worker->solvers[index]->ClearAndSolveWithProto(*request, &response);
+    MutexLock lock(&mutex_);
+    idle_workers_.push_back(worker);
+  }
+
+  MutexLock lock(&mutex_);
+  completed_.emplace_back();
+  completed_.back().first = tag;
+  completed_.back().second.Swap(&response);
+  response_ready_.Signal();
+}
+
+bool MPBatchSolver::Next(int64* tag, MPSolutionResponse* response) {
+  MutexLock lock(&mutex_);
+  if (num_pending_ == 0) return false;
+  while (completed_.empty()) response_ready_.Wait(&mutex_);
+  PopCompleted(tag, response);
+  return true;
+}
+
+bool MPBatchSolver::TryNext(int64* tag, MPSolutionResponse* response) {
+  MutexLock lock(&mutex_);
+  if (completed_.empty()) return false;
+  PopCompleted(tag, response);
+  return true;
+}
+
+int MPBatchSolver::NumPending() const {
+  MutexLock lock(&mutex_);
+  return num_pending_;
+}
+
+void MPBatchSolver::PopCompleted(int64* tag, MPSolutionResponse* response) {
+  *tag = completed_.front().first;
+  response->Swap(&completed_.front().second);
+  completed_.pop_front();
+  --num_pending_;
+}
+
+}  // namespace operations_research
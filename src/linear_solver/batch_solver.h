@@ -0,0 +1,107 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// An in-process batch solving service for MPModelRequest protocol buffers.
+//
+// Requests are solved asynchronously by a pool of worker threads, and their
+// responses are delivered through a completion queue, in the order in which
+// they are solved. Each worker keeps one MPSolver per solver type and reuses it
+// from one request to the next (see MPSolver::ClearAndSolveWithProto()), so the
+// allocations of the underlying solvers stay warm and the per-request overhead
+// is mostly the model loading.
+//
+// Example:
+//   MPBatchSolver batch_solver(/*num_workers=*/8);
+//   for (int i = 0; i < requests.size(); ++i) {
+//     batch_solver.Submit(i, requests[i]);
+//   }
+//   int64 tag;
+//   MPSolutionResponse response;
+//   while (batch_solver.Next(&tag, &response)) {
+//     ... response is the solution of requests[tag] ...
+//   }
+
+#ifndef OR_TOOLS_LINEAR_SOLVER_BATCH_SOLVER_H_
+#define OR_TOOLS_LINEAR_SOLVER_BATCH_SOLVER_H_
+
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "base/mutex.h"
+#include "base/threadpool.h"
+#include "linear_solver/linear_solver.h"
+#include "linear_solver/linear_solver.pb.h"
+
+namespace operations_research {
+
+class MPBatchSolver {
+ public:
+  explicit MPBatchSolver(int num_workers);
+
+  // Waits for all the submitted requests to be solved. The responses that were
+  // not retrieved with Next() are discarded.
+  ~MPBatchSolver();
+
+  // Adds a request to the queue. The tag is an arbitrary value returned with
+  // the response of this request. The second version avoids copying the
+  // request.
+  void Submit(int64 tag, const MPModelRequest& request);
+  void Submit(int64 tag, std::unique_ptr<MPModelRequest> request);
+
+  // Waits for the next solved request and fills its tag and response. Returns
+  // false without waiting if there is no request left, i.e. if all the
+  // submitted requests were already returned.
+  bool Next(int64* tag, MPSolutionResponse* response);
+
+  // Same as Next() but never waits: returns false if no response is ready.
+  bool TryNext(int64* tag, MPSolutionResponse* response);
+
+  // Number of submitted requests whose response was not returned yet.
+  int NumPending() const;
+
+ private:
+  // The solvers owned by one worker, indexed by solver type. Only one request
+  // at a time uses a given Worker.
+  struct Worker {
+    std::vector<std::unique_ptr<MPSolver>> solvers;
+  };
+
+  // Solves the given request, takes its ownership.
+  void SolveRequest(int64 tag, MPModelRequest* request);
+
+  // Moves the front of completed_ to the given tag and response.
+  void PopCompleted(int64* tag, MPSolutionResponse* response)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  mutable Mutex mutex_;
+  CondVar response_ready_;
+  std::vector<Worker*> idle_workers_ GUARDED_BY(mutex_);
+  std::deque<std::pair<int64, MPSolutionResponse>> completed_
+      GUARDED_BY(mutex_);
+  int num_pending_ GUARDED_BY(mutex_);
+
+  // Destroyed first in the destructor, so that no task is running afterwards.
+  std::unique_ptr<ThreadPool> pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(MPBatchSolver);
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_LINEAR_SOLVER_BATCH_SOLVER_H_
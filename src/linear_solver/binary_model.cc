@@ -0,0 +1,570 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "linear_solver/binary_model.h"
+
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // !_MSC_VER
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#include "base/file.h"
+#include "base/join.h"
+#include "base/logging.h"
+#include "linear_solver/linear_solver.pb.h"
+
+namespace operations_research {
+namespace {
+
+const char kMagic[8] = {'M', 'P', 'B', 'M', 'O', 'D', 'E', 'L'};
+const uint32 kVersion = 1;
+// Written with the native byte order, so it reads differently on a machine
+// with another byte order.
+const uint32 kByteOrderMark = 0x01020304;
+
+const double kInfinity = std::numeric_limits<double>::infinity();
+
+struct Header {
+  char magic[8];
+  uint32 version;
+  uint32 byte_order_mark;
+  int64 num_variables;
+  int64 num_constraints;
+  int64 num_entries;
+  int64 names_size;
+  int64 maximize;
+  double objective_offset;
+};
+
+// The sections of the file, in order.
+enum Section {
+  VARIABLE_LOWER_BOUNDS,
+  VARIABLE_UPPER_BOUNDS,
+  OBJECTIVE_COEFFICIENTS,
+  VARIABLE_IS_INTEGER,
+  CONSTRAINT_LOWER_BOUNDS,
+  CONSTRAINT_UPPER_BOUNDS,
+  CONSTRAINT_IS_LAZY,
+  ROW_STARTS,
+  COLUMN_INDICES,
+  COEFFICIENTS,
+  NAME_STARTS,
+  NAMES,
+  NUM_SECTIONS
+};
+
+int64 AlignUp(int64 offset) {
+  return (offset + kMPBinaryModelAlignment - 1) / kMPBinaryModelAlignment *
+         kMPBinaryModelAlignment;
+}
+
+// Fills offsets[s] with the position of the section s in the file, and
+// offsets[NUM_SECTIONS] with the size of the file.
+void ComputeLayout(const Header& header, int64 offsets[NUM_SECTIONS + 1]) {
+  const int64 n = header.num_variables;
+  const int64 m = header.num_constraints;
+  const int64 nnz = header.num_entries;
+  const int64 sizes[NUM_SECTIONS] = {
+      static_cast<int64>(n * sizeof(double)),
+      static_cast<int64>(n * sizeof(double)),
+      static_cast<int64>(n * sizeof(double)),
+      static_cast<int64>(n * sizeof(uint8)),
+      static_cast<int64>(m * sizeof(double)),
+      static_cast<int64>(m * sizeof(double)),
+      static_cast<int64>(m * sizeof(uint8)),
+      static_cast<int64>((m + 1) * sizeof(int64)),
+      static_cast<int64>(nnz * sizeof(int32)),
+      static_cast<int64>(nnz * sizeof(double)),
+      static_cast<int64>((n + m + 2) * sizeof(int64)),
+      header.names_size};
+  int64 offset = AlignUp(sizeof(Header));
+  for (int s = 0; s < NUM_SECTIONS; ++s) {
+    offsets[s] = offset;
+    offset = AlignUp(offset + sizes[s]);
+  }
+  offsets[NUM_SECTIONS] = offset;
+}
+
+// Appends data to a file through a fixed-size buffer.
+class BufferedWriter {
+ public:
+  explicit BufferedWriter(File* file)
+      : file_(file), buffer_(), position_(0), ok_(true) {
+    buffer_.reserve(kBufferSize);
+  }
+
+  template <class T>
+  void Append(T value) {
+    AppendBytes(&value, sizeof(value));
+  }
+
+  void AppendBytes(const void* data, size_t size) {
+    position_ += size;
+    if (buffer_.size() + size > kBufferSize) {
+      Flush();
+      if (size >= kBufferSize) {
+        ok_ &= file_->Write(data, size) == size;
+        return;
+      }
+    }
+    const char* const bytes = static_cast<const char*>(data);
+    buffer_.insert(buffer_.end(), bytes, bytes + size);
+  }
+
+  // Appends zeros up to the given position in the file.
+  void PadTo(int64 position) {
+    DCHECK_GE(position, position_);
+    const char zeros[kMPBinaryModelAlignment] = {0};
+    while (position_ < position) {
+      AppendBytes(zeros, std::min<int64>(kMPBinaryModelAlignment,
+                                         position - position_));
+    }
+  }
+
+  // Writes the content of the buffer. Returns false if any write failed.
+  bool Flush() {
+    if (!buffer_.empty()) {
+      ok_ &= file_->Write(buffer_.data(), buffer_.size()) == buffer_.size();
+      buffer_.clear();
+    }
+    return ok_;
+  }
+
+ private:
+  static const size_t kBufferSize = 1 << 20;
+
+  File* const file_;
+  std::vector<char> buffer_;
+  int64 position_;
+  bool ok_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferedWriter);
+};
+
+}  // namespace
+
+bool WriteModelAsBinaryFile(const MPModelProto& model,
+                            const std::string& filename,
+                            std::string* error_message) {
+  CHECK(error_message != nullptr);
+  Header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.byte_order_mark = kByteOrderMark;
+  header.num_variables = model.variable_size();
+  header.num_constraints = model.constraint_size();
+  header.maximize = model.maximize();
+  header.objective_offset = model.objective_offset();
+
+  // First pass: checks the structure of the model and computes the dimensions
+  // of the sections.
+  header.names_size = model.name().size();
+  for (const MPVariableProto& variable : model.variable()) {
+    header.names_size += variable.name().size();
+  }
+  for (int i = 0; i < model.constraint_size(); ++i) {
+    const MPConstraintProto& constraint = model.constraint(i);
+    if (constraint.var_index_size() != constraint.coefficient_size()) {
+      *error_message = StrCat("In constraint #", i,
+                              ": var_index_size() != coefficient_size() (",
+                              constraint.var_index_size(), " VS ",
+                              constraint.coefficient_size());
+      return false;
+    }
+    for (int k = 0; k < constraint.var_index_size(); ++k) {
+      const int var_index = constraint.var_index(k);
+      if (var_index < 0 || var_index >= model.variable_size()) {
+        *error_message = StrCat("In constraint #", i, ": var_index(", k, ")=",
+                                var_index, " is out of bounds");
+        return false;
+      }
+    }
+    header.num_entries += constraint.var_index_size();
+    header.names_size += constraint.name().size();
+  }
+  int64 offsets[NUM_SECTIONS + 1];
+  ComputeLayout(header, offsets);
+
+  std::unique_ptr<File> file(File::Open(filename, "wb"));
+  if (file == nullptr) {
+    *error_message = StrCat("Could not open ", filename, " for writing");
+    return false;
+  }
+  BufferedWriter writer(file.get());
+  writer.AppendBytes(&header, sizeof(header));
+
+  // The sections, each generated by one pass over the model.
+  writer.PadTo(offsets[VARIABLE_LOWER_BOUNDS]);
+  for (const MPVariableProto& variable : model.variable()) {
+    writer.Append<double>(variable.lower_bound());
+  }
+  writer.PadTo(offsets[VARIABLE_UPPER_BOUNDS]);
+  for (const MPVariableProto& variable : model.variable()) {
+    writer.Append<double>(variable.upper_bound());
+  }
+  writer.PadTo(offsets[OBJECTIVE_COEFFICIENTS]);
+  for (const MPVariableProto& variable : model.variable()) {
+    writer.Append<double>(variable.objective_coefficient());
+  }
+  writer.PadTo(offsets[VARIABLE_IS_INTEGER]);
+  for (const MPVariableProto& variable : model.variable()) {
+    writer.Append<uint8>(variable.is_integer());
+  }
+  writer.PadTo(offsets[CONSTRAINT_LOWER_BOUNDS]);
+  for (const MPConstraintProto& constraint : model.constraint()) {
+    writer.Append<double>(constraint.lower_bound());
+  }
+  writer.PadTo(offsets[CONSTRAINT_UPPER_BOUNDS]);
+  for (const MPConstraintProto& constraint : model.constraint()) {
+    writer.Append<double>(constraint.upper_bound());
+  }
+  writer.PadTo(offsets[CONSTRAINT_IS_LAZY]);
+  for (const MPConstraintProto& constraint : model.constraint()) {
+    writer.Append<uint8>(constraint.is_lazy());
+  }
+  writer.PadTo(offsets[ROW_STARTS]);
+  int64 row_start = 0;
+  writer.Append<int64>(row_start);
+  for (const MPConstraintProto& constraint : model.constraint()) {
+    row_start += constraint.var_index_size();
+    writer.Append<int64>(row_start);
+  }
+  writer.PadTo(offsets[COLUMN_INDICES]);
+  for (const MPConstraintProto& constraint : model.constraint()) {
+    for (const int var_index : constraint.var_index()) {
+      writer.Append<int32>(var_index);
+    }
+  }
+  writer.PadTo(offsets[COEFFICIENTS]);
+  for (const MPConstraintProto& constraint : model.constraint()) {
+    for (const double coefficient : constraint.coefficient()) {
+      writer.Append<double>(coefficient);
+    }
+  }
+  writer.PadTo(offsets[NAME_STARTS]);
+  int64 name_start = 0;
+  writer.Append<int64>(name_start);
+  name_start += model.name().size();
+  writer.Append<int64>(name_start);
+  for (const MPVariableProto& variable : model.variable()) {
+    name_start += variable.name().size();
+    writer.Append<int64>(name_start);
+  }
+  for (const MPConstraintProto& constraint : model.constraint()) {
+    name_start += constraint.name().size();
+    writer.Append<int64>(name_start);
+  }
+  writer.PadTo(offsets[NAMES]);
+  writer.AppendBytes(model.name().data(), model.name().size());
+  for (const MPVariableProto& variable : model.variable()) {
+    writer.AppendBytes(variable.name().data(), variable.name().size());
+  }
+  for (const MPConstraintProto& constraint : model.constraint()) {
+    writer.AppendBytes(constraint.name().data(), constraint.name().size());
+  }
+  writer.PadTo(offsets[NUM_SECTIONS]);
+
+  const bool write_ok = writer.Flush();
+  if (!file->Close() || !write_ok) {
+    *error_message = StrCat("Error while writing ", filename);
+    return false;
+  }
+  return true;
+}
+
+MPBinaryModel::MPBinaryModel()
+    : data_(nullptr), size_(0), is_mapped_(false), buffer_() {
+  Close();
+}
+
+MPBinaryModel::~MPBinaryModel() { Close(); }
+
+bool MPBinaryModel::Open(const std::string& filename,
+                         std::string* error_message) {
+  CHECK(error_message != nullptr);
+  Close();
+#if defined(_MSC_VER)
+  // No memory mapping: the file is read in an int64 buffer, which has the
+  // alignment needed by the sections.
+  std::unique_ptr<File> file(File::Open(filename, "rb"));
+  if (file == nullptr) {
+    *error_message = StrCat("Could not open ", filename);
+    return false;
+  }
+  size_ = file->Size();
+  buffer_.resize((size_ + sizeof(int64) - 1) / sizeof(int64));
+  const bool read_ok = file->Read(buffer_.data(), size_) == size_;
+  file->Close();
+  if (!read_ok) {
+    *error_message = StrCat("Error while reading ", filename);
+    Close();
+    return false;
+  }
+  data_ = reinterpret_cast<const char*>(buffer_.data());
+#else   // _MSC_VER
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    *error_message = StrCat("Could not open ", filename);
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    *error_message = StrCat("Could not stat ", filename);
+    return false;
+  }
+  size_ = file_stat.st_size;
+  if (size_ > 0) {
+    void* const mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      close(fd);
+      *error_message = StrCat("Could not map ", filename);
+      size_ = 0;
+      return false;
+    }
+    data_ = static_cast<const char*>(mapping);
+    is_mapped_ = true;
+  }
+  close(fd);
+#endif  // _MSC_VER
+  if (!Parse(error_message)) {
+    *error_message = StrCat(filename, ": ", *error_message);
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void MPBinaryModel::Close() {
+#if !defined(_MSC_VER)
+  if (is_mapped_) munmap(const_cast<char*>(data_), size_);
+#endif  // !_MSC_VER
+  data_ = nullptr;
+  size_ = 0;
+  is_mapped_ = false;
+  buffer_.clear();
+  num_variables_ = 0;
+  num_constraints_ = 0;
+  num_entries_ = 0;
+  maximize_ = false;
+  objective_offset_ = 0.0;
+  variable_lower_bounds_ = nullptr;
+  variable_upper_bounds_ = nullptr;
+  objective_coefficients_ = nullptr;
+  variable_is_integer_ = nullptr;
+  constraint_lower_bounds_ = nullptr;
+  constraint_upper_bounds_ = nullptr;
+  constraint_is_lazy_ = nullptr;
+  row_starts_ = nullptr;
+  column_indices_ = nullptr;
+  coefficients_ = nullptr;
+  name_starts_ = nullptr;
+  names_ = nullptr;
+}
+
+bool MPBinaryModel::Parse(std::string* error_message) {
+  Header header;
+  if (size_ < sizeof(header)) {
+    *error_message = "File too small";
+    return false;
+  }
+  memcpy(&header, data_, sizeof(header));
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    *error_message = "Not a binary model file";
+    return false;
+  }
+  if (header.byte_order_mark != kByteOrderMark) {
+    *error_message = "The file was written with another byte order";
+    return false;
+  }
+  if (header.version != kVersion) {
+    *error_message = StrCat("Unsupported version ", header.version);
+    return false;
+  }
+  // These bounds make sure that the computation of the layout cannot overflow.
+  const int64 kMaxIndex = std::numeric_limits<int32>::max() - 1;
+  if (header.num_variables < 0 || header.num_variables > kMaxIndex ||
+      header.num_constraints < 0 || header.num_constraints > kMaxIndex ||
+      header.num_entries < 0 || header.num_entries > size_ ||
+      header.names_size < 0 || header.names_size > size_) {
+    *error_message = "Invalid dimensions";
+    return false;
+  }
+  int64 offsets[NUM_SECTIONS + 1];
+  ComputeLayout(header, offsets);
+  if (offsets[NUM_SECTIONS] > size_) {
+    *error_message = StrCat("Truncated file: ", size_, " bytes instead of ",
+                            offsets[NUM_SECTIONS]);
+    return false;
+  }
+  // Extra bytes mean that the sections are not where the layout puts them, for
+  // instance because they were written without their padding.
+  if (offsets[NUM_SECTIONS] != size_) {
+    *error_message = StrCat("Misaligned file: ", size_, " bytes instead of ",
+                            offsets[NUM_SECTIONS]);
+    return false;
+  }
+
+  num_variables_ = header.num_variables;
+  num_constraints_ = header.num_constraints;
+  num_entries_ = header.num_entries;
+  maximize_ = header.maximize != 0;
+  objective_offset_ = header.objective_offset;
+  variable_lower_bounds_ =
+      reinterpret_cast<const double*>(data_ + offsets[VARIABLE_LOWER_BOUNDS]);
+  variable_upper_bounds_ =
+      reinterpret_cast<const double*>(data_ + offsets[VARIABLE_UPPER_BOUNDS]);
+  objective_coefficients_ =
+      reinterpret_cast<const double*>(data_ + offsets[OBJECTIVE_COEFFICIENTS]);
+  variable_is_integer_ =
+      reinterpret_cast<const uint8*>(data_ + offsets[VARIABLE_IS_INTEGER]);
+  constraint_lower_bounds_ =
+      reinterpret_cast<const double*>(data_ + offsets[CONSTRAINT_LOWER_BOUNDS]);
+  constraint_upper_bounds_ =
+      reinterpret_cast<const double*>(data_ + offsets[CONSTRAINT_UPPER_BOUNDS]);
+  constraint_is_lazy_ =
+      reinterpret_cast<const uint8*>(data_ + offsets[CONSTRAINT_IS_LAZY]);
+  row_starts_ = reinterpret_cast<const int64*>(data_ + offsets[ROW_STARTS]);
+  column_indices_ =
+      reinterpret_cast<const int32*>(data_ + offsets[COLUMN_INDICES]);
+  coefficients_ = reinterpret_cast<const double*>(data_ + offsets[COEFFICIENTS]);
+  name_starts_ = reinterpret_cast<const int64*>(data_ + offsets[NAME_STARTS]);
+  names_ = data_ + offsets[NAMES];
+
+  // The accessors rely on the following properties.
+  if (row_starts_[0] != 0 || row_starts_[num_constraints_] != num_entries_) {
+    *error_message = "Invalid row_starts";
+    return false;
+  }
+  for (int i = 0; i < num_constraints_; ++i) {
+    if (row_starts_[i] > row_starts_[i + 1]) {
+      *error_message = StrCat("Invalid row_starts[", i + 1, "]");
+      return false;
+    }
+  }
+  for (int64 k = 0; k < num_entries_; ++k) {
+    if (column_indices_[k] < 0 || column_indices_[k] >= num_variables_) {
+      *error_message = StrCat("column_indices[", k, "]=", column_indices_[k],
+                              " is out of bounds");
+      return false;
+    }
+  }
+  const int64 num_names = num_variables_ + num_constraints_ + 1;
+  if (name_starts_[0] != 0 || name_starts_[num_names] != header.names_size) {
+    *error_message = "Invalid name_starts";
+    return false;
+  }
+  for (int64 i = 0; i < num_names; ++i) {
+    if (name_starts_[i] > name_starts_[i + 1]) {
+      *error_message = StrCat("Invalid name_starts[", i + 1, "]");
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string MPBinaryModel::FindError() const {
+  if (!std::isfinite(objective_offset_)) {
+    return StrCat("Invalid objective_offset: ", objective_offset_);
+  }
+  for (int i = 0; i < num_variables_; ++i) {
+    const double lb = variable_lower_bounds_[i];
+    const double ub = variable_upper_bounds_[i];
+    if (std::isnan(lb) || std::isnan(ub) || lb == kInfinity ||
+        ub == -kInfinity || lb > ub) {
+      return StrCat("In variable #", i, ": Infeasible bounds: [", lb, ", ", ub,
+                    "]");
+    }
+    if (variable_is_integer_[i] && ceil(lb) > floor(ub)) {
+      return StrCat("In variable #", i,
+                    ": Infeasible bounds for integer variable: [", lb, ", ",
+                    ub, "] translate to the empty set");
+    }
+    if (!std::isfinite(objective_coefficients_[i])) {
+      return StrCat("In variable #", i, ": Invalid objective_coefficient: ",
+                    objective_coefficients_[i]);
+    }
+  }
+  std::vector<bool> var_mask(num_variables_, false);
+  for (int i = 0; i < num_constraints_; ++i) {
+    const double lb = constraint_lower_bounds_[i];
+    const double ub = constraint_upper_bounds_[i];
+    if (std::isnan(lb) || std::isnan(ub) || lb == kInfinity ||
+        ub == -kInfinity || lb > ub) {
+      return StrCat("In constraint #", i, ": Infeasible bounds: [", lb, ", ",
+                    ub, "]");
+    }
+    const int64 begin = row_starts_[i];
+    const int64 end = row_starts_[i + 1];
+    int duplicate_var_index = -1;
+    for (int64 k = begin; k < end; ++k) {
+      if (!std::isfinite(coefficients_[k])) {
+        return StrCat("In constraint #", i, ": coefficient(", k - begin, ")=",
+                      coefficients_[k], " is invalid");
+      }
+      if (var_mask[column_indices_[k]]) {
+        duplicate_var_index = column_indices_[k];
+      }
+      var_mask[column_indices_[k]] = true;
+    }
+    for (int64 k = begin; k < end; ++k) var_mask[column_indices_[k]] = false;
+    if (duplicate_var_index >= 0) {
+      return StrCat("In constraint #", i, ": var_index #", duplicate_var_index,
+                    " appears several times");
+    }
+  }
+  return std::string();
+}
+
+void MPBinaryModel::ExportToProto(bool clear_names,
+                                  MPModelProto* output) const {
+  CHECK(output != nullptr);
+  output->Clear();
+  if (!clear_names) name().CopyToString(output->mutable_name());
+  output->set_maximize(maximize_);
+  output->set_objective_offset(objective_offset_);
+  for (int j = 0; j < num_variables_; ++j) {
+    MPVariableProto* const variable = output->add_variable();
+    if (!clear_names) variable_name(j).CopyToString(variable->mutable_name());
+    variable->set_lower_bound(variable_lower_bounds_[j]);
+    variable->set_upper_bound(variable_upper_bounds_[j]);
+    variable->set_objective_coefficient(objective_coefficients_[j]);
+    variable->set_is_integer(variable_is_integer_[j] != 0);
+  }
+  for (int i = 0; i < num_constraints_; ++i) {
+    MPConstraintProto* const constraint = output->add_constraint();
+    if (!clear_names) {
+      constraint_name(i).CopyToString(constraint->mutable_name());
+    }
+    constraint->set_lower_bound(constraint_lower_bounds_[i]);
+    constraint->set_upper_bound(constraint_upper_bounds_[i]);
+    constraint->set_is_lazy(constraint_is_lazy_[i] != 0);
+    constraint->mutable_var_index()->Reserve(row_starts_[i + 1] -
+                                             row_starts_[i]);
+    constraint->mutable_coefficient()->Reserve(row_starts_[i + 1] -
+                                               row_starts_[i]);
+    for (int64 k = row_starts_[i]; k < row_starts_[i + 1]; ++k) {
+      constraint->add_var_index(column_indices_[k]);
+      constraint->add_coefficient(coefficients_[k]);
+    }
+  }
+}
+
+}  // namespace operations_research
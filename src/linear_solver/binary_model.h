@@ -0,0 +1,179 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A columnar binary format for the models of MPModelProto, designed to be
+// written in a stream and memory-mapped for reading, without any parsing.
+//
+// A file is a fixed-size header, holding the dimensions of the model, followed
+// by one section per array below. Each section starts at a multiple of
+// kMPBinaryModelAlignment bytes, and its position only depends on the
+// dimensions of the model, as does the size of the file, padded up to the
+// alignment after the last section:
+//   variable_lower_bounds    double[num_variables]
+//   variable_upper_bounds    double[num_variables]
+//   objective_coefficients   double[num_variables]
+//   variable_is_integer      uint8[num_variables]
+//   constraint_lower_bounds  double[num_constraints]
+//   constraint_upper_bounds  double[num_constraints]
+//   constraint_is_lazy       uint8[num_constraints]
+//   row_starts               int64[num_constraints + 1]
+//   column_indices           int32[num_entries]
+//   coefficients             double[num_entries]
+//   name_starts              int64[num_variables + num_constraints + 2]
+//   names                    char[name_starts[num_variables + num_constraints
+//                                             + 1]]
+// The matrix is stored in compressed sparse row (CSR) format: the terms of the
+// i-th constraint are at the positions [row_starts[i], row_starts[i + 1]) of
+// column_indices and coefficients. The names form a string table: the model
+// name, the variable names and the constraint names, in this order, are the
+// consecutive ranges of names delimited by name_starts.
+//
+// The arrays use the native byte order of the machine that wrote the file.
+// It is recorded in the header, and files with another byte order are rejected.
+// The solution hint of MPModelProto is not stored.
+//
+// Example:
+//   std::string error;
+//   CHECK(WriteModelAsBinaryFile(model_proto, "/tmp/model.mpb", &error));
+//   MPBinaryModel model;
+//   CHECK(model.Open("/tmp/model.mpb", &error)) << error;
+//   MPSolver solver("replay", MPSolver::GLOP_LINEAR_PROGRAMMING);
+//   MPSolutionResponse response;
+//   solver.ClearAndSolveBinaryModel(model, &response);
+
+#ifndef OR_TOOLS_LINEAR_SOLVER_BINARY_MODEL_H_
+#define OR_TOOLS_LINEAR_SOLVER_BINARY_MODEL_H_
+
+#include <string>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "base/stringpiece.h"
+
+namespace operations_research {
+
+class MPModelProto;
+
+// The alignment, in bytes, of the header and of each section of the file.
+static const int kMPBinaryModelAlignment = 64;
+
+// Writes the given model to the given file in the binary format above. The
+// arrays are generated one after the other from the proto and written through
+// a fixed-size buffer, so the file is never entirely in memory. Returns false
+// and fills error_message if the model is malformed (coefficients and indices
+// of a constraint of different sizes, or indices out of bounds) or if the file
+// cannot be written. The bounds and coefficients are not otherwise checked, so
+// that any model can be archived.
+bool WriteModelAsBinaryFile(const MPModelProto& model,
+                            const std::string& filename,
+                            std::string* error_message);
+
+// A read-only view of a model in the binary format above. The file is mapped
+// in memory, and all the accessors point directly into the mapping, which
+// stays valid until the next Open() or the destruction of this object.
+class MPBinaryModel {
+ public:
+  MPBinaryModel();
+  ~MPBinaryModel();
+
+  // Maps the given file. Returns false and fills error_message if it cannot be
+  // read or is not a valid binary model. All the structural properties needed
+  // to use the accessors safely are checked here (dimensions, row_starts,
+  // column_indices and name_starts), in time linear in the number of
+  // constraints and entries. The values are checked by FindError().
+  bool Open(const std::string& filename, std::string* error_message);
+
+  // Unmaps the current file, if any. The model is then empty.
+  void Close();
+
+  // Returns an empty string iff the model is valid, with the same rules and
+  // messages as FindErrorInMPModelProto() from model_validator.h.
+  std::string FindError() const;
+
+  // Fills the given proto with the model, except the names if clear_names is
+  // true.
+  void ExportToProto(bool clear_names, MPModelProto* output) const;
+
+  int num_variables() const { return num_variables_; }
+  int num_constraints() const { return num_constraints_; }
+  int64 num_entries() const { return num_entries_; }
+  bool maximize() const { return maximize_; }
+  double objective_offset() const { return objective_offset_; }
+
+  const double* variable_lower_bounds() const { return variable_lower_bounds_; }
+  const double* variable_upper_bounds() const { return variable_upper_bounds_; }
+  const double* objective_coefficients() const {
+    return objective_coefficients_;
+  }
+  const uint8* variable_is_integer() const { return variable_is_integer_; }
+  const double* constraint_lower_bounds() const {
+    return constraint_lower_bounds_;
+  }
+  const double* constraint_upper_bounds() const {
+    return constraint_upper_bounds_;
+  }
+  const uint8* constraint_is_lazy() const { return constraint_is_lazy_; }
+  const int64* row_starts() const { return row_starts_; }
+  const int32* column_indices() const { return column_indices_; }
+  const double* coefficients() const { return coefficients_; }
+
+  StringPiece name() const { return Name(0); }
+  StringPiece variable_name(int var_index) const {
+    return Name(1 + var_index);
+  }
+  StringPiece constraint_name(int ct_index) const {
+    return Name(1 + num_variables_ + ct_index);
+  }
+
+ private:
+  StringPiece Name(int64 i) const {
+    return StringPiece(names_ + name_starts_[i],
+                       name_starts_[i + 1] - name_starts_[i]);
+  }
+
+  // Sets all the pointers and dimensions from data_ and size_. Returns false
+  // and fills error_message if the data is not a valid binary model.
+  bool Parse(std::string* error_message);
+
+  // The mapped file, or a copy of it in buffer_ if memory mapping is not
+  // available on this platform.
+  const char* data_;
+  int64 size_;
+  bool is_mapped_;
+  std::vector<int64> buffer_;
+
+  int num_variables_;
+  int num_constraints_;
+  int64 num_entries_;
+  bool maximize_;
+  double objective_offset_;
+  const double* variable_lower_bounds_;
+  const double* variable_upper_bounds_;
+  const double* objective_coefficients_;
+  const uint8* variable_is_integer_;
+  const double* constraint_lower_bounds_;
+  const double* constraint_upper_bounds_;
+  const uint8* constraint_is_lazy_;
+  const int64* row_starts_;
+  const int32* column_indices_;
+  const double* coefficients_;
+  const int64* name_starts_;
+  const char* names_;
+
+  DISALLOW_COPY_AND_ASSIGN(MPBinaryModel);
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_LINEAR_SOLVER_BINARY_MODEL_H_
@@ -11,6 +11,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <fstream>
@@ -113,7 +114,7 @@ class BopInterface : public MPSolverInterface {
   std::vector<MPSolver::BasisStatus> row_status_;
   bop::BopParameters parameters_;
   double best_objective_bound_;
-  bool interrupt_solver_;
+  std::atomic<bool> interrupt_solver_;
 };
 
 BopInterface::BopInterface(MPSolver* const solver)
@@ -302,9 +303,11 @@ void BopInterface::ExtractNewVariables() {
   const glop::ColIndex num_cols(solver_->variables_.size());
   for (glop::ColIndex col(last_variable_index_); col < num_cols; ++col) {
     MPVariable* const var = solver_->variables_[col.value()];
-    const glop::ColIndex new_col =
-        linear_program_.FindOrCreateVariable(var->name());
+    // The MPSolver names are unique, so there is no need to go through the
+    // name lookup of FindOrCreateVariable().
+    const glop::ColIndex new_col = linear_program_.CreateNewVariable();
     DCHECK_EQ(new_col, col);
+    linear_program_.SetVariableName(col, var->name());
     set_variable_as_extracted(col.value(), true);
     linear_program_.SetVariableBounds(col, var->lb(), var->ub());
     linear_program_.SetVariableIntegrality(col, var->integer());
@@ -322,9 +325,9 @@ void BopInterface::ExtractNewConstraints() {
 
     const double lb = ct->lb();
     const double ub = ct->ub();
-    const glop::RowIndex new_row =
-        linear_program_.FindOrCreateConstraint(ct->name());
+    const glop::RowIndex new_row = linear_program_.CreateNewConstraint();
     DCHECK_EQ(new_row, row);
+    linear_program_.SetConstraintName(row, ct->name());
     linear_program_.SetConstraintBounds(row, lb, ub);
 
     for (CoeffEntry entry : ct->coefficients_) {
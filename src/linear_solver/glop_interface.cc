@@ -13,6 +13,7 @@
 
 
 #include "base/hash.h"
+#include <atomic>
 #include <string>
 #include <vector>
 #include <fstream>
@@ -35,6 +36,8 @@
 #include "base/hash.h"
 #include "glop/lp_solver.h"
 #include "glop/parameters.pb.h"
+#include "linear_solver/binary_model.h"
+#include "linear_solver/glop_utils.h"
 #include "linear_solver/linear_solver.h"
 #include "lp_data/lp_data.h"
 #include "lp_data/lp_types.h"
@@ -44,36 +47,6 @@ namespace operations_research {
 
 namespace {
 
-MPSolver::ResultStatus TranslateProblemStatus(glop::ProblemStatus status) {
-  switch (status) {
-    case glop::ProblemStatus::OPTIMAL:
-      return MPSolver::OPTIMAL;
-    case glop::ProblemStatus::PRIMAL_FEASIBLE:
-      return MPSolver::FEASIBLE;
-    case glop::ProblemStatus::PRIMAL_INFEASIBLE:  // PASS_THROUGH_INTENDED
-    case glop::ProblemStatus::DUAL_UNBOUNDED:
-      return MPSolver::INFEASIBLE;
-    case glop::ProblemStatus::PRIMAL_UNBOUNDED:
-      return MPSolver::UNBOUNDED;
-    case glop::ProblemStatus::DUAL_FEASIBLE:  // PASS_THROUGH_INTENDED
-    case glop::ProblemStatus::INIT:
-      return MPSolver::NOT_SOLVED;
-    // TODO(user): Glop may return ProblemStatus::DUAL_INFEASIBLE or
-    // ProblemStatus::INFEASIBLE_OR_UNBOUNDED.
-    // Unfortunatley, the wrapper does not support this return status at this
-    // point (even though Cplex and Gurobi have the equivalent). So we convert
-    // it to MPSolver::ABNORMAL instead.
-    case glop::ProblemStatus::DUAL_INFEASIBLE:          // PASS_THROUGH_INTENDED
-    case glop::ProblemStatus::INFEASIBLE_OR_UNBOUNDED:  // PASS_THROUGH_INTENDED
-    case glop::ProblemStatus::ABNORMAL:                 // PASS_THROUGH_INTENDED
-    case glop::ProblemStatus::IMPRECISE:                // PASS_THROUGH_INTENDED
-    case glop::ProblemStatus::INVALID_PROBLEM:
-      return MPSolver::ABNORMAL;
-  }
-  LOG(DFATAL) << "Invalid glop::ProblemStatus " << status;
-  return MPSolver::ABNORMAL;
-}
-
 MPSolver::BasisStatus TranslateVariableStatus(glop::VariableStatus status) {
   switch (status) {
     case glop::VariableStatus::FREE:
@@ -117,6 +90,9 @@ class GLOPInterface : public MPSolverInterface {
   // ----- Solve -----
   MPSolver::ResultStatus Solve(const MPSolverParameters& param) override;
   bool InterruptSolve() override;
+  bool SolveBinaryModel(const MPBinaryModel& model,
+                        const MPSolverParameters& param,
+                        std::vector<double>* variable_values) override;
 
   // ----- Model modifications and extraction -----
   void Reset() override;
@@ -166,12 +142,16 @@ class GLOPInterface : public MPSolverInterface {
  private:
   void NonIncrementalChange();
 
+  // Solves linear_program_ with the current parameters and sets the result
+  // status and the objective value.
+  void SolveLinearProgram();
+
   glop::LinearProgram linear_program_;
   glop::LPSolver lp_solver_;
   std::vector<MPSolver::BasisStatus> column_status_;
   std::vector<MPSolver::BasisStatus> row_status_;
   glop::GlopParameters parameters_;
-  bool interrupt_solver_;
+  std::atomic<bool> interrupt_solver_;
 };
 
 GLOPInterface::GLOPInterface(MPSolver* const solver)
@@ -192,39 +172,15 @@ MPSolver::ResultStatus GLOPInterface::Solve(const MPSolverParameters& param) {
   SetParameters(param);
 
   linear_program_.SetMaximizationProblem(maximize_);
-  linear_program_.CleanUp();
-
-  // Time limit.
-  if (solver_->time_limit()) {
-    VLOG(1) << "Setting time limit = " << solver_->time_limit() << " ms.";
-    parameters_.set_max_time_in_seconds(
-        static_cast<double>(solver_->time_limit()) / 1000.0);
-  }
-
-  solver_->SetSolverSpecificParametersAsString(
-      solver_->solver_specific_parameter_string_);
-  lp_solver_.SetParameters(parameters_);
-  std::unique_ptr<TimeLimit> time_limit =
-      TimeLimit::FromParameters(parameters_);
-  time_limit->RegisterExternalBooleanAsLimit(&interrupt_solver_);
-  const glop::ProblemStatus status =
-      lp_solver_.SolveWithTimeLimit(linear_program_, time_limit.get());
-
-  // The solution must be marked as synchronized even when no solution exists.
-  sync_status_ = SOLUTION_SYNCHRONIZED;
-  result_status_ = TranslateProblemStatus(status);
-  objective_value_ = lp_solver_.GetObjectiveValue();
+  SolveLinearProgram();
 
+  GlopInterfaceUtils::SetSolutionValues(lp_solver_.variable_values(), solver_);
   const size_t num_vars = solver_->variables_.size();
   column_status_.resize(num_vars, MPSolver::FREE);
   for (int var_id = 0; var_id < num_vars; ++var_id) {
     MPVariable* const var = solver_->variables_[var_id];
     const glop::ColIndex lp_solver_var_id(var->index());
 
-    const glop::Fractional solution_value =
-        lp_solver_.variable_values()[lp_solver_var_id];
-    var->set_solution_value(static_cast<double>(solution_value));
-
     const glop::Fractional reduced_cost =
         lp_solver_.reduced_costs()[lp_solver_var_id];
     var->set_reduced_cost(static_cast<double>(reduced_cost));
@@ -252,6 +208,63 @@ MPSolver::ResultStatus GLOPInterface::Solve(const MPSolverParameters& param) {
   return result_status_;
 }
 
+bool GLOPInterface::SolveBinaryModel(const MPBinaryModel& model,
+                                     const MPSolverParameters& param,
+                                     std::vector<double>* variable_values) {
+  DCHECK_EQ(0, solver_->NumVariables());
+  Reset();
+  SetParameters(param);
+
+  // The names are not needed by glop and are not copied.
+  const glop::ColIndex num_cols(model.num_variables());
+  for (glop::ColIndex col(0); col < num_cols; ++col) {
+    linear_program_.CreateNewVariable();
+    linear_program_.SetVariableBounds(col,
+                                      model.variable_lower_bounds()[col.value()],
+                                      model.variable_upper_bounds()[col.value()]);
+    linear_program_.SetObjectiveCoefficient(
+        col, model.objective_coefficients()[col.value()]);
+  }
+  const glop::RowIndex num_rows(model.num_constraints());
+  for (glop::RowIndex row(0); row < num_rows; ++row) {
+    linear_program_.CreateNewConstraint();
+    linear_program_.SetConstraintBounds(
+        row, model.constraint_lower_bounds()[row.value()],
+        model.constraint_upper_bounds()[row.value()]);
+  }
+
+  // The matrix is transposed from the CSR arrays to the columns of glop. The
+  // columns are sized beforehand and filled in increasing row order, so they
+  // are only allocated once and are already sorted.
+  std::vector<int> column_sizes(model.num_variables(), 0);
+  for (int64 k = 0; k < model.num_entries(); ++k) {
+    ++column_sizes[model.column_indices()[k]];
+  }
+  for (glop::ColIndex col(0); col < num_cols; ++col) {
+    linear_program_.GetMutableSparseColumn(col)->Reserve(
+        glop::EntryIndex(column_sizes[col.value()]));
+  }
+  for (glop::RowIndex row(0); row < num_rows; ++row) {
+    for (int64 k = model.row_starts()[row.value()];
+         k < model.row_starts()[row.value() + 1]; ++k) {
+      const glop::ColIndex col(model.column_indices()[k]);
+      linear_program_.GetMutableSparseColumn(col)->SetCoefficient(
+          row, model.coefficients()[k]);
+    }
+  }
+  linear_program_.SetObjectiveOffset(model.objective_offset());
+  linear_program_.SetMaximizationProblem(model.maximize());
+  SolveLinearProgram();
+
+  variable_values->assign(model.num_variables(), 0.0);
+  for (glop::ColIndex col(0); col < num_cols; ++col) {
+    (*variable_values)[col.value()] = lp_solver_.variable_values()[col];
+  }
+  // The extracted model does not correspond to the one of solver_.
+  sync_status_ = MUST_RELOAD;
+  return true;
+}
+
 bool GLOPInterface::InterruptSolve() {
   interrupt_solver_ = true;
   return true;
@@ -344,51 +357,24 @@ void* GLOPInterface::underlying_solver() { return &lp_solver_; }
 void GLOPInterface::ExtractNewVariables() {
   DCHECK_EQ(0, last_variable_index_);
   DCHECK_EQ(0, last_constraint_index_);
-
-  const glop::ColIndex num_cols(solver_->variables_.size());
-  for (glop::ColIndex col(last_variable_index_); col < num_cols; ++col) {
-    MPVariable* const var = solver_->variables_[col.value()];
-    const glop::ColIndex new_col =
-        linear_program_.FindOrCreateVariable(var->name());
-    DCHECK_EQ(new_col, col);
-    set_variable_as_extracted(col.value(), true);
-    linear_program_.SetVariableBounds(col, var->lb(), var->ub());
+  GlopInterfaceUtils::ExtractVariables(*solver_, /*with_integrality=*/false,
+                                       &linear_program_);
+  for (int var_index = 0; var_index < solver_->variables_.size();
+       ++var_index) {
+    set_variable_as_extracted(var_index, true);
   }
 }
 
 void GLOPInterface::ExtractNewConstraints() {
   DCHECK_EQ(0, last_constraint_index_);
-
-  const glop::RowIndex num_rows(solver_->constraints_.size());
-  for (glop::RowIndex row(0); row < num_rows; ++row) {
-    MPConstraint* const ct = solver_->constraints_[row.value()];
-    set_constraint_as_extracted(row.value(), true);
-
-    const double lb = ct->lb();
-    const double ub = ct->ub();
-    const glop::RowIndex new_row =
-        linear_program_.FindOrCreateConstraint(ct->name());
-    DCHECK_EQ(new_row, row);
-    linear_program_.SetConstraintBounds(row, lb, ub);
-
-    for (CoeffEntry entry : ct->coefficients_) {
-      const int var_index = entry.first->index();
-      DCHECK(variable_is_extracted(var_index));
-      const glop::ColIndex col(var_index);
-      const double coeff = entry.second;
-      linear_program_.SetCoefficient(row, col, coeff);
-    }
+  GlopInterfaceUtils::ExtractConstraints(*solver_, &linear_program_);
+  for (int ct_index = 0; ct_index < solver_->constraints_.size(); ++ct_index) {
+    set_constraint_as_extracted(ct_index, true);
   }
 }
 
 void GLOPInterface::ExtractObjective() {
-  linear_program_.SetObjectiveOffset(solver_->Objective().offset());
-  for (CoeffEntry entry : solver_->objective_->coefficients_) {
-    const int var_index = entry.first->index();
-    const glop::ColIndex col(var_index);
-    const double coeff = entry.second;
-    linear_program_.SetObjectiveCoefficient(col, coeff);
-  }
+  GlopInterfaceUtils::ExtractObjective(*solver_, &linear_program_);
 }
 
 void GLOPInterface::SetParameters(const MPSolverParameters& param) {
@@ -486,6 +472,31 @@ bool GLOPInterface::SetSolverSpecificParametersAsString(
 #endif
 }
 
+void GLOPInterface::SolveLinearProgram() {
+  linear_program_.CleanUp();
+
+  // Time limit.
+  if (solver_->time_limit()) {
+    VLOG(1) << "Setting time limit = " << solver_->time_limit() << " ms.";
+    parameters_.set_max_time_in_seconds(
+        static_cast<double>(solver_->time_limit()) / 1000.0);
+  }
+
+  solver_->SetSolverSpecificParametersAsString(
+      solver_->solver_specific_parameter_string_);
+  lp_solver_.SetParameters(parameters_);
+  std::unique_ptr<TimeLimit> time_limit =
+      TimeLimit::FromParameters(parameters_);
+  time_limit->RegisterExternalBooleanAsLimit(&interrupt_solver_);
+  const glop::ProblemStatus status =
+      lp_solver_.SolveWithTimeLimit(linear_program_, time_limit.get());
+
+  // The solution must be marked as synchronized even when no solution exists.
+  sync_status_ = SOLUTION_SYNCHRONIZED;
+  result_status_ = GlopInterfaceUtils::TranslateProblemStatus(status);
+  objective_value_ = lp_solver_.GetObjectiveValue();
+}
+
 void GLOPInterface::NonIncrementalChange() {
   // The current implementation is not incremental.
   sync_status_ = MUST_RELOAD;
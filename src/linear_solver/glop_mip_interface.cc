@@ -0,0 +1,359 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "google/protobuf/text_format.h"
+#include "base/hash.h"
+#include "glop/branch_and_bound.h"
+#include "glop/parameters.pb.h"
+#include "linear_solver/glop_utils.h"
+#include "linear_solver/linear_solver.h"
+#include "lp_data/lp_data.h"
+#include "lp_data/lp_types.h"
+#include "util/time_limit.h"
+
+#if defined(USE_GLOP)
+
+namespace operations_research {
+// Mixed integer programming with the LP-based branch and bound of
+// glop/branch_and_bound.h.
+class GlopMipInterface : public MPSolverInterface {
+ public:
+  explicit GlopMipInterface(MPSolver* const solver);
+  ~GlopMipInterface() override;
+
+  // ----- Solve -----
+  MPSolver::ResultStatus Solve(const MPSolverParameters& param) override;
+
+  // ----- Model modifications and extraction -----
+  void Reset() override;
+  void SetOptimizationDirection(bool maximize) override;
+  void SetVariableBounds(int index, double lb, double ub) override;
+  void SetVariableInteger(int index, bool integer) override;
+  void SetConstraintBounds(int index, double lb, double ub) override;
+  void AddRowConstraint(MPConstraint* const ct) override;
+  void AddVariable(MPVariable* const var) override;
+  void SetCoefficient(MPConstraint* const constraint,
+                      const MPVariable* const variable, double new_value,
+                      double old_value) override;
+  void ClearConstraint(MPConstraint* const constraint) override;
+  void SetObjectiveCoefficient(const MPVariable* const variable,
+                               double coefficient) override;
+  void SetObjectiveOffset(double value) override;
+  void ClearObjective() override;
+
+  // ------ Query statistics on the solution and the solve ------
+  int64 iterations() const override;
+  int64 nodes() const override;
+  double best_objective_bound() const override;
+  MPSolver::BasisStatus row_status(int constraint_index) const override;
+  MPSolver::BasisStatus column_status(int variable_index) const override;
+
+  // ----- Misc -----
+  bool IsContinuous() const override;
+  bool IsLP() const override;
+  bool IsMIP() const override;
+
+  std::string SolverVersion() const override;
+  bool InterruptSolve() override;
+  void* underlying_solver() override;
+
+  void ExtractNewVariables() override;
+  void ExtractNewConstraints() override;
+  void ExtractObjective() override;
+
+  void SetParameters(const MPSolverParameters& param) override;
+  void SetRelativeMipGap(double value) override;
+  void SetPrimalTolerance(double value) override;
+  void SetDualTolerance(double value) override;
+  void SetPresolveMode(int value) override;
+  void SetScalingMode(int value) override;
+  void SetLpAlgorithm(int value) override;
+  bool SetSolverSpecificParametersAsString(const std::string& parameters) override;
+
+ private:
+  void NonIncrementalChange();
+
+  glop::LinearProgram linear_program_;
+  glop::BranchAndBound branch_and_bound_;
+  std::vector<MPSolver::BasisStatus> column_status_;
+  std::vector<MPSolver::BasisStatus> row_status_;
+  glop::GlopParameters parameters_;
+  std::atomic<bool> interrupt_solver_;
+};
+
+GlopMipInterface::GlopMipInterface(MPSolver* const solver)
+    : MPSolverInterface(solver),
+      linear_program_(),
+      branch_and_bound_(),
+      column_status_(),
+      row_status_(),
+      parameters_(),
+      interrupt_solver_(false) {}
+
+GlopMipInterface::~GlopMipInterface() {}
+
+MPSolver::ResultStatus GlopMipInterface::Solve(
+    const MPSolverParameters& param) {
+  // Check whenever the solve has already been stopped by the user.
+  if (interrupt_solver_) {
+    Reset();
+    return MPSolver::NOT_SOLVED;
+  }
+
+  // Reset extraction as this interface is not incremental yet.
+  Reset();
+  ExtractModel();
+  SetParameters(param);
+
+  linear_program_.SetMaximizationProblem(maximize_);
+  linear_program_.CleanUp();
+
+  // Time limit.
+  if (solver_->time_limit()) {
+    VLOG(1) << "Setting time limit = " << solver_->time_limit() << " ms.";
+    parameters_.set_max_time_in_seconds(
+        static_cast<double>(solver_->time_limit()) / 1000.0);
+  }
+
+  solver_->SetSolverSpecificParametersAsString(
+      solver_->solver_specific_parameter_string_);
+  branch_and_bound_.SetParameters(parameters_);
+
+  // Only a hint with a value for each variable is used.
+  glop::DenseRow solution_hint;
+  if (solver_->solution_hint_.size() == solver_->variables_.size()) {
+    solution_hint.assign(glop::ColIndex(solver_->variables_.size()), 0.0);
+    for (const std::pair<MPVariable*, double>& p : solver_->solution_hint_) {
+      solution_hint[glop::ColIndex(p.first->index())] = p.second;
+    }
+  }
+  branch_and_bound_.SetSolutionHint(solution_hint);
+  std::unique_ptr<TimeLimit> time_limit =
+      TimeLimit::FromParameters(parameters_);
+  time_limit->RegisterExternalBooleanAsLimit(&interrupt_solver_);
+  const glop::ProblemStatus status =
+      branch_and_bound_.SolveWithTimeLimit(linear_program_, time_limit.get());
+
+  // The solution must be marked as synchronized even when no solution exists.
+  sync_status_ = SOLUTION_SYNCHRONIZED;
+  result_status_ = GlopInterfaceUtils::TranslateProblemStatus(status);
+  if (result_status_ == MPSolver::FEASIBLE ||
+      result_status_ == MPSolver::OPTIMAL) {
+    objective_value_ = branch_and_bound_.objective_value();
+    GlopInterfaceUtils::SetSolutionValues(branch_and_bound_.variable_values(),
+                                          solver_);
+  }
+
+  // There is no basis for the solution of a mixed integer program.
+  column_status_.assign(solver_->variables_.size(), MPSolver::FREE);
+  row_status_.assign(solver_->constraints_.size(), MPSolver::FREE);
+  return result_status_;
+}
+
+void GlopMipInterface::Reset() {
+  ResetExtractionInformation();
+  linear_program_.Clear();
+  interrupt_solver_ = false;
+}
+
+void GlopMipInterface::SetOptimizationDirection(bool maximize) {
+  NonIncrementalChange();
+}
+
+void GlopMipInterface::SetVariableBounds(int index, double lb, double ub) {
+  NonIncrementalChange();
+}
+
+void GlopMipInterface::SetVariableInteger(int index, bool integer) {
+  NonIncrementalChange();
+}
+
+void GlopMipInterface::SetConstraintBounds(int index, double lb, double ub) {
+  NonIncrementalChange();
+}
+
+void GlopMipInterface::AddRowConstraint(MPConstraint* const ct) {
+  NonIncrementalChange();
+}
+
+void GlopMipInterface::AddVariable(MPVariable* const var) {
+  NonIncrementalChange();
+}
+
+void GlopMipInterface::SetCoefficient(MPConstraint* const constraint,
+                                      const MPVariable* const variable,
+                                      double new_value, double old_value) {
+  NonIncrementalChange();
+}
+
+void GlopMipInterface::ClearConstraint(MPConstraint* const constraint) {
+  NonIncrementalChange();
+}
+
+void GlopMipInterface::SetObjectiveCoefficient(
+    const MPVariable* const variable, double coefficient) {
+  NonIncrementalChange();
+}
+
+void GlopMipInterface::SetObjectiveOffset(double value) {
+  NonIncrementalChange();
+}
+
+void GlopMipInterface::ClearObjective() { NonIncrementalChange(); }
+
+int64 GlopMipInterface::iterations() const {
+  return branch_and_bound_.num_simplex_iterations();
+}
+
+int64 GlopMipInterface::nodes() const { return branch_and_bound_.num_nodes(); }
+
+double GlopMipInterface::best_objective_bound() const {
+  if (!CheckSolutionIsSynchronized() || !CheckBestObjectiveBoundExists()) {
+    return trivial_worst_objective_bound();
+  }
+  return branch_and_bound_.best_bound();
+}
+
+MPSolver::BasisStatus GlopMipInterface::row_status(int constraint_index) const {
+  return row_status_[constraint_index];
+}
+
+MPSolver::BasisStatus GlopMipInterface::column_status(
+    int variable_index) const {
+  return column_status_[variable_index];
+}
+
+bool GlopMipInterface::IsContinuous() const { return false; }
+bool GlopMipInterface::IsLP() const { return false; }
+bool GlopMipInterface::IsMIP() const { return true; }
+
+std::string GlopMipInterface::SolverVersion() const { return "Glop-MIP-0.0"; }
+
+bool GlopMipInterface::InterruptSolve() {
+  interrupt_solver_ = true;
+  return true;
+}
+
+void* GlopMipInterface::underlying_solver() { return &branch_and_bound_; }
+
+void GlopMipInterface::ExtractNewVariables() {
+  DCHECK_EQ(0, last_variable_index_);
+  DCHECK_EQ(0, last_constraint_index_);
+  GlopInterfaceUtils::ExtractVariables(*solver_, /*with_integrality=*/true,
+                                       &linear_program_);
+  for (int var_index = 0; var_index < solver_->variables_.size();
+       ++var_index) {
+    set_variable_as_extracted(var_index, true);
+  }
+}
+
+void GlopMipInterface::ExtractNewConstraints() {
+  DCHECK_EQ(0, last_constraint_index_);
+  GlopInterfaceUtils::ExtractConstraints(*solver_, &linear_program_);
+  for (int ct_index = 0; ct_index < solver_->constraints_.size(); ++ct_index) {
+    set_constraint_as_extracted(ct_index, true);
+  }
+}
+
+void GlopMipInterface::ExtractObjective() {
+  GlopInterfaceUtils::ExtractObjective(*solver_, &linear_program_);
+}
+
+void GlopMipInterface::SetParameters(const MPSolverParameters& param) {
+  parameters_.Clear();
+  SetCommonParameters(param);
+  SetMIPParameters(param);
+  SetScalingMode(param.GetIntegerParam(MPSolverParameters::SCALING));
+}
+
+void GlopMipInterface::SetRelativeMipGap(double value) {
+  parameters_.set_mip_relative_gap_limit(value);
+}
+
+// Like for Glop, we keep the more accurate default tolerances of the
+// GlopParameters.
+void GlopMipInterface::SetPrimalTolerance(double value) {
+  if (value != MPSolverParameters::kDefaultDoubleParamValue) {
+    SetDoubleParamToUnsupportedValue(MPSolverParameters::PRIMAL_TOLERANCE,
+                                     value);
+  }
+}
+
+void GlopMipInterface::SetDualTolerance(double value) {
+  if (value != MPSolverParameters::kDefaultDoubleParamValue) {
+    SetDoubleParamToUnsupportedValue(MPSolverParameters::DUAL_TOLERANCE,
+                                     value);
+  }
+}
+
+void GlopMipInterface::SetPresolveMode(int value) {
+  switch (value) {
+    case MPSolverParameters::PRESOLVE_OFF:
+      parameters_.set_use_preprocessing(false);
+      break;
+    case MPSolverParameters::PRESOLVE_ON:
+      parameters_.set_use_preprocessing(true);
+      break;
+    default:
+      if (value != MPSolverParameters::kDefaultIntegerParamValue) {
+        SetIntegerParamToUnsupportedValue(MPSolverParameters::PRESOLVE, value);
+      }
+  }
+}
+
+// The RevisedSimplex used by the branch and bound does not scale the problem.
+void GlopMipInterface::SetScalingMode(int value) {}
+
+void GlopMipInterface::SetLpAlgorithm(int value) {
+  // This only affects the root node, the other nodes always use the dual
+  // simplex.
+  switch (value) {
+    case MPSolverParameters::DUAL:
+      parameters_.set_use_dual_simplex(true);
+      break;
+    case MPSolverParameters::PRIMAL:
+      parameters_.set_use_dual_simplex(false);
+      break;
+    default:
+      if (value != MPSolverParameters::kDefaultIntegerParamValue) {
+        SetIntegerParamToUnsupportedValue(MPSolverParameters::LP_ALGORITHM,
+                                          value);
+      }
+  }
+}
+
+bool GlopMipInterface::SetSolverSpecificParametersAsString(
+    const std::string& parameters) {
+  const bool ok = google::protobuf::TextFormat::MergeFromString(parameters, &parameters_);
+  branch_and_bound_.SetParameters(parameters_);
+  return ok;
+}
+
+void GlopMipInterface::NonIncrementalChange() {
+  // The current implementation is not incremental.
+  sync_status_ = MUST_RELOAD;
+}
+
+// Register the Glop branch and bound in the global linear solver factory.
+MPSolverInterface* BuildGlopMipInterface(MPSolver* const solver) {
+  return new GlopMipInterface(solver);
+}
+
+}  // namespace operations_research
+#endif  //  #if defined(USE_GLOP)
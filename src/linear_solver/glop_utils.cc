@@ -0,0 +1,106 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "linear_solver/glop_utils.h"
+
+#include "base/logging.h"
+
+namespace operations_research {
+
+// static
+void GlopInterfaceUtils::ExtractVariables(const MPSolver& solver,
+                                          bool with_integrality,
+                                          glop::LinearProgram* lp) {
+  const glop::ColIndex num_cols(solver.variables().size());
+  for (glop::ColIndex col(lp->num_variables()); col < num_cols; ++col) {
+    const MPVariable* const var = solver.variables()[col.value()];
+    // The MPSolver names are unique, so there is no need to go through the
+    // name lookup of FindOrCreateVariable().
+    const glop::ColIndex new_col = lp->CreateNewVariable();
+    DCHECK_EQ(new_col, col);
+    lp->SetVariableName(col, var->name());
+    lp->SetVariableBounds(col, var->lb(), var->ub());
+    if (with_integrality) lp->SetVariableIntegrality(col, var->integer());
+  }
+}
+
+// static
+void GlopInterfaceUtils::ExtractConstraints(const MPSolver& solver,
+                                            glop::LinearProgram* lp) {
+  const glop::RowIndex num_rows(solver.constraints().size());
+  for (glop::RowIndex row(lp->num_constraints()); row < num_rows; ++row) {
+    const MPConstraint* const ct = solver.constraints()[row.value()];
+    const glop::RowIndex new_row = lp->CreateNewConstraint();
+    DCHECK_EQ(new_row, row);
+    lp->SetConstraintName(row, ct->name());
+    lp->SetConstraintBounds(row, ct->lb(), ct->ub());
+    for (const CoeffEntry& entry : ct->coefficients_) {
+      const glop::ColIndex col(entry.first->index());
+      DCHECK_LT(col, lp->num_variables());
+      lp->SetCoefficient(row, col, entry.second);
+    }
+  }
+}
+
+// static
+void GlopInterfaceUtils::ExtractObjective(const MPSolver& solver,
+                                          glop::LinearProgram* lp) {
+  lp->SetObjectiveOffset(solver.Objective().offset());
+  for (const CoeffEntry& entry : solver.Objective().coefficients_) {
+    const glop::ColIndex col(entry.first->index());
+    lp->SetObjectiveCoefficient(col, entry.second);
+  }
+}
+
+// static
+void GlopInterfaceUtils::SetSolutionValues(const glop::DenseRow& values,
+                                           MPSolver* solver) {
+  for (MPVariable* const var : solver->variables()) {
+    const glop::ColIndex col(var->index());
+    var->set_solution_value(static_cast<double>(values[col]));
+  }
+}
+
+// static
+MPSolver::ResultStatus GlopInterfaceUtils::TranslateProblemStatus(
+    glop::ProblemStatus status) {
+  switch (status) {
+    case glop::ProblemStatus::OPTIMAL:
+      return MPSolver::OPTIMAL;
+    case glop::ProblemStatus::PRIMAL_FEASIBLE:
+      return MPSolver::FEASIBLE;
+    case glop::ProblemStatus::PRIMAL_INFEASIBLE:  // PASS_THROUGH_INTENDED
+    case glop::ProblemStatus::DUAL_UNBOUNDED:
+      return MPSolver::INFEASIBLE;
+    case glop::ProblemStatus::PRIMAL_UNBOUNDED:
+      return MPSolver::UNBOUNDED;
+    case glop::ProblemStatus::DUAL_FEASIBLE:  // PASS_THROUGH_INTENDED
+    case glop::ProblemStatus::INIT:
+      return MPSolver::NOT_SOLVED;
+    // TODO(user): Glop may return ProblemStatus::DUAL_INFEASIBLE or
+    // ProblemStatus::INFEASIBLE_OR_UNBOUNDED.
+    // Unfortunatley, the wrapper does not support this return status at this
+    // point (even though Cplex and Gurobi have the equivalent). So we convert
+    // it to MPSolver::ABNORMAL instead.
+    case glop::ProblemStatus::DUAL_INFEASIBLE:          // PASS_THROUGH_INTENDED
+    case glop::ProblemStatus::INFEASIBLE_OR_UNBOUNDED:  // PASS_THROUGH_INTENDED
+    case glop::ProblemStatus::ABNORMAL:                 // PASS_THROUGH_INTENDED
+    case glop::ProblemStatus::IMPRECISE:                // PASS_THROUGH_INTENDED
+    case glop::ProblemStatus::INVALID_PROBLEM:
+      return MPSolver::ABNORMAL;
+  }
+  LOG(DFATAL) << "Invalid glop::ProblemStatus " << status;
+  return MPSolver::ABNORMAL;
+}
+
+}  // namespace operations_research
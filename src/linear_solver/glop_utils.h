@@ -0,0 +1,54 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Conversions between an MPSolver and a glop::LinearProgram, shared by the
+// Glop linear programming interface and the Glop branch and bound interface.
+
+#ifndef OR_TOOLS_LINEAR_SOLVER_GLOP_UTILS_H_
+#define OR_TOOLS_LINEAR_SOLVER_GLOP_UTILS_H_
+
+#include "linear_solver/linear_solver.h"
+#include "lp_data/lp_data.h"
+#include "lp_data/lp_types.h"
+
+namespace operations_research {
+
+// The functions are static members of a class, rather than free functions, so
+// that the MPSolver classes can grant them access to their internals.
+class GlopInterfaceUtils {
+ public:
+  // Appends the variables of solver to lp, in the same order. The integrality
+  // of the variables is only copied if with_integrality is true.
+  static void ExtractVariables(const MPSolver& solver, bool with_integrality,
+                               glop::LinearProgram* lp);
+
+  // Appends the constraints of solver to lp, in the same order. The variables
+  // must already be extracted.
+  static void ExtractConstraints(const MPSolver& solver,
+                                 glop::LinearProgram* lp);
+
+  // Sets the objective coefficients and offset of lp from the ones of solver.
+  static void ExtractObjective(const MPSolver& solver, glop::LinearProgram* lp);
+
+  // Sets the solution value of each variable of solver from values, which is
+  // indexed by the columns of the extracted linear program.
+  static void SetSolutionValues(const glop::DenseRow& values, MPSolver* solver);
+
+  // Translates the status returned by the Glop solvers.
+  static MPSolver::ResultStatus TranslateProblemStatus(
+      glop::ProblemStatus status);
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_LINEAR_SOLVER_GLOP_UTILS_H_
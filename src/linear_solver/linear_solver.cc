@@ -20,6 +20,7 @@
 #endif
 
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <utility>
@@ -43,7 +44,9 @@
 #include "base/stl_util.h"
 #include "base/hash.h"
 #include "base/accurate_sum.h"
+#include "linear_solver/binary_model.h"
 #include "linear_solver/linear_solver.pb.h"
+#include "linear_solver/lp_relaxation_hint.h"
 #include "linear_solver/model_exporter.h"
 #include "linear_solver/model_validator.h"
 #include "util/fp_utils.h"
@@ -66,6 +69,17 @@ DEFINE_bool(mpsolver_bypass_model_validation, false,
             "If set, the user-provided Model won't be verified before Solve()."
             " Invalid models will typically trigger various error responses"
             " from the underlying solvers; sometimes crashes.");
+DEFINE_int32(mpsolver_model_validation_threads, 1,
+             "Number of threads used to validate the constraints of the models"
+             " given to LoadModelFromProto(). Only large models are validated"
+             " in parallel.");
+DEFINE_bool(mpsolver_lp_relaxation_hint, false,
+            "If set, and if no solution hint was given, Solve() runs a rounding"
+            " and diving heuristic on the linear relaxation of the integer"
+            " models and gives its solution, if any, as hint to the solver.");
+DEFINE_double(mpsolver_lp_relaxation_hint_max_time_in_seconds, 1.0,
+              "Time limit of the heuristic of --mpsolver_lp_relaxation_hint. It"
+              " is also limited to a tenth of the time limit of the solver.");
 
 
 // To compile the open-source code, the anonymous namespace should be
@@ -86,6 +100,61 @@ std::string MPModelRequest_SolverType_Name(int type) {
 }
 #endif  // defined(ANDROID_JNI) && (defined(__ANDROID__) || defined(__APPLE__))
 
+// ----- CoeffMap -----
+
+const int CoeffMap::kMaxLinearScanSize;
+
+void CoeffMap::clear() {
+  entries_.clear();
+  index_.clear();
+}
+
+int CoeffMap::FindPosition(const MPVariable* var) const {
+  if (!index_.empty()) return FindWithDefault(index_, var, -1);
+  for (int i = 0; i < entries_.size(); ++i) {
+    if (entries_[i].first == var) return i;
+  }
+  return -1;
+}
+
+void CoeffMap::BuildIndexIfNeeded() {
+  if (entries_.size() <= kMaxLinearScanSize || !index_.empty()) return;
+  for (int i = 0; i < entries_.size(); ++i) {
+    index_[entries_[i].first] = i;
+  }
+}
+
+CoeffMap::iterator CoeffMap::find(const MPVariable* var) {
+  const int position = FindPosition(var);
+  return position == -1 ? entries_.end() : entries_.begin() + position;
+}
+
+CoeffMap::const_iterator CoeffMap::find(const MPVariable* var) const {
+  const int position = FindPosition(var);
+  return position == -1 ? entries_.end() : entries_.begin() + position;
+}
+
+std::pair<CoeffMap::iterator, bool> CoeffMap::insert(const CoeffEntry& entry) {
+  const int position = FindPosition(entry.first);
+  if (position != -1) {
+    return std::make_pair(entries_.begin() + position, false);
+  }
+  AddNewEntry(entry.first, entry.second);
+  return std::make_pair(entries_.end() - 1, true);
+}
+
+double& CoeffMap::operator[](const MPVariable* var) {
+  return insert(std::make_pair(var, 0.0)).first->second;
+}
+
+void CoeffMap::AddNewEntry(const MPVariable* var, double coeff) {
+  if (!index_.empty()) index_[var] = entries_.size();
+  entries_.push_back(std::make_pair(var, coeff));
+  BuildIndexIfNeeded();
+}
+
+// ----- MPConstraint -----
+
 double MPConstraint::GetCoefficient(const MPVariable* const var) const {
   DLOG_IF(DFATAL, !interface_->solver_->OwnsVariable(var)) << var;
   if (var == NULL) return 0.0;
@@ -311,6 +380,7 @@ extern MPSolverInterface* BuildBopInterface(MPSolver* const solver);
 #endif
 #if defined(USE_GLOP)
 extern MPSolverInterface* BuildGLOPInterface(MPSolver* const solver);
+extern MPSolverInterface* BuildGlopMipInterface(MPSolver* const solver);
 #endif
 #if defined(USE_SCIP)
 extern MPSolverInterface* BuildSCIPInterface(MPSolver* const solver);
@@ -341,6 +411,8 @@ MPSolverInterface* BuildSolverInterface(MPSolver* const solver) {
 #if defined(USE_GLOP)
     case MPSolver::GLOP_LINEAR_PROGRAMMING:
       return BuildGLOPInterface(solver);
+    case MPSolver::GLOP_MIXED_INTEGER_PROGRAMMING:
+      return BuildGlopMipInterface(solver);
 #endif
 #if defined(USE_GLPK)
     case MPSolver::GLPK_LINEAR_PROGRAMMING:
@@ -430,6 +502,7 @@ bool MPSolver::SupportsProblemType(OptimizationProblemType problem_type) {
     #endif
     #ifdef USE_GLOP
     if (problem_type == GLOP_LINEAR_PROGRAMMING) return true;
+    if (problem_type == GLOP_MIXED_INTEGER_PROGRAMMING) return true;
     #endif
     #if defined(USE_SLM)
     if (problem_type == SULUM_LINEAR_PROGRAMMING) return true;
@@ -487,7 +560,8 @@ MPSolverResponseStatus MPSolver::LoadModelFromProtoWithUniqueNamesOrDie(
 MPSolverResponseStatus MPSolver::LoadModelFromProtoInternal(
     const MPModelProto& input_model, bool clear_names, std::string* error_message) {
   CHECK(error_message != nullptr);
-  const std::string error = FindErrorInMPModelProto(input_model);
+  const std::string error = FindErrorInMPModelProto(
+      input_model, FLAGS_mpsolver_model_validation_threads);
   if (!error.empty()) {
     *error_message = error;
     LOG_IF(INFO, OutputIsEnabled())
@@ -514,16 +588,18 @@ MPSolverResponseStatus MPSolver::LoadModelFromProtoInternal(
     objective->SetCoefficient(variable, var_proto.objective_coefficient());
   }
 
+  std::vector<int> position_in_constraint(NumVariables(), -1);
   for (int i = 0; i < input_model.constraint_size(); ++i) {
     const MPConstraintProto& ct_proto = input_model.constraint(i);
     MPConstraint* const ct =
         MakeRowConstraint(ct_proto.lower_bound(), ct_proto.upper_bound(),
                           clear_names ? empty : ct_proto.name());
     ct->set_is_lazy(ct_proto.is_lazy());
-    for (int j = 0; j < ct_proto.var_index_size(); ++j) {
-      ct->SetCoefficient(variables_[ct_proto.var_index(j)],
-                         ct_proto.coefficient(j));
-    }
+    DCHECK_EQ(ct_proto.var_index_size(), ct_proto.coefficient_size());
+    SetNewConstraintTerms(ct_proto.var_index_size(),
+                          ct_proto.var_index().data(),
+                          ct_proto.coefficient().data(), ct,
+                          &position_in_constraint);
   }
   objective->SetOptimizationDirection(input_model.maximize());
   if (input_model.has_objective_offset()) {
@@ -588,11 +664,25 @@ void MPSolver::SolveWithProto(const MPModelRequest& model_request,
   const MPModelProto& model = model_request.model();
   MPSolver solver(model.name(), static_cast<MPSolver::OptimizationProblemType>(
                                     model_request.solver_type()));
-  if (model_request.enable_internal_solver_output()) {
-    solver.EnableOutput();
+  solver.ClearAndSolveWithProto(model_request, response);
+}
+
+void MPSolver::ClearAndSolveWithProto(const MPModelRequest& model_request,
+                                      MPSolutionResponse* response) {
+  CHECK_NOTNULL(response);
+  DCHECK_EQ(static_cast<int>(ProblemType()),
+            static_cast<int>(model_request.solver_type()));
+  Clear();
+  response->Clear();
+  if (model_request.enable_internal_solver_output() ||
+      FLAGS_linear_solver_enable_verbose_output) {
+    EnableOutput();
+  } else {
+    SuppressOutput();
   }
   std::string error_message;
-  response->set_status(solver.LoadModelFromProto(model, &error_message));
+  response->set_status(LoadModelFromProto(model_request.model(),
+                                          &error_message));
   if (response->status() != MPSOLVER_MODEL_IS_VALID) {
     LOG_EVERY_N_SEC(WARNING, 1.0)
         << "Loading model from protocol buffer failed, load status = "
@@ -600,16 +690,103 @@ void MPSolver::SolveWithProto(const MPModelRequest& model_request,
         << response->status() << "); Error: " << error_message;
     return;
   }
-  if (model_request.has_solver_time_limit_seconds()) {
-    // static_cast<int64> avoids a warning with -Wreal-conversion. This
-    // helps catching bugs with unwanted conversions from double to ints.
-    solver.set_time_limit(
-        static_cast<int64>(model_request.solver_time_limit_seconds() * 1000));
-  }
-  solver.SetSolverSpecificParametersAsString(
+  // static_cast<int64> avoids a warning with -Wreal-conversion. This
+  // helps catching bugs with unwanted conversions from double to ints.
+  set_time_limit(
+      model_request.has_solver_time_limit_seconds()
+          ? static_cast<int64>(model_request.solver_time_limit_seconds() * 1000)
+          : 0);
+  SetSolverSpecificParametersAsString(
       model_request.solver_specific_parameters());
-  solver.Solve();
-  solver.FillSolutionResponseProto(response);
+  Solve();
+  FillSolutionResponseProto(response);
+}
+
+MPSolverResponseStatus MPSolver::LoadModelFromBinaryModel(
+    const MPBinaryModel& model, std::string* error_message) {
+  CHECK(error_message != nullptr);
+  const std::string error = model.FindError();
+  if (!error.empty()) {
+    *error_message = error;
+    LOG_IF(INFO, OutputIsEnabled())
+        << "Invalid model given to LoadModelFromBinaryModel(): " << error;
+    if (FLAGS_mpsolver_bypass_model_validation) {
+      LOG_IF(INFO, OutputIsEnabled())
+          << "Ignoring the model error(s) because of"
+          << " --mpsolver_bypass_model_validation.";
+    } else {
+      return error.find("Infeasible") == std::string::npos ? MPSOLVER_MODEL_INVALID
+                                                      : MPSOLVER_INFEASIBLE;
+    }
+  }
+
+  LoadValidatedBinaryModel(model);
+  return MPSOLVER_MODEL_IS_VALID;
+}
+
+void MPSolver::LoadValidatedBinaryModel(const MPBinaryModel& model) {
+  MPObjective* const objective = MutableObjective();
+  const std::string empty;
+  for (int j = 0; j < model.num_variables(); ++j) {
+    MPVariable* const variable =
+        MakeVar(model.variable_lower_bounds()[j],
+                model.variable_upper_bounds()[j],
+                model.variable_is_integer()[j] != 0, empty);
+    objective->SetCoefficient(variable, model.objective_coefficients()[j]);
+  }
+  // The column indices are int32, which is int on all supported platforms.
+  std::vector<int> position_in_constraint(NumVariables(), -1);
+  for (int i = 0; i < model.num_constraints(); ++i) {
+    MPConstraint* const ct =
+        MakeRowConstraint(model.constraint_lower_bounds()[i],
+                          model.constraint_upper_bounds()[i], empty);
+    ct->set_is_lazy(model.constraint_is_lazy()[i] != 0);
+    const int64 begin = model.row_starts()[i];
+    SetNewConstraintTerms(model.row_starts()[i + 1] - begin,
+                          model.column_indices() + begin,
+                          model.coefficients() + begin, ct,
+                          &position_in_constraint);
+  }
+  objective->SetOptimizationDirection(model.maximize());
+  objective->SetOffset(model.objective_offset());
+  solution_hint_.clear();
+}
+
+void MPSolver::ClearAndSolveBinaryModel(const MPBinaryModel& model,
+                                        MPSolutionResponse* response) {
+  CHECK_NOTNULL(response);
+  Clear();
+  response->Clear();
+  const std::string error = model.FindError();
+  if (!error.empty() && !FLAGS_mpsolver_bypass_model_validation) {
+    response->set_status(error.find("Infeasible") == std::string::npos
+                             ? MPSOLVER_MODEL_INVALID
+                             : MPSOLVER_INFEASIBLE);
+    LOG_EVERY_N_SEC(WARNING, 1.0)
+        << "Invalid binary model, load status = "
+        << MPSolverResponseStatus_Name(response->status()) << " ("
+        << response->status() << "); Error: " << error;
+    return;
+  }
+
+  // Direct path, without any MPVariable or MPConstraint.
+  std::vector<double> variable_values;
+  if (interface_->SolveBinaryModel(model, MPSolverParameters(),
+                                   &variable_values)) {
+    const MPSolver::ResultStatus status = interface_->result_status_;
+    response->set_status(ResultStatusToMPSolverResponseStatus(status));
+    if (status == MPSolver::OPTIMAL || status == MPSolver::FEASIBLE) {
+      response->set_objective_value(interface_->objective_value_);
+      for (const double value : variable_values) {
+        response->add_variable_value(value);
+      }
+    }
+    return;
+  }
+
+  LoadValidatedBinaryModel(model);
+  Solve();
+  FillSolutionResponseProto(response);
 }
 
 void MPSolver::ExportModelToProto(MPModelProto* output_model) const {
@@ -786,6 +963,27 @@ void MPSolver::MakeVarArray(int nb, double lb, double ub, bool integer,
   }
 }
 
+void MPSolver::MakeVarArray(const std::vector<double>& lb,
+                            const std::vector<double>& ub, bool integer,
+                            const std::string& name_prefix,
+                            std::vector<MPVariable*>* vars) {
+  DCHECK_EQ(lb.size(), ub.size());
+  const int nb = lb.size();
+  if (nb == 0) return;
+  const int num_digits = NumDigits(nb);
+  variables_.reserve(variables_.size() + nb);
+  vars->reserve(vars->size() + nb);
+  for (int i = 0; i < nb; ++i) {
+    if (name_prefix.empty()) {
+      vars->push_back(MakeVar(lb[i], ub[i], integer, name_prefix));
+    } else {
+      std::string vname =
+          StringPrintf("%s%0*d", name_prefix.c_str(), num_digits, i);
+      vars->push_back(MakeVar(lb[i], ub[i], integer, vname));
+    }
+  }
+}
+
 void MPSolver::MakeNumVarArray(int nb, double lb, double ub, const std::string& name,
                                std::vector<MPVariable*>* vars) {
   MakeVarArray(nb, lb, ub, false, name, vars);
@@ -827,6 +1025,64 @@ MPConstraint* MPSolver::MakeRowConstraint(const std::string& name) {
   return MakeRowConstraint(-infinity(), infinity(), name);
 }
 
+void MPSolver::MakeRowConstraintArray(const std::vector<double>& lb,
+                                      const std::vector<double>& ub,
+                                      const std::vector<int>& row_starts,
+                                      const std::vector<int>& var_indices,
+                                      const std::vector<double>& coefficients,
+                                      const std::string& name_prefix,
+                                      std::vector<MPConstraint*>* constraints) {
+  DCHECK_EQ(lb.size(), ub.size());
+  DCHECK_EQ(lb.size() + 1, row_starts.size());
+  DCHECK_EQ(var_indices.size(), coefficients.size());
+  const int num_rows = lb.size();
+  if (num_rows == 0) return;
+  const int num_digits = NumDigits(num_rows);
+  std::vector<int> position_in_constraint(NumVariables(), -1);
+  constraints_.reserve(constraints_.size() + num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    MPConstraint* const ct = MakeRowConstraint(
+        lb[i], ub[i],
+        name_prefix.empty()
+            ? name_prefix
+            : StringPrintf("%s%0*d", name_prefix.c_str(), num_digits, i));
+    const int start = row_starts[i];
+    DCHECK_LE(start, row_starts[i + 1]);
+    SetNewConstraintTerms(row_starts[i + 1] - start, var_indices.data() + start,
+                          coefficients.data() + start, ct,
+                          &position_in_constraint);
+    if (constraints != nullptr) constraints->push_back(ct);
+  }
+}
+
+void MPSolver::SetNewConstraintTerms(int num_terms, const int* var_indices,
+                                     const double* coefficients,
+                                     MPConstraint* ct,
+                                     std::vector<int>* position_in_constraint) {
+  DCHECK(ct->coefficients_.empty());
+  CoeffMap* const terms = &ct->coefficients_;
+  terms->reserve(num_terms);
+  for (int i = 0; i < num_terms; ++i) {
+    const int var_index = var_indices[i];
+    if (var_index < 0 || var_index >= NumVariables()) {
+      LOG(DFATAL) << "Invalid variable index " << var_index
+                  << " in the terms of constraint " << ct->name();
+      continue;
+    }
+    const int position = (*position_in_constraint)[var_index];
+    if (position != -1) {
+      // Same as SetCoefficient(), see the comment there for the zeros.
+      (terms->begin() + position)->second = coefficients[i];
+    } else if (coefficients[i] != 0.0) {
+      (*position_in_constraint)[var_index] = terms->size();
+      terms->AddNewEntry(variables_[var_index], coefficients[i]);
+    }
+  }
+  for (const CoeffEntry entry : *terms) {
+    (*position_in_constraint)[entry.first->index()] = -1;
+  }
+}
+
 int MPSolver::ComputeMaxConstraintSize(int min_constraint_index,
                                        int max_constraint_index) const {
   int max_constraint_size = 0;
@@ -871,8 +1127,35 @@ MPSolver::ResultStatus MPSolver::Solve(const MPSolverParameters& param) {
     return interface_->result_status_;
   }
 
+#if defined(USE_GLOP)
+  // The generated hint is only used for this solve.
+  bool has_generated_hint = false;
+  if (FLAGS_mpsolver_lp_relaxation_hint && interface_->IsMIP() &&
+      solution_hint_.empty()) {
+    double max_time_in_seconds =
+        FLAGS_mpsolver_lp_relaxation_hint_max_time_in_seconds;
+    if (time_limit_ != 0) {
+      max_time_in_seconds =
+          std::min(max_time_in_seconds, time_limit_in_secs() / 10.0);
+    }
+    MPModelProto model;
+    ExportModelToProto(&model);
+    PartialVariableAssignment hint;
+    if (FindErrorInMPModelProto(model).empty() &&
+        FindSolutionHintFromLpRelaxation(model, max_time_in_seconds, &hint)) {
+      for (int i = 0; i < hint.var_index_size(); ++i) {
+        solution_hint_.push_back(
+            std::make_pair(variables_[hint.var_index(i)], hint.var_value(i)));
+      }
+      has_generated_hint = true;
+    }
+  }
+#endif
 
   MPSolver::ResultStatus status = interface_->Solve(param);
+#if defined(USE_GLOP)
+  if (has_generated_hint) solution_hint_.clear();
+#endif
   if (FLAGS_verify_solution) {
     if (status != MPSolver::OPTIMAL) {
       VLOG(1) << "--verify_solution enabled, but the solver did not find an"
@@ -1139,6 +1422,21 @@ bool MPSolver::ExportModelAsMpsFormat(bool fixed_format, bool obfuscate,
   MPModelProtoExporter exporter(proto);
   return exporter.ExportModelAsMpsFormat(fixed_format, obfuscate, output);
 }
+
+bool MPSolver::ExportModelAsLpFormat(bool obfuscate, MPModelExportSink* sink) {
+  MPModelProto proto;
+  ExportModelToProto(&proto);
+  MPModelProtoExporter exporter(proto);
+  return exporter.ExportModelAsLpFormat(obfuscate, sink);
+}
+
+bool MPSolver::ExportModelAsMpsFormat(bool fixed_format, bool obfuscate,
+                                      MPModelExportSink* sink) {
+  MPModelProto proto;
+  ExportModelToProto(&proto);
+  MPModelProtoExporter exporter(proto);
+  return exporter.ExportModelAsMpsFormat(fixed_format, obfuscate, sink);
+}
 #endif
 
 // ---------- MPSolverInterface ----------
@@ -1263,7 +1561,8 @@ void MPSolverInterface::SetCommonParameters(const MPSolverParameters& param) {
 // than for the rest of the solvers.
 //
 #if defined(USE_GLOP)
-  if (solver_->ProblemType() != MPSolver::GLOP_LINEAR_PROGRAMMING) {
+  if (solver_->ProblemType() != MPSolver::GLOP_LINEAR_PROGRAMMING &&
+      solver_->ProblemType() != MPSolver::GLOP_MIXED_INTEGER_PROGRAMMING) {
 #endif
     SetPrimalTolerance(
         param.GetDoubleParam(MPSolverParameters::PRIMAL_TOLERANCE));
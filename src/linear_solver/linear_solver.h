@@ -155,7 +155,9 @@
 
 namespace operations_research {
 
+class MPBinaryModel;
 class MPConstraint;
+class MPModelExportSink;
 class MPObjective;
 class MPSolverInterface;
 class MPSolverParameters;
@@ -212,6 +214,9 @@ class MPSolver {
     #if defined(USE_BOP)
     BOP_INTEGER_PROGRAMMING = 12,
     #endif
+    #ifdef USE_GLOP
+    GLOP_MIXED_INTEGER_PROGRAMMING = 14,
+    #endif
   };
 
   MPSolver(const std::string& name, OptimizationProblemType problem_type);
@@ -271,6 +276,11 @@ class MPSolver {
                        std::vector<MPVariable*>* vars);
   // Creates an array of boolean variables.
   void MakeBoolVarArray(int nb, const std::string& name, std::vector<MPVariable*>* vars);
+  // Bulk version of MakeVarArray(): creates one variable per entry of lb and
+  // ub, which must have the same size, with the i-th bounds.
+  void MakeVarArray(const std::vector<double>& lb, const std::vector<double>& ub,
+                    bool integer, const std::string& name_prefix,
+                    std::vector<MPVariable*>* vars);
 
   // ----- Constraints -----
   // Returns the number of constraints.
@@ -293,6 +303,28 @@ class MPSolver {
   // Creates a named constraint with -infinity and +infinity bounds.
   MPConstraint* MakeRowConstraint(const std::string& name);
 
+  // Creates lb.size() constraints at once from a matrix in compressed sparse
+  // row (CSR) format: the terms of the i-th constraint are the pairs
+  // (var_indices[k], coefficients[k]) for k in [row_starts[i],
+  // row_starts[i + 1]), where var_indices are indices in variables(). Thus
+  // row_starts must have lb.size() + 1 entries. As with successive calls to
+  // SetCoefficient(), the last coefficient is kept if a variable appears
+  // twice in a row, and zeros are skipped. The constraints are named from
+  // name_prefix as in MakeVarArray() and appended to constraints if it is not
+  // NULL.
+  //
+  // This is much faster than MakeRowConstraint() followed by one
+  // SetCoefficient() per term, because the terms are copied directly in the
+  // flat storage of each constraint, and only the long rows are hashed once
+  // to index their variables.
+  void MakeRowConstraintArray(const std::vector<double>& lb,
+                              const std::vector<double>& ub,
+                              const std::vector<int>& row_starts,
+                              const std::vector<int>& var_indices,
+                              const std::vector<double>& coefficients,
+                              const std::string& name_prefix,
+                              std::vector<MPConstraint*>* constraints);
+
   // ----- Objective -----
   // Note that the objective is owned by the solver, and is initialized to
   // its default value (see the MPObjective class below) at construction.
@@ -393,6 +425,30 @@ class MPSolver {
   static void SolveWithProto(const MPModelRequest& model_request,
                              MPSolutionResponse* response);
 
+  // Same as SolveWithProto() but uses this solver, after clearing its current
+  // model and parameters, instead of a temporary one. The problem type of this
+  // solver must correspond to the solver_type of the request. Reusing a solver
+  // from one request to the next keeps the allocations of its underlying
+  // solver, see batch_solver.h.
+  void ClearAndSolveWithProto(const MPModelRequest& model_request,
+                              MPSolutionResponse* response);
+
+  // Loads a model stored in the binary format of binary_model.h, in the same
+  // way as LoadModelFromProto(): the names are dropped and the model is
+  // validated first.
+  MPSolverResponseStatus LoadModelFromBinaryModel(const MPBinaryModel& model,
+                                                  std::string* error_message);
+
+  // Clears the current model and solves the given binary model with the
+  // current time limit and solver specific parameters, then fills the response
+  // as FillSolutionResponseProto() does. Solvers that support it (GLOP) build
+  // their internal model directly from the arrays of the binary model without
+  // creating any MPVariable or MPConstraint, in which case the solution is only
+  // available in the response. Other solvers load the model first with
+  // LoadModelFromBinaryModel().
+  void ClearAndSolveBinaryModel(const MPBinaryModel& model,
+                                MPSolutionResponse* response);
+
   // Exports model to protocol buffer.
   void ExportModelToProto(MPModelProto* output_model) const;
 
@@ -434,6 +490,11 @@ class MPSolver {
   bool ExportModelAsLpFormat(bool obfuscated, std::string* model_str);
   bool ExportModelAsMpsFormat(bool fixed_format, bool obfuscated,
                               std::string* model_str);
+  // Same as above, but the output is given to the sink as it is generated,
+  // e.g. to write a large model to a file without building it in memory.
+  bool ExportModelAsLpFormat(bool obfuscated, MPModelExportSink* sink);
+  bool ExportModelAsMpsFormat(bool fixed_format, bool obfuscated,
+                              MPModelExportSink* sink);
 #endif
   // ----- Misc -----
 
@@ -545,6 +606,7 @@ class MPSolver {
   friend class SLMInterface;
   friend class MPSolverInterface;
   friend class GLOPInterface;
+  friend class GlopMipInterface;
   friend class BopInterface;
   friend class KnapsackInterface;
 
@@ -558,6 +620,18 @@ class MPSolver {
   int ComputeMaxConstraintSize(int min_constraint_index,
                                int max_constraint_index) const;
 
+  // Sets the terms of a newly created constraint, which has no coefficient
+  // yet, without going through MPConstraint::SetCoefficient(). This is
+  // possible since the interface only needs to be notified of changes on
+  // extracted constraints. position_in_constraint must have NumVariables()
+  // entries, all equal to -1, and is restored to this state on return.
+  void SetNewConstraintTerms(int num_terms, const int* var_indices,
+                             const double* coefficients, MPConstraint* ct,
+                             std::vector<int>* position_in_constraint);
+
+  // Implementation of LoadModelFromBinaryModel() once the model is validated.
+  void LoadValidatedBinaryModel(const MPBinaryModel& model);
+
   // Returns true if the model has constraints with lower bound > upper bound.
   bool HasInfeasibleConstraints() const;
 
@@ -616,20 +690,58 @@ inline std::ostream& operator<<(std::ostream& os,
 }
 #endif
 
+typedef std::pair<const MPVariable*, double> CoeffEntry;
+
 // The data structure used to store the coefficients of the contraints and of
 // the objective. Also define a type to facilitate iteration over them with:
 //  for (CoeffEntry entry : coefficients_) { ... }
-class CoeffMap : public hash_map<const MPVariable*, double> {
+//
+// The entries are stored contiguously in insertion order, so that the solver
+// interfaces extract them with a linear scan. The lookups by variable use a
+// hash index as soon as a map has more than kMaxLinearScanSize entries,
+// including the constraints created in bulk by
+// MPSolver::MakeRowConstraintArray(). The index is maintained by the
+// insertions only, so that the const lookups can run concurrently.
+class CoeffMap {
  public:
-  explicit CoeffMap(int num_buckets)
-#if !defined(_MSC_VER)  // Visual C++ doesn't support this constructor
-      : hash_map<const MPVariable*, double>(num_buckets)
-#endif  // _MSC_VER
-  {
-  }
-};
+  typedef CoeffEntry value_type;
+  typedef std::vector<CoeffEntry>::iterator iterator;
+  typedef std::vector<CoeffEntry>::const_iterator const_iterator;
+
+  CoeffMap() {}
+
+  iterator begin() { return entries_.begin(); }
+  iterator end() { return entries_.end(); }
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+  size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+  void reserve(size_t size) { entries_.reserve(size); }
+  void clear();
+
+  // Same semantic as the hash_map functions with the same name.
+  iterator find(const MPVariable* var);
+  const_iterator find(const MPVariable* var) const;
+  std::pair<iterator, bool> insert(const CoeffEntry& entry);
+  double& operator[](const MPVariable* var);
+
+  // Appends an entry for a variable that is not already in the map.
+  void AddNewEntry(const MPVariable* var, double coeff);
 
-typedef std::pair<const MPVariable*, double> CoeffEntry;
+ private:
+  // Returns the position of var in entries_, or -1 if it is not there.
+  int FindPosition(const MPVariable* var) const;
+
+  // Builds index_ if entries_ has more than kMaxLinearScanSize entries and it
+  // is not built yet.
+  void BuildIndexIfNeeded();
+
+  std::vector<CoeffEntry> entries_;
+
+  // Position of each variable in entries_. This is either empty or complete.
+  static const int kMaxLinearScanSize = 16;
+  hash_map<const MPVariable*, int> index_;
+};
 
 // A class to express a linear objective.
 class MPObjective {
@@ -693,6 +805,8 @@ class MPObjective {
   friend class GurobiInterface;
   friend class CplexInterface;
   friend class GLOPInterface;
+  friend class GlopMipInterface;
+  friend class GlopInterfaceUtils;
   friend class BopInterface;
   friend class KnapsackInterface;
 
@@ -702,7 +816,7 @@ class MPObjective {
   // At construction, an MPObjective has no terms (which is equivalent
   // on having a coefficient of 0 for all variables), and an offset of 0.
   explicit MPObjective(MPSolverInterface* const interface)
-      : interface_(interface), coefficients_(1), offset_(0.0) {}
+      : interface_(interface), coefficients_(), offset_(0.0) {}
 
   MPSolverInterface* const interface_;
 
@@ -767,6 +881,8 @@ class MPVariable {
   friend class GurobiInterface;
   friend class CplexInterface;
   friend class GLOPInterface;
+  friend class GlopMipInterface;
+  friend class GlopInterfaceUtils;
   friend class MPVariableSolutionValueTest;
   friend class BopInterface;
   friend class KnapsackInterface;
@@ -864,6 +980,8 @@ class MPConstraint {
   friend class GurobiInterface;
   friend class CplexInterface;
   friend class GLOPInterface;
+  friend class GlopMipInterface;
+  friend class GlopInterfaceUtils;
   friend class BopInterface;
   friend class KnapsackInterface;
 
@@ -872,7 +990,7 @@ class MPConstraint {
   // to several models.
   MPConstraint(int index, double lb, double ub, const std::string& name,
                MPSolverInterface* const interface)
-      : coefficients_(1),
+      : coefficients_(),
         index_(index),
         lb_(lb),
         ub_(ub),
@@ -1234,6 +1352,17 @@ class MPSolverInterface {
 
   virtual bool InterruptSolve() { return false; }
 
+  // Solves the given binary model directly, i.e. without going through the
+  // variables and constraints of solver_, which must be empty. Sets
+  // result_status_ and objective_value_ and fills variable_values with the
+  // solution if there is one. Returns false if this is not supported by the
+  // interface.
+  virtual bool SolveBinaryModel(const MPBinaryModel& model,
+                                const MPSolverParameters& param,
+                                std::vector<double>* variable_values) {
+    return false;
+  }
+
   friend class MPSolver;
 
   // To access the maximize_ bool and the MPSolver.
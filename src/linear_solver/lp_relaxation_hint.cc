@@ -0,0 +1,439 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#if defined(USE_GLOP)
+
+#include "linear_solver/lp_relaxation_hint.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "glop/lp_solver.h"
+#include "glop/proto_utils.h"
+#include "lp_data/lp_data.h"
+#include "lp_data/lp_types.h"
+#include "util/time_limit.h"
+
+namespace operations_research {
+
+namespace {
+
+const double kInfinity = std::numeric_limits<double>::infinity();
+
+// Tolerance used for the integrality of the values and, relatively to the
+// magnitude of the bounds, for the feasibility of the bounds and constraints.
+const double kTolerance = 1e-6;
+
+// Maximum number of constraint terms visited by the propagation, per entry of
+// the constraint matrix. Once reached, the dive continues without propagation.
+const int64 kMaxPropagationWorkPerEntry = 100;
+
+bool HasPrimalSolution(glop::ProblemStatus status) {
+  return status == glop::ProblemStatus::OPTIMAL ||
+         status == glop::ProblemStatus::PRIMAL_FEASIBLE ||
+         status == glop::ProblemStatus::IMPRECISE;
+}
+
+bool IsWithinBounds(double value, double lower_bound, double upper_bound) {
+  return value >= lower_bound - kTolerance * std::max(1.0, fabs(lower_bound)) &&
+         value <= upper_bound + kTolerance * std::max(1.0, fabs(upper_bound));
+}
+
+// Returns true if the given values are a feasible solution of the model.
+bool IsFeasibleSolution(const MPModelProto& model,
+                        const std::vector<double>& values) {
+  for (int var = 0; var < model.variable_size(); ++var) {
+    const MPVariableProto& variable = model.variable(var);
+    if (!IsWithinBounds(values[var], variable.lower_bound(),
+                        variable.upper_bound())) {
+      return false;
+    }
+    if (variable.is_integer() &&
+        fabs(values[var] - round(values[var])) > kTolerance) {
+      return false;
+    }
+  }
+  for (const MPConstraintProto& constraint : model.constraint()) {
+    double activity = 0.0;
+    for (int k = 0; k < constraint.var_index_size(); ++k) {
+      activity += constraint.coefficient(k) * values[constraint.var_index(k)];
+    }
+    if (!IsWithinBounds(activity, constraint.lower_bound(),
+                        constraint.upper_bound())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The domains of the integer variables of a model, tightened by propagating
+// its linear constraints. For each constraint, the minimum and maximum of its
+// activity over the current domains are maintained incrementally: they are
+// stored as a finite sum plus the number of infinite contributions. All the
+// bound changes are recorded on a trail, so that they can be undone.
+class IntegerBoundPropagator {
+ public:
+  explicit IntegerBoundPropagator(const MPModelProto& model);
+
+  // Propagates all the constraints. Returns false if a conflict is found,
+  // including an integer variable whose bounds contain no integer.
+  bool PropagateAll();
+
+  // Fixes the given integer variable to the given value, which must be in its
+  // domain, and propagates. Returns false if a conflict is found, in which case
+  // the domains must be restored with Undo().
+  bool Fix(int var, double value);
+
+  // Undoes all the bound changes made after the trail had the given size.
+  int TrailSize() const { return trail_.size(); }
+  void Undo(int trail_size);
+
+  double lower_bound(int var) const { return lower_bounds_[var]; }
+  double upper_bound(int var) const { return upper_bounds_[var]; }
+
+ private:
+  struct ColumnEntry {
+    int constraint;
+    double coefficient;
+  };
+
+  struct BoundChange {
+    int var;
+    double old_lower_bound;
+    double old_upper_bound;
+  };
+
+  // Adds (sign = 1) or removes (sign = -1) the contribution of a variable with
+  // the given coefficient and bounds to the activity bounds of a constraint.
+  void UpdateActivity(int ct, double coefficient, double lower_bound,
+                      double upper_bound, int sign);
+
+  // Changes the bounds of var, updates the activities of its constraints and
+  // enqueues them if enqueue is true.
+  void ChangeBounds(int var, double lower_bound, double upper_bound,
+                    bool enqueue);
+
+  // Tightens the bounds of the integer variables of the constraint. Returns
+  // false if the constraint cannot be satisfied.
+  bool PropagateConstraint(int ct);
+
+  // Propagates the enqueued constraints until a fixed point or a conflict.
+  bool Propagate();
+
+  const MPModelProto& model_;
+  std::vector<double> lower_bounds_;
+  std::vector<double> upper_bounds_;
+
+  // The constraint matrix in compressed sparse column format.
+  std::vector<int> column_starts_;
+  std::vector<ColumnEntry> column_entries_;
+
+  std::vector<double> min_activities_;
+  std::vector<double> max_activities_;
+  std::vector<int> num_infinite_min_activities_;
+  std::vector<int> num_infinite_max_activities_;
+
+  std::vector<BoundChange> trail_;
+  std::vector<int> queue_;
+  std::vector<bool> in_queue_;
+  int64 remaining_work_;
+
+  DISALLOW_COPY_AND_ASSIGN(IntegerBoundPropagator);
+};
+
+IntegerBoundPropagator::IntegerBoundPropagator(const MPModelProto& model)
+    : model_(model),
+      lower_bounds_(model.variable_size()),
+      upper_bounds_(model.variable_size()),
+      column_starts_(model.variable_size() + 1, 0),
+      column_entries_(),
+      min_activities_(model.constraint_size(), 0.0),
+      max_activities_(model.constraint_size(), 0.0),
+      num_infinite_min_activities_(model.constraint_size(), 0),
+      num_infinite_max_activities_(model.constraint_size(), 0),
+      trail_(),
+      queue_(),
+      in_queue_(model.constraint_size(), false),
+      remaining_work_(0) {
+  const int num_vars = model.variable_size();
+  for (int var = 0; var < num_vars; ++var) {
+    const MPVariableProto& variable = model.variable(var);
+    lower_bounds_[var] = variable.lower_bound();
+    upper_bounds_[var] = variable.upper_bound();
+    if (variable.is_integer()) {
+      lower_bounds_[var] = ceil(lower_bounds_[var] - kTolerance);
+      upper_bounds_[var] = floor(upper_bounds_[var] + kTolerance);
+    }
+  }
+
+  // Counting sort of the constraint terms by variable.
+  for (const MPConstraintProto& constraint : model.constraint()) {
+    for (const int var : constraint.var_index()) ++column_starts_[var + 1];
+  }
+  for (int var = 0; var < num_vars; ++var) {
+    column_starts_[var + 1] += column_starts_[var];
+  }
+  column_entries_.resize(column_starts_.back());
+  std::vector<int> next_entry(column_starts_.begin(), column_starts_.end() - 1);
+  for (int ct = 0; ct < model.constraint_size(); ++ct) {
+    const MPConstraintProto& constraint = model.constraint(ct);
+    for (int k = 0; k < constraint.var_index_size(); ++k) {
+      const int var = constraint.var_index(k);
+      const double coefficient = constraint.coefficient(k);
+      column_entries_[next_entry[var]++] = {ct, coefficient};
+      UpdateActivity(ct, coefficient, lower_bounds_[var], upper_bounds_[var],
+                     1);
+    }
+  }
+  remaining_work_ = kMaxPropagationWorkPerEntry * (column_entries_.size() + 1);
+}
+
+void IntegerBoundPropagator::UpdateActivity(int ct, double coefficient,
+                                            double lower_bound,
+                                            double upper_bound, int sign) {
+  if (coefficient == 0.0) return;
+  const double min_bound = coefficient > 0.0 ? lower_bound : upper_bound;
+  const double max_bound = coefficient > 0.0 ? upper_bound : lower_bound;
+  if (std::isinf(min_bound)) {
+    num_infinite_min_activities_[ct] += sign;
+  } else {
+    min_activities_[ct] += sign * coefficient * min_bound;
+  }
+  if (std::isinf(max_bound)) {
+    num_infinite_max_activities_[ct] += sign;
+  } else {
+    max_activities_[ct] += sign * coefficient * max_bound;
+  }
+}
+
+void IntegerBoundPropagator::ChangeBounds(int var, double lower_bound,
+                                          double upper_bound, bool enqueue) {
+  for (int i = column_starts_[var]; i < column_starts_[var + 1]; ++i) {
+    const ColumnEntry& entry = column_entries_[i];
+    UpdateActivity(entry.constraint, entry.coefficient, lower_bounds_[var],
+                   upper_bounds_[var], -1);
+    UpdateActivity(entry.constraint, entry.coefficient, lower_bound,
+                   upper_bound, 1);
+    if (enqueue && !in_queue_[entry.constraint]) {
+      in_queue_[entry.constraint] = true;
+      queue_.push_back(entry.constraint);
+    }
+  }
+  lower_bounds_[var] = lower_bound;
+  upper_bounds_[var] = upper_bound;
+}
+
+bool IntegerBoundPropagator::PropagateConstraint(int ct) {
+  const MPConstraintProto& constraint = model_.constraint(ct);
+  const double lb = constraint.lower_bound();
+  const double ub = constraint.upper_bound();
+  if (num_infinite_min_activities_[ct] == 0 &&
+      !IsWithinBounds(min_activities_[ct], -kInfinity, ub)) {
+    return false;
+  }
+  if (num_infinite_max_activities_[ct] == 0 &&
+      !IsWithinBounds(max_activities_[ct], lb, kInfinity)) {
+    return false;
+  }
+  remaining_work_ -= constraint.var_index_size();
+  for (int k = 0; k < constraint.var_index_size(); ++k) {
+    const int var = constraint.var_index(k);
+    const double coefficient = constraint.coefficient(k);
+    if (coefficient == 0.0 || !model_.variable(var).is_integer()) continue;
+    const double var_lb = lower_bounds_[var];
+    const double var_ub = upper_bounds_[var];
+    if (var_lb == var_ub) continue;
+
+    // The activity bounds of the other terms of the constraint, if finite.
+    const double min_bound = coefficient > 0.0 ? var_lb : var_ub;
+    const double max_bound = coefficient > 0.0 ? var_ub : var_lb;
+    const int num_other_infinite_min =
+        num_infinite_min_activities_[ct] - (std::isinf(min_bound) ? 1 : 0);
+    const int num_other_infinite_max =
+        num_infinite_max_activities_[ct] - (std::isinf(max_bound) ? 1 : 0);
+    double new_lb = var_lb;
+    double new_ub = var_ub;
+    if (num_other_infinite_min == 0 && ub != kInfinity) {
+      const double other_min =
+          min_activities_[ct] -
+          (std::isinf(min_bound) ? 0.0 : coefficient * min_bound);
+      const double bound = (ub - other_min) / coefficient;
+      if (coefficient > 0.0) {
+        new_ub = std::min(new_ub, floor(bound + kTolerance));
+      } else {
+        new_lb = std::max(new_lb, ceil(bound - kTolerance));
+      }
+    }
+    if (num_other_infinite_max == 0 && lb != -kInfinity) {
+      const double other_max =
+          max_activities_[ct] -
+          (std::isinf(max_bound) ? 0.0 : coefficient * max_bound);
+      const double bound = (lb - other_max) / coefficient;
+      if (coefficient > 0.0) {
+        new_lb = std::max(new_lb, ceil(bound - kTolerance));
+      } else {
+        new_ub = std::min(new_ub, floor(bound + kTolerance));
+      }
+    }
+    if (new_lb > new_ub) return false;
+    if (new_lb != var_lb || new_ub != var_ub) {
+      trail_.push_back({var, var_lb, var_ub});
+      ChangeBounds(var, new_lb, new_ub, /*enqueue=*/true);
+    }
+  }
+  return true;
+}
+
+bool IntegerBoundPropagator::Propagate() {
+  bool feasible = true;
+  for (int i = 0; i < queue_.size(); ++i) {
+    const int ct = queue_[i];
+    in_queue_[ct] = false;
+    if (feasible && remaining_work_ > 0) feasible = PropagateConstraint(ct);
+  }
+  queue_.clear();
+  return feasible;
+}
+
+bool IntegerBoundPropagator::PropagateAll() {
+  // The rounding of the bounds of the integer variables in the constructor
+  // empties the domain of the ones without any integer value, like [0.3, 0.7].
+  for (int var = 0; var < lower_bounds_.size(); ++var) {
+    if (lower_bounds_[var] > upper_bounds_[var]) return false;
+  }
+  for (int ct = 0; ct < model_.constraint_size(); ++ct) {
+    in_queue_[ct] = true;
+    queue_.push_back(ct);
+  }
+  return Propagate();
+}
+
+bool IntegerBoundPropagator::Fix(int var, double value) {
+  DCHECK(model_.variable(var).is_integer());
+  DCHECK_GE(value, lower_bounds_[var]);
+  DCHECK_LE(value, upper_bounds_[var]);
+  trail_.push_back({var, lower_bounds_[var], upper_bounds_[var]});
+  ChangeBounds(var, value, value, /*enqueue=*/true);
+  return Propagate();
+}
+
+void IntegerBoundPropagator::Undo(int trail_size) {
+  while (trail_.size() > trail_size) {
+    const BoundChange& change = trail_.back();
+    ChangeBounds(change.var, change.old_lower_bound, change.old_upper_bound,
+                 /*enqueue=*/false);
+    trail_.pop_back();
+  }
+}
+
+void FillHint(const std::vector<double>& values,
+              PartialVariableAssignment* hint) {
+  hint->Clear();
+  for (int var = 0; var < values.size(); ++var) {
+    hint->add_var_index(var);
+    hint->add_var_value(values[var]);
+  }
+}
+
+}  // namespace
+
+bool FindSolutionHintFromLpRelaxation(const MPModelProto& model,
+                                      double max_time_in_seconds,
+                                      PartialVariableAssignment* hint) {
+  CHECK(hint != nullptr);
+  TimeLimit time_limit(max_time_in_seconds);
+  glop::LinearProgram lp;
+  glop::MPModelProtoToLinearProgram(model, &lp);
+  glop::LPSolver lp_solver;
+  if (!HasPrimalSolution(lp_solver.SolveWithTimeLimit(lp, &time_limit))) {
+    VLOG(1) << "The linear relaxation could not be solved.";
+    return false;
+  }
+  const int num_vars = model.variable_size();
+  std::vector<double> relaxation_values(num_vars);
+  std::vector<int> integer_vars;
+  for (int var = 0; var < num_vars; ++var) {
+    relaxation_values[var] = lp_solver.variable_values()[glop::ColIndex(var)];
+    if (model.variable(var).is_integer()) integer_vars.push_back(var);
+  }
+  if (integer_vars.empty()) return false;
+
+  // Simple rounding.
+  std::vector<double> values = relaxation_values;
+  for (const int var : integer_vars) values[var] = round(values[var]);
+  if (IsFeasibleSolution(model, values)) {
+    VLOG(1) << "Solution hint found by rounding the linear relaxation.";
+    FillHint(values, hint);
+    return true;
+  }
+
+  // Fix-and-propagate dive, from the most to the least integral variables.
+  IntegerBoundPropagator propagator(model);
+  if (!propagator.PropagateAll()) return false;
+  std::stable_sort(integer_vars.begin(), integer_vars.end(),
+                   [&relaxation_values](int a, int b) {
+                     const double value_a = relaxation_values[a];
+                     const double value_b = relaxation_values[b];
+                     return fabs(value_a - round(value_a)) <
+                            fabs(value_b - round(value_b));
+                   });
+  for (const int var : integer_vars) {
+    if (time_limit.LimitReached()) return false;
+    const double lb = propagator.lower_bound(var);
+    const double ub = propagator.upper_bound(var);
+    if (lb == ub) continue;
+    const double value = relaxation_values[var];
+    const double rounded = std::min(ub, std::max(lb, round(value)));
+    const int trail_size = propagator.TrailSize();
+    if (propagator.Fix(var, rounded)) continue;
+    propagator.Undo(trail_size);
+
+    // Try the other integer next to the relaxation value.
+    double other = value < rounded ? rounded - 1.0 : rounded + 1.0;
+    if (other < lb || other > ub) other = 2.0 * rounded - other;
+    if (other < lb || other > ub || !propagator.Fix(var, other)) {
+      VLOG(1) << "The fix-and-propagate dive failed.";
+      return false;
+    }
+  }
+  for (const int var : integer_vars) values[var] = propagator.lower_bound(var);
+
+  // Set the continuous variables by solving the linear program with all the
+  // integer variables fixed.
+  if (integer_vars.size() < num_vars) {
+    for (const int var : integer_vars) {
+      lp.SetVariableBounds(glop::ColIndex(var), values[var], values[var]);
+    }
+    if (!HasPrimalSolution(lp_solver.SolveWithTimeLimit(lp, &time_limit))) {
+      return false;
+    }
+    for (int var = 0; var < num_vars; ++var) {
+      if (!model.variable(var).is_integer()) {
+        values[var] = lp_solver.variable_values()[glop::ColIndex(var)];
+      }
+    }
+  }
+  if (!IsFeasibleSolution(model, values)) return false;
+  VLOG(1) << "Solution hint found by the fix-and-propagate dive.";
+  FillHint(values, hint);
+  return true;
+}
+
+}  // namespace operations_research
+
+#endif  // #if defined(USE_GLOP)
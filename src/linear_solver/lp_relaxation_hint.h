@@ -0,0 +1,50 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A primal heuristic for mixed integer programs, used to generate the
+// solution_hint of a model before it is given to a MIP solver.
+//
+// The linear relaxation of the model is solved with Glop, then:
+// - The integer variables are simply rounded to the nearest integer. If this
+//   gives a feasible solution, it is returned.
+// - Otherwise, a fix-and-propagate dive fixes the integer variables one by one,
+//   from the most integral in the relaxation to the most fractional, to their
+//   rounded value (or to the other neighbouring integer if this leads to a
+//   conflict). After each fixing, the bounds of the other integer variables
+//   are tightened by propagating the linear constraints. Once all the integer
+//   variables are fixed, the continuous ones are set by solving the linear
+//   program with the integer variables fixed.
+// This is the same idea as using the solution of the relaxation as assignment
+// preference in sat::SolveLpAndUseSolutionForSatAssignmentPreference(), with
+// the propagation done directly on the linear constraints.
+
+#ifndef OR_TOOLS_LINEAR_SOLVER_LP_RELAXATION_HINT_H_
+#define OR_TOOLS_LINEAR_SOLVER_LP_RELAXATION_HINT_H_
+
+#include "linear_solver/linear_solver.pb.h"
+
+namespace operations_research {
+
+// Tries to find a feasible solution of the given model, which must be valid
+// (see FindErrorInMPModelProto()) and have at least one integer variable, with
+// the heuristic above. Returns true and fills hint with the values of all the
+// variables on success. Returns false if no solution was found within the given
+// time limit, including when an integer variable has no integer value within
+// its bounds.
+bool FindSolutionHintFromLpRelaxation(const MPModelProto& model,
+                                      double max_time_in_seconds,
+                                      PartialVariableAssignment* hint);
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_LINEAR_SOLVER_LP_RELAXATION_HINT_H_
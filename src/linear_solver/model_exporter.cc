@@ -46,7 +46,8 @@ MPModelProtoExporter::MPModelProtoExporter(const MPModelProto& proto)
       num_continuous_variables_(0),
       current_mps_column_(0),
       use_fixed_mps_format_(false),
-      use_obfuscated_names_(false) {}
+      use_obfuscated_names_(false),
+      sink_(nullptr) {}
 
 namespace {
 class NameManager {
@@ -186,7 +187,13 @@ class LineBreaker {
   // lines.
   void Consume(int size) { line_size_ += size; }
 
-  std::string GetOutput() const { return output_; }
+  // Clears the output, to reuse its memory for the next line.
+  void Clear() {
+    line_size_ = 0;
+    output_.clear();
+  }
+
+  const std::string& GetOutput() const { return output_; }
 
  private:
   int max_line_size_;
@@ -213,8 +220,8 @@ bool MPModelProtoExporter::WriteLpTerm(int var_index, double coefficient,
     return false;
   }
   if (coefficient != 0.0) {
-    *output = StringPrintf("%+.16G %-s ", coefficient,
-                           exported_variable_names_[var_index].c_str());
+    StringAppendF(output, "%+.16G %-s ", coefficient,
+                  exported_variable_names_[var_index].c_str());
   }
   return true;
 }
@@ -242,9 +249,36 @@ void MPModelProtoExporter::Setup() {
       proto_.variable_size() - num_binary_variables_ - num_integer_variables_;
 }
 
+bool MPModelProtoExporter::FlushOutput(bool force, std::string* output) {
+  if (sink_ == nullptr || (!force && output->size() < kExportBufferSize)) {
+    return true;
+  }
+  const bool ok = sink_->Append(output->data(), output->size());
+  output->clear();
+  return ok;
+}
+
 bool MPModelProtoExporter::ExportModelAsLpFormat(bool obfuscated,
                                                  std::string* output) {
   output->clear();
+  sink_ = nullptr;
+  return ExportModelAsLpFormatInternal(obfuscated, output);
+}
+
+bool MPModelProtoExporter::ExportModelAsLpFormat(bool obfuscated,
+                                                 MPModelExportSink* sink) {
+  CHECK(sink != nullptr);
+  std::string buffer;
+  buffer.reserve(kExportBufferSize);
+  sink_ = sink;
+  const bool ok = ExportModelAsLpFormatInternal(obfuscated, &buffer) &&
+                  FlushOutput(/*force=*/true, &buffer);
+  sink_ = nullptr;
+  return ok;
+}
+
+bool MPModelProtoExporter::ExportModelAsLpFormatInternal(bool obfuscated,
+                                                         std::string* output) {
   Setup();
   exported_constraint_names_ =
       ExtractAndProcessNames(proto_.constraint(), "C", obfuscated);
@@ -264,9 +298,10 @@ bool MPModelProtoExporter::ExportModelAsLpFormat(bool obfuscated,
   }
   std::vector<bool> show_variable(proto_.variable_size(),
                              FLAGS_lp_shows_unused_variables);
+  // Reused for all the terms.
+  std::string term;
   for (int var_index = 0; var_index < proto_.variable_size(); ++var_index) {
     const double coeff = proto_.variable(var_index).objective_coefficient();
-    std::string term;
     if (!WriteLpTerm(var_index, coeff, &term)) {
       return false;
     }
@@ -275,10 +310,12 @@ bool MPModelProtoExporter::ExportModelAsLpFormat(bool obfuscated,
   }
   // Constraints
   StrAppend(output, obj_line_breaker.GetOutput(), "\nSubject to\n");
+  LineBreaker line_breaker(FLAGS_lp_max_line_length);
   for (int cst_index = 0; cst_index < proto_.constraint_size(); ++cst_index) {
+    if (!FlushOutput(/*force=*/false, output)) return false;
     const MPConstraintProto& ct_proto = proto_.constraint(cst_index);
     const std::string& name = exported_constraint_names_[cst_index];
-    LineBreaker line_breaker(FLAGS_lp_max_line_length);
+    line_breaker.Clear();
     const int kNumFormattingChars = 10;  // Overevaluated.
     // Account for the size of the constraint name + possibly "_rhs" +
     // the formatting characters here.
@@ -286,7 +323,6 @@ bool MPModelProtoExporter::ExportModelAsLpFormat(bool obfuscated,
     for (int i = 0; i < ct_proto.var_index_size(); ++i) {
       const int var_index = ct_proto.var_index(i);
       const double coeff = ct_proto.coefficient(i);
-      std::string term;
       if (!WriteLpTerm(var_index, coeff, &term)) {
         return false;
       }
@@ -332,6 +368,7 @@ bool MPModelProtoExporter::ExportModelAsLpFormat(bool obfuscated,
   }
   for (int var_index = 0; var_index < proto_.variable_size(); ++var_index) {
     if (!show_variable[var_index]) continue;
+    if (!FlushOutput(/*force=*/false, output)) return false;
     const MPVariableProto& var_proto = proto_.variable(var_index);
     const double lb = var_proto.lower_bound();
     const double ub = var_proto.upper_bound();
@@ -359,6 +396,7 @@ bool MPModelProtoExporter::ExportModelAsLpFormat(bool obfuscated,
       if (IsBoolean(var_proto)) {
         StringAppendF(output, " %s\n",
                       exported_variable_names_[var_index].c_str());
+        if (!FlushOutput(/*force=*/false, output)) return false;
       }
     }
   }
@@ -372,6 +410,7 @@ bool MPModelProtoExporter::ExportModelAsLpFormat(bool obfuscated,
       if (var_proto.is_integer() && !IsBoolean(var_proto)) {
         StringAppendF(output, " %s\n",
                       exported_variable_names_[var_index].c_str());
+        if (!FlushOutput(/*force=*/false, output)) return false;
       }
     }
   }
@@ -437,8 +476,9 @@ void MPModelProtoExporter::AppendNewLineIfTwoColumns(std::string* output) {
   }
 }
 
-void MPModelProtoExporter::AppendMpsColumns(bool integrality,
-    const std::vector<std::vector<std::pair<int, double>>>& transpose, std::string* output) {
+bool MPModelProtoExporter::AppendMpsColumns(
+    bool integrality, const std::vector<int>& column_starts,
+    const std::vector<std::pair<int, double>>& transpose, std::string* output) {
   current_mps_column_ = 0;
   for (int var_index = 0; var_index < proto_.variable_size(); ++var_index) {
     const MPVariableProto& var_proto = proto_.variable(var_index);
@@ -450,20 +490,44 @@ void MPModelProtoExporter::AppendMpsColumns(bool integrality,
                                var_proto.objective_coefficient(),
                                output);
     }
-    for (const std::pair<int, double> cst_index_and_coeff : transpose[var_index]) {
+    for (int k = column_starts[var_index]; k < column_starts[var_index + 1];
+         ++k) {
       const std::string& cst_name =
-          exported_constraint_names_[cst_index_and_coeff.first];
-      AppendMpsTermWithContext(var_name, cst_name, cst_index_and_coeff.second,
+          exported_constraint_names_[transpose[k].first];
+      AppendMpsTermWithContext(var_name, cst_name, transpose[k].second,
                                output);
     }
     AppendNewLineIfTwoColumns(output);
+    if (!FlushOutput(/*force=*/false, output)) return false;
   }
+  return true;
 }
 
 bool MPModelProtoExporter::ExportModelAsMpsFormat(bool fixed_format,
                                                   bool obfuscated,
                                                   std::string* output) {
   output->clear();
+  sink_ = nullptr;
+  return ExportModelAsMpsFormatInternal(fixed_format, obfuscated, output);
+}
+
+bool MPModelProtoExporter::ExportModelAsMpsFormat(bool fixed_format,
+                                                  bool obfuscated,
+                                                  MPModelExportSink* sink) {
+  CHECK(sink != nullptr);
+  std::string buffer;
+  buffer.reserve(kExportBufferSize);
+  sink_ = sink;
+  const bool ok =
+      ExportModelAsMpsFormatInternal(fixed_format, obfuscated, &buffer) &&
+      FlushOutput(/*force=*/true, &buffer);
+  sink_ = nullptr;
+  return ok;
+}
+
+bool MPModelProtoExporter::ExportModelAsMpsFormatInternal(bool fixed_format,
+                                                          bool obfuscated,
+                                                          std::string* output) {
   Setup();
   use_fixed_mps_format_ = fixed_format;
   exported_constraint_names_ =
@@ -480,33 +544,32 @@ bool MPModelProtoExporter::ExportModelAsMpsFormat(bool fixed_format,
   // NAME section.
   StringAppendF(output, "%-14s%s\n", "NAME", proto_.name().c_str());
 
-  // ROWS section.
+  // ROWS section. It is never empty because of the objective row.
   current_mps_column_ = 0;
-  std::string rows_section;
-  AppendMpsLineHeaderWithNewLine("N", "COST", &rows_section);
+  *output += "ROWS\n";
+  AppendMpsLineHeaderWithNewLine("N", "COST", output);
   for (int cst_index = 0; cst_index < proto_.constraint_size(); ++cst_index) {
     const MPConstraintProto& ct_proto = proto_.constraint(cst_index);
     const double lb = ct_proto.lower_bound();
     const double ub = ct_proto.upper_bound();
     const std::string& cst_name = exported_constraint_names_[cst_index];
     if (lb == ub) {
-      AppendMpsLineHeaderWithNewLine("E", cst_name, &rows_section);
+      AppendMpsLineHeaderWithNewLine("E", cst_name, output);
     } else if (lb == -std::numeric_limits<double>::infinity()) {
       DCHECK_NE(std::numeric_limits<double>::infinity(), ub);
-      AppendMpsLineHeaderWithNewLine("L", cst_name, &rows_section);
+      AppendMpsLineHeaderWithNewLine("L", cst_name, output);
     } else {
       DCHECK_NE(-std::numeric_limits<double>::infinity(), lb);
-      AppendMpsLineHeaderWithNewLine("G", cst_name, &rows_section);
+      AppendMpsLineHeaderWithNewLine("G", cst_name, output);
     }
-  }
-  if (!rows_section.empty()) {
-    *output += "ROWS\n" + rows_section;
+    if (!FlushOutput(/*force=*/false, output)) return false;
   }
 
-  // As the information regarding a column needs to be contiguous, we create
-  // a vector associating a variable index to a vector containing the indices
-  // of the constraints where this variable appears.
-  std::vector<std::vector<std::pair<int, double>>> transpose(proto_.variable_size());
+  // As the information regarding a column needs to be contiguous, we
+  // transpose the matrix: the (constraint index, coefficient) pairs of the
+  // column of a variable are contiguous in 'transpose', starting at
+  // column_starts[var_index].
+  std::vector<int> column_starts(proto_.variable_size() + 1, 0);
   for (int cst_index = 0; cst_index < proto_.constraint_size(); ++cst_index) {
     const MPConstraintProto& ct_proto = proto_.constraint(cst_index);
     for (int k = 0; k < ct_proto.var_index_size(); ++k) {
@@ -516,66 +579,123 @@ bool MPModelProtoExporter::ExportModelAsMpsFormat(bool fixed_format,
                     << " is " << var_index << ", which is out of bounds.";
         return false;
       }
-      const double coeff = ct_proto.coefficient(k);
-      if (coeff != 0.0) {
-        transpose[var_index].push_back(std::pair<int, double>(cst_index, coeff));
+      if (ct_proto.coefficient(k) != 0.0) ++column_starts[var_index + 1];
+    }
+  }
+  for (int var_index = 0; var_index < proto_.variable_size(); ++var_index) {
+    column_starts[var_index + 1] += column_starts[var_index];
+  }
+  std::vector<std::pair<int, double>> transpose(column_starts.back());
+  {
+    std::vector<int> next_entry(column_starts.begin(), column_starts.end() - 1);
+    for (int cst_index = 0; cst_index < proto_.constraint_size();
+         ++cst_index) {
+      const MPConstraintProto& ct_proto = proto_.constraint(cst_index);
+      for (int k = 0; k < ct_proto.var_index_size(); ++k) {
+        const double coeff = ct_proto.coefficient(k);
+        if (coeff != 0.0) {
+          transpose[next_entry[ct_proto.var_index(k)]++] =
+              std::pair<int, double>(cst_index, coeff);
+        }
       }
     }
   }
 
-  // COLUMNS section.
-  std::string columns_section;
-  AppendMpsColumns(/*integrality=*/true, transpose, &columns_section);
-  if (!columns_section.empty()) {
+  // COLUMNS section. A variable has a column iff it has a nonzero objective
+  // coefficient or a nonzero coefficient in a constraint.
+  bool has_integer_column = false;
+  bool has_continuous_column = false;
+  for (int var_index = 0; var_index < proto_.variable_size(); ++var_index) {
+    const MPVariableProto& var_proto = proto_.variable(var_index);
+    if (var_proto.objective_coefficient() != 0.0 ||
+        column_starts[var_index + 1] > column_starts[var_index]) {
+      (var_proto.is_integer() ? has_integer_column : has_continuous_column) =
+          true;
+    }
+  }
+  if (has_integer_column || has_continuous_column) *output += "COLUMNS\n";
+  if (has_integer_column) {
     const char* const kIntMarkerFormat = "  %-10s%-36s%-10s\n";
-    columns_section = StringPrintf(kIntMarkerFormat, "INTSTART",
-                                   "'MARKER'", "'INTORG'") + columns_section;
-    StringAppendF(&columns_section, kIntMarkerFormat,
-                  "INTEND", "'MARKER'", "'INTEND'");
+    StringAppendF(output, kIntMarkerFormat, "INTSTART", "'MARKER'",
+                  "'INTORG'");
+    if (!AppendMpsColumns(/*integrality=*/true, column_starts, transpose,
+                          output)) {
+      return false;
+    }
+    StringAppendF(output, kIntMarkerFormat, "INTEND", "'MARKER'", "'INTEND'");
   }
-  AppendMpsColumns(/*integrality=*/false, transpose, &columns_section);
-  if (!columns_section.empty()) {
-    *output += "COLUMNS\n" + columns_section;
+  if (!AppendMpsColumns(/*integrality=*/false, column_starts, transpose,
+                        output)) {
+    return false;
   }
 
   // RHS (right-hand-side) section.
-  current_mps_column_ = 0;
-  std::string rhs_section;
-  for (int cst_index = 0; cst_index < proto_.constraint_size(); ++cst_index) {
-    const MPConstraintProto& ct_proto = proto_.constraint(cst_index);
-    const double lb = ct_proto.lower_bound();
-    const double ub = ct_proto.upper_bound();
-    const std::string& cst_name = exported_constraint_names_[cst_index];
-    if (lb != -std::numeric_limits<double>::infinity()) {
-      AppendMpsTermWithContext("RHS", cst_name, lb, &rhs_section);
-    } else if (ub != +std::numeric_limits<double>::infinity()) {
-      AppendMpsTermWithContext("RHS", cst_name, ub, &rhs_section);
+  bool has_rhs = false;
+  for (const MPConstraintProto& ct_proto : proto_.constraint()) {
+    if (ct_proto.lower_bound() != -std::numeric_limits<double>::infinity() ||
+        ct_proto.upper_bound() != +std::numeric_limits<double>::infinity()) {
+      has_rhs = true;
+      break;
     }
   }
-  AppendNewLineIfTwoColumns(&rhs_section);
-  if (!rhs_section.empty()) {
-    *output += "RHS\n" + rhs_section;
+  if (has_rhs) {
+    current_mps_column_ = 0;
+    *output += "RHS\n";
+    for (int cst_index = 0; cst_index < proto_.constraint_size();
+         ++cst_index) {
+      const MPConstraintProto& ct_proto = proto_.constraint(cst_index);
+      const double lb = ct_proto.lower_bound();
+      const double ub = ct_proto.upper_bound();
+      const std::string& cst_name = exported_constraint_names_[cst_index];
+      if (lb != -std::numeric_limits<double>::infinity()) {
+        AppendMpsTermWithContext("RHS", cst_name, lb, output);
+      } else if (ub != +std::numeric_limits<double>::infinity()) {
+        AppendMpsTermWithContext("RHS", cst_name, ub, output);
+      }
+      if (!FlushOutput(/*force=*/false, output)) return false;
+    }
+    AppendNewLineIfTwoColumns(output);
   }
 
   // RANGES section.
-  current_mps_column_ = 0;
-  std::string ranges_section;
-  for (int cst_index = 0; cst_index < proto_.constraint_size(); ++cst_index) {
-    const MPConstraintProto& ct_proto = proto_.constraint(cst_index);
+  bool has_range = false;
+  for (const MPConstraintProto& ct_proto : proto_.constraint()) {
     const double range = fabs(ct_proto.upper_bound() - ct_proto.lower_bound());
     if (range != 0.0 && range != +std::numeric_limits<double>::infinity()) {
-      const std::string& cst_name = exported_constraint_names_[cst_index];
-      AppendMpsTermWithContext("RANGE", cst_name, range, &ranges_section);
+      has_range = true;
+      break;
     }
   }
-  AppendNewLineIfTwoColumns(&ranges_section);
-  if (!ranges_section.empty()) {
-    *output += "RANGES\n" + ranges_section;
+  if (has_range) {
+    current_mps_column_ = 0;
+    *output += "RANGES\n";
+    for (int cst_index = 0; cst_index < proto_.constraint_size();
+         ++cst_index) {
+      const MPConstraintProto& ct_proto = proto_.constraint(cst_index);
+      const double range =
+          fabs(ct_proto.upper_bound() - ct_proto.lower_bound());
+      if (range != 0.0 && range != +std::numeric_limits<double>::infinity()) {
+        const std::string& cst_name = exported_constraint_names_[cst_index];
+        AppendMpsTermWithContext("RANGE", cst_name, range, output);
+        if (!FlushOutput(/*force=*/false, output)) return false;
+      }
+    }
+    AppendNewLineIfTwoColumns(output);
   }
 
-  // BOUNDS section.
+  // BOUNDS section. Only the general integer variables with the default
+  // bounds [0, +inf) have no bound line.
+  bool has_bounds = false;
+  for (const MPVariableProto& var_proto : proto_.variable()) {
+    if (!var_proto.is_integer() || IsBoolean(var_proto) ||
+        var_proto.lower_bound() != 0.0 ||
+        var_proto.upper_bound() != +std::numeric_limits<double>::infinity()) {
+      has_bounds = true;
+      break;
+    }
+  }
+  if (has_bounds) *output += "BOUNDS\n";
   current_mps_column_ = 0;
-  std::string bounds_section;
   for (int var_index = 0; var_index < proto_.variable_size(); ++var_index) {
     const MPVariableProto& var_proto = proto_.variable(var_index);
     const double lb = var_proto.lower_bound();
@@ -583,38 +703,36 @@ bool MPModelProtoExporter::ExportModelAsMpsFormat(bool fixed_format,
     const std::string& var_name = exported_variable_names_[var_index];
     if (var_proto.is_integer()) {
       if (IsBoolean(var_proto)) {
-        AppendMpsLineHeader("BV", "BOUND", &bounds_section);
-        StringAppendF(&bounds_section, "  %s\n", var_name.c_str());
+        AppendMpsLineHeader("BV", "BOUND", output);
+        StringAppendF(output, "  %s\n", var_name.c_str());
       } else {
         if (lb != 0.0) {
-          AppendMpsBound("LI", var_name, lb, &bounds_section);
+          AppendMpsBound("LI", var_name, lb, output);
         }
         if (ub != +std::numeric_limits<double>::infinity()) {
-          AppendMpsBound("UI", var_name, ub, &bounds_section);
+          AppendMpsBound("UI", var_name, ub, output);
         }
       }
     } else {
       if (lb == -std::numeric_limits<double>::infinity() &&
           ub == +std::numeric_limits<double>::infinity()) {
-        AppendMpsLineHeader("FR", "BOUND", &bounds_section);
-        StringAppendF(&bounds_section, "  %s\n", var_name.c_str());
+        AppendMpsLineHeader("FR", "BOUND", output);
+        StringAppendF(output, "  %s\n", var_name.c_str());
       } else if (lb == ub) {
-        AppendMpsBound("FX", var_name, lb, &bounds_section);
+        AppendMpsBound("FX", var_name, lb, output);
       } else {
         if (lb != 0.0) {
-          AppendMpsBound("LO", var_name, lb, &bounds_section);
+          AppendMpsBound("LO", var_name, lb, output);
         } else if (ub == +std::numeric_limits<double>::infinity()) {
-          AppendMpsLineHeader("PL", "BOUND", &bounds_section);
-          StringAppendF(&bounds_section, "  %s\n", var_name.c_str());
+          AppendMpsLineHeader("PL", "BOUND", output);
+          StringAppendF(output, "  %s\n", var_name.c_str());
         }
         if (ub != +std::numeric_limits<double>::infinity()) {
-          AppendMpsBound("UP", var_name, ub, &bounds_section);
+          AppendMpsBound("UP", var_name, ub, output);
         }
       }
     }
-  }
-  if (!bounds_section.empty()) {
-    *output += "BOUNDS\n" + bounds_section;
+    if (!FlushOutput(/*force=*/false, output)) return false;
   }
 
   *output += "ENDATA\n";
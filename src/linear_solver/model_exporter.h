@@ -27,6 +27,17 @@ class MPVariable;
 
 class MPModelProto;
 
+// Receives the output of MPModelProtoExporter piece by piece, so that the
+// exported model never has to be entirely in memory.
+class MPModelExportSink {
+ public:
+  virtual ~MPModelExportSink() {}
+
+  // Appends the given bytes to the output. Returns false on error, in which
+  // case the export stops.
+  virtual bool Append(const char* data, size_t size) = 0;
+};
+
 class MPModelProtoExporter {
  public:
   // The argument must live as long as this class is active.
@@ -83,7 +94,27 @@ class MPModelProtoExporter {
   bool ExportModelAsMpsFormat(bool fixed_format, bool obfuscated,
                               std::string* model_str);
 
+  // Same as above, but the output is given to the sink by pieces of about
+  // kExportBufferSize bytes, as it is generated.
+  bool ExportModelAsLpFormat(bool obfuscated, MPModelExportSink* sink);
+  bool ExportModelAsMpsFormat(bool fixed_format, bool obfuscated,
+                              MPModelExportSink* sink);
+
+  static const int kExportBufferSize = 1 << 20;
+
  private:
+  // Implementation of the export methods above. The output is appended to
+  // *output, which is flushed to sink_ whenever it exceeds kExportBufferSize
+  // if sink_ is not NULL.
+  bool ExportModelAsLpFormatInternal(bool obfuscated, std::string* output);
+  bool ExportModelAsMpsFormatInternal(bool fixed_format, bool obfuscated,
+                                      std::string* output);
+
+  // Gives the content of *output to sink_ and clears it, if there is a sink
+  // and if *output is larger than kExportBufferSize, or always if force is
+  // true. Returns false if the sink reported an error.
+  bool FlushOutput(bool force, std::string* output);
+
   // Computes the number of continuous, integer and binary variables.
   // Called by ExportModelAsLpFormat() and ExportModelAsMpsFormat().
   void Setup();
@@ -156,9 +187,12 @@ class MPModelProtoExporter {
 
   // When 'integrality' is true, appends columns corresponding to integer
   // variables. Appends the columns for non-integer variables otherwise.
-  // The sparse matrix must be passed as a vector of columns ('transpose').
-  void AppendMpsColumns(bool integrality,
-                        const std::vector<std::vector<std::pair<int, double>>>& transpose,
+  // The sparse matrix must be passed by columns: the (constraint index,
+  // coefficient) pairs of the column of var_index are the entries
+  // [column_starts[var_index], column_starts[var_index + 1]) of 'transpose'.
+  // Returns false if the sink reported an error.
+  bool AppendMpsColumns(bool integrality, const std::vector<int>& column_starts,
+                        const std::vector<std::pair<int, double>>& transpose,
                         std::string* output);
 
   // Appends a line describing the bound of a variablenew-line if two columns
@@ -193,6 +227,9 @@ class MPModelProtoExporter {
   // True if the variable and constraint names will be obfuscated.
   bool use_obfuscated_names_;
 
+  // Where the output goes, if it is not a string.
+  MPModelExportSink* sink_;
+
   DISALLOW_COPY_AND_ASSIGN(MPModelProtoExporter);
 };
 
@@ -13,10 +13,16 @@
 
 #include "linear_solver/model_validator.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <limits>
+#include <memory>
+#include "base/callback.h"
 #include "base/join.h"
 #include "base/accurate_sum.h"
+#include "base/macros.h"
+#include "base/threadpool.h"
 #include "util/fp_utils.h"
 
 namespace operations_research {
@@ -135,9 +141,137 @@ std::string FindErrorInSolutionHint(const PartialVariableAssignment& solution_hi
   return std::string();
 }
 
+// Returns the error message of FindErrorInMPModelProto() for the given
+// invalid constraint.
+std::string ConstraintErrorMessage(const MPConstraintProto& constraint, int index,
+                                   const std::string& error) {
+  // Constraint protos can be huge, theoretically. So we guard against that.
+  const int kMaxNumVarsInPrintedConstraint = 10;
+  MPConstraintProto constraint_light = constraint;
+  std::string suffix_str;
+  if (constraint.var_index_size() > kMaxNumVarsInPrintedConstraint) {
+    constraint_light.mutable_var_index()->Truncate(
+        kMaxNumVarsInPrintedConstraint);
+    StrAppend(&suffix_str, " (var_index cropped; size=",
+              constraint.var_index_size(), ").");
+  }
+  if (constraint.coefficient_size() > kMaxNumVarsInPrintedConstraint) {
+    constraint_light.mutable_coefficient()->Truncate(
+        kMaxNumVarsInPrintedConstraint);
+    StrAppend(&suffix_str, " (coefficient cropped; size=",
+              constraint.coefficient_size(), ").");
+  }
+  return StrCat("In constraint #", index, ": ", error, ". Constraint proto: ",
+                DebugString(constraint_light), suffix_str);
+}
+
+// The constraints of a model validated in parallel, split in chunks of
+// consecutive constraints with about kNumTermsPerChunk terms each. The chunks
+// are taken in increasing order by the threads; once an invalid chunk is
+// found, the chunks after it are skipped since their errors would not be
+// reported anyway.
+class ParallelConstraintValidator {
+ public:
+  explicit ParallelConstraintValidator(const MPModelProto& model)
+      : model_(model), next_chunk_(0), first_invalid_chunk_(kNoInvalidChunk) {
+    const int kNumTermsPerChunk = 1 << 16;
+    int num_terms = 0;
+    chunk_starts_.push_back(0);
+    for (int i = 0; i < model.constraint_size(); ++i) {
+      // Each constraint counts as at least one term, for its bounds.
+      num_terms += 1 + model.constraint(i).var_index_size();
+      if (num_terms >= kNumTermsPerChunk) {
+        chunk_starts_.push_back(i + 1);
+        num_terms = 0;
+      }
+    }
+    if (chunk_starts_.back() != model.constraint_size()) {
+      chunk_starts_.push_back(model.constraint_size());
+    }
+    chunk_errors_.resize(NumChunks());
+  }
+
+  int NumChunks() const { return chunk_starts_.size() - 1; }
+
+  // Validates chunks until there is none left. Run by each thread.
+  void Run() {
+    std::vector<bool> variable_appears(model_.variable_size(), false);
+    for (;;) {
+      const int chunk = next_chunk_.fetch_add(1);
+      if (chunk >= NumChunks() || chunk > first_invalid_chunk_.load()) return;
+      for (int i = chunk_starts_[chunk]; i < chunk_starts_[chunk + 1]; ++i) {
+        const std::string error =
+            FindErrorInMPConstraint(model_.constraint(i), &variable_appears);
+        if (!error.empty()) {
+          chunk_errors_[chunk] =
+              ConstraintErrorMessage(model_.constraint(i), i, error);
+          int current = first_invalid_chunk_.load();
+          while (chunk < current &&
+                 !first_invalid_chunk_.compare_exchange_weak(current, chunk)) {
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  // Returns the error of the first invalid constraint, or an empty string.
+  // Must be called after all the calls to Run() have returned.
+  std::string FirstError() const {
+    const int chunk = first_invalid_chunk_.load();
+    return chunk == kNoInvalidChunk ? std::string() : chunk_errors_[chunk];
+  }
+
+ private:
+  static const int kNoInvalidChunk = std::numeric_limits<int>::max();
+
+  const MPModelProto& model_;
+  std::vector<int> chunk_starts_;
+  // Only the entry of a chunk is written by the thread validating it.
+  std::vector<std::string> chunk_errors_;
+  std::atomic<int> next_chunk_;
+  std::atomic<int> first_invalid_chunk_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelConstraintValidator);
+};
+
+// Returns the error message of FindErrorInMPModelProto() for the first invalid
+// constraint of the model, or an empty string.
+std::string FindErrorInConstraints(const MPModelProto& model) {
+  std::vector<bool> variable_appears(model.variable_size(), false);
+  for (int i = 0; i < model.constraint_size(); ++i) {
+    const MPConstraintProto& constraint = model.constraint(i);
+    const std::string error =
+        FindErrorInMPConstraint(constraint, &variable_appears);
+    if (!error.empty()) return ConstraintErrorMessage(constraint, i, error);
+  }
+  return std::string();
+}
+
+// Same as FindErrorInConstraints(), with the given number of threads.
+std::string FindErrorInConstraintsInParallel(const MPModelProto& model,
+                                             int num_threads) {
+  ParallelConstraintValidator validator(model);
+  if (validator.NumChunks() <= 1) return FindErrorInConstraints(model);
+  num_threads = std::min(num_threads, validator.NumChunks());
+  {
+    // The destructor of the pool waits for all the threads to finish.
+    ThreadPool pool("FindErrorInMPModelProto", num_threads);
+    pool.StartWorkers();
+    for (int i = 0; i < num_threads; ++i) {
+      pool.Add(NewCallback(&validator, &ParallelConstraintValidator::Run));
+    }
+  }
+  return validator.FirstError();
+}
+
 }  // namespace
 
 std::string FindErrorInMPModelProto(const MPModelProto& model) {
+  return FindErrorInMPModelProto(model, /*num_threads=*/1);
+}
+
+std::string FindErrorInMPModelProto(const MPModelProto& model, int num_threads) {
   // TODO(user): enhance the error reporting: report several errors instead of
   // stopping at the first one.
 
@@ -161,31 +295,9 @@ std::string FindErrorInMPModelProto(const MPModelProto& model) {
   }
 
   // Validate constraints.
-  std::vector<bool> variable_appears(num_vars, false);
-  const int kMaxNumVarsInPrintedConstraint = 10;
-  for (int i = 0; i < num_cts; ++i) {
-    const MPConstraintProto& constraint = model.constraint(i);
-    error = FindErrorInMPConstraint(constraint, &variable_appears);
-    if (!error.empty()) {
-      // Constraint protos can be huge, theoretically. So we guard against that.
-      MPConstraintProto constraint_light = constraint;
-      std::string suffix_str;
-      if (constraint.var_index_size() > kMaxNumVarsInPrintedConstraint) {
-        constraint_light.mutable_var_index()->Truncate(
-            kMaxNumVarsInPrintedConstraint);
-        StrAppend(&suffix_str, " (var_index cropped; size=",
-                  constraint.var_index_size(), ").");
-      }
-      if (constraint.coefficient_size() > kMaxNumVarsInPrintedConstraint) {
-        constraint_light.mutable_coefficient()->Truncate(
-            kMaxNumVarsInPrintedConstraint);
-        StrAppend(&suffix_str, " (coefficient cropped; size=",
-                  constraint.coefficient_size(), ").");
-      }
-      return StrCat("In constraint #", i, ": ", error, ". Constraint proto: ",
-                    DebugString(constraint_light), suffix_str);
-    }
-  }
+  error = num_threads > 1 ? FindErrorInConstraintsInParallel(model, num_threads)
+                          : FindErrorInConstraints(model);
+  if (!error.empty()) return error;
 
   // Validate the solution hint.
   error = FindErrorInSolutionHint(model.solution_hint(), num_vars);
@@ -27,6 +27,11 @@ namespace operations_research {
 // require it, we could add a formal error status enum.
 std::string FindErrorInMPModelProto(const MPModelProto& model);
 
+// Same as above, but the constraints are validated by num_threads threads,
+// each working on chunks of consecutive constraints. The result is always the
+// same as the one of the sequential version: the first error is reported.
+std::string FindErrorInMPModelProto(const MPModelProto& model, int num_threads);
+
 // Returns an empty std::string if the solution hint given in the model is a feasible
 // solution. Otherwise, returns a description of the first reason for
 // infeasibility.
@@ -13,7 +13,11 @@
 
 #include "lp_data/matrix_utils.h"
 #include <algorithm>
+#include <memory>
+#include "base/callback.h"
 #include "base/hash.h"
+#include "base/synchronization.h"
+#include "base/threadpool.h"
 
 namespace operations_research {
 namespace glop {
@@ -107,43 +111,153 @@ ColumnFingerprint ComputeFingerprint(ColIndex col, const SparseColumn& column) {
                            inverse_dynamic_range + scaled_average);
 }
 
+// Appends the fingerprints of the non-empty columns in [begin, end) to
+// fingerprints.
+void ComputeFingerprints(const SparseMatrix* matrix, ColIndex begin,
+                         ColIndex end,
+                         std::vector<ColumnFingerprint>* fingerprints) {
+  for (ColIndex col(begin); col < end; ++col) {
+    if (!matrix->column(col).IsEmpty()) {
+      fingerprints->push_back(ComputeFingerprint(col, matrix->column(col)));
+    }
+  }
+}
+
+void ComputeFingerprintsAndBlock(const SparseMatrix* matrix, ColIndex begin,
+                                 ColIndex end,
+                                 std::vector<ColumnFingerprint>* fingerprints,
+                                 Barrier* barrier) {
+  ComputeFingerprints(matrix, begin, end, fingerprints);
+  if (barrier->Block()) delete barrier;
+}
+
+// The sorted fingerprints, split into groups of equal non-zero pattern hash.
+// Two candidates always belong to the same group, so the groups can be
+// processed independently. Each group only writes the mapping of its own
+// columns.
+struct FingerprintGroups {
+  const SparseMatrix* matrix;
+  Fractional tolerance;
+  std::vector<ColumnFingerprint> fingerprints;
+  std::vector<int> group_starts;
+  ColMapping* mapping;
+
+  int num_groups() const { return group_starts.size() - 1; }
+
+  // Finds a representative of each proportional columns class of the groups
+  // in [first_group, last_group). This only compares columns with a
+  // close-enough fingerprint.
+  void FindProportionalColumns(int first_group, int last_group) {
+    for (int group = first_group; group < last_group; ++group) {
+      const int group_end = group_starts[group + 1];
+      for (int i = group_starts[group]; i < group_end; ++i) {
+        const ColIndex col_a = fingerprints[i].col;
+        if ((*mapping)[col_a] != kInvalidCol) continue;
+        for (int j = i + 1; j < group_end; ++j) {
+          const ColIndex col_b = fingerprints[j].col;
+          if ((*mapping)[col_b] != kInvalidCol) continue;
+
+          // Note that we use the same tolerance for the fingerprints.
+          // TODO(user): Derive precise bounds on what this tolerance should
+          // be so that no proportional columns are missed.
+          if (!AreProportionalCandidates(fingerprints[i], fingerprints[j],
+                                         tolerance)) {
+            break;
+          }
+          if (AreColumnsProportional(matrix->column(col_a),
+                                     matrix->column(col_b), tolerance)) {
+            (*mapping)[col_b] = col_a;
+          }
+        }
+      }
+    }
+  }
+
+  void FindProportionalColumnsAndBlock(int first_group, int last_group,
+                                       Barrier* barrier) {
+    FindProportionalColumns(first_group, last_group);
+    if (barrier->Block()) delete barrier;
+  }
+};
+
+// Below this number of columns per thread, FindProportionalColumns() does not
+// start more threads.
+const int kMinProportionalColumnsPerThread = 256;
+
 }  // namespace
 
 ColMapping FindProportionalColumns(const SparseMatrix& matrix,
-                                   Fractional tolerance) {
+                                   Fractional tolerance, int num_threads) {
   const ColIndex num_cols = matrix.num_cols();
   ColMapping mapping(num_cols, kInvalidCol);
+  const int num_chunks = std::max(
+      1, std::min(num_threads,
+                  num_cols.value() / kMinProportionalColumnsPerThread));
+  std::unique_ptr<ThreadPool> pool;
+  if (num_chunks > 1) {
+    pool.reset(new ThreadPool("FindProportionalColumns", num_chunks - 1));
+    pool->StartWorkers();
+  }
 
-  // Compute the fingerprint of each columns and sort them.
-  std::vector<ColumnFingerprint> fingerprints;
-  for (ColIndex col(0); col < num_cols; ++col) {
-    if (!matrix.column(col).IsEmpty()) {
-      fingerprints.push_back(ComputeFingerprint(col, matrix.column(col)));
+  // Compute the fingerprint of each columns and sort them. The columns are
+  // split in contiguous chunks, one per thread, and the chunks are then
+  // concatenated so that the result does not depend on num_threads.
+  FingerprintGroups groups;
+  groups.matrix = &matrix;
+  groups.tolerance = tolerance;
+  groups.mapping = &mapping;
+  if (num_chunks == 1) {
+    ComputeFingerprints(&matrix, ColIndex(0), num_cols, &groups.fingerprints);
+  } else {
+    std::vector<std::vector<ColumnFingerprint>> chunks(num_chunks);
+    const int chunk_size = (num_cols.value() + num_chunks - 1) / num_chunks;
+    Barrier* const barrier = new Barrier(num_chunks);
+    for (int chunk = 1; chunk < num_chunks; ++chunk) {
+      const ColIndex begin(chunk * chunk_size);
+      const ColIndex end(std::min(num_cols.value(), (chunk + 1) * chunk_size));
+      pool->Add(NewCallback(&ComputeFingerprintsAndBlock, &matrix, begin, end,
+                            &chunks[chunk], barrier));
+    }
+    ComputeFingerprintsAndBlock(&matrix, ColIndex(0), ColIndex(chunk_size),
+                                &chunks[0], barrier);
+    for (const std::vector<ColumnFingerprint>& chunk : chunks) {
+      groups.fingerprints.insert(groups.fingerprints.end(), chunk.begin(),
+                                 chunk.end());
     }
   }
+  std::vector<ColumnFingerprint>& fingerprints = groups.fingerprints;
   std::sort(fingerprints.begin(), fingerprints.end());
-
-  // Find a representative of each proportional columns class. This only
-  // compares columns with a close-enough fingerprint.
   for (int i = 0; i < fingerprints.size(); ++i) {
-    const ColIndex col_a = fingerprints[i].col;
-    if (mapping[col_a] != kInvalidCol) continue;
-    for (int j = i + 1; j < fingerprints.size(); ++j) {
-      const ColIndex col_b = fingerprints[j].col;
-      if (mapping[col_b] != kInvalidCol) continue;
+    if (i == 0 || fingerprints[i].hash != fingerprints[i - 1].hash) {
+      groups.group_starts.push_back(i);
+    }
+  }
+  groups.group_starts.push_back(fingerprints.size());
 
-      // Note that we use the same tolerance for the fingerprints.
-      // TODO(user): Derive precise bounds on what this tolerance should be so
-      // that no proportional columns are missed.
-      if (!AreProportionalCandidates(fingerprints[i], fingerprints[j],
-                                     tolerance)) {
-        break;
-      }
-      if (AreColumnsProportional(matrix.column(col_a), matrix.column(col_b),
-                                 tolerance)) {
-        mapping[col_b] = col_a;
+  // The groups are split in ranges holding about the same number of
+  // fingerprints, one per thread.
+  if (num_chunks == 1) {
+    groups.FindProportionalColumns(0, groups.num_groups());
+  } else {
+    std::vector<int> range_starts(1, 0);
+    const int range_size = (fingerprints.size() + num_chunks - 1) / num_chunks;
+    for (int group = 1; group < groups.num_groups(); ++group) {
+      const int num_ranges = range_starts.size();
+      if (groups.group_starts[group] >= num_ranges * range_size) {
+        range_starts.push_back(group);
       }
     }
+    range_starts.push_back(groups.num_groups());
+    const int num_ranges = range_starts.size() - 1;
+    Barrier* const barrier = new Barrier(num_ranges);
+    for (int range = 1; range < num_ranges; ++range) {
+      pool->Add(NewCallback(&groups,
+                            &FingerprintGroups::FindProportionalColumnsAndBlock,
+                            range_starts[range], range_starts[range + 1],
+                            barrier));
+    }
+    groups.FindProportionalColumnsAndBlock(range_starts[0], range_starts[1],
+                                           barrier);
   }
 
   // Sort the mapping so that the representative of each class is the smallest
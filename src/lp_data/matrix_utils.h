@@ -33,8 +33,11 @@ namespace glop {
 // The complexity is in most cases O(num entries of the matrix). However,
 // compared to the less efficient algorithm below, it is highly unlikely but
 // possible that some pairs of proportional columns are not detected.
+//
+// The fingerprinting and the pairwise comparisons are done by up to num_threads
+// threads on large matrices. The result does not depend on num_threads.
 ColMapping FindProportionalColumns(const SparseMatrix& matrix,
-                                   Fractional tolerance);
+                                   Fractional tolerance, int num_threads = 1);
 
 // A simple version of FindProportionalColumns() that compares all the columns
 // pairs one by one. This is slow, but here for reference. The complexity is
@@ -15,6 +15,7 @@
 #define OR_TOOLS_UTIL_TIME_LIMIT_H_
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <limits>
 #include <memory>
@@ -192,15 +193,18 @@ return 1e-9 * (base::GetCurrentTimeNanos() - start_ns_);
   // i.e. LimitReached() returns true when the value of
   // external_boolean_as_limit is true whatever the time limits are.
   //
-  // Note that external_boolean_as_limit is not protected by a mutex; This
-  // should not prevent usage in a mutli-threading environment because the
-  // change is atomic and it is usually not critical to wrongly return false in
-  // LimitReached() once in case of race between the change of the Boolean and
-  // the check of the limit.
-  void RegisterExternalBooleanAsLimit(const bool* external_boolean_as_limit) {
+  // The Boolean is atomic so that it can be set from another thread, for
+  // instance to interrupt a solve.
+  void RegisterExternalBooleanAsLimit(
+      const std::atomic<bool>* external_boolean_as_limit) {
     external_boolean_as_limit_ = external_boolean_as_limit;
   }
 
+  // Returns the external Boolean registered above, or nullptr if there is none.
+  const std::atomic<bool>* ExternalBooleanAsLimit() const {
+    return external_boolean_as_limit_;
+  }
+
   // Returns information about the time limit object in a human-readable form.
   std::string DebugString() const;
 
@@ -220,7 +224,7 @@ return 1e-9 * (base::GetCurrentTimeNanos() - start_ns_);
   double deterministic_limit_;
   double elapsed_deterministic_time_;
 
-  const bool* external_boolean_as_limit_;
+  const std::atomic<bool>* external_boolean_as_limit_;
 
 #ifndef NDEBUG
   // Contains the values of the deterministic time counters.